@@ -59,6 +59,11 @@ EXTERN_C_BEGIN
  */
 #define ADUCITF_FIELDNAME_STEPRESULTS "stepResults"
 
+/**
+ * @brief JSON field name for the optional deploymentTimings property.
+ */
+#define ADUCITF_FIELDNAME_DEPLOYMENTTIMINGS "deploymentTimings"
+
 /**
  * @brief JSON field name for ResultCode property.
  */
@@ -23,18 +23,27 @@
 #include "aduc/config_utils.h"
 #include "aduc/download_handler_factory.h" // ADUC_DownloadHandlerFactory_LoadDownloadHandler
 #include "aduc/download_handler_plugin.h" // ADUC_DownloadHandlerPlugin_OnUpdateWorkflowCompleted
+#include "aduc/extension_manager.h" // ExtensionManager_InvalidateComponentsCache
 #include "aduc/logging.h"
 #include "aduc/parser_utils.h" // ADUC_FileEntity_Uninit
 #include "aduc/result.h"
 #include "aduc/string_c_utils.h"
 #include "aduc/system_utils.h"
+#include "aduc/timing_utils.h"
 #include "aduc/types/workflow.h"
+#include "aduc/wakeup_utils.h"
 #include "aduc/workflow_data_utils.h"
 #include "aduc/workflow_utils.h"
 #include "root_key_util.h" // RootKeyUtility_GetReportingErc
 
+#include <azure_c_shared_utility/strings.h> // STRING_*
 #include <pthread.h>
 
+/**
+ * @brief The name of the deployment timing report file in the workflow sandbox.
+ */
+#define DEPLOYMENT_TIMING_REPORT_FILE_NAME "deployment_timings.json"
+
 // fwd decl
 void ADUC_Workflow_WorkCompletionCallback(const void* workCompletionToken, ADUC_Result result, bool isAsync);
 
@@ -418,6 +427,10 @@ void ADUC_Workflow_HandlePropertyUpdate(
     ADUC_WorkflowData* currentWorkflowData, const unsigned char* propertyUpdateValue, bool forceUpdate)
 {
     ADUC_WorkflowHandle nextWorkflow;
+    ADUC_TimingSpan validationSpan;
+
+    ADUC_Timing_BeginSpan(
+        &validationSpan, ADUC_TIMING_PHASE_MANIFEST_VALIDATION, NULL, ADUC_TIMING_NO_LEVEL, ADUC_TIMING_NO_LEVEL);
 
     ADUC_Result result = workflow_init((const char*)propertyUpdateValue, true /* shouldValidate */, &nextWorkflow);
 
@@ -439,6 +452,11 @@ void ADUC_Workflow_HandlePropertyUpdate(
 
     ADUCITF_UpdateAction nextUpdateAction = workflow_get_action(nextWorkflow);
 
+    if (nextUpdateAction == ADUCITF_UpdateAction_ProcessDeployment)
+    {
+        ADUC_Timing_EndSpan(workflow_get_timing_report(nextWorkflow), &validationSpan);
+    }
+
     //
     // Take lock until goto done.
     //
@@ -681,6 +699,9 @@ void ADUC_Workflow_HandleUpdateAction(ADUC_WorkflowData* workflowData)
     //
     ADUC_WorkflowData_SetCurrentAction(desiredAction, workflowData);
 
+    // Re-enumerate components once per deployment, for enumerators that do not report an inventory version.
+    ExtensionManager_InvalidateComponentsCache();
+
     //
     // Check if installed already
     // Note, must be done after setting current action for proper reporting.
@@ -790,6 +811,47 @@ void ADUC_Workflow_AutoTransitionWorkflow(ADUC_WorkflowData* workflowData, bool
     }
 }
 
+// The span of the workflow step in progress. Only one step is in progress at a time.
+static ADUC_TimingSpan s_workflowStepSpan;
+
+/**
+ * @brief Writes the deployment timing report to the sandbox, so it can be collected with the other deployment
+ * artifacts. Rewritten on each completed workflow step, since the sandbox is destroyed when returning to Idle.
+ *
+ * @param workflowData The workflow data.
+ */
+static void WriteDeploymentTimingReport(ADUC_WorkflowData* workflowData)
+{
+    char* workflowId = ADUC_WorkflowData_GetWorkflowId(workflowData); // see workflow_free_string below
+    char* workFolder = ADUC_WorkflowData_GetWorkFolder(workflowData); // see workflow_free_string below
+    char* reportJson = NULL;
+    STRING_HANDLE reportPath = NULL;
+
+    if (workflowId == NULL || workFolder == NULL)
+    {
+        goto done;
+    }
+
+    reportJson = ADUC_TimingReport_CreateJson(workflow_get_timing_report(workflowData->WorkflowHandle), workflowId);
+    reportPath = STRING_construct_sprintf("%s/%s", workFolder, DEPLOYMENT_TIMING_REPORT_FILE_NAME);
+    if (reportJson == NULL || reportPath == NULL)
+    {
+        goto done;
+    }
+
+    // The sandbox does not exist until the download step creates it.
+    if (ADUC_SystemUtils_WriteStringToFile(STRING_c_str(reportPath), reportJson) != 0)
+    {
+        Log_Debug("Deployment timing report not written to '%s'", STRING_c_str(reportPath));
+    }
+
+done:
+    STRING_delete(reportPath);
+    free(reportJson);
+    workflow_free_string(workflowId);
+    workflow_free_string(workFolder);
+}
+
 /**
  * @brief Transitions the workflow to the next workflow step, e.g. Download to Install, Install to Apply, etc.
  * @remark Must be in a lock
@@ -824,6 +886,15 @@ void ADUC_Workflow_TransitionWorkflow(ADUC_WorkflowData* workflowData)
     methodCallData->WorkCompletionData.WorkCompletionCallback = ADUC_Workflow_WorkCompletionCallback;
     methodCallData->WorkCompletionData.WorkCompletionToken = methodCallData;
 
+    // Spans recorded by code without a workflow at hand, e.g. hashing, go to this deployment's report.
+    ADUC_Timing_SetCurrentReport(workflow_get_timing_report(workflowData->WorkflowHandle));
+    ADUC_Timing_BeginSpan(
+        &s_workflowStepSpan,
+        ADUC_TIMING_PHASE_WORKFLOW_STEP,
+        ADUCITF_WorkflowStepToString(entry->WorkflowStep),
+        0 /* level */,
+        ADUC_TIMING_NO_LEVEL);
+
     // Call into the upper-layer method to perform operation.
     Log_Debug("Setting operation_in_progress => true");
     workflow_set_operation_in_progress(workflowData->WorkflowHandle, true);
@@ -897,6 +968,9 @@ void ADUC_Workflow_WorkCompletionCallback(const void* workCompletionToken, ADUC_
 
     entry->OperationCompleteFunc(methodCallData, result);
 
+    ADUC_Timing_EndSpan(workflow_get_timing_report(workflowData->WorkflowHandle), &s_workflowStepSpan);
+    WriteDeploymentTimingReport(workflowData);
+
     if (IsAducResultCodeSuccess(result.ResultCode))
     {
         // Operation succeeded -- go to next state.
@@ -1034,6 +1108,9 @@ done:
     if (isAsync)
     {
         s_workflow_unlock();
+
+        // Let the main loop pick up whatever the transition queued.
+        ADUC_Wakeup_Signal();
     }
 }
 
@@ -1179,23 +1256,14 @@ static void CallDownloadHandlerOnUpdateWorkflowCompleted(const ADUC_WorkflowHand
         ADUC_Result result;
         memset(&result, 0, sizeof(result));
 
-        ADUC_FileEntity fileEntity;
-        memset(&fileEntity, 0, sizeof(fileEntity));
-
-        if (!workflow_get_update_file(workflowHandle, i, &fileEntity))
+        const ADUC_FileEntity* fileEntity = workflow_peek_update_file(workflowHandle, i);
+        if (fileEntity == NULL || IsNullOrEmpty(fileEntity->DownloadHandlerId))
         {
             continue;
         }
 
-        if (IsNullOrEmpty(fileEntity.DownloadHandlerId))
-        {
-            ADUC_FileEntity_Uninit(&fileEntity);
-            continue;
-        }
-
         // NOTE: do not free the handle as it is owned by the DownloadHandlerFactory.
-        DownloadHandlerHandle* handle = ADUC_DownloadHandlerFactory_LoadDownloadHandler(fileEntity.DownloadHandlerId);
-        ADUC_FileEntity_Uninit(&fileEntity);
+        DownloadHandlerHandle* handle = ADUC_DownloadHandlerFactory_LoadDownloadHandler(fileEntity->DownloadHandlerId);
         if (handle != NULL)
         {
             result = ADUC_DownloadHandlerPlugin_OnUpdateWorkflowCompleted(handle, workflowHandle);
@@ -1320,6 +1388,22 @@ void ADUC_Workflow_MethodCall_Idle(ADUC_WorkflowData* workflowData)
 
     updateActionCallbacks->IdleCallback(updateActionCallbacks->PlatformLayerHandle, workflowId);
 
+    if (workflowData->WorkflowHandle != NULL)
+    {
+        char* phaseTotals = NULL;
+        ADUC_JsonWriter writer;
+        if (ADUC_JsonWriter_Init(&writer, 0))
+        {
+            ADUC_TimingReport_WritePhaseTotals(workflow_get_timing_report(workflowData->WorkflowHandle), &writer);
+            phaseTotals = ADUC_JsonWriter_Detach(&writer);
+        }
+
+        Log_Info("Deployment timings (ms): %s", phaseTotals != NULL ? phaseTotals : "unavailable");
+        free(phaseTotals);
+    }
+
+    ADUC_Timing_SetCurrentReport(NULL);
+
     workflow_free_string(workflowId);
     workflow_free_string(workFolder);
 
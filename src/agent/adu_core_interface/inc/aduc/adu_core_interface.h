@@ -10,6 +10,7 @@
 
 #include <aduc/c_utils.h>
 #include <aduc/client_handle.h>
+#include <aduc/json_writer.h>
 #include <aduc/result.h> // ADUC_Result
 #include <aduc/types/workflow.h>
 #include <azureiot/iothub_client_core_common.h>
@@ -93,15 +94,17 @@ bool AzureDeviceUpdateCoreInterface_ReportStateAndResultAsync(
     const char* installedUpdateId);
 
 /**
- * @brief Get the Reporting Json Value object
+ * @brief Writes the reporting document for the 'agent' property into @p writer.
  *
+ * @param writer The writer to append the document to.
  * @param workflowData The workflow data.
  * @param updateState The workflow state machine state.
  * @param result The pointer to the result. If NULL, then the result will be retrieved from the opaque handle object in the workflow data.
  * @param installedUpdateId The installed Update ID string.
- * @return JSON_Value* The resultant json value object.
+ * @return bool true if the whole document was written.
  */
-JSON_Value* GetReportingJsonValue(
+bool WriteReportingJson(
+    ADUC_JsonWriter* writer,
     ADUC_WorkflowData* workflowData,
     ADUCITF_State updateState,
     const ADUC_Result* result,
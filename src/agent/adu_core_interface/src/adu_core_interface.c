@@ -15,13 +15,14 @@
 #include "aduc/config_utils.h"
 #include "aduc/d2c_messaging.h"
 #include "aduc/hash_utils.h"
+#include "aduc/json_writer.h"
 #include "aduc/logging.h"
-#include "aduc/reporting_utils.h"
 #include "aduc/rootkey_workflow.h"
 #include "aduc/rootkeypackage_do_download.h"
 #include "aduc/rootkeypackage_types.h"
 #include "aduc/rootkeypackage_utils.h"
 #include "aduc/string_c_utils.h"
+#include "aduc/timing_utils.h"
 #include "aduc/types/adu_core.h"
 #include "aduc/types/update_content.h"
 #include "aduc/workflow_data_utils.h"
@@ -33,6 +34,7 @@
 #include <iothub_client_version.h>
 #include <parson.h>
 #include <pnp_protocol.h>
+#include <stdio.h> // snprintf
 
 // Name of an Device Update Agent component that this device implements.
 static const char g_aduPnPComponentName[] = "deviceUpdate";
@@ -548,249 +550,194 @@ void AzureDeviceUpdateCoreInterface_PropertyUpdateCallback(
 //
 // Reporting
 //
-static JSON_Status _json_object_set_update_result(
-    JSON_Object* object, int32_t resultCode, STRING_HANDLE extendedResultCodes, const char* resultDetails)
+
+// Estimated size of the reporting document without steps, and of each 'stepResults' entry.
+// Used to size the writer buffer up-front so that it is not regrown while writing.
+#define REPORTING_JSON_BASE_CAPACITY 512
+#define REPORTING_JSON_STEP_CAPACITY 192
+
+/**
+ * @brief Writes the 'resultCode', 'extendedResultCodes' and 'resultDetails' members of an update result.
+ *
+ * @param writer The writer, positioned inside the result object.
+ * @param result The result.
+ * @param extraExtendedResultCodes optional. The ',' prefixed extra ERCs to append after the result's ERC.
+ * @param resultDetails optional. The result details. Written as 'null' when NULL.
+ */
+static void WriteUpdateResult(
+    ADUC_JsonWriter* writer, ADUC_Result result, const char* extraExtendedResultCodes, const char* resultDetails)
 {
-    JSON_Status status = json_object_set_number(object, ADUCITF_FIELDNAME_RESULTCODE, resultCode);
-    if (status != JSONSuccess)
-    {
-        Log_Error("Could not set value for field: %s", ADUCITF_FIELDNAME_RESULTCODE);
-        goto done;
-    }
+    // The first ERC (8 hex digits) is always from the result itself.
+    char extendedResultCode[9];
+    (void)snprintf(extendedResultCode, sizeof(extendedResultCode), "%08X", (uint32_t)result.ExtendedResultCode);
 
-    status = json_object_set_string(object, ADUCITF_FIELDNAME_EXTENDEDRESULTCODES, STRING_c_str(extendedResultCodes));
-    if (status != JSONSuccess)
-    {
-        Log_Error("Could not set value for field: %s", ADUCITF_FIELDNAME_EXTENDEDRESULTCODES);
-        goto done;
-    }
+    ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_RESULTCODE);
+    ADUC_JsonWriter_WriteInt64(writer, result.ResultCode);
 
-    if (resultDetails != NULL)
-    {
-        status = json_object_set_string(object, ADUCITF_FIELDNAME_RESULTDETAILS, resultDetails);
-        if (status != JSONSuccess)
-        {
-            Log_Error("Could not set value for field: %s", ADUCITF_FIELDNAME_RESULTDETAILS);
-        }
-    }
-    else
-    {
-        status = json_object_set_null(object, ADUCITF_FIELDNAME_RESULTDETAILS);
-        if (status != JSONSuccess)
-        {
-            Log_Error("Could not set field %s to 'null'", ADUCITF_FIELDNAME_RESULTDETAILS);
-        }
-    }
+    ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_EXTENDEDRESULTCODES);
+    ADUC_JsonWriter_BeginString(writer);
+    ADUC_JsonWriter_AppendStringContent(writer, extendedResultCode);
+    ADUC_JsonWriter_AppendStringContent(writer, extraExtendedResultCodes);
+    ADUC_JsonWriter_EndString(writer);
 
-done:
-    return status;
+    ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_RESULTDETAILS);
+    ADUC_JsonWriter_WriteString(writer, resultDetails);
 }
 
 /**
- * @brief Sets workflow properties on the workflow json value.
+ * @brief Writes the 'workflow' member.
  *
- * @param[in,out] workflowValue The workflow json value to set properties on.
- * @param[in] updateAction The updateAction for the action field.
- * @param[in] workflowId The workflow id of the update deployment.
- * @param[in] retryTimestamp optional. The retry timestamp that's present for service-initiated retries.
- * @return true if all properties were set successfully; false, otherwise.
+ * @param writer The writer, positioned inside the root object.
+ * @param updateAction The updateAction for the action field.
+ * @param workflowId The workflow id of the update deployment.
+ * @param retryTimestamp optional. The retry timestamp that's present for service-initiated retries.
  */
-static bool set_workflow_properties(
-    JSON_Value* workflowValue, ADUCITF_UpdateAction updateAction, const char* workflowId, const char* retryTimestamp)
+static void WriteWorkflowProperties(
+    ADUC_JsonWriter* writer, ADUCITF_UpdateAction updateAction, const char* workflowId, const char* retryTimestamp)
 {
-    bool succeeded = false;
+    ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_WORKFLOW);
+    ADUC_JsonWriter_BeginObject(writer);
 
-    JSON_Object* workflowObject = json_value_get_object(workflowValue);
-    if (json_object_set_number(workflowObject, ADUCITF_FIELDNAME_ACTION, updateAction) != JSONSuccess)
-    {
-        Log_Error("Could not add JSON field: %s", ADUCITF_FIELDNAME_ACTION);
-        goto done;
-    }
+    ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_ACTION);
+    ADUC_JsonWriter_WriteInt64(writer, updateAction);
 
-    if (json_object_set_string(workflowObject, ADUCITF_FIELDNAME_ID, workflowId) != JSONSuccess)
-    {
-        Log_Error("Could not add JSON field: %s", ADUCITF_FIELDNAME_ID);
-        goto done;
-    }
+    ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_ID);
+    ADUC_JsonWriter_WriteString(writer, workflowId);
 
     if (!IsNullOrEmpty(retryTimestamp))
     {
-        if (json_object_set_string(workflowObject, ADUCITF_FIELDNAME_RETRYTIMESTAMP, retryTimestamp) != JSONSuccess)
-        {
-            Log_Error("Could not add JSON field: %s", ADUCITF_FIELDNAME_RETRYTIMESTAMP);
-            goto done;
-        }
+        ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_RETRYTIMESTAMP);
+        ADUC_JsonWriter_WriteString(writer, retryTimestamp);
     }
 
-    succeeded = true;
+    ADUC_JsonWriter_EndObject(writer);
+}
 
-done:
+/**
+ * @brief Gets whether deployment timings should be reported.
+ *
+ * @return true if 'reportDeploymentTimings' is set in du-config.json
+ */
+static bool IsDeploymentTimingReportingEnabled()
+{
+    bool enabled = false;
+    const ADUC_ConfigInfo* config = ADUC_ConfigInfo_GetInstance();
+    if (config != NULL)
+    {
+        enabled = config->reportDeploymentTimings;
+        ADUC_ConfigInfo_ReleaseInstance(config);
+    }
 
-    return succeeded;
+    return enabled;
 }
 
-static STRING_HANDLE construct_extended_result_codes_str(ADUC_WorkflowHandle handle, ADUC_Result rootResult)
+/**
+ * @brief Writes the 'stepResults' entries, one per child workflow.
+ *
+ * @param writer The writer, positioned inside the 'stepResults' object.
+ * @param handle The root workflow handle.
+ */
+static void WriteStepResults(ADUC_JsonWriter* writer, ADUC_WorkflowHandle handle)
 {
-    STRING_HANDLE root_result_erc_str =
-        ADUC_ReportingUtils_CreateReportingErcHexStr(rootResult.ExtendedResultCode, true /* is_first */);
-    STRING_HANDLE extra_ercs_str = workflow_get_extra_ercs(handle);
-    if (extra_ercs_str != NULL && STRING_length(extra_ercs_str) > 0 && root_result_erc_str != NULL
-        && STRING_length(root_result_erc_str) > 0)
+    size_t stepsCount = workflow_get_children_count(handle);
+    for (size_t i = 0; i < stepsCount; i++)
     {
-        STRING_concat_with_STRING(root_result_erc_str, extra_ercs_str);
-    }
+        ADUC_WorkflowHandle childHandle = workflow_get_child(handle, i);
+        if (childHandle == NULL)
+        {
+            Log_Error("Could not get components #%d update result", i);
+            continue;
+        }
+
+        // Note: IoTHub twin doesn't support some special characters in a map key (e.g. ':', '-').
+        // Let's name the result using "step_" +  the array index.
+        char childUpdateId[32];
+        (void)snprintf(childUpdateId, sizeof(childUpdateId), "step_%zu", i);
 
-    STRING_delete(extra_ercs_str);
-    return root_result_erc_str;
+        ADUC_JsonWriter_WriteKey(writer, childUpdateId);
+        ADUC_JsonWriter_BeginObject(writer);
+        WriteUpdateResult(
+            writer,
+            workflow_get_result(childHandle),
+            NULL /* extraExtendedResultCodes */,
+            workflow_peek_result_details(childHandle));
+        ADUC_JsonWriter_EndObject(writer);
+    }
 }
 
 /**
- * @brief Get the Reporting Json Value object
+ * @brief Writes the reporting document for the 'agent' property straight into @p writer, without building a DOM.
+ *
+ * Example schema:
  *
+ * {
+ *     "state" : ###,
+ *     "workflow": {
+ *         "action": 3,
+ *         "id": "..."
+ *     },
+ *     "installedUpdateId" : "...",
+ *
+ *     "lastInstallResult" : {
+ *         "resultCode" : ####,
+ *         "extendedResultCodes" : "########,########",
+ *         "resultDetails" : "...",
+ *         "stepResults" : {
+ *             "step_0" : {
+ *                 "resultCode" : ####,
+ *                 "extendedResultCodes" : "########",
+ *                 "resultDetails" : "..."
+ *             },
+ *             ...
+ *         }
+ *     }
+ * }
+ *
+ * @param writer The writer to append the document to.
  * @param workflowData The workflow data.
  * @param updateState The workflow state machine state.
  * @param result The pointer to the result. If NULL, then the result will be retrieved from the opaque handle object in the workflow data.
  * @param installedUpdateId The installed Update ID string.
- * @return JSON_Value* The resultant json value object. Caller must free using json_value_free().
+ * @return bool true if the whole document was written.
  */
-JSON_Value* GetReportingJsonValue(
+bool WriteReportingJson(
+    ADUC_JsonWriter* writer,
     ADUC_WorkflowData* workflowData,
     ADUCITF_State updateState,
     const ADUC_Result* result,
     const char* installedUpdateId)
 {
-    JSON_Value* resultValue = NULL;
-
-    // Declare and init here to avoid maybe-uninitialized static analysis errors
-    JSON_Value* rootValue = NULL;
-    JSON_Value* lastInstallResultValue = NULL;
-    JSON_Value* stepResultsValue = NULL;
-    JSON_Value* workflowValue = NULL;
-    STRING_HANDLE rootResultERCs = NULL;
-
     //
     // Get result from current workflow if exists.
     // (Note: on startup, update workflow is not started, unless there is an existing Update Action in the twin.)
     //
     // If not, try to use specified 'result' param.
     //
-    // If there's no result details, we'll report only 'updateState'.
-    //
-    ADUC_Result rootResult;
     ADUC_WorkflowHandle handle = workflowData->WorkflowHandle;
+    ADUC_Result rootResult = (result != NULL) ? *result : workflow_get_result(handle);
 
-    if (result != NULL)
-    {
-        rootResult = *result;
-    }
-    else
-    {
-        rootResult = workflow_get_result(handle);
-    }
-
-    // The "extendedResultCodes" reported property is a JSON string, where the first ERC (8 hex digits) is always
-    // from the rootResult. Extra ERC can be appended for soft-failing mechanisms with fallback mechanisms
+    // Extra ERCs can be appended after the root ERC for soft-failing mechanisms with fallback mechanisms
     // e.g. download handler or update metadata rootkey management.
-    rootResultERCs = construct_extended_result_codes_str(handle, rootResult);
-    if (rootResultERCs == NULL)
-    {
-        goto done;
-    }
+    STRING_HANDLE extraErcs = workflow_get_extra_ercs(handle);
 
-    rootValue = json_value_init_object();
-    JSON_Object* rootObject = json_value_get_object(rootValue);
-    size_t stepsCount = workflow_get_children_count(handle);
-
-    //
-    // Prepare 'lastInstallResult', 'stepResults' data.
-    //
-    // Example schema:
-    //
-    // {
-    //     "state" : ###,
-    //     "workflow": {
-    //         "action": 3,
-    //         "id": "..."
-    //     },
-    //     "installedUpdateId" : "...",
-    //
-    //     "lastInstallResult" : {
-    //         "resultCode" : ####,
-    //         "extendedResultCodes" : "########,########",
-    //         "resultDetails" : "...",
-    //         "stepResults" : {
-    //             "step_0" : {
-    //                 "resultCode" : ####,
-    //                 "extendedResultCodes" : "########",
-    //                 "resultDetails" : "..."
-    //             },
-    //             ...
-    //             "step_N" : {
-    //                 "resultCode" : ####,
-    //                 "extendedResultCodes" : "########",
-    //                 "resultDetails" : "..."
-    //             }
-    //         }
-    //     }
-    // }
-
-    lastInstallResultValue = json_value_init_object();
-    JSON_Object* lastInstallResultObject = json_object(lastInstallResultValue);
-
-    stepResultsValue = json_value_init_object();
-    JSON_Object* stepResultsObject = json_object(stepResultsValue);
-
-    workflowValue = json_value_init_object();
-
-    if (lastInstallResultValue == NULL || stepResultsValue == NULL || workflowValue == NULL)
-    {
-        Log_Error("Failed to init object for json value");
-        goto done;
-    }
-
-    JSON_Status jsonStatus =
-        json_object_set_value(rootObject, ADUCITF_FIELDNAME_LASTINSTALLRESULT, lastInstallResultValue);
-    if (jsonStatus != JSONSuccess)
-    {
-        Log_Error("Could not add JSON field: %s", ADUCITF_FIELDNAME_LASTINSTALLRESULT);
-        goto done;
-    }
-
-    lastInstallResultValue = NULL; // rootObject owns the value now.
+    ADUC_JsonWriter_BeginObject(writer);
 
     //
     // State
     //
-    jsonStatus = json_object_set_number(rootObject, ADUCITF_FIELDNAME_STATE, updateState);
-    if (jsonStatus != JSONSuccess)
-    {
-        Log_Error("Could not add JSON field: %s", ADUCITF_FIELDNAME_STATE);
-        goto done;
-    }
+    ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_STATE);
+    ADUC_JsonWriter_WriteInt64(writer, updateState);
 
     //
     // Workflow
     //
     if (!IsNullOrEmpty(workflow_peek_id(handle)))
     {
-        bool success = set_workflow_properties(
-            workflowValue,
+        WriteWorkflowProperties(
+            writer,
             ADUC_WorkflowData_GetCurrentAction(workflowData),
             workflow_peek_id(handle),
             workflow_peek_retryTimestamp(handle));
-
-        if (!success)
-        {
-            goto done;
-        }
-
-        if (json_object_set_value(rootObject, ADUCITF_FIELDNAME_WORKFLOW, workflowValue) != JSONSuccess)
-        {
-            Log_Error("Could not add JSON : %s", ADUCITF_FIELDNAME_WORKFLOW);
-            goto done;
-        }
-
-        workflowValue = NULL; // rootObject owns the value now.
     }
 
     //
@@ -798,128 +745,57 @@ JSON_Value* GetReportingJsonValue(
     //
     if (installedUpdateId != NULL)
     {
-        jsonStatus = json_object_set_string(rootObject, ADUCITF_FIELDNAME_INSTALLEDUPDATEID, installedUpdateId);
-        if (jsonStatus != JSONSuccess)
-        {
-            Log_Error("Could not add JSON field: %s", ADUCITF_FIELDNAME_INSTALLEDUPDATEID);
-            goto done;
-        }
+        ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_INSTALLEDUPDATEID);
+        ADUC_JsonWriter_WriteString(writer, installedUpdateId);
     }
 
+    //
+    // Last install result, with the result of every step.
+    //
+    ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_LASTINSTALLRESULT);
+    ADUC_JsonWriter_BeginObject(writer);
+
+    WriteUpdateResult(
+        writer, rootResult, extraErcs != NULL ? STRING_c_str(extraErcs) : NULL, workflow_peek_result_details(handle));
+
     // If reporting 'downloadStarted' or 'ADUCITF_State_DeploymentInProgress' state, we must clear previous 'stepResults' map, if exists.
     if (updateState == ADUCITF_State_DownloadStarted || updateState == ADUCITF_State_DeploymentInProgress)
     {
-        if (json_object_set_null(lastInstallResultObject, ADUCITF_FIELDNAME_STEPRESULTS) != JSONSuccess)
-        {
-            /* Note: continue the 'download' phase if we could not clear the previous results. */
-            Log_Warn("Could not clear 'stepResults' property. The property may contains previous install results.");
-        }
+        ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_STEPRESULTS);
+        ADUC_JsonWriter_WriteNull(writer);
     }
     // Otherwise, we will only report 'stepResults' property if we have one or more step.
-    else if (stepsCount > 0)
+    else if (workflow_get_children_count(handle) > 0)
     {
-        jsonStatus = json_object_set_value(lastInstallResultObject, ADUCITF_FIELDNAME_STEPRESULTS, stepResultsValue);
-        if (jsonStatus != JSONSuccess)
-        {
-            Log_Error("Could not add JSON field: %s", ADUCITF_FIELDNAME_STEPRESULTS);
-            goto done;
-        }
-
-        stepResultsValue = NULL; // rootObject owns the value now.
+        ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_STEPRESULTS);
+        ADUC_JsonWriter_BeginObject(writer);
+        WriteStepResults(writer, handle);
+        ADUC_JsonWriter_EndObject(writer);
     }
 
+    ADUC_JsonWriter_EndObject(writer); // lastInstallResult
+
     //
-    // Report both state and result
+    // Per-phase deployment timings, once the deployment has ended.
     //
-
-    // Set top-level update state and result.
-    jsonStatus = _json_object_set_update_result(
-        lastInstallResultObject, rootResult.ResultCode, rootResultERCs, workflow_peek_result_details(handle));
-
-    if (jsonStatus != JSONSuccess)
+    if (handle != NULL && (updateState == ADUCITF_State_Idle || updateState == ADUCITF_State_Failed)
+        && IsDeploymentTimingReportingEnabled())
     {
-        goto done;
+        ADUC_JsonWriter_WriteKey(writer, ADUCITF_FIELDNAME_DEPLOYMENTTIMINGS);
+        ADUC_TimingReport_WritePhaseTotals(workflow_get_timing_report(handle), writer);
     }
 
-    // Report all steps result.
-    if (updateState != ADUCITF_State_DownloadStarted)
-    {
-        stepsCount = workflow_get_children_count(handle);
-        for (size_t i = 0; i < stepsCount; i++)
-        {
-            ADUC_WorkflowHandle childHandle = workflow_get_child(handle, i);
-            ADUC_Result childResult;
-            JSON_Value* childResultValue = NULL;
-            JSON_Object* childResultObject = NULL;
-            STRING_HANDLE childUpdateId = NULL;
-            STRING_HANDLE childExtendedResultCodes = NULL;
-
-            if (childHandle == NULL)
-            {
-                Log_Error("Could not get components #%d update result", i);
-                continue;
-            }
-
-            childResult = workflow_get_result(childHandle);
-
-            childResultValue = json_value_init_object();
-            childResultObject = json_object(childResultValue);
-            if (childResultValue == NULL)
-            {
-                Log_Error("Could not create components update result #%d", i);
-                goto childDone;
-            }
-
-            // Note: IoTHub twin doesn't support some special characters in a map key (e.g. ':', '-').
-            // Let's name the result using "step_" +  the array index.
-            childUpdateId = STRING_construct_sprintf("step_%d", i);
-            if (childUpdateId == NULL)
-            {
-                Log_Error("Could not create proper child update id result key.");
-                goto childDone;
-            }
-
-            jsonStatus = json_object_set_value(stepResultsObject, STRING_c_str(childUpdateId), childResultValue);
-            if (jsonStatus != JSONSuccess)
-            {
-                Log_Error("Could not add step #%d update result", i);
-                goto childDone;
-            }
-            childResultValue = NULL; // stepResultsValue owns it now.
+    ADUC_JsonWriter_EndObject(writer); // root
 
-            childExtendedResultCodes =
-                ADUC_ReportingUtils_CreateReportingErcHexStr(childResult.ExtendedResultCode, true /* is_first */);
-            jsonStatus = _json_object_set_update_result(
-                childResultObject,
-                childResult.ResultCode,
-                childExtendedResultCodes,
-                workflow_peek_result_details(childHandle));
+    STRING_delete(extraErcs);
 
-            if (jsonStatus != JSONSuccess)
-            {
-                goto childDone;
-            }
-
-        childDone:
-            STRING_delete(childUpdateId);
-            STRING_delete(childExtendedResultCodes);
-            childUpdateId = NULL;
-            json_value_free(childResultValue);
-            childResultValue = NULL;
-        }
+    if (ADUC_JsonWriter_HasFailed(writer))
+    {
+        Log_Error("Failed to write reporting json");
+        return false;
     }
 
-    resultValue = rootValue;
-    rootValue = NULL;
-
-done:
-    json_value_free(rootValue);
-    json_value_free(lastInstallResultValue);
-    json_value_free(stepResultsValue);
-    json_value_free(workflowValue);
-    STRING_delete(rootResultERCs);
-
-    return resultValue;
+    return true;
 }
 
 /**
@@ -940,8 +816,8 @@ bool AzureDeviceUpdateCoreInterface_ReportStateAndResultAsync(
     bool success = false;
     ADUC_WorkflowData* workflowData = (ADUC_WorkflowData*)workflowDataToken;
 
-    JSON_Value* rootValue = NULL;
-    char* jsonString = NULL;
+    ADUC_JsonWriter writer;
+    memset(&writer, 0, sizeof(writer));
 
     if (g_iotHubClientHandleForADUComponent == NULL)
     {
@@ -961,31 +837,57 @@ bool AzureDeviceUpdateCoreInterface_ReportStateAndResultAsync(
         workflow_set_result(workflowData->WorkflowHandle, resultForSet);
     }
 
-    rootValue = GetReportingJsonValue(workflowData, updateState, result, installedUpdateId);
-    if (rootValue == NULL)
+    if (!ADUC_JsonWriter_Init(
+            &writer,
+            REPORTING_JSON_BASE_CAPACITY
+                + REPORTING_JSON_STEP_CAPACITY * workflow_get_children_count(workflowData->WorkflowHandle)))
     {
-        Log_Error("Failed to get reporting json value");
+        Log_Error("Failed to allocate reporting json buffer");
         goto done;
     }
 
-    jsonString = json_serialize_to_string(rootValue);
-    if (jsonString == NULL)
+    // Write the reported property patch, i.e. the PnP component wrapper around the 'agent' property, directly.
+    // See PnP_CreateReportedProperty().
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, g_aduPnPComponentName);
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, "__t");
+    ADUC_JsonWriter_WriteString(&writer, "c");
+    ADUC_JsonWriter_WriteKey(&writer, g_aduPnPComponentAgentPropertyName);
+
+    if (!WriteReportingJson(&writer, workflowData, updateState, result, installedUpdateId))
+    {
+        goto done;
+    }
+
+    ADUC_JsonWriter_EndObject(&writer);
+    ADUC_JsonWriter_EndObject(&writer);
+
+    // The D2C message takes ownership of the buffer; it is not copied again.
+    char* message = ADUC_JsonWriter_Detach(&writer);
+    if (message == NULL)
     {
-        Log_Error("Serializing JSON to string failed");
+        Log_Error("Failed to write reporting json");
         goto done;
     }
 
-    if (!ReportClientJsonProperty(ADUC_D2C_Message_Type_Device_Update_Result, jsonString, workflowData))
+    if (!ADUC_D2C_Message_SendOwnedAsync(
+            ADUC_D2C_Message_Type_Device_Update_Result,
+            &g_iotHubClientHandleForADUComponent,
+            message,
+            NULL /* responseCallback */,
+            OnUpdateResultD2CMessageCompleted,
+            NULL /* statusChangedCallback */,
+            NULL /* userData */))
     {
+        Log_Error("Unable to send update result.");
         goto done;
     }
 
     success = true;
 
 done:
-    json_value_free(rootValue);
-    json_free_serialized_string(jsonString);
-    // Don't free the persistenceData as that will be done by the startup logic that owns it.
+    ADUC_JsonWriter_Uninit(&writer);
 
     return success;
 }
@@ -8,12 +8,16 @@
  */
 
 #include "aduc/shutdown_service.h"
+#include "aduc/wakeup_utils.h"
 
 static bool s_isShuttingDown = false;
 
 void ADUC_ShutdownService_RequestShutdown()
 {
     s_isShuttingDown = true;
+
+    // Interrupt the main loop wait so that shutdown starts immediately.
+    ADUC_Wakeup_Signal();
 }
 
 bool ADUC_ShutdownService_ShouldKeepRunning()
@@ -20,6 +20,7 @@
 #include "aduc/device_info_interface.h"
 #include "aduc/extension_manager.h"
 #include "aduc/extension_utils.h"
+#include "aduc/hash_utils.h" // ADUC_DIGEST_CACHE_FILE_ENV
 #include "aduc/health_management.h"
 #include "aduc/https_proxy_utils.h"
 #include "aduc/iothub_communication_manager.h"
@@ -28,9 +29,10 @@
 #include "aduc/shutdown_service.h"
 #include "aduc/string_c_utils.h"
 #include "aduc/system_utils.h" // ADUC_SystemUtils_MkDirRecursiveDefault
+#include "aduc/wakeup_utils.h"
 #include "aducpal/stdlib.h" // setenv
 #include <azure_c_shared_utility/shared_util_options.h>
-#include <azure_c_shared_utility/threadapi.h> // ThreadAPI_Sleep
+#include <crypto_lib.h> // CryptoUtils_UninitSharedVerifyContext
 #include <ctype.h>
 #include <diagnostics_devicename.h>
 #include <diagnostics_interface.h>
@@ -74,6 +76,17 @@
  */
 #define RET_COLON_FOR_MISSING_OPTIONARG ":"
 
+/**
+ * @brief Main loop wait time while the IoT Hub client needs pumping (connecting, or D2C messages in flight).
+ */
+#define MAIN_LOOP_BUSY_WAIT_MS 100
+
+/**
+ * @brief Main loop wait time while idle. Bounds the latency of incoming twin updates and keeps the
+ * IoT Hub client's keep-alive serviced.
+ */
+#define MAIN_LOOP_IDLE_WAIT_MS 1000
+
 // Name of ADU Agent subcomponent that this device implements.
 static const char g_aduPnPComponentName[] = "deviceUpdate";
 
@@ -699,11 +712,22 @@ bool StartupAgent(const ADUC_LaunchArguments* launchArgs)
     ADUC_ConnectionInfo info;
     memset(&info, 0, sizeof(info));
 
+    if (!ADUC_Wakeup_Init())
+    {
+        Log_Warn("Cannot create main loop wakeup sources. Falling back to periodic polling.");
+    }
+
     if (!ADUC_D2C_Messaging_Init())
     {
         goto done;
     }
 
+    // Pending reported property patches can be merged into one; ACKs are always sent as submitted.
+    ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type_Device_Update_Result, true);
+    ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type_Device_Information, true);
+    ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type_Diagnostics, true);
+    ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type_Device_Properties, true);
+
     if (launchArgs->connectionString != NULL)
     {
         ADUC_ConnType connType = GetConnTypeFromConnectionString(launchArgs->connectionString);
@@ -822,6 +846,8 @@ void ShutdownAgent()
     DiagnosticsComponent_DestroyDeviceName();
     ADUC_Logging_Uninit();
     ExtensionManager_Uninit();
+    ADUC_Wakeup_Uninit();
+    CryptoUtils_UninitSharedVerifyContext();
 }
 
 /**
@@ -922,6 +948,9 @@ int main(int argc, char** argv)
 
     ADUCPAL_setenv(ADUC_CONFIG_FOLDER_ENV, launchArgs.configFolder, 1);
 
+    // Persist verified file digests, for this module and the extensions the agent loads.
+    ADUCPAL_setenv(ADUC_DIGEST_CACHE_FILE_ENV, ADUC_DIGEST_CACHE_FILE_PATH, 1);
+
     const ADUC_ConfigInfo* config = ADUC_ConfigInfo_GetInstance();
     if (config == NULL)
     {
@@ -1094,8 +1123,14 @@ int main(int argc, char** argv)
         // See: https://github.com/Azure/azure-iot-sdk-c/tree/master/iothub_client/samples
         // NOTE: For this example the above has been wrapped to support module and device client methods using
         // the client_handle_helper.h function ClientHandle_DoWork()
-
-        ThreadAPI_Sleep(100);
+        //
+        // The LL client exposes no socket to wait on, so it is pumped at that rate only while connecting or while
+        // D2C messages are in flight. Otherwise the loop sleeps until new D2C messages, worker thread completions,
+        // D2C retry timers or a shutdown request wake it, polling only occasionally for incoming twin updates.
+        const bool isBusy =
+            !IoTHub_CommunicationManager_IsAuthenticated() || ADUC_D2C_Messaging_HasInFlightMessages();
+
+        ADUC_Wakeup_Wait(isBusy ? MAIN_LOOP_BUSY_WAIT_MS : MAIN_LOOP_IDLE_WAIT_MS);
     };
 
     ret = 0; // Success.
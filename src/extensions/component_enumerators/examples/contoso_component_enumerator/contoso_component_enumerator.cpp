@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <sstream>
 #include <string.h>
+#include <sys/stat.h> // stat
 
 /*
 
@@ -135,6 +136,25 @@ static JSON_Value* _GetAllComponentsFromFile(const char* configFilepath)
     return rootValue;
 }
 
+/**
+ * @brief Appends the modification time, size and inode of @p filePath to @p version.
+ */
+static void _AppendFileVersion(std::stringstream& version, const char* filePath)
+{
+    struct stat st
+    {
+    };
+
+    if (stat(filePath, &st) == 0)
+    {
+        version << st.st_mtime << "." << st.st_size << "." << st.st_ino << ";";
+    }
+    else
+    {
+        version << "-;";
+    }
+}
+
 static bool _json_object_contains_named_value(JSON_Object* jsonObject, const char* name, const char* value)
 {
     if (!(jsonObject != nullptr && name != nullptr && *name != 0 && value != nullptr && *value != 0))
@@ -207,6 +227,7 @@ EXPORTED_METHOD char* SelectComponents(const char* selectorJson)
             if (!matched)
             {
                 json_array_remove(componentsArray, (size_t)i);
+                break;
             }
         }
     }
@@ -234,6 +255,42 @@ EXPORTED_METHOD char* GetAllComponents()
     return returnString;
 }
 
+/**
+ * @brief Returns a version string of the component inventory.
+ * For demonstration purposes, the version is made of the inventory file's and every component's
+ * firmware data file's modification time, size and inode, since GetAllComponents reads all of them.
+ *
+ * @return Returns the version string. Caller must call FreeComponentsDataString function when done with it.
+ */
+EXPORTED_METHOD char* GetComponentsVersion()
+{
+    std::stringstream version;
+    _AppendFileVersion(version, g_contosoComponentInventoryFilePath);
+
+    JSON_Value* rootValue = json_parse_file(g_contosoComponentInventoryFilePath);
+    JSON_Array* components = json_object_get_array(json_object(rootValue), "components");
+    for (size_t i = 0; i < json_array_get_count(components); i++)
+    {
+        JSON_Object* properties = json_object_get_object(json_array_get_object(components, i), "properties");
+        const char* path = json_object_get_string(properties, "path");
+        const char* firmwareDataFile = json_object_get_string(properties, "firmwareDataFile");
+        if (path != nullptr && firmwareDataFile != nullptr)
+        {
+            std::stringstream propsFile;
+            propsFile << path << "/" << firmwareDataFile;
+            _AppendFileVersion(version, propsFile.str().c_str());
+        }
+    }
+
+    json_value_free(rootValue);
+
+    // Allocated with parson's allocator, since FreeComponentsDataString frees it with json_free_serialized_string.
+    JSON_Value* versionValue = json_value_init_string(version.str().c_str());
+    char* versionString = json_serialize_to_string(versionValue);
+    json_value_free(versionValue);
+    return versionString;
+}
+
 /**
  * @brief Frees the components data string allocated by GetAllComponents.
  *
@@ -31,6 +31,25 @@ EXPORTED_METHOD ADUC_Result Download(
     return Download_curl(entity, workflowId, workFolder, timeoutInSeconds, downloadProgressCallback);
 }
 
+EXPORTED_METHOD ADUC_Result DownloadWithDigest(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64,
+    size_t digestBase64Size)
+{
+    return Download_curl(
+        entity,
+        workflowId,
+        workFolder,
+        timeoutInSeconds,
+        downloadProgressCallback,
+        digestBase64,
+        digestBase64Size);
+}
+
 EXPORTED_METHOD ADUC_Result Initialize(const char* initializeData)
 {
     UNREFERENCED_PARAMETER(initializeData);
@@ -10,8 +10,11 @@
 #include "aduc/contract_utils.h"
 #include "aduc/hash_utils.h"
 #include "aduc/logging.h"
-#include "aduc/process_utils.hpp" // for ADUC_LaunchChildProcess
+#include "aduc/process_utils.hpp" // for ADUC_LaunchChildProcessStreamOutput
 
+#include <cstdio> // for FILE, fopen, fwrite
+#include <cstdlib> // for EXIT_FAILURE
+#include <cstring> // for strcmp, strlen, memcpy
 #include <sstream>
 #include <sys/stat.h> // for stat
 #include <vector>
@@ -19,22 +22,95 @@
 // keep this last to minimize chance to interfere with system header includes.
 #include "aduc/aduc_banned.h"
 
+/**
+ * @brief Copies @p digest to the caller's @p digestBase64 buffer, if one was provided.
+ */
+static void CopyDigestToOutput(const char* digest, char* digestBase64, size_t digestBase64Size)
+{
+    if (digestBase64 == nullptr || digestBase64Size == 0)
+    {
+        return;
+    }
+
+    const size_t digestSize = strlen(digest) + 1;
+    if (digestSize > digestBase64Size)
+    {
+        digestBase64[0] = '\0';
+        return;
+    }
+
+    memcpy(digestBase64, digest, digestSize);
+}
+
+/**
+ * @brief Runs curl with the payload streamed through its stdout, writing it to @p filePath
+ * and feeding the same buffers to @p hashStream.
+ *
+ * @param uri The URI to download.
+ * @param filePath The output file path.
+ * @param hashStream The hash stream that receives every byte written to the file.
+ * @param[out] writeFailed Set to true if writing to the file or hashing failed.
+ * @return int The curl exit code.
+ */
+static int StreamDownloadToFile(
+    const char* uri, const char* filePath, ADUC_HashStreamHandle hashStream, bool* writeFailed)
+{
+    *writeFailed = false;
+
+    FILE* file = fopen(filePath, "wb");
+    if (file == nullptr)
+    {
+        Log_Error("Cannot open '%s' for writing.", filePath);
+        *writeFailed = true;
+        return EXIT_FAILURE;
+    }
+
+    std::vector<std::string> args;
+    args.emplace_back(uri);
+
+    const int exitCode = ADUC_LaunchChildProcessStreamOutput(
+        "/usr/bin/curl", args, [file, hashStream, writeFailed](const uint8_t* data, size_t size) -> bool {
+            if (fwrite(data, 1, size, file) != size || !ADUC_HashUtils_HashStream_Update(hashStream, data, size))
+            {
+                *writeFailed = true;
+                return false;
+            }
+
+            return true;
+        });
+
+    if (fclose(file) != 0)
+    {
+        *writeFailed = true;
+    }
+
+    return exitCode;
+}
+
 ADUC_Result Download_curl(
     const ADUC_FileEntity* entity,
     const char* workflowId,
     const char* workFolder,
     unsigned int timeoutInSeconds,
-    ADUC_DownloadProgressCallback downloadProgressCallback)
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64,
+    size_t digestBase64Size)
 {
     UNREFERENCED_PARAMETER(timeoutInSeconds);
     ADUC_Result result = { ADUC_Result_Failure };
     SHAversion algVersion;
-    std::vector<std::string> args;
-    std::string output;
     int exitCode = 1;
     std::stringstream fullFilePath;
     bool isValidHash;
     bool reportProgress = false;
+    bool writeFailed = false;
+    ADUC_HashStreamHandle hashStream = nullptr;
+    char computedHash[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE] = {};
+
+    if (digestBase64 != nullptr && digestBase64Size > 0)
+    {
+        digestBase64[0] = '\0';
+    }
 
     if (entity == nullptr)
     {
@@ -97,6 +173,8 @@ ADUC_Result Download_curl(
 
     if (isValidHash)
     {
+        CopyDigestToOutput(
+            ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0), digestBase64, digestBase64Size);
         result = { ADUC_Result_Download_Skipped_FileExists };
         reportProgress = true;
         goto done;
@@ -108,18 +186,28 @@ ADUC_Result Download_curl(
         entity->DownloadUri,
         fullFilePath.str().c_str());
 
-    args.emplace_back("-o");
-    args.emplace_back(fullFilePath.str().c_str());
-    args.emplace_back("-O");
-    args.emplace_back(entity->DownloadUri);
+    hashStream = ADUC_HashUtils_HashStream_Create(algVersion);
+    if (hashStream == nullptr)
+    {
+        result.ExtendedResultCode = ADUC_ERC_NOMEM;
+        reportProgress = true;
+        goto done;
+    }
 
-    exitCode = ADUC_LaunchChildProcess("/usr/bin/curl", args, output);
+    // The payload is hashed from the same buffers that are written to disk,
+    // so the file never has to be read back for validation.
+    exitCode = StreamDownloadToFile(entity->DownloadUri, fullFilePath.str().c_str(), hashStream, &writeFailed);
 
-    if (exitCode == 0)
+    if (writeFailed)
     {
-        result = { ADUC_Result_Download_Success };
+        Log_Error("Failed to write '%s'.", fullFilePath.str().c_str());
+        result.ResultCode = ADUC_Result_Failure;
+        result.ExtendedResultCode = ADUC_ERROR_CURL_DOWNLOADER_FILE_WRITE_FAILURE;
+        reportProgress = true;
+        goto done;
     }
-    else
+
+    if (exitCode != 0)
     {
         result.ResultCode = ADUC_Result_Failure;
         result.ExtendedResultCode = ADUC_ERROR_CURL_DOWNLOADER_EXTERNAL_FAILURE(exitCode);
@@ -127,34 +215,29 @@ ADUC_Result Download_curl(
         goto done;
     }
 
-    Log_Info("Download output:: \n%s", output.c_str());
+    // Note: Currently we expect there to be only one hash, but
+    // support for multiple hashes is already built in.
+    Log_Info("Validating file hash");
 
-    // If we downloaded successfully, validate the file hash.
-    if (IsAducResultCodeSuccess(result.ResultCode))
+    if (!ADUC_HashUtils_HashStream_GetResult(hashStream, computedHash, sizeof(computedHash))
+        || strcmp(computedHash, ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0)) != 0)
     {
-        // Note: Currently we expect there to be only one hash, but
-        // support for multiple hashes is already built in.
-        Log_Info("Validating file hash");
+        Log_Error("Hash for %s is not valid", entity->TargetFilename);
 
-        const bool isValid = ADUC_HashUtils_IsValidFileHash(
-            fullFilePath.str().c_str(),
-            ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0),
-            algVersion,
-            true /* suppressErrorLog */);
+        result.ResultCode = ADUC_Result_Failure;
+        result.ExtendedResultCode = ADUC_ERC_VALIDATION_FILE_HASH_INVALID_HASH;
+        reportProgress = true;
+        goto done;
+    }
 
-        if (!isValid)
-        {
-            Log_Error("Hash for %s is not valid", entity->TargetFilename);
+    CopyDigestToOutput(computedHash, digestBase64, digestBase64Size);
 
-            result.ResultCode = ADUC_Result_Failure;
-            result.ExtendedResultCode = ADUC_ERC_VALIDATION_FILE_HASH_INVALID_HASH;
-            reportProgress = true;
-            goto done;
-        }
-    }
+    result = { ADUC_Result_Download_Success };
 
 done:
 
+    ADUC_HashUtils_HashStream_Free(hashStream);
+
     if (reportProgress && (downloadProgressCallback != nullptr))
     {
         if (IsAducResultCodeSuccess(result.ResultCode))
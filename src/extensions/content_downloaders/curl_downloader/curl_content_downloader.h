@@ -3,9 +3,25 @@
 #include <aduc/types/download.h> // for ADUC_DownloadProgressCallback
 #include <aduc/types/update_content.h> // for ADUC_FileEntity
 
+#include <cstddef> // for size_t
+
+/**
+ * @brief Downloads @p entity with curl, hashing the payload as it is written to disk.
+ *
+ * @param entity The file entity.
+ * @param workflowId The workflow id.
+ * @param workFolder The work folder for the update payloads.
+ * @param timeoutInSeconds The download timeout.
+ * @param downloadProgressCallback The download progress callback function.
+ * @param digestBase64 Optional output buffer that receives the base64 encoded digest of the downloaded content.
+ * @param digestBase64Size The size of @p digestBase64.
+ * @return ADUC_Result The result.
+ */
 ADUC_Result Download_curl(
     const ADUC_FileEntity* entity,
     const char* workflowId,
     const char* workFolder,
     unsigned int timeoutInSeconds,
-    ADUC_DownloadProgressCallback downloadProgressCallback);
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64 = nullptr,
+    size_t digestBase64Size = 0);
@@ -119,6 +119,31 @@ EXPORTED_METHOD ADUC_Result Download(
     return do_download(entity, workflowId, workFolder, timeoutInSeconds, downloadProgressCallback);
 }
 
+/**
+ * @brief The download export that also returns the digest of the downloaded content.
+ *
+ * @param entity The file entity.
+ * @param workflowId The workflow id.
+ * @param workFolder The work folder for the update payloads.
+ * @param timeoutInSeconds * The maximum number of seconds the content downloader should wait for receiving data (whilst the network interface stays up).
+ * @param downloadProgressCallback The download progress callback function.
+ * @param digestBase64 The output buffer for the base64 encoded digest of the downloaded content.
+ * @param digestBase64Size The size of @p digestBase64.
+ * @return ADUC_Result The result.
+ */
+EXPORTED_METHOD ADUC_Result DownloadWithDigest(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64,
+    size_t digestBase64Size)
+{
+    return do_download(
+        entity, workflowId, workFolder, timeoutInSeconds, downloadProgressCallback, digestBase64, digestBase64Size);
+}
+
 //
 // END Shared Library Export Functions
 /////////////////////////////////////////////////////////////////////////////
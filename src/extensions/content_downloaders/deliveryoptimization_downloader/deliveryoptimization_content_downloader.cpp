@@ -14,6 +14,7 @@
 
 #include <stdio.h> // for FILE
 #include <stdlib.h> // for calloc
+#include <string.h> // for strcmp, strlen, memcpy
 #include <sys/stat.h> // for stat
 #include <vector>
 
@@ -35,11 +36,18 @@ ADUC_Result do_download(
     const char* workflowId,
     const char* workFolder,
     unsigned int timeoutInSeconds,
-    ADUC_DownloadProgressCallback downloadProgressCallback)
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64,
+    size_t digestBase64Size)
 {
     ADUC_Result_t resultCode = ADUC_Result_Failure;
     ADUC_Result_t extendedResultCode = ADUC_ERC_NOTRECOVERABLE;
 
+    if (digestBase64 != nullptr && digestBase64Size > 0)
+    {
+        digestBase64[0] = '\0';
+    }
+
     if (entity->HashCount == 0)
     {
         Log_Error("File entity does not contain a file hash! Cannot validate cancelling download.");
@@ -119,11 +127,19 @@ ADUC_Result do_download(
             return ADUC_Result{ resultCode, extendedResultCode };
         }
 
-        const bool isValid = ADUC_HashUtils_IsValidFileHash(
-            fullFilePath.c_str(),
-            ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0),
-            algVersion,
-            false /* suppressErrorLog */);
+        // DO writes the file itself, so hash it once here and hand the digest back to the caller
+        // rather than having the agent read the file again.
+        char* fileHash = nullptr;
+        const char* expectedHash = ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0);
+        const bool isValid = ADUC_HashUtils_GetFileHash(fullFilePath.c_str(), algVersion, &fileHash)
+            && strcmp(fileHash, expectedHash) == 0;
+
+        if (isValid && digestBase64 != nullptr && strlen(fileHash) < digestBase64Size)
+        {
+            memcpy(digestBase64, fileHash, strlen(fileHash) + 1);
+        }
+
+        free(fileHash);
 
         if (!isValid)
         {
@@ -5,11 +5,15 @@
 #include <aduc/types/download.h> // for ADUC_DownloadProgressCallback
 #include <aduc/types/update_content.h> // for ADUC_FileEntity
 
+#include <cstddef> // for size_t
+
 ADUC_Result do_download(
     const ADUC_FileEntity* entity,
     const char* workflowId,
     const char* workFolder,
     unsigned int timeoutInSeconds,
-    ADUC_DownloadProgressCallback downloadProgressCallback);
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64 = nullptr,
+    size_t digestBase64Size = 0);
 
 #endif // DELIVERYOPTIMIZATION_CONTENT_DOWNLOADER_HELPERS_H
@@ -0,0 +1,83 @@
+/**
+ * @file http_content_downloader.EXPORTS.cpp
+ * @brief The exports for the HTTP Content Downloader Extension.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#include "http_content_downloader.h" // for HttpDownloader_Download
+#include <aduc/c_utils.h> // for EXTERN_C_BEGIN, EXTERN_C_END
+#include <aduc/contract_utils.h> // for ADUC_ExtensionContractInfo
+#include <aduc/types/download.h> // for ADUC_DownloadProgressCallback
+#include <aduc/types/update_content.h> // for ADUC_FileEntity
+
+EXTERN_C_BEGIN
+
+/////////////////////////////////////////////////////////////////////////////
+// BEGIN Shared Library Export Functions
+//
+// These are the function symbols that the device update agent will
+// lookup and call.
+//
+
+EXPORTED_METHOD ADUC_Result Download(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback)
+{
+    return HttpDownloader_Download(entity, workflowId, workFolder, timeoutInSeconds, downloadProgressCallback);
+}
+
+EXPORTED_METHOD ADUC_Result DownloadWithDigest(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64,
+    size_t digestBase64Size)
+{
+    return HttpDownloader_Download(
+        entity,
+        workflowId,
+        workFolder,
+        timeoutInSeconds,
+        downloadProgressCallback,
+        digestBase64,
+        digestBase64Size);
+}
+
+/**
+ * @brief Tells the agent that downloads may run concurrently.
+ * Each call uses its own curl handle, download context and target file; curl_global_init runs once.
+ *
+ * @return bool true.
+ */
+EXPORTED_METHOD bool SupportsConcurrentCalls()
+{
+    return true;
+}
+
+EXPORTED_METHOD ADUC_Result Initialize(const char* initializeData)
+{
+    UNREFERENCED_PARAMETER(initializeData);
+    return HttpDownloader_Initialize();
+}
+
+/**
+ * @brief Gets the extension contract info.
+ *
+ * @param[out] contractInfo The extension contract info.
+ * @return ADUC_Result The result.
+ */
+EXPORTED_METHOD ADUC_Result GetContractInfo(ADUC_ExtensionContractInfo* contractInfo)
+{
+    contractInfo->majorVer = ADUC_V1_CONTRACT_MAJOR_VER;
+    contractInfo->minorVer = ADUC_V1_CONTRACT_MINOR_VER;
+    return ADUC_Result{ ADUC_GeneralResult_Success, 0 };
+}
+
+EXTERN_C_END
@@ -0,0 +1,595 @@
+/**
+ * @file http_content_downloader.cpp
+ * @brief Content Downloader Extension using in-process libcurl, with HTTP range resume.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#include "http_content_downloader.h"
+
+#include "aduc/content_downloader_extension.hpp"
+#include "aduc/contract_utils.h"
+#include "aduc/hash_utils.h"
+#include "aduc/logging.h"
+
+#include <chrono>
+#include <cstdio> // for FILE, fopen, fwrite, remove, rename
+#include <cstring> // for strcmp, strlen, memcpy
+#include <memory> // for std::unique_ptr
+#include <mutex> // for std::call_once
+#include <string>
+#include <sys/stat.h> // for stat
+#include <thread> // for std::this_thread::sleep_for
+#include <unistd.h> // for ftruncate
+
+#include <curl/curl.h>
+
+// keep this last to minimize chance to interfere with system header includes.
+#include "aduc/aduc_banned.h"
+
+/**
+ * @brief The maximum number of transfer attempts per Download call.
+ * Each attempt after the first resumes from the end of the partial file.
+ */
+static const unsigned int MaxTransferAttempts = 5;
+
+#ifndef HTTP_DOWNLOADER_INITIAL_RETRY_DELAY_MS
+/**
+ * @brief The delay before the first retry, in milliseconds. Doubles on each subsequent retry.
+ */
+#    define HTTP_DOWNLOADER_INITIAL_RETRY_DELAY_MS 2000
+#endif
+
+/**
+ * @brief The minimum interval between InProgress progress reports.
+ */
+static const std::chrono::seconds ProgressReportInterval{ 1 };
+
+/**
+ * @brief The size of the buffer used to re-hash an existing partial file before resuming.
+ */
+static const size_t PartialFileReadBufferSize = 64 * 1024;
+
+static std::once_flag s_curlInitOnce;
+static CURLcode s_curlInitResult = CURLE_FAILED_INIT;
+
+/**
+ * @brief The state shared with the libcurl callbacks for a single download.
+ */
+struct HttpDownloadContext
+{
+    CURL* curl = nullptr; //!< The easy handle of the current transfer.
+    FILE* file = nullptr; //!< The partial file.
+    ADUC_HashStreamHandle hashStream = nullptr; //!< Hash of all bytes in the partial file.
+    SHAversion algorithm = SHA256; //!< The hash algorithm.
+    curl_off_t bytesInFile = 0; //!< Number of bytes in the partial file.
+    curl_off_t transferStartOffset = 0; //!< The offset requested with the Range header for the current transfer.
+    bool responseChecked = false; //!< Whether the response code of the current transfer was checked.
+    bool writeFailed = false; //!< Whether writing to the file or hashing failed.
+
+    const char* workflowId = nullptr; //!< The workflow id for progress reports.
+    const char* fileId = nullptr; //!< The file id for progress reports.
+    uint64_t bytesTotal = 0; //!< The expected file size.
+    ADUC_DownloadProgressCallback progressCallback = nullptr; //!< The progress callback.
+    std::chrono::steady_clock::time_point lastProgressReport; //!< Time of the last InProgress report.
+};
+
+/**
+ * @brief Copies @p digest to the caller's @p digestBase64 buffer, if one was provided.
+ */
+static void CopyDigestToOutput(const char* digest, char* digestBase64, size_t digestBase64Size)
+{
+    if (digestBase64 == nullptr || digestBase64Size == 0)
+    {
+        return;
+    }
+
+    const size_t digestSize = strlen(digest) + 1;
+    if (digestSize > digestBase64Size)
+    {
+        digestBase64[0] = '\0';
+        return;
+    }
+
+    memcpy(digestBase64, digest, digestSize);
+}
+
+/**
+ * @brief Discards the partial file content and the hash computed so far, so the download starts over.
+ * @return bool true on success.
+ */
+static bool RestartPartialFile(HttpDownloadContext* ctx)
+{
+    ADUC_HashUtils_HashStream_Free(ctx->hashStream);
+    ctx->hashStream = ADUC_HashUtils_HashStream_Create(ctx->algorithm);
+    ctx->bytesInFile = 0;
+
+    if (ctx->hashStream == nullptr)
+    {
+        return false;
+    }
+
+    if (ctx->file != nullptr)
+    {
+        if (fflush(ctx->file) != 0 || ftruncate(fileno(ctx->file), 0) != 0 || fseek(ctx->file, 0, SEEK_SET) != 0)
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Seeds the hash stream with the content of an existing partial file.
+ * @return bool true on success.
+ */
+static bool HashExistingPartialFile(const char* partialFilePath, HttpDownloadContext* ctx)
+{
+    FILE* file = fopen(partialFilePath, "rb");
+    if (file == nullptr)
+    {
+        return false;
+    }
+
+    bool success = true;
+    std::unique_ptr<uint8_t[]> buffer{ new uint8_t[PartialFileReadBufferSize] };
+    curl_off_t total = 0;
+
+    for (;;)
+    {
+        const size_t readSize = fread(buffer.get(), 1, PartialFileReadBufferSize, file);
+        if (readSize == 0)
+        {
+            success = (ferror(file) == 0);
+            break;
+        }
+
+        if (!ADUC_HashUtils_HashStream_Update(ctx->hashStream, buffer.get(), readSize))
+        {
+            success = false;
+            break;
+        }
+
+        total += static_cast<curl_off_t>(readSize);
+    }
+
+    fclose(file);
+
+    ctx->bytesInFile = total;
+    return success;
+}
+
+/**
+ * @brief libcurl write callback. Writes the received data to the partial file and the hash stream.
+ */
+static size_t WriteCallback(char* data, size_t size, size_t nmemb, void* userdata)
+{
+    auto ctx = static_cast<HttpDownloadContext*>(userdata);
+    const size_t byteCount = size * nmemb;
+
+    if (!ctx->responseChecked)
+    {
+        ctx->responseChecked = true;
+
+        long responseCode = 0;
+        curl_easy_getinfo(ctx->curl, CURLINFO_RESPONSE_CODE, &responseCode);
+
+        // A server that ignores the Range header sends the whole content, e.g. with 200 OK.
+        if (ctx->transferStartOffset > 0 && responseCode != 206)
+        {
+            Log_Info("Server does not support range requests. Restarting download from the beginning.");
+            if (!RestartPartialFile(ctx))
+            {
+                ctx->writeFailed = true;
+                return 0;
+            }
+        }
+    }
+
+    if (fwrite(data, 1, byteCount, ctx->file) != byteCount
+        || !ADUC_HashUtils_HashStream_Update(ctx->hashStream, reinterpret_cast<const uint8_t*>(data), byteCount))
+    {
+        ctx->writeFailed = true;
+        return 0; // Signals an error to libcurl.
+    }
+
+    ctx->bytesInFile += static_cast<curl_off_t>(byteCount);
+    return byteCount;
+}
+
+/**
+ * @brief libcurl transfer info callback. Drives the download progress callback.
+ */
+static int TransferInfoCallback(
+    void* userdata, curl_off_t dltotal, curl_off_t dlnow, curl_off_t ultotal, curl_off_t ulnow)
+{
+    UNREFERENCED_PARAMETER(dltotal);
+    UNREFERENCED_PARAMETER(dlnow);
+    UNREFERENCED_PARAMETER(ultotal);
+    UNREFERENCED_PARAMETER(ulnow);
+
+    auto ctx = static_cast<HttpDownloadContext*>(userdata);
+    if (ctx->progressCallback == nullptr)
+    {
+        return 0;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    if (now - ctx->lastProgressReport >= ProgressReportInterval)
+    {
+        ctx->lastProgressReport = now;
+        ctx->progressCallback(
+            ctx->workflowId,
+            ctx->fileId,
+            ADUC_DownloadProgressState_InProgress,
+            static_cast<uint64_t>(ctx->bytesInFile),
+            ctx->bytesTotal);
+    }
+
+    return 0;
+}
+
+/**
+ * @brief Whether a failed transfer is worth resuming.
+ *
+ * @param code The libcurl result.
+ * @param responseCode The HTTP response code, for CURLE_HTTP_RETURNED_ERROR.
+ * Server errors (5xx) and throttling (429) are transient; other 4xx responses are final.
+ */
+static bool IsRetriableCurlError(CURLcode code, long responseCode)
+{
+    switch (code)
+    {
+    case CURLE_HTTP_RETURNED_ERROR:
+        return responseCode >= 500 || responseCode == 429;
+    case CURLE_COULDNT_RESOLVE_HOST:
+    case CURLE_COULDNT_CONNECT:
+    case CURLE_OPERATION_TIMEDOUT:
+    case CURLE_PARTIAL_FILE:
+    case CURLE_RECV_ERROR:
+    case CURLE_SEND_ERROR:
+    case CURLE_GOT_NOTHING:
+    case CURLE_HTTP2:
+    case CURLE_HTTP2_STREAM:
+        return true;
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Runs a single transfer, appending to the partial file from ctx->bytesInFile.
+ *
+ * @param uri The URI to download.
+ * @param timeoutInSeconds Abort if no data is received for this many seconds.
+ * @param ctx The download context.
+ * @param[out] responseCode The HTTP response code.
+ * @return CURLcode The libcurl result.
+ */
+static CURLcode RunTransfer(
+    const char* uri, unsigned int timeoutInSeconds, HttpDownloadContext* ctx, long* responseCode)
+{
+    *responseCode = 0;
+
+    CURL* curl = curl_easy_init();
+    if (curl == nullptr)
+    {
+        return CURLE_FAILED_INIT;
+    }
+
+    ctx->curl = curl;
+    ctx->transferStartOffset = ctx->bytesInFile;
+    ctx->responseChecked = false;
+
+    curl_easy_setopt(curl, CURLOPT_URL, uri);
+    curl_easy_setopt(curl, CURLOPT_FOLLOWLOCATION, 1L);
+    curl_easy_setopt(curl, CURLOPT_FAILONERROR, 1L);
+    curl_easy_setopt(curl, CURLOPT_NOSIGNAL, 1L);
+    curl_easy_setopt(curl, CURLOPT_WRITEFUNCTION, WriteCallback);
+    curl_easy_setopt(curl, CURLOPT_WRITEDATA, ctx);
+    curl_easy_setopt(curl, CURLOPT_NOPROGRESS, 0L);
+    curl_easy_setopt(curl, CURLOPT_XFERINFOFUNCTION, TransferInfoCallback);
+    curl_easy_setopt(curl, CURLOPT_XFERINFODATA, ctx);
+
+    if (timeoutInSeconds > 0)
+    {
+        // The timeout is for receiving data while the network is up, not for the whole transfer,
+        // so a large payload over a slow link is not aborted as long as it keeps making progress.
+        curl_easy_setopt(curl, CURLOPT_CONNECTTIMEOUT, static_cast<long>(timeoutInSeconds));
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_LIMIT, 1L);
+        curl_easy_setopt(curl, CURLOPT_LOW_SPEED_TIME, static_cast<long>(timeoutInSeconds));
+    }
+
+    if (ctx->bytesInFile > 0)
+    {
+        // Set the Range header directly rather than CURLOPT_RESUME_FROM_LARGE. With the latter, libcurl fails
+        // a transfer answered with 200 OK (CURLE_RANGE_ERROR) and treats 416 as success, so neither could be
+        // recovered from by starting over.
+        const std::string range = std::to_string(static_cast<long long>(ctx->bytesInFile)) + "-";
+        Log_Info("Resuming download at offset %lld", static_cast<long long>(ctx->bytesInFile));
+        curl_easy_setopt(curl, CURLOPT_RANGE, range.c_str());
+    }
+
+    const CURLcode code = curl_easy_perform(curl);
+
+    curl_easy_getinfo(curl, CURLINFO_RESPONSE_CODE, responseCode);
+    curl_easy_cleanup(curl);
+    ctx->curl = nullptr;
+
+    return code;
+}
+
+ADUC_Result HttpDownloader_Initialize()
+{
+    std::call_once(s_curlInitOnce, []() { s_curlInitResult = curl_global_init(CURL_GLOBAL_DEFAULT); });
+
+    if (s_curlInitResult != CURLE_OK)
+    {
+        Log_Error("curl_global_init failed: %s", curl_easy_strerror(s_curlInitResult));
+        return ADUC_Result{ ADUC_GeneralResult_Failure, ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_INIT_FAILURE };
+    }
+
+    return ADUC_Result{ ADUC_GeneralResult_Success, 0 };
+}
+
+ADUC_Result HttpDownloader_Download(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64,
+    size_t digestBase64Size)
+{
+    ADUC_Result result = { ADUC_Result_Failure };
+    SHAversion algVersion;
+    std::string fullFilePath;
+    std::string partialFilePath;
+    HttpDownloadContext ctx;
+    CURLcode curlCode = CURLE_OK;
+    long responseCode = 0;
+    unsigned int retryDelayMs = HTTP_DOWNLOADER_INITIAL_RETRY_DELAY_MS;
+    const char* expectedHash = nullptr;
+    char computedHash[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE] = {};
+    struct stat st = {};
+
+    if (digestBase64 != nullptr && digestBase64Size > 0)
+    {
+        digestBase64[0] = '\0';
+    }
+
+    if (entity == nullptr)
+    {
+        result.ExtendedResultCode = ADUC_ERC_CONTENT_DOWNLOADER_INVALID_FILE_ENTITY;
+        return result;
+    }
+
+    if (entity->DownloadUri == nullptr || *entity->DownloadUri == 0)
+    {
+        result.ExtendedResultCode = ADUC_ERC_CONTENT_DOWNLOADER_INVALID_DOWNLOAD_URI;
+        goto done;
+    }
+
+    if (entity->HashCount == 0)
+    {
+        Log_Error("File entity does not contain a file hash! Cannot validate cancelling download.");
+        result.ExtendedResultCode = ADUC_ERC_VALIDATION_FILE_HASH_IS_EMPTY;
+        goto done;
+    }
+
+    result = HttpDownloader_Initialize();
+    if (IsAducResultCodeFailure(result.ResultCode))
+    {
+        goto done;
+    }
+
+    result = { ADUC_Result_Failure };
+
+    fullFilePath = std::string{ workFolder } + "/" + entity->TargetFilename;
+    partialFilePath = fullFilePath + ".partial";
+
+    if (!ADUC_HashUtils_GetShaVersionForTypeString(
+            ADUC_HashUtils_GetHashType(entity->Hash, entity->HashCount, 0), &algVersion))
+    {
+        Log_Error(
+            "FileEntity for %s has unsupported hash type %s",
+            fullFilePath.c_str(),
+            ADUC_HashUtils_GetHashType(entity->Hash, entity->HashCount, 0));
+        result.ExtendedResultCode = ADUC_ERC_VALIDATION_FILE_HASH_TYPE_NOT_SUPPORTED;
+        goto done;
+    }
+
+    expectedHash = ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0);
+
+    // If target file exists, validate file hash.
+    // If file is valid, then skip the download.
+    if (stat(fullFilePath.c_str(), &st) == 0
+        && ADUC_HashUtils_IsValidFileHash(fullFilePath.c_str(), expectedHash, algVersion, true /* suppressErrorLog */))
+    {
+        CopyDigestToOutput(expectedHash, digestBase64, digestBase64Size);
+        result = { ADUC_Result_Download_Skipped_FileExists };
+        goto done;
+    }
+
+    ctx.algorithm = algVersion;
+    ctx.workflowId = workflowId;
+    ctx.fileId = entity->FileId;
+    ctx.bytesTotal = entity->SizeInBytes;
+    ctx.progressCallback = downloadProgressCallback;
+    ctx.hashStream = ADUC_HashUtils_HashStream_Create(algVersion);
+    if (ctx.hashStream == nullptr)
+    {
+        result.ExtendedResultCode = ADUC_ERC_NOMEM;
+        goto done;
+    }
+
+    // Resume from a partial file left by an earlier, interrupted attempt.
+    if (stat(partialFilePath.c_str(), &st) == 0 && st.st_size > 0)
+    {
+        if (entity->SizeInBytes != 0 && static_cast<uint64_t>(st.st_size) > entity->SizeInBytes)
+        {
+            Log_Info("Discarding partial file larger than the expected size.");
+        }
+        else if (!HashExistingPartialFile(partialFilePath.c_str(), &ctx) && !RestartPartialFile(&ctx))
+        {
+            result.ExtendedResultCode = ADUC_ERC_NOMEM;
+            goto done;
+        }
+    }
+
+    ctx.file = fopen(partialFilePath.c_str(), (ctx.bytesInFile > 0) ? "ab" : "wb");
+    if (ctx.file == nullptr)
+    {
+        Log_Error("Cannot open '%s' for writing.", partialFilePath.c_str());
+        result.ExtendedResultCode = ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_FILE_WRITE_FAILURE;
+        goto done;
+    }
+
+    Log_Info("Downloading File '%s' from '%s' to '%s'", entity->TargetFilename, entity->DownloadUri, fullFilePath.c_str());
+
+    for (unsigned int attempt = 1; attempt <= MaxTransferAttempts; ++attempt)
+    {
+        // The partial content may already be complete, e.g. if the agent stopped before the rename.
+        if (entity->SizeInBytes != 0 && static_cast<uint64_t>(ctx.bytesInFile) == entity->SizeInBytes)
+        {
+            curlCode = CURLE_OK;
+            break;
+        }
+
+        curlCode = RunTransfer(entity->DownloadUri, timeoutInSeconds, &ctx, &responseCode);
+
+        if (fflush(ctx.file) != 0)
+        {
+            ctx.writeFailed = true;
+        }
+
+        if (curlCode == CURLE_OK || ctx.writeFailed)
+        {
+            break;
+        }
+
+        if (responseCode == 416)
+        {
+            // Range not satisfiable; the partial content does not match the resource. Start over.
+            Log_Info("Range not satisfiable at offset %lld.", static_cast<long long>(ctx.bytesInFile));
+            if (!RestartPartialFile(&ctx))
+            {
+                ctx.writeFailed = true;
+                break;
+            }
+        }
+        else if (!IsRetriableCurlError(curlCode, responseCode))
+        {
+            break;
+        }
+
+        Log_Warn(
+            "Transfer attempt %u of %u failed: %s (http %ld). %lld bytes downloaded so far.",
+            attempt,
+            MaxTransferAttempts,
+            curl_easy_strerror(curlCode),
+            responseCode,
+            static_cast<long long>(ctx.bytesInFile));
+
+        if (attempt < MaxTransferAttempts)
+        {
+            std::this_thread::sleep_for(std::chrono::milliseconds(retryDelayMs));
+            retryDelayMs *= 2;
+        }
+    }
+
+    if (fclose(ctx.file) != 0)
+    {
+        ctx.writeFailed = true;
+    }
+    ctx.file = nullptr;
+
+    if (ctx.writeFailed)
+    {
+        Log_Error("Failed to write '%s'.", partialFilePath.c_str());
+        result.ExtendedResultCode = ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_FILE_WRITE_FAILURE;
+        goto done;
+    }
+
+    if (curlCode != CURLE_OK)
+    {
+        // Keep the partial file so the next download attempt can resume from it.
+        Log_Error("Download failed: %s (http %ld)", curl_easy_strerror(curlCode), responseCode);
+        if (curlCode == CURLE_OPERATION_TIMEDOUT)
+        {
+            result.ExtendedResultCode = ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_TIMEOUT;
+        }
+        else if (curlCode == CURLE_HTTP_RETURNED_ERROR)
+        {
+            result.ExtendedResultCode = ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_HTTP_FAILURE(responseCode);
+        }
+        else
+        {
+            result.ExtendedResultCode = ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_CURL_FAILURE(curlCode);
+        }
+        goto done;
+    }
+
+    Log_Info("Validating file hash");
+
+    if (!ADUC_HashUtils_HashStream_GetResult(ctx.hashStream, computedHash, sizeof(computedHash))
+        || strcmp(computedHash, expectedHash) != 0)
+    {
+        Log_Error("Hash for %s is not valid", entity->TargetFilename);
+
+        // The content is bad, so there is nothing worth resuming.
+        remove(partialFilePath.c_str());
+        result.ExtendedResultCode = ADUC_ERC_VALIDATION_FILE_HASH_INVALID_HASH;
+        goto done;
+    }
+
+    if (rename(partialFilePath.c_str(), fullFilePath.c_str()) != 0)
+    {
+        Log_Error("Cannot move '%s' to '%s'.", partialFilePath.c_str(), fullFilePath.c_str());
+        result.ExtendedResultCode = ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_FILE_WRITE_FAILURE;
+        goto done;
+    }
+
+    CopyDigestToOutput(computedHash, digestBase64, digestBase64Size);
+
+    result = { ADUC_Result_Download_Success };
+
+done:
+
+    if (ctx.file != nullptr)
+    {
+        fclose(ctx.file);
+    }
+
+    ADUC_HashUtils_HashStream_Free(ctx.hashStream);
+
+    if (downloadProgressCallback != nullptr)
+    {
+        if (IsAducResultCodeSuccess(result.ResultCode))
+        {
+            const uint64_t fileSize{ (stat(fullFilePath.c_str(), &st) == 0) ? static_cast<uint64_t>(st.st_size)
+                                                                             : 0 };
+            downloadProgressCallback(
+                workflowId, entity->FileId, ADUC_DownloadProgressState_Completed, fileSize, entity->SizeInBytes);
+        }
+        else
+        {
+            downloadProgressCallback(
+                workflowId,
+                entity->FileId,
+                (result.ResultCode == ADUC_Result_Failure_Cancelled) ? ADUC_DownloadProgressState_Cancelled
+                                                                     : ADUC_DownloadProgressState_Error,
+                static_cast<uint64_t>(ctx.bytesInFile),
+                entity->SizeInBytes);
+        }
+    }
+
+    Log_Info(
+        "Download task end. resultCode: %d, extendedCode: %d (0x%X)",
+        result.ResultCode,
+        result.ExtendedResultCode,
+        result.ExtendedResultCode);
+    return result;
+}
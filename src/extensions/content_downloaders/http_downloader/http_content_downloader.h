@@ -0,0 +1,48 @@
+/**
+ * @file http_content_downloader.h
+ * @brief Content Downloader Extension using in-process libcurl, with HTTP range resume.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#ifndef HTTP_CONTENT_DOWNLOADER_H
+#define HTTP_CONTENT_DOWNLOADER_H
+
+#include <aduc/result.h> // for ADUC_Result
+#include <aduc/types/download.h> // for ADUC_DownloadProgressCallback
+#include <aduc/types/update_content.h> // for ADUC_FileEntity
+
+#include <cstddef> // for size_t
+
+/**
+ * @brief Performs one-time libcurl initialization.
+ * @return ADUC_Result The result.
+ */
+ADUC_Result HttpDownloader_Initialize();
+
+/**
+ * @brief Downloads @p entity with libcurl.
+ * @details Content is first written to '<target>.partial'. If a download is interrupted,
+ * the next attempt (in this call or a later one) resumes with an HTTP Range request instead of
+ * starting over. The payload is hashed as it is written, and the partial file is moved to the
+ * target file name only after its hash has been validated.
+ *
+ * @param entity The file entity.
+ * @param workflowId The workflow id.
+ * @param workFolder The work folder for the update payloads.
+ * @param timeoutInSeconds The maximum number of seconds to wait to receive data before the transfer times out.
+ * @param downloadProgressCallback The download progress callback function.
+ * @param digestBase64 Optional output buffer that receives the base64 encoded digest of the downloaded content.
+ * @param digestBase64Size The size of @p digestBase64.
+ * @return ADUC_Result The result.
+ */
+ADUC_Result HttpDownloader_Download(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64 = nullptr,
+    size_t digestBase64Size = 0);
+
+#endif // HTTP_CONTENT_DOWNLOADER_H
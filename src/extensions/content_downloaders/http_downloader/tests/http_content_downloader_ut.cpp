@@ -0,0 +1,403 @@
+/**
+ * @file http_content_downloader_ut.cpp
+ * @brief Unit tests for the HTTP content downloader's resume and retry behavior.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "http_content_downloader.h"
+
+#include <aduc/hash_utils.h>
+#include <aduc/result.h>
+#include <aduc/types/adu_core.h> // ADUC_Result_Download_Success
+#include <aduc/system_utils.h> // ADUC_SystemUtils_GetTemporaryPathName, ADUC_SystemUtils_RmDirRecursive
+
+#include <catch2/catch.hpp>
+
+#include <arpa/inet.h>
+#include <cstdlib> // mkdtemp
+#include <cstring> // strlen
+#include <fstream>
+#include <functional>
+#include <iterator>
+#include <mutex>
+#include <netinet/in.h>
+#include <sstream>
+#include <string>
+#include <sys/socket.h>
+#include <thread>
+#include <unistd.h>
+#include <vector>
+
+/**
+ * @brief A scripted response of the test HTTP server.
+ */
+struct TestResponse
+{
+    int status; //!< The HTTP status code.
+    std::string body; //!< The response body.
+    size_t bytesToSend; //!< Number of body bytes to send before dropping the connection.
+    std::string extraHeaders; //!< Additional header lines, each ending with CRLF.
+};
+
+/**
+ * @brief Builds a response that sends all of @p body.
+ */
+static TestResponse FullResponse(int status, const std::string& body)
+{
+    return TestResponse{ status, body, body.size(), "" };
+}
+
+/**
+ * @brief Builds a 206 Partial Content response with @p content from @p rangeStart to the end.
+ */
+static TestResponse RangeResponse(const std::string& content, long long rangeStart)
+{
+    const std::string body = content.substr(static_cast<size_t>(rangeStart));
+    std::stringstream contentRange;
+    contentRange << "Content-Range: bytes " << rangeStart << "-" << content.size() - 1 << "/" << content.size()
+                 << "\r\n";
+    return TestResponse{ 206, body, body.size(), contentRange.str() };
+}
+
+/**
+ * @brief A single-threaded HTTP server on the loopback interface that answers every request with
+ * the response returned by a test-provided function, and closes the connection after each response.
+ */
+class TestHttpServer
+{
+public:
+    /**
+     * @brief Called for each request with the request index and the start offset of its
+     * 'Range: bytes=N-' header, or -1 if the request has no Range header.
+     */
+    using Responder = std::function<TestResponse(size_t requestIndex, long long rangeStart)>;
+
+    explicit TestHttpServer(Responder responder) : _responder(std::move(responder))
+    {
+        sockaddr_in addr = {};
+        socklen_t addrLen = sizeof(addr);
+
+        addr.sin_family = AF_INET;
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        addr.sin_port = 0;
+
+        _listenSocket = socket(AF_INET, SOCK_STREAM, 0);
+        REQUIRE(_listenSocket >= 0);
+        REQUIRE(bind(_listenSocket, reinterpret_cast<sockaddr*>(&addr), sizeof(addr)) == 0);
+        REQUIRE(listen(_listenSocket, 4) == 0);
+        REQUIRE(getsockname(_listenSocket, reinterpret_cast<sockaddr*>(&addr), &addrLen) == 0);
+        _port = ntohs(addr.sin_port);
+
+        _thread = std::thread{ [this]() { Serve(); } };
+    }
+
+    TestHttpServer(const TestHttpServer&) = delete;
+    TestHttpServer& operator=(const TestHttpServer&) = delete;
+    TestHttpServer(TestHttpServer&&) = delete;
+    TestHttpServer& operator=(TestHttpServer&&) = delete;
+
+    ~TestHttpServer()
+    {
+        shutdown(_listenSocket, SHUT_RDWR);
+        close(_listenSocket);
+        _thread.join();
+    }
+
+    std::string GetUri() const
+    {
+        return "http://127.0.0.1:" + std::to_string(_port) + "/payload.bin";
+    }
+
+    /**
+     * @brief Gets the Range start offset of each request received so far, in order.
+     */
+    std::vector<long long> GetRangeStarts()
+    {
+        std::lock_guard<std::mutex> lock{ _mutex };
+        return _rangeStarts;
+    }
+
+private:
+    void Serve()
+    {
+        for (;;)
+        {
+            const int connection = accept(_listenSocket, nullptr, nullptr);
+            if (connection < 0)
+            {
+                return;
+            }
+
+            std::string request;
+            char buffer[1024];
+            while (request.find("\r\n\r\n") == std::string::npos)
+            {
+                const ssize_t readSize = recv(connection, buffer, sizeof(buffer), 0);
+                if (readSize <= 0)
+                {
+                    break;
+                }
+                request.append(buffer, static_cast<size_t>(readSize));
+            }
+
+            long long rangeStart = -1;
+            const size_t rangePos = request.find("Range: bytes=");
+            if (rangePos != std::string::npos)
+            {
+                rangeStart = std::stoll(request.substr(rangePos + strlen("Range: bytes=")));
+            }
+
+            size_t requestIndex = 0;
+            {
+                std::lock_guard<std::mutex> lock{ _mutex };
+                requestIndex = _rangeStarts.size();
+                _rangeStarts.push_back(rangeStart);
+            }
+
+            const TestResponse response = _responder(requestIndex, rangeStart);
+            std::stringstream header;
+            header << "HTTP/1.1 " << response.status << " Test\r\n"
+                   << "Content-Length: " << response.body.size() << "\r\n" << response.extraHeaders
+                   << "Connection: close\r\n\r\n";
+
+            const std::string data = header.str() + response.body.substr(0, response.bytesToSend);
+            (void)send(connection, data.data(), data.size(), MSG_NOSIGNAL);
+            close(connection);
+        }
+    }
+
+    Responder _responder;
+    int _listenSocket = -1;
+    unsigned short _port = 0;
+    std::thread _thread;
+    std::mutex _mutex;
+    std::vector<long long> _rangeStarts;
+};
+
+/**
+ * @brief A temporary work folder for a download, removed with its content on destruction.
+ */
+class TestWorkFolder
+{
+public:
+    TestWorkFolder()
+    {
+        // Keep digests of test files out of the agent's data folder.
+        ADUC_HashUtils_SetDigestCacheFilePath(nullptr);
+
+        std::string folderTemplate = std::string{ ADUC_SystemUtils_GetTemporaryPathName() }
+            + "/http_content_downloader_ut_XXXXXX";
+        std::vector<char> folder{ folderTemplate.begin(), folderTemplate.end() };
+        folder.push_back('\0');
+        REQUIRE(mkdtemp(folder.data()) != nullptr);
+        _path = folder.data();
+    }
+
+    TestWorkFolder(const TestWorkFolder&) = delete;
+    TestWorkFolder& operator=(const TestWorkFolder&) = delete;
+    TestWorkFolder(TestWorkFolder&&) = delete;
+    TestWorkFolder& operator=(TestWorkFolder&&) = delete;
+
+    ~TestWorkFolder()
+    {
+        (void)ADUC_SystemUtils_RmDirRecursive(_path.c_str());
+    }
+
+    const char* GetPath() const
+    {
+        return _path.c_str();
+    }
+
+    std::string GetFilePath(const char* fileName) const
+    {
+        return _path + "/" + fileName;
+    }
+
+private:
+    std::string _path;
+};
+
+static std::string ReadFile(const std::string& path)
+{
+    std::ifstream file{ path, std::ios::binary };
+    return std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+}
+
+static void WriteFile(const std::string& path, const std::string& content)
+{
+    std::ofstream file{ path, std::ios::binary | std::ios::trunc };
+    file.write(content.data(), static_cast<std::streamsize>(content.size()));
+}
+
+static std::string GetSha256Base64(const std::string& content)
+{
+    char hash[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE] = {};
+    ADUC_HashStreamHandle hashStream = ADUC_HashUtils_HashStream_Create(SHA256);
+    REQUIRE(hashStream != nullptr);
+    REQUIRE(ADUC_HashUtils_HashStream_Update(
+        hashStream, reinterpret_cast<const uint8_t*>(content.data()), content.size()));
+    REQUIRE(ADUC_HashUtils_HashStream_GetResult(hashStream, hash, sizeof(hash)));
+    ADUC_HashUtils_HashStream_Free(hashStream);
+    return hash;
+}
+
+/**
+ * @brief The payload served by the tests. Not a repeating pattern, so a misplaced range shows up in the hash.
+ */
+static std::string GetTestPayload()
+{
+    std::string payload;
+    for (int i = 0; payload.size() < 100 * 1024; ++i)
+    {
+        payload += std::to_string(i) + ",";
+    }
+    return payload;
+}
+
+/**
+ * @brief Downloads @p uri as 'payload.bin' to @p workFolder, expecting @p content.
+ *
+ * @param sizeInBytes The file entity's size. 0 when the size is unknown.
+ */
+static ADUC_Result DownloadTestPayload(
+    const std::string& uri, const TestWorkFolder& workFolder, const std::string& content, size_t sizeInBytes)
+{
+    std::string hashValue = GetSha256Base64(content);
+    std::string downloadUri = uri;
+    char hashType[] = "sha256";
+    char fileId[] = "f1";
+    char targetFilename[] = "payload.bin";
+    ADUC_Hash hash = { &hashValue[0], hashType };
+
+    ADUC_FileEntity entity = {};
+    entity.FileId = fileId;
+    entity.DownloadUri = &downloadUri[0];
+    entity.Hash = &hash;
+    entity.HashCount = 1;
+    entity.TargetFilename = targetFilename;
+    entity.SizeInBytes = sizeInBytes;
+
+    return HttpDownloader_Download(&entity, "workflow", workFolder.GetPath(), 30, nullptr);
+}
+
+TEST_CASE("HttpDownloader_Download resumes from a partial file")
+{
+    const std::string content = GetTestPayload();
+    const size_t partialSize = 1000;
+    TestWorkFolder workFolder;
+
+    WriteFile(workFolder.GetFilePath("payload.bin.partial"), content.substr(0, partialSize));
+
+    TestHttpServer server{ [&](size_t, long long rangeStart) {
+        return rangeStart < 0 ? FullResponse(200, content) : RangeResponse(content, rangeStart);
+    } };
+
+    const ADUC_Result result = DownloadTestPayload(server.GetUri(), workFolder, content, content.size());
+
+    CHECK(result.ResultCode == ADUC_Result_Download_Success);
+    CHECK(server.GetRangeStarts() == std::vector<long long>{ static_cast<long long>(partialSize) });
+    CHECK(ReadFile(workFolder.GetFilePath("payload.bin")) == content);
+}
+
+TEST_CASE("HttpDownloader_Download resumes after the connection drops")
+{
+    const std::string content = GetTestPayload();
+    const size_t bytesBeforeDrop = 5000;
+    TestWorkFolder workFolder;
+
+    TestHttpServer server{ [&](size_t requestIndex, long long rangeStart) {
+        if (requestIndex == 0)
+        {
+            return TestResponse{ 200, content, bytesBeforeDrop, "" };
+        }
+        return RangeResponse(content, rangeStart);
+    } };
+
+    const ADUC_Result result = DownloadTestPayload(server.GetUri(), workFolder, content, content.size());
+
+    CHECK(result.ResultCode == ADUC_Result_Download_Success);
+    CHECK(server.GetRangeStarts() == std::vector<long long>{ -1, static_cast<long long>(bytesBeforeDrop) });
+    CHECK(ReadFile(workFolder.GetFilePath("payload.bin")) == content);
+}
+
+TEST_CASE("HttpDownloader_Download restarts when the server answers a range request with 200")
+{
+    const std::string content = GetTestPayload();
+    TestWorkFolder workFolder;
+
+    WriteFile(workFolder.GetFilePath("payload.bin.partial"), content.substr(0, 1000));
+
+    TestHttpServer server{ [&](size_t, long long) { return FullResponse(200, content); } };
+
+    const ADUC_Result result = DownloadTestPayload(server.GetUri(), workFolder, content, content.size());
+
+    CHECK(result.ResultCode == ADUC_Result_Download_Success);
+    CHECK(server.GetRangeStarts() == std::vector<long long>{ 1000 });
+    CHECK(ReadFile(workFolder.GetFilePath("payload.bin")) == content);
+}
+
+TEST_CASE("HttpDownloader_Download restarts when the range is not satisfiable")
+{
+    const std::string content = GetTestPayload();
+    const std::string staleContent = content + "stale";
+    TestWorkFolder workFolder;
+
+    // Without a known size, a partial file longer than the resource is only detected by the server.
+    WriteFile(workFolder.GetFilePath("payload.bin.partial"), staleContent);
+
+    TestHttpServer server{ [&](size_t, long long rangeStart) {
+        if (rangeStart >= static_cast<long long>(content.size()))
+        {
+            return FullResponse(416, "");
+        }
+        return rangeStart < 0 ? FullResponse(200, content) : RangeResponse(content, rangeStart);
+    } };
+
+    const ADUC_Result result = DownloadTestPayload(server.GetUri(), workFolder, content, 0);
+
+    CHECK(result.ResultCode == ADUC_Result_Download_Success);
+    CHECK(server.GetRangeStarts() == std::vector<long long>{ static_cast<long long>(staleContent.size()), -1 });
+    CHECK(ReadFile(workFolder.GetFilePath("payload.bin")) == content);
+}
+
+TEST_CASE("HttpDownloader_Download retries server errors")
+{
+    const std::string content = GetTestPayload();
+    TestWorkFolder workFolder;
+
+    SECTION("Gives up after the maximum number of attempts")
+    {
+        TestHttpServer server{ [&](size_t, long long) { return FullResponse(503, "unavailable"); } };
+
+        const ADUC_Result result = DownloadTestPayload(server.GetUri(), workFolder, content, content.size());
+
+        CHECK(result.ResultCode == ADUC_Result_Failure);
+        CHECK(result.ExtendedResultCode == ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_HTTP_FAILURE(503));
+        CHECK(server.GetRangeStarts().size() == 5);
+    }
+
+    SECTION("Succeeds once throttling stops")
+    {
+        TestHttpServer server{ [&](size_t requestIndex, long long) {
+            return requestIndex == 0 ? FullResponse(429, "slow down") : FullResponse(200, content);
+        } };
+
+        const ADUC_Result result = DownloadTestPayload(server.GetUri(), workFolder, content, content.size());
+
+        CHECK(result.ResultCode == ADUC_Result_Download_Success);
+        CHECK(server.GetRangeStarts().size() == 2);
+        CHECK(ReadFile(workFolder.GetFilePath("payload.bin")) == content);
+    }
+
+    SECTION("Does not retry client errors")
+    {
+        TestHttpServer server{ [&](size_t, long long) { return FullResponse(404, "not found"); } };
+
+        const ADUC_Result result = DownloadTestPayload(server.GetUri(), workFolder, content, content.size());
+
+        CHECK(result.ResultCode == ADUC_Result_Failure);
+        CHECK(result.ExtendedResultCode == ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_HTTP_FAILURE(404));
+        CHECK(server.GetRangeStarts().size() == 1);
+    }
+}
@@ -0,0 +1,10 @@
+/**
+ * @file main.cpp
+ * @brief HTTP content downloader unit tests main entry point.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+//https://github.com/catchorg/Catch2/blob/devel/docs/own-main.md
+#define CATCH_CONFIG_MAIN
+#include <catch2/catch.hpp>
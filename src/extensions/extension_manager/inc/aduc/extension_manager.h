@@ -40,6 +40,12 @@ ADUC_Result ExtensionManager_Download(
     ExtensionManager_Download_Options* options,
     ADUC_DownloadProgressCallback downloadProgressCallback);
 
+/**
+ * @brief Drops cached component enumerator data, so that the next deployment queries the enumerator again.
+ * Only affects the caller's module; the steps handler drops its own copy when it starts a top-level workflow.
+ */
+void ExtensionManager_InvalidateComponentsCache();
+
 /**
  * @brief Uninitializes the extension manager.
  */
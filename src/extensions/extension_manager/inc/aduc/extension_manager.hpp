@@ -35,29 +35,48 @@ public:
     static ADUC_Result SetContentDownloaderLibrary(void* contentDownloaderLibrary);
     static ADUC_Result GetContentDownloaderContractVersion(ADUC_ExtensionContractInfo* contractInfo);
     static void SetContentDownloaderContractVersion(const ADUC_ExtensionContractInfo& contractInfo);
+    static void SetContentDownloaderSupportsConcurrentCalls(bool supportsConcurrentCalls);
 
     static bool IsComponentsEnumeratorRegistered();
     static ADUC_Result LoadComponentEnumeratorLibrary(void** componentEnumerator);
+    static ADUC_Result SetComponentEnumeratorLibrary(void* componentEnumerator);
     static ADUC_Result GetComponentEnumeratorContractVersion(ADUC_ExtensionContractInfo* contractInfo);
 
     static ADUC_Result LoadUpdateContentHandlerExtension(const std::string& updateType, ContentHandler** handler);
-    static ADUC_Result SetUpdateContentHandlerExtension(const std::string& updateType, ContentHandler* handler);
+    static ADUC_Result SetUpdateContentHandlerExtension(
+        const std::string& updateType, ContentHandler* handler, bool supportsConcurrentCalls = false);
+
+    /**
+     * @brief Whether @p handler, a loaded update content handler, may be called from more than one thread at a time.
+     * Handlers opt in by exporting SupportsConcurrentCalls; see content_handler.hpp.
+     */
+    static bool SupportsConcurrentCalls(const ContentHandler* handler);
 
     static void Uninit();
 
     /**
      * @brief Returns all components information in JSON format.
+     * The result is cached until the component inventory version changes, see InvalidateComponentsCache.
      * @param[out] outputComponentsData An output string containing components data.
      */
     static ADUC_Result GetAllComponents(std::string& outputComponentsData);
 
     /**
      * @brief Selects component(s) matching specified @p selector.
+     * Results are cached per selector until the component inventory version changes, see InvalidateComponentsCache.
      * @param selector A JSON string contains name-value pairs used for selecting components.
      * @param[out] outputComponentsData An output string containing components data.
      */
     static ADUC_Result SelectComponents(const std::string& selector, std::string& outputComponentsData);
 
+    /**
+     * @brief Drops cached component data. Called at the start of each deployment, so that enumerators without
+     * a GetComponentsVersion export are queried again once per deployment.
+     * Each module that links the extension manager has its own cache; the agent and the steps handler
+     * each invalidate theirs.
+     */
+    static void InvalidateComponentsCache();
+
     /**
      * @brief Initialize Content Downloader extension.
      * @param[in] initializeData A string contains downloader initialization data.
@@ -74,13 +93,15 @@ public:
     static DownloadProc DefaultDownloadProcResolver(void* lib);
 
     /**
-     * @brief
+     * @brief Downloads a file into the workflow's work folder.
+     * Returns ADUC_Result_Failure_Cancelled, without downloading, if workflow_is_download_cancel_requested.
      *
      * @param entity An #ADUC_FileEntity object with information of the file to be downloaded.
      * @param workflowHandle The workflow handle opaque object for per-workflow workflow data.
      * @param downloadOptions The download options.
      * @param downloadProgressCallback A download progress reporting callback.
      * @param downloadProcResolver The resolver that resolves the library's symbol to a @p DownloadProc. Defaults to DefaultDownloadProcResolver.
+     * The downloader's DownloadWithDigest export, when present, is only used with DefaultDownloadProcResolver.
      * @return ADUC_Result
      */
     static ADUC_Result Download(
@@ -90,11 +111,33 @@ public:
         ADUC_DownloadProgressCallback downloadProgressCallback,
         ADUC_DownloadProcResolver downloadProcResolver = DefaultDownloadProcResolver);
 
+    /**
+     * @brief Downloads a batch of files, running up to maxConcurrentDownloads (du-config.json) transfers at a time
+     * if the content downloader supports concurrent calls, or one at a time otherwise.
+     * Once a download fails, no further downloads from the batch are started.
+     *
+     * @param entities The #ADUC_FileEntity objects with information of the files to be downloaded.
+     * @param entityCount The number of entities in @p entities.
+     * @param workflowHandle The workflow handle opaque object for per-workflow workflow data.
+     * @param downloadOptions The download options.
+     * @param downloadProgressCallback A download progress reporting callback. Can be called from multiple threads.
+     * @param downloadProcResolver The resolver that resolves the library's symbol to a @p DownloadProc. Defaults to DefaultDownloadProcResolver.
+     * @return ADUC_Result The result of the first failed download in batch order, or success.
+     */
+    static ADUC_Result DownloadBatch(
+        const ADUC_FileEntity* entities,
+        size_t entityCount,
+        ADUC_WorkflowHandle workflowHandle,
+        ExtensionManager_Download_Options* downloadOptions,
+        ADUC_DownloadProgressCallback downloadProgressCallback,
+        ADUC_DownloadProcResolver downloadProcResolver = DefaultDownloadProcResolver);
+
 private:
     static void UnloadAllUpdateContentHandlers();
     static void UnloadAllExtensions();
 
     static void _FreeComponentsDataString(char* componentsJson);
+    static void _ValidateComponentsCache(void* lib);
 
     static ADUC_Result LoadExtensionLibrary(
         const char* extensionName,
@@ -109,6 +152,8 @@ private:
     static std::unordered_map<std::string, void*> _libs;
     static std::unordered_map<std::string, ContentHandler*> _contentHandlers;
     static void* _contentDownloader;
+    static DownloadWithDigestProc _contentDownloaderDownloadWithDigest;
+    static bool _contentDownloaderSupportsConcurrentCalls;
     static ADUC_ExtensionContractInfo _contentDownloaderContractVersion;
     static void* _componentEnumerator;
     static ADUC_ExtensionContractInfo _componentEnumeratorContractVersion;
@@ -6,6 +6,13 @@
 // Default Content Downloader Download Timeout of 8 hours.
 #define CONTENT_DOWNLOADER_MAX_TIMEOUT_IN_MINUTES_DEFAULT (8 * 60)
 
+// Default maximum number of payload files downloaded at the same time by ExtensionManager::DownloadBatch,
+// for a content downloader that exports SupportsConcurrentCalls. Other content downloaders get one file at a time.
+#define CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_DEFAULT 4
+
+// Upper bound for the maxConcurrentDownloads setting in du-config.json.
+#define CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_LIMIT 16
+
 typedef struct tagADUC_ExtensionManager_Download_Options
 {
     unsigned int
@@ -24,6 +24,8 @@ ADUC_Result ProcessDownloadHandlerExtensibility(
 
 unsigned int GetDownloadTimeoutInMinutes(const ExtensionManager_Download_Options* downloadOptions) noexcept;
 
+unsigned int GetMaxConcurrentDownloads(bool downloaderSupportsConcurrentCalls) noexcept;
+
 EXTERN_C_END
 
 #endif // ADUC_EXTENSION_MANAGER_HELPER_HPP
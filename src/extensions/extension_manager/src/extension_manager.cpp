@@ -29,11 +29,19 @@
 #include <aduc/string_c_utils.h>
 #include <aduc/string_handle_wrapper.hpp>
 #include <aduc/string_utils.hpp>
+#include <aduc/timing_utils.h>
 #include <aduc/types/workflow.h> // ADUC_WorkflowHandle
 #include <aduc/workflow_utils.h>
 
+#include <algorithm> // std::min
+#include <atomic>
 #include <cstring>
+#include <mutex>
+#include <system_error> // std::system_error
+#include <thread>
 #include <unordered_map>
+#include <unordered_set>
+#include <vector>
 
 // Note: this requires ${CMAKE_DL_LIBS}
 #include <aducpal/dlfcn.h> // dlopen, dlerror, dlsym, dlclose
@@ -42,6 +50,7 @@
 // type aliases
 using UPDATE_CONTENT_HANDLER_CREATE_PROC = ContentHandler* (*)(ADUC_LOG_SEVERITY logLevel);
 using GET_CONTRACT_INFO_PROC = ADUC_Result (*)(ADUC_ExtensionContractInfo* contractInfo);
+using SUPPORTS_CONCURRENT_CALLS_PROC = bool (*)();
 using WorkflowHandle = void*;
 using ADUC::StringUtils::cstr_wrapper;
 
@@ -49,10 +58,80 @@ using ADUC::StringUtils::cstr_wrapper;
 std::unordered_map<std::string, void*> ExtensionManager::_libs;
 std::unordered_map<std::string, ContentHandler*> ExtensionManager::_contentHandlers;
 void* ExtensionManager::_contentDownloader;
+DownloadWithDigestProc ExtensionManager::_contentDownloaderDownloadWithDigest;
+bool ExtensionManager::_contentDownloaderSupportsConcurrentCalls;
 ADUC_ExtensionContractInfo ExtensionManager::_contentDownloaderContractVersion;
 void* ExtensionManager::_componentEnumerator;
 ADUC_ExtensionContractInfo ExtensionManager::_componentEnumeratorContractVersion;
 
+// Serializes workflow mutations and download handler processing while DownloadBatch runs downloads concurrently.
+static std::mutex s_downloadWorkflowMutex;
+
+// Guards the loaded library and handler caches, which the steps handler may fill from more than one thread.
+static std::recursive_mutex s_extensionsMutex;
+
+// Loaded update content handlers that may be called from more than one thread at a time.
+static std::unordered_set<const ContentHandler*> s_concurrentContentHandlers;
+
+// Component enumerator results, valid for as long as the enumerator reports the same inventory version.
+// Also serializes enumerator calls, so that concurrent callers do not query a slow enumerator twice.
+static std::mutex s_componentsCacheMutex;
+static std::string s_componentsVersion;
+static bool s_allComponentsCached = false;
+static std::string s_allComponents;
+static std::unordered_map<std::string, std::string> s_selectedComponents;
+
+/**
+ * @brief Reads the registration in @p regFilePath and verifies the hash of the extension library it names.
+ * @param regFilePath A full path to the extension registration file.
+ * @param facilityCode Facility code for extended error report.
+ * @param componentCode Component code for extended error report.
+ * @param entity A file entity to receive the registration. The caller must uninit it.
+ * @return ADUC_Result contains result code and extended result code.
+ */
+static ADUC_Result
+VerifyExtensionLibrary(const char* regFilePath, int facilityCode, int componentCode, ADUC_FileEntity* entity)
+{
+    ADUC_Result result{ ADUC_GeneralResult_Failure };
+    SHAversion algVersion;
+
+    if (!GetExtensionFileEntity(regFilePath, entity))
+    {
+        Log_Info("Failed to load extension from '%s'.", regFilePath);
+        result.ExtendedResultCode = ADUC_ERC_EXTENSION_CREATE_FAILURE_NOT_FOUND(facilityCode, componentCode);
+        goto done;
+    }
+
+    // Validate file hash.
+    if (!ADUC_HashUtils_GetShaVersionForTypeString(
+            ADUC_HashUtils_GetHashType(entity->Hash, entity->HashCount, 0), &algVersion))
+    {
+        Log_Error(
+            "FileEntity for %s has unsupported hash type %s",
+            entity->TargetFilename,
+            ADUC_HashUtils_GetHashType(entity->Hash, entity->HashCount, 0));
+        result.ExtendedResultCode = ADUC_ERC_EXTENSION_CREATE_FAILURE_VALIDATE(facilityCode, componentCode);
+        goto done;
+    }
+
+    // Always read the library itself, rather than trust a cached digest, as it is about to be loaded.
+    if (!ADUC_HashUtils_IsValidFileHashUncached(
+            entity->TargetFilename,
+            ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0),
+            algVersion,
+            true /* suppressErrorLog */))
+    {
+        Log_Error("Hash for %s is not valid", entity->TargetFilename);
+        result.ExtendedResultCode = ADUC_ERC_EXTENSION_CREATE_FAILURE_VALIDATE(facilityCode, componentCode);
+        goto done;
+    }
+
+    result = { ADUC_Result_Success };
+
+done:
+    return result;
+}
+
 /**
  * @brief Loads extension shared library file.
  * @param extensionName An extension name.
@@ -76,8 +155,8 @@ ADUC_Result ExtensionManager::LoadExtensionLibrary(
     void** libHandle)
 {
     ADUC_Result result{ ADUC_GeneralResult_Failure };
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
     ADUC_FileEntity entity = {};
-    SHAversion algVersion;
 
     std::stringstream path;
     path << extensionPath << "/" << extensionSubfolder << "/" << extensionRegFileName;
@@ -110,35 +189,11 @@ ADUC_Result ExtensionManager::LoadExtensionLibrary(
         }
     }
 
-    memset(&entity, 0, sizeof(entity));
-
-    if (!GetExtensionFileEntity(path.str().c_str(), &entity))
-    {
-        Log_Info("Failed to load extension from '%s'.", path.str().c_str());
-        result.ExtendedResultCode = ADUC_ERC_EXTENSION_CREATE_FAILURE_NOT_FOUND(facilityCode, componentCode);
-        goto done;
-    }
-
-    // Validate file hash.
-    if (!ADUC_HashUtils_GetShaVersionForTypeString(
-            ADUC_HashUtils_GetHashType(entity.Hash, entity.HashCount, 0), &algVersion))
-    {
-        Log_Error(
-            "FileEntity for %s has unsupported hash type %s",
-            entity.TargetFilename,
-            ADUC_HashUtils_GetHashType(entity.Hash, entity.HashCount, 0));
-        result.ExtendedResultCode = ADUC_ERC_EXTENSION_CREATE_FAILURE_VALIDATE(facilityCode, componentCode);
-        goto done;
-    }
+    *libHandle = nullptr;
 
-    if (!ADUC_HashUtils_IsValidFileHash(
-            entity.TargetFilename,
-            ADUC_HashUtils_GetHashValue(entity.Hash, entity.HashCount, 0),
-            algVersion,
-            true /* suppressErrorLog */))
+    result = VerifyExtensionLibrary(path.str().c_str(), facilityCode, componentCode, &entity);
+    if (IsAducResultCodeFailure(result.ResultCode))
     {
-        Log_Error("Hash for %s is not valid", entity.TargetFilename);
-        result.ExtendedResultCode = ADUC_ERC_EXTENSION_CREATE_FAILURE_VALIDATE(facilityCode, componentCode);
         goto done;
     }
 
@@ -175,7 +230,7 @@ ADUC_Result ExtensionManager::LoadExtensionLibrary(
 done:
     if (IsAducResultCodeFailure(result.ResultCode))
     {
-        if (*libHandle != nullptr)
+        if (libHandle != nullptr && *libHandle != nullptr)
         {
             ADUCPAL_dlclose(*libHandle);
             *libHandle = nullptr;
@@ -201,9 +256,13 @@ ExtensionManager::LoadUpdateContentHandlerExtension(const std::string& updateTyp
 
     UPDATE_CONTENT_HANDLER_CREATE_PROC createUpdateContentHandlerExtensionFn = nullptr;
     GET_CONTRACT_INFO_PROC getContractInfoFn = nullptr;
+    SUPPORTS_CONCURRENT_CALLS_PROC supportsConcurrentCallsFn = nullptr;
     void* libHandle = nullptr;
     ADUC_ExtensionContractInfo contractInfo{};
     const ADUC_ConfigInfo* config = nullptr;
+    ADUC_TimingSpan loadSpan;
+    bool isLoadTimed = false;
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
 
     Log_Info("Loading handler for '%s'.", updateType.c_str());
 
@@ -252,6 +311,10 @@ ExtensionManager::LoadUpdateContentHandlerExtension(const std::string& updateTyp
         goto done;
     }
 
+    ADUC_Timing_BeginSpan(
+        &loadSpan, ADUC_TIMING_PHASE_HANDLER_LOAD, updateType.c_str(), ADUC_TIMING_NO_LEVEL, ADUC_TIMING_NO_LEVEL);
+    isLoadTimed = true;
+
     result = LoadExtensionLibrary(
         updateType.c_str(),
         config->extensionsStepHandlerFolder,
@@ -337,6 +400,16 @@ ExtensionManager::LoadUpdateContentHandlerExtension(const std::string& updateTyp
 
     (*handler)->SetContractInfo(contractInfo);
 
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    supportsConcurrentCallsFn = reinterpret_cast<SUPPORTS_CONCURRENT_CALLS_PROC>(
+        ADUCPAL_dlsym(libHandle, CONTENT_HANDLER__SupportsConcurrentCalls__EXPORT_SYMBOL));
+
+    if (supportsConcurrentCallsFn != nullptr && supportsConcurrentCallsFn())
+    {
+        Log_Debug("'%s' handler supports concurrent calls.", updateType.c_str());
+        s_concurrentContentHandlers.insert(*handler);
+    }
+
     Log_Debug("Caching new handler for '%s'.", updateType.c_str());
     _contentHandlers.emplace(updateType, *handler);
 
@@ -355,6 +428,11 @@ done:
         }
     }
 
+    if (isLoadTimed)
+    {
+        ADUC_Timing_EndSpanInCurrentReport(&loadSpan);
+    }
+
     return result;
 }
 
@@ -362,11 +440,14 @@ done:
  * @brief Sets UpdateContentHandler for specified @p updateType
  * @param updateType An update type string.
  * @param handler A ContentHandler object.
+ * @param supportsConcurrentCalls Whether @p handler may be called from more than one thread at a time.
  * @return ADUCResult contains result code and extended result code.
  * */
-ADUC_Result ExtensionManager::SetUpdateContentHandlerExtension(const std::string& updateType, ContentHandler* handler)
+ADUC_Result ExtensionManager::SetUpdateContentHandlerExtension(
+    const std::string& updateType, ContentHandler* handler, bool supportsConcurrentCalls)
 {
     ADUC_Result result = { ADUC_Result_Failure };
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
 
     Log_Info("Setting handler for '%s'.", updateType.c_str());
 
@@ -379,10 +460,19 @@ ADUC_Result ExtensionManager::SetUpdateContentHandlerExtension(const std::string
     }
 
     // Remove existing one.
-    _contentHandlers.erase(updateType);
+    if (_contentHandlers.count(updateType) > 0)
+    {
+        s_concurrentContentHandlers.erase(_contentHandlers.at(updateType));
+        _contentHandlers.erase(updateType);
+    }
 
     _contentHandlers.emplace(updateType, handler);
 
+    if (supportsConcurrentCalls)
+    {
+        s_concurrentContentHandlers.insert(handler);
+    }
+
     result = { ADUC_GeneralResult_Success };
 
 done:
@@ -391,12 +481,21 @@ done:
 
 void ExtensionManager::UnloadAllUpdateContentHandlers()
 {
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
+
     for (auto& contentHandler : _contentHandlers)
     {
         delete (contentHandler.second); // NOLINT(cppcoreguidelines-owning-memory)
     }
 
     _contentHandlers.clear();
+    s_concurrentContentHandlers.clear();
+}
+
+bool ExtensionManager::SupportsConcurrentCalls(const ContentHandler* handler)
+{
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
+    return s_concurrentContentHandlers.count(handler) > 0;
 }
 
 /**
@@ -405,6 +504,8 @@ void ExtensionManager::UnloadAllUpdateContentHandlers()
  */
 void ExtensionManager::UnloadAllExtensions()
 {
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
+
     // Make sure we unload every handlers first.
     UnloadAllUpdateContentHandlers();
 
@@ -418,6 +519,7 @@ void ExtensionManager::UnloadAllExtensions()
 
 void ExtensionManager::Uninit()
 {
+    ExtensionManager::InvalidateComponentsCache();
     ExtensionManager::UnloadAllExtensions();
 }
 
@@ -428,6 +530,8 @@ ADUC_Result ExtensionManager::LoadContentDownloaderLibrary(void** contentDownloa
                                            CONTENT_DOWNLOADER__Download__EXPORT_SYMBOL };
     void* extensionLib = nullptr;
     GET_CONTRACT_INFO_PROC getContractInfoFn = nullptr;
+    SUPPORTS_CONCURRENT_CALLS_PROC supportsConcurrentCallsFn = nullptr;
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
 
     if (_contentDownloader != nullptr)
     {
@@ -465,6 +569,26 @@ ADUC_Result ExtensionManager::LoadContentDownloaderLibrary(void** contentDownloa
         }
     }
 
+    // Optional. Lets the downloader hand back the digest it computed while writing the file.
+    ADUCPAL_dlerror(); // Clear any existing error
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    _contentDownloaderDownloadWithDigest = reinterpret_cast<DownloadWithDigestProc>(
+        ADUCPAL_dlsym(extensionLib, CONTENT_DOWNLOADER__DownloadWithDigest__EXPORT_SYMBOL));
+    if (_contentDownloaderDownloadWithDigest == nullptr)
+    {
+        Log_Debug("No " CONTENT_DOWNLOADER__DownloadWithDigest__EXPORT_SYMBOL
+                  " export. Downloaded content will be re-hashed.");
+    }
+
+    // Optional. Without it, DownloadBatch calls the downloader from one thread at a time.
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    supportsConcurrentCallsFn = reinterpret_cast<SUPPORTS_CONCURRENT_CALLS_PROC>(
+        ADUCPAL_dlsym(extensionLib, CONTENT_DOWNLOADER__SupportsConcurrentCalls__EXPORT_SYMBOL));
+    _contentDownloaderSupportsConcurrentCalls = supportsConcurrentCallsFn != nullptr && supportsConcurrentCallsFn();
+    Log_Debug(
+        "Content downloader %s concurrent calls.",
+        _contentDownloaderSupportsConcurrentCalls ? "supports" : "does not support");
+
     Log_Debug("Determining contract version for content downloader.");
 
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
@@ -498,9 +622,16 @@ ADUC_Result ExtensionManager::SetContentDownloaderLibrary(void* contentDownloade
 {
     ADUC_Result result = { ADUC_Result_Success };
     _contentDownloader = contentDownloaderLibrary;
+    _contentDownloaderDownloadWithDigest = nullptr;
+    _contentDownloaderSupportsConcurrentCalls = false;
     return result;
 }
 
+void ExtensionManager::SetContentDownloaderSupportsConcurrentCalls(bool supportsConcurrentCalls)
+{
+    _contentDownloaderSupportsConcurrentCalls = supportsConcurrentCalls;
+}
+
 ADUC_Result ExtensionManager::GetContentDownloaderContractVersion(ADUC_ExtensionContractInfo* contractInfo)
 {
     *contractInfo = _contentDownloaderContractVersion;
@@ -533,6 +664,7 @@ ADUC_Result ExtensionManager::LoadComponentEnumeratorLibrary(void** componentEnu
     void* extensionLib = nullptr;
     const char* requiredFunction = COMPONENT_ENUMERATOR__GetAllComponents__EXPORT_SYMBOL;
     GET_CONTRACT_INFO_PROC getContractInfoFn = nullptr;
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
 
     if (_componentEnumerator != nullptr)
     {
@@ -602,6 +734,23 @@ done:
     return result;
 }
 
+/**
+ * @brief Sets the component enumerator library, with a V1 contract, or unsets it if @p componentEnumerator is nullptr.
+ * The cached component data is dropped.
+ * @param componentEnumerator The component enumerator library handle.
+ */
+ADUC_Result ExtensionManager::SetComponentEnumeratorLibrary(void* componentEnumerator)
+{
+    ADUC_Result result = { ADUC_Result_Success };
+    std::lock_guard<std::recursive_mutex> extensionsLock{ s_extensionsMutex };
+
+    _componentEnumerator = componentEnumerator;
+    _componentEnumeratorContractVersion.majorVer = ADUC_V1_CONTRACT_MAJOR_VER;
+    _componentEnumeratorContractVersion.minorVer = ADUC_V1_CONTRACT_MINOR_VER;
+    InvalidateComponentsCache();
+    return result;
+}
+
 void ExtensionManager::_FreeComponentsDataString(char* componentsJson)
 {
     void* lib = nullptr;
@@ -659,6 +808,58 @@ done:
     }
 }
 
+/**
+ * @brief Drops the cached component data if the enumerator reports a different inventory version.
+ * Enumerators without a GetComponentsVersion export keep the cache until InvalidateComponentsCache is called.
+ * Caller must hold s_componentsCacheMutex.
+ * @param lib The component enumerator library.
+ */
+void ExtensionManager::_ValidateComponentsCache(void* lib)
+{
+    // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+    auto getComponentsVersion = reinterpret_cast<GetComponentsVersionProc>(
+        ADUCPAL_dlsym(lib, COMPONENT_ENUMERATOR__GetComponentsVersion__EXPORT_SYMBOL));
+    char* version = nullptr;
+
+    if (getComponentsVersion == nullptr)
+    {
+        return;
+    }
+
+    try
+    {
+        version = getComponentsVersion();
+    }
+    catch (...)
+    {
+        Log_Warn("Exception occurred while getting the component inventory version.");
+    }
+
+    // An unknown version cannot be compared, so nothing is reused.
+    if (version == nullptr || s_componentsVersion != version)
+    {
+        s_allComponentsCached = false;
+        s_allComponents.clear();
+        s_selectedComponents.clear();
+        s_componentsVersion = version != nullptr ? version : "";
+    }
+
+    if (version != nullptr)
+    {
+        _FreeComponentsDataString(version);
+    }
+}
+
+void ExtensionManager::InvalidateComponentsCache()
+{
+    std::lock_guard<std::mutex> lock{ s_componentsCacheMutex };
+
+    s_allComponentsCached = false;
+    s_allComponents.clear();
+    s_selectedComponents.clear();
+    s_componentsVersion.clear();
+}
+
 /**
  * @brief Returns all components information in JSON format.
  * @param[out] outputComponentsData An output string containing components data.
@@ -669,6 +870,7 @@ ADUC_Result ExtensionManager::GetAllComponents(std::string& outputComponentsData
 
     void* lib = nullptr;
     char* components = nullptr;
+    std::lock_guard<std::mutex> lock{ s_componentsCacheMutex };
 
     outputComponentsData = "";
 
@@ -678,6 +880,14 @@ ADUC_Result ExtensionManager::GetAllComponents(std::string& outputComponentsData
         goto done;
     }
 
+    _ValidateComponentsCache(lib);
+    if (s_allComponentsCached)
+    {
+        outputComponentsData = s_allComponents;
+        result = { ADUC_GeneralResult_Success, 0 };
+        goto done;
+    }
+
     if (ADUC_ContractUtils_IsV1Contract(&ExtensionManager::_componentEnumeratorContractVersion))
     {
         if (_getAllComponents == nullptr)
@@ -709,6 +919,9 @@ ADUC_Result ExtensionManager::GetAllComponents(std::string& outputComponentsData
             outputComponentsData = components;
             _FreeComponentsDataString(components);
         }
+
+        s_allComponents = outputComponentsData;
+        s_allComponentsCached = true;
     }
     else
     {
@@ -737,6 +950,7 @@ ADUC_Result ExtensionManager::SelectComponents(const std::string& selector, std:
     void* lib = nullptr;
     SelectComponentsProc _selectComponents = nullptr;
     char* components = nullptr;
+    std::lock_guard<std::mutex> lock{ s_componentsCacheMutex };
 
     outputComponentsData = "";
 
@@ -746,6 +960,17 @@ ADUC_Result ExtensionManager::SelectComponents(const std::string& selector, std:
         goto done;
     }
 
+    _ValidateComponentsCache(lib);
+    {
+        auto cached = s_selectedComponents.find(selector);
+        if (cached != s_selectedComponents.end())
+        {
+            Log_Debug("Reusing cached components for selector %s", selector.c_str());
+            outputComponentsData = cached->second;
+            goto done;
+        }
+    }
+
     // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
     _selectComponents = reinterpret_cast<SelectComponentsProc>(
         ADUCPAL_dlsym(lib, COMPONENT_ENUMERATOR__SelectComponents__EXPORT_SYMBOL));
@@ -773,6 +998,8 @@ ADUC_Result ExtensionManager::SelectComponents(const std::string& selector, std:
         _FreeComponentsDataString(components);
     }
 
+    s_selectedComponents[selector] = outputComponentsData;
+
 done:
     return result;
 }
@@ -838,11 +1065,23 @@ ADUC_Result ExtensionManager::Download(
 {
     void* lib = nullptr;
     DownloadProc downloadProc = nullptr;
+    DownloadWithDigestProc downloadWithDigestProc = nullptr;
     SHAversion algVersion;
+    char downloadedDigest[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE] = {};
+    ADUC_TimingSpan downloadSpan;
+    bool isDownloadTimed = false;
 
     ADUC_Result result = { /* .ResultCode = */ ADUC_Result_Failure, /* .ExtendedResultCode = */ 0 };
     ADUC::StringUtils::STRING_HANDLE_wrapper targetUpdateFilePath{ nullptr };
 
+    // E.g. the steps handler abandons a step's background download once the step will not be installed.
+    if (workflow_is_download_cancel_requested(workflowHandle))
+    {
+        Log_Info("Download of '%s' is cancelled.", entity->TargetFilename);
+        result = { /* .ResultCode = */ ADUC_Result_Failure_Cancelled, /* .ExtendedResultCode = */ 0 };
+        goto done;
+    }
+
     if (!workflow_get_entity_workfolder_filepath(workflowHandle, entity, targetUpdateFilePath.address_of()))
     {
         Log_Error("Cannot construct child manifest file path.");
@@ -869,7 +1108,15 @@ ADUC_Result ExtensionManager::Download(
     }
 
     downloadProc = downloadProcResolver(lib);
-    if (downloadProc == nullptr)
+
+    // The digest-reporting entry point stands in for the default Download export only;
+    // a caller-supplied resolver always decides which proc is called.
+    if (downloadProcResolver == DefaultDownloadProcResolver)
+    {
+        downloadWithDigestProc = _contentDownloaderDownloadWithDigest;
+    }
+
+    if (downloadProc == nullptr && downloadWithDigestProc == nullptr)
     {
         result = { /* .ResultCode = */ ADUC_Result_Failure,
                    /* .ExtendedResultCode = */ ADUC_ERC_CONTENT_DOWNLOADER_INITIALIZEPROC_NOTIMP };
@@ -924,10 +1171,19 @@ ADUC_Result ExtensionManager::Download(
     result.ResultCode = ADUC_Result_Failure;
     result.ExtendedResultCode = 0;
 
+    ADUC_Timing_BeginSpan(
+        &downloadSpan,
+        ADUC_TIMING_PHASE_DOWNLOAD,
+        entity->TargetFilename,
+        workflow_get_level(workflowHandle),
+        workflow_get_step_index(workflowHandle));
+    isDownloadTimed = true;
+
     // First, attempt to produce the update using download handler if
     // download handler exists in the entity (metadata).
     if (!IsNullOrEmpty(entity->DownloadHandlerId))
     {
+        std::lock_guard<std::mutex> lock{ s_downloadWorkflowMutex };
         result = ProcessDownloadHandlerExtensibility(workflowHandle, entity, targetUpdateFilePath.c_str());
         // continue on to fallback to full content download if necessary
     }
@@ -948,7 +1204,21 @@ ADUC_Result ExtensionManager::Download(
         // but the content downloader contract version is in terms of seconds.
         unsigned int timeoutInSeconds = 60 * timeoutInMinutes;
 
-        result = downloadProc(entity, workflowId, workFolder.get(), timeoutInSeconds, downloadProgressCallback);
+        if (downloadWithDigestProc != nullptr)
+        {
+            result = downloadWithDigestProc(
+                entity,
+                workflowId,
+                workFolder.get(),
+                timeoutInSeconds,
+                downloadProgressCallback,
+                downloadedDigest,
+                sizeof(downloadedDigest));
+        }
+        else
+        {
+            result = downloadProc(entity, workflowId, workFolder.get(), timeoutInSeconds, downloadProgressCallback);
+        }
         if (IsAducResultCodeFailure(result.ResultCode))
         {
             goto done;
@@ -957,17 +1227,24 @@ ADUC_Result ExtensionManager::Download(
 
     if (IsAducResultCodeSuccess(result.ResultCode))
     {
-        if (!ADUC_HashUtils_IsValidFileHash(
-                targetUpdateFilePath.c_str(),
-                ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0),
-                algVersion,
-                false))
+        const char* expectedHash = ADUC_HashUtils_GetHashValue(entity->Hash, entity->HashCount, 0);
+
+        // If the downloader computed the digest from the bytes it wrote, compare digests
+        // instead of reading the whole file back from disk.
+        const bool isValidHash = (downloadedDigest[0] != '\0')
+            ? (expectedHash != nullptr && strcmp(downloadedDigest, expectedHash) == 0)
+            : ADUC_HashUtils_IsValidFileHash(targetUpdateFilePath.c_str(), expectedHash, algVersion, false);
+
+        if (!isValidHash)
         {
             result.ResultCode = ADUC_Result_Failure;
             result.ExtendedResultCode = ADUC_ERC_CONTENT_DOWNLOADER_INVALID_FILE_HASH;
 
             Log_Error("Successful download of '%s' failed hash check.", targetUpdateFilePath.c_str());
-            workflow_add_erc(workflowHandle, result.ExtendedResultCode);
+            {
+                std::lock_guard<std::mutex> lock{ s_downloadWorkflowMutex };
+                workflow_add_erc(workflowHandle, result.ExtendedResultCode);
+            }
 
             goto done;
         }
@@ -981,6 +1258,118 @@ ADUC_Result ExtensionManager::Download(
     result.ResultCode = ADUC_GeneralResult_Success;
     result.ExtendedResultCode = 0;
 
+done:
+
+    if (isDownloadTimed)
+    {
+        ADUC_Timing_EndSpan(workflow_get_timing_report(workflowHandle), &downloadSpan);
+    }
+
+    return result;
+}
+
+ADUC_Result ExtensionManager::DownloadBatch(
+    const ADUC_FileEntity* entities,
+    size_t entityCount,
+    WorkflowHandle workflowHandle,
+    ExtensionManager_Download_Options* options,
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    ADUC_DownloadProcResolver downloadProcResolver)
+{
+    ADUC_Result result = { /* .ResultCode = */ ADUC_Result_Download_Success, /* .ExtendedResultCode = */ 0 };
+    void* lib = nullptr;
+
+    if (entityCount == 0)
+    {
+        goto done;
+    }
+
+    if (entities == nullptr)
+    {
+        result = { /* .ResultCode = */ ADUC_Result_Failure,
+                   /* .ExtendedResultCode = */ ADUC_ERC_CONTENT_DOWNLOADER_INVALID_FILE_ENTITY };
+        goto done;
+    }
+
+    // Load the content downloader up front so that worker threads only ever read the cached library state.
+    result = ExtensionManager::LoadContentDownloaderLibrary(&lib);
+    if (IsAducResultCodeFailure(result.ResultCode))
+    {
+        goto done;
+    }
+
+    {
+        const size_t workerCount =
+            std::min<size_t>(GetMaxConcurrentDownloads(_contentDownloaderSupportsConcurrentCalls), entityCount);
+        std::vector<ADUC_Result> results(entityCount, ADUC_Result{ ADUC_Result_Failure, 0 });
+        std::vector<char> attempted(entityCount, 0);
+        std::atomic<size_t> nextIndex{ 0 };
+        std::atomic<bool> failed{ false };
+
+        Log_Info("Downloading %zu file(s), up to %zu at a time.", entityCount, workerCount);
+
+        auto worker = [&]() {
+            for (size_t i = nextIndex++; i < entityCount && !failed; i = nextIndex++)
+            {
+                attempted[i] = 1;
+
+                try
+                {
+                    results[i] = ExtensionManager::Download(
+                        &entities[i], workflowHandle, options, downloadProgressCallback, downloadProcResolver);
+                }
+                catch (...)
+                {
+                    Log_Error("Exception occurred while downloading file #%zu.", i);
+                    results[i] = { /* .ResultCode = */ ADUC_Result_Failure,
+                                   /* .ExtendedResultCode = */ ADUC_ERC_CONTENT_DOWNLOADER_DOWNLOAD_EXCEPTION };
+                }
+
+                if (IsAducResultCodeFailure(results[i].ResultCode))
+                {
+                    Log_Error("Cannot download file #%zu. (0x%X)", i, results[i].ExtendedResultCode);
+                    failed = true;
+                }
+            }
+        };
+
+        // The calling thread is one of the workers.
+        std::vector<std::thread> threads;
+        threads.reserve(workerCount - 1);
+        for (size_t t = 1; t < workerCount; ++t)
+        {
+            try
+            {
+                threads.emplace_back(worker);
+            }
+            catch (const std::system_error& e)
+            {
+                // Carry on with the workers that did start.
+                Log_Warn("Cannot start download worker thread: %s", e.what());
+                break;
+            }
+        }
+
+        worker();
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+
+        // Report the first failure in batch order, skipping files that were never started.
+        for (size_t i = 0; i < entityCount; ++i)
+        {
+            if (attempted[i] != 0 && IsAducResultCodeFailure(results[i].ResultCode))
+            {
+                result = results[i];
+                goto done;
+            }
+        }
+    }
+
+    result = { /* .ResultCode = */ ADUC_Result_Download_Success, /* .ExtendedResultCode = */ 0 };
+
 done:
 
     return result;
@@ -1002,6 +1391,11 @@ ADUC_Result ExtensionManager_Download(
     return ExtensionManager::Download(entity, workflowHandle, options, downloadProgressCallback);
 }
 
+void ExtensionManager_InvalidateComponentsCache()
+{
+    ExtensionManager::InvalidateComponentsCache();
+}
+
 /**
  * @brief Uninitializes the extension manager.
  */
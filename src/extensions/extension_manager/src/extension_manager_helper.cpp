@@ -147,3 +147,48 @@ unsigned int GetDownloadTimeoutInMinutes(const ExtensionManager_Download_Options
 done:
     return ret;
 }
+
+/**
+ * @brief Get the maximum number of concurrent payload downloads, from the config file or the compile-time default.
+ * @param downloaderSupportsConcurrentCalls Whether the content downloader opted in to concurrent calls.
+ * @return unsigned int The maximum number of downloads in flight at the same time. Always at least 1,
+ * and 1 if the content downloader has not opted in to concurrent calls.
+ */
+unsigned int GetMaxConcurrentDownloads(bool downloaderSupportsConcurrentCalls) noexcept
+{
+    unsigned int ret = 1;
+    const ADUC_ConfigInfo* config = nullptr;
+
+    if (!downloaderSupportsConcurrentCalls)
+    {
+        Log_Debug("Content downloader does not support concurrent calls. Downloading one file at a time.");
+        goto done;
+    }
+
+    ret = CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_DEFAULT;
+    config = ADUC_ConfigInfo_GetInstance();
+    if (config == nullptr)
+    {
+        Log_Error("ADUC_ConfigInfo singleton hasn't been initialized.");
+        goto done;
+    }
+
+    if (config->maxConcurrentDownloads != 0)
+    {
+        Log_Info("maxConcurrentDownloads override from config: %u", config->maxConcurrentDownloads);
+        ret = config->maxConcurrentDownloads;
+        if (ret > CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_LIMIT)
+        {
+            Log_Warn(
+                "maxConcurrentDownloads %u exceeds the limit. Using %u.",
+                ret,
+                CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_LIMIT);
+            ret = CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_LIMIT;
+        }
+    }
+
+    ADUC_ConfigInfo_ReleaseInstance(config);
+
+done:
+    return ret;
+}
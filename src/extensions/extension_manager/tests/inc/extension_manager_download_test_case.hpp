@@ -10,8 +10,16 @@
 #define EXTENSIONMANAGER_DOWNLOAD_TEST_CASE
 
 #include <aduc/extension_manager.hpp>
+#include <aduc/extension_manager_download_options.h> // CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_DEFAULT
 #include <aduc/result.h>
 
+#include <cstddef>
+
+/**
+ * @brief The number of files in the batch scenarios; more than the number of downloads run at a time.
+ */
+constexpr size_t batchScenarioEntityCount = 2 * CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_DEFAULT + 2;
+
 /**
  * @brief The extension manager download test scenarios.
  *
@@ -21,6 +29,12 @@ enum class DownloadTestScenario
     Invalid,
     BasicDownloadSuccess,
     BasicDownloadFailure,
+    BatchDownloadSuccess,
+    BatchDownloadFailure,
+    BatchDownloadConcurrent,
+    BatchDownloadStopsAfterFailure,
+    BatchDownloadFirstFailureInBatchOrder,
+    BatchDownloadWithoutConcurrentCalls,
 };
 
 class ExtensionManagerDownloadTestCase
@@ -52,6 +66,16 @@ public:
         return expected_result;
     }
 
+    /**
+     * @brief Gets the highest number of downloads that were in progress at the same time.
+     */
+    size_t GetMaxDownloadsInFlight() const;
+
+    /**
+     * @brief Gets the number of downloads that were started.
+     */
+    size_t GetStartedDownloadCount() const;
+
 private:
     void InitCommon();
     void RunCommon();
@@ -63,6 +87,9 @@ private:
     ADUC_Result expected_result{};
 
     ADUC_DownloadProcResolver mockProcResolver{ nullptr };
+    bool useDownloadBatch{ false };
+    bool downloaderSupportsConcurrentCalls{ true };
+    size_t batchEntityCount{ 1 };
 
     ADUC_WorkflowHandle workflowHandle{ nullptr };
 };
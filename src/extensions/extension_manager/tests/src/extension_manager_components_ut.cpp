@@ -0,0 +1,93 @@
+/**
+ * @file extension_manager_components_ut.cpp
+ * @brief Unit Tests for the extension manager's component enumerator cache.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <aduc/c_utils.h> // EXPORTED_METHOD
+#include <aduc/extension_manager.hpp>
+#include <aduc/result.h>
+#include <aducpal/dlfcn.h> // ADUCPAL_dlopen, ADUCPAL_dlclose
+#include <atomic>
+#include <catch2/catch.hpp>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+
+// A component enumerator without a GetComponentsVersion export, exported by this test executable.
+static std::atomic<int> s_selectComponentsCalls{ 0 };
+
+extern "C" {
+
+EXPORTED_METHOD char* SelectComponents(const char* /* selectorJson */)
+{
+    std::string components =
+        R"({"components":[{"id":")" + std::to_string(++s_selectComponentsCalls) + R"("}]})";
+    return strdup(components.c_str());
+}
+
+EXPORTED_METHOD void FreeComponentsDataString(char* string)
+{
+    free(string); // NOLINT(cppcoreguidelines-no-malloc,hicpp-no-malloc)
+}
+
+} // extern "C"
+
+/**
+ * @brief Uses this executable as the component enumerator for the lifetime of the object.
+ */
+class TestComponentEnumerator
+{
+public:
+    TestComponentEnumerator() : _lib(ADUCPAL_dlopen(nullptr, RTLD_LAZY))
+    {
+        REQUIRE(_lib != nullptr);
+        REQUIRE(IsAducResultCodeSuccess(ExtensionManager::SetComponentEnumeratorLibrary(_lib).ResultCode));
+        s_selectComponentsCalls = 0;
+    }
+
+    TestComponentEnumerator(const TestComponentEnumerator&) = delete;
+    TestComponentEnumerator& operator=(const TestComponentEnumerator&) = delete;
+    TestComponentEnumerator(TestComponentEnumerator&&) = delete;
+    TestComponentEnumerator& operator=(TestComponentEnumerator&&) = delete;
+
+    ~TestComponentEnumerator()
+    {
+        ExtensionManager::SetComponentEnumeratorLibrary(nullptr);
+        ADUCPAL_dlclose(_lib);
+    }
+
+private:
+    void* _lib;
+};
+
+TEST_CASE("ExtensionManager::SelectComponents caches an enumerator without a version until invalidated")
+{
+    TestComponentEnumerator enumerator;
+    const std::string selector = R"({"group":"motors"})";
+    std::string first;
+    std::string second;
+
+    REQUIRE(IsAducResultCodeSuccess(ExtensionManager::SelectComponents(selector, first).ResultCode));
+    REQUIRE(IsAducResultCodeSuccess(ExtensionManager::SelectComponents(selector, second).ResultCode));
+    CHECK(s_selectComponentsCalls == 1);
+    CHECK(first == R"({"components":[{"id":"1"}]})");
+    CHECK(second == first);
+
+    SECTION("A different selector queries the enumerator")
+    {
+        std::string other;
+        REQUIRE(IsAducResultCodeSuccess(ExtensionManager::SelectComponents(R"({"group":"fans"})", other).ResultCode));
+        CHECK(s_selectComponentsCalls == 2);
+    }
+
+    SECTION("Invalidating the cache queries the enumerator again")
+    {
+        std::string afterInvalidate;
+        ExtensionManager::InvalidateComponentsCache();
+        REQUIRE(IsAducResultCodeSuccess(ExtensionManager::SelectComponents(selector, afterInvalidate).ResultCode));
+        CHECK(s_selectComponentsCalls == 2);
+        CHECK(afterInvalidate == R"({"components":[{"id":"2"}]})");
+    }
+}
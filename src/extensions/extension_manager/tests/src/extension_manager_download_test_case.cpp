@@ -18,13 +18,18 @@
 #include <aduc/workflow_utils.h>
 #include <aducpal/stdio.h> // remove
 #include <aducpal/unistd.h> // UNREFERENCED_PARAMETER
+#include <atomic>
 #include <catch2/catch.hpp>
+#include <chrono>
 #include <fstream>
+#include <functional>
 #include <memory>
 #include <parson.h>
 #include <stdexcept>
 #include <stdio.h>
 #include <string>
+#include <thread>
+#include <vector>
 
 struct json_value_deleter
 {
@@ -41,6 +46,7 @@ MockLib mockLib;
 ADUC_ExtensionContractInfo mockContractInfo{ 1, 0 };
 
 const int32_t FailureERC = 0xD0070070;
+const int32_t LaterFailureERC = 0xD0070071;
 char mockTargetFilename[] = "mock_update_payload.txt";
 char mockPayloadContent[] = "hello";
 
@@ -51,6 +57,155 @@ const std::string downloaded_file_path = testWorkfolder + "/" + mockTargetFilena
 
 using unique_json_value = std::unique_ptr<JSON_Value, json_value_deleter>;
 
+// Batch scenario state, shared by the mock download procs on the batch's worker threads.
+static std::atomic<size_t> s_downloadsInFlight{ 0 };
+static std::atomic<size_t> s_maxDownloadsInFlight{ 0 };
+static std::atomic<size_t> s_startedDownloads{ 0 };
+static std::atomic<bool> s_batchFailureReturned{ false };
+
+/**
+ * @brief Waits until @p condition is true, or a few seconds have passed, so a broken scheduler fails the test
+ * instead of hanging it.
+ */
+static void WaitFor(const std::function<bool()>& condition)
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+    while (!condition() && std::chrono::steady_clock::now() < deadline)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+/**
+ * @brief Gets the index of a batch scenario entity, which is its FileId.
+ */
+static size_t GetBatchEntityIndex(const ADUC_FileEntity* entity)
+{
+    return std::stoul(entity->FileId);
+}
+
+static void BeginBatchDownload()
+{
+    ++s_startedDownloads;
+    const size_t inFlight = ++s_downloadsInFlight;
+    size_t maxInFlight = s_maxDownloadsInFlight;
+    while (inFlight > maxInFlight && !s_maxDownloadsInFlight.compare_exchange_weak(maxInFlight, inFlight))
+    {
+    }
+}
+
+static ADUC_Result EndBatchDownload(const ADUC_FileEntity* entity, const char* workFolder)
+{
+    const std::string filePath = std::string{ workFolder } + "/" + entity->TargetFilename;
+    std::ofstream fileStream;
+    fileStream.open(filePath.c_str(), std::ios::out | std::ios::trunc);
+    fileStream << mockPayloadContent;
+    fileStream.close();
+
+    --s_downloadsInFlight;
+    return ADUC_Result{ 1, 0 };
+}
+
+static ADUC_Result EndFailedBatchDownload(int32_t erc)
+{
+    --s_downloadsInFlight;
+    return ADUC_Result{ 0, erc };
+}
+
+/**
+ * @brief Holds each download until the batch has reached its maximum concurrency.
+ */
+static ADUC_Result MockConcurrentDownloadProc(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback)
+{
+    UNREFERENCED_PARAMETER(workflowId);
+    UNREFERENCED_PARAMETER(timeoutInSeconds);
+    UNREFERENCED_PARAMETER(downloadProgressCallback);
+
+    BeginBatchDownload();
+    WaitFor([]() { return s_maxDownloadsInFlight >= CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_DEFAULT; });
+    return EndBatchDownload(entity, workFolder);
+}
+
+/**
+ * @brief Fails the second file, while the other downloads in flight complete only after that failure.
+ */
+static ADUC_Result MockStopsAfterFailureDownloadProc(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback)
+{
+    UNREFERENCED_PARAMETER(workflowId);
+    UNREFERENCED_PARAMETER(timeoutInSeconds);
+    UNREFERENCED_PARAMETER(downloadProgressCallback);
+
+    BeginBatchDownload();
+    if (GetBatchEntityIndex(entity) == 1)
+    {
+        s_batchFailureReturned = true;
+        return EndFailedBatchDownload(FailureERC);
+    }
+
+    WaitFor([]() { return s_batchFailureReturned.load(); });
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    return EndBatchDownload(entity, workFolder);
+}
+
+/**
+ * @brief Fails the fourth file first, then the third.
+ */
+static ADUC_Result MockOutOfOrderFailuresDownloadProc(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback)
+{
+    UNREFERENCED_PARAMETER(workflowId);
+    UNREFERENCED_PARAMETER(timeoutInSeconds);
+    UNREFERENCED_PARAMETER(downloadProgressCallback);
+
+    BeginBatchDownload();
+    switch (GetBatchEntityIndex(entity))
+    {
+    case 2:
+        WaitFor([]() { return s_batchFailureReturned.load(); });
+        return EndFailedBatchDownload(FailureERC);
+
+    case 3:
+        s_batchFailureReturned = true;
+        return EndFailedBatchDownload(LaterFailureERC);
+
+    default:
+        return EndBatchDownload(entity, workFolder);
+    }
+}
+
+/**
+ * @brief Keeps each download in flight for a while, so overlapping downloads would be seen.
+ */
+static ADUC_Result MockSlowDownloadProc(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback)
+{
+    UNREFERENCED_PARAMETER(workflowId);
+    UNREFERENCED_PARAMETER(timeoutInSeconds);
+    UNREFERENCED_PARAMETER(downloadProgressCallback);
+
+    BeginBatchDownload();
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    return EndBatchDownload(entity, workFolder);
+}
+
 static ADUC_Result MockDownloadSuccessProc(
     const ADUC_FileEntity* entity,
     const char* workflowId,
@@ -101,6 +256,38 @@ static DownloadProc mockDownloadFailureProcResolver(void* lib)
     return MockDownloadFailureProc;
 }
 
+static DownloadProc mockConcurrentDownloadProcResolver(void* lib)
+{
+    UNREFERENCED_PARAMETER(lib);
+    return MockConcurrentDownloadProc;
+}
+
+static DownloadProc mockStopsAfterFailureDownloadProcResolver(void* lib)
+{
+    UNREFERENCED_PARAMETER(lib);
+    return MockStopsAfterFailureDownloadProc;
+}
+
+static DownloadProc mockOutOfOrderFailuresDownloadProcResolver(void* lib)
+{
+    UNREFERENCED_PARAMETER(lib);
+    return MockOutOfOrderFailuresDownloadProc;
+}
+
+static DownloadProc mockSlowDownloadProcResolver(void* lib)
+{
+    UNREFERENCED_PARAMETER(lib);
+    return MockSlowDownloadProc;
+}
+
+/**
+ * @brief Gets the work folder file name of batch scenario entity @p index.
+ */
+static std::string GetBatchTargetFilename(size_t index)
+{
+    return "mock_update_payload_" + std::to_string(index) + ".txt";
+}
+
 static void setupWorkflowHandle(const char* msgJson, ADUC_WorkflowHandle* outWorkflowHandle)
 {
     ADUC_Result result{ workflow_init(msgJson, false /* validateManifest */, outWorkflowHandle) };
@@ -133,6 +320,53 @@ void ExtensionManagerDownloadTestCase::RunScenario()
         expected_result.ExtendedResultCode = FailureERC;
         break;
 
+    case DownloadTestScenario::BatchDownloadSuccess:
+        mockProcResolver = mockDownloadSuccessProcResolver;
+        useDownloadBatch = true;
+        expected_result.ResultCode = ADUC_Result_Download_Success;
+        expected_result.ExtendedResultCode = 0;
+        break;
+
+    case DownloadTestScenario::BatchDownloadFailure:
+        mockProcResolver = mockDownloadFailureProcResolver;
+        useDownloadBatch = true;
+        expected_result.ResultCode = 0;
+        expected_result.ExtendedResultCode = FailureERC;
+        break;
+
+    case DownloadTestScenario::BatchDownloadConcurrent:
+        mockProcResolver = mockConcurrentDownloadProcResolver;
+        useDownloadBatch = true;
+        batchEntityCount = batchScenarioEntityCount;
+        expected_result.ResultCode = ADUC_Result_Download_Success;
+        expected_result.ExtendedResultCode = 0;
+        break;
+
+    case DownloadTestScenario::BatchDownloadStopsAfterFailure:
+        mockProcResolver = mockStopsAfterFailureDownloadProcResolver;
+        useDownloadBatch = true;
+        batchEntityCount = batchScenarioEntityCount;
+        expected_result.ResultCode = 0;
+        expected_result.ExtendedResultCode = FailureERC;
+        break;
+
+    case DownloadTestScenario::BatchDownloadFirstFailureInBatchOrder:
+        mockProcResolver = mockOutOfOrderFailuresDownloadProcResolver;
+        useDownloadBatch = true;
+        batchEntityCount = batchScenarioEntityCount;
+        expected_result.ResultCode = 0;
+        expected_result.ExtendedResultCode = FailureERC;
+        break;
+
+    case DownloadTestScenario::BatchDownloadWithoutConcurrentCalls:
+        mockProcResolver = mockSlowDownloadProcResolver;
+        useDownloadBatch = true;
+        downloaderSupportsConcurrentCalls = false;
+        batchEntityCount = batchScenarioEntityCount;
+        expected_result.ResultCode = ADUC_Result_Download_Success;
+        expected_result.ExtendedResultCode = 0;
+        break;
+
     default:
         throw std::invalid_argument("invalid scenario");
     }
@@ -142,6 +376,11 @@ void ExtensionManagerDownloadTestCase::RunScenario()
 
 void ExtensionManagerDownloadTestCase::InitCommon()
 {
+    s_downloadsInFlight = 0;
+    s_maxDownloadsInFlight = 0;
+    s_startedDownloads = 0;
+    s_batchFailureReturned = false;
+
     ExtensionManager::SetContentDownloaderLibrary(&mockLib);
     ExtensionManager::SetContentDownloaderContractVersion(mockContractInfo);
 
@@ -167,6 +406,36 @@ void ExtensionManagerDownloadTestCase::RunCommon()
     REQUIRE(workflow_get_update_file(workflowHandle, 0, &fileEntity));
 
     ExtensionManager_Download_Options downloadOptions{ 1 /*timeoutInMinutes*/ };
+    if (useDownloadBatch)
+    {
+        ExtensionManager::SetContentDownloaderSupportsConcurrentCalls(downloaderSupportsConcurrentCalls);
+
+        // Copies of the manifest's file entity, each with its own id and target file. The copies share the
+        // other members with fileEntity, which owns them.
+        std::vector<std::string> fileIds;
+        std::vector<std::string> targetFilenames;
+        std::vector<ADUC_FileEntity> entities(batchEntityCount, fileEntity);
+
+        fileIds.reserve(batchEntityCount);
+        targetFilenames.reserve(batchEntityCount);
+        for (size_t i = 0; batchEntityCount > 1 && i < batchEntityCount; ++i)
+        {
+            fileIds.push_back(std::to_string(i));
+            targetFilenames.push_back(GetBatchTargetFilename(i));
+            entities[i].FileId = &fileIds.back()[0];
+            entities[i].TargetFilename = &targetFilenames.back()[0];
+        }
+
+        actual_result = ExtensionManager::DownloadBatch(
+            entities.data(),
+            entities.size(),
+            workflowHandle,
+            &downloadOptions,
+            nullptr, // downloadProgressCallback
+            mockProcResolver);
+        return;
+    }
+
     actual_result = ExtensionManager::Download(
         &fileEntity,
         workflowHandle,
@@ -175,8 +444,22 @@ void ExtensionManagerDownloadTestCase::RunCommon()
         mockProcResolver);
 }
 
+size_t ExtensionManagerDownloadTestCase::GetMaxDownloadsInFlight() const
+{
+    return s_maxDownloadsInFlight;
+}
+
+size_t ExtensionManagerDownloadTestCase::GetStartedDownloadCount() const
+{
+    return s_startedDownloads;
+}
+
 void ExtensionManagerDownloadTestCase::Cleanup()
 {
     remove(downloaded_file_path.c_str());
+    for (size_t i = 0; i < batchEntityCount; ++i)
+    {
+        remove((testWorkfolder + "/" + GetBatchTargetFilename(i)).c_str());
+    }
     workflow_free(workflowHandle);
 }
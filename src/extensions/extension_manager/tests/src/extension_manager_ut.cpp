@@ -37,3 +37,67 @@ TEST_CASE("ExtensionManager::Download failure should return failure ResultCode a
     CHECK(actual_result.ResultCode == expected_result.ResultCode);
     CHECK(actual_result.ExtendedResultCode == expected_result.ExtendedResultCode);
 }
+
+TEST_CASE("ExtensionManager::DownloadBatch success should return success ResultCode")
+{
+    ExtensionManagerDownloadTestCase testCase{ DownloadTestScenario::BatchDownloadSuccess };
+    REQUIRE_NOTHROW(testCase.RunScenario());
+
+    ADUC_Result actual_result = testCase.GetActualResult();
+    ADUC_Result expected_result = testCase.GetExpectedResult();
+
+    CHECK(actual_result.ResultCode == expected_result.ResultCode);
+    CHECK(actual_result.ExtendedResultCode == expected_result.ExtendedResultCode);
+}
+
+TEST_CASE("ExtensionManager::DownloadBatch failure should return the failed download's ResultCode and ERC")
+{
+    ExtensionManagerDownloadTestCase testCase{ DownloadTestScenario::BatchDownloadFailure };
+    REQUIRE_NOTHROW(testCase.RunScenario());
+
+    ADUC_Result actual_result = testCase.GetActualResult();
+    ADUC_Result expected_result = testCase.GetExpectedResult();
+
+    CHECK(actual_result.ResultCode == expected_result.ResultCode);
+    CHECK(actual_result.ExtendedResultCode == expected_result.ExtendedResultCode);
+}
+
+TEST_CASE("ExtensionManager::DownloadBatch runs up to the maximum number of downloads at a time")
+{
+    ExtensionManagerDownloadTestCase testCase{ DownloadTestScenario::BatchDownloadConcurrent };
+    REQUIRE_NOTHROW(testCase.RunScenario());
+
+    CHECK(testCase.GetActualResult() == testCase.GetExpectedResult());
+    CHECK(testCase.GetStartedDownloadCount() == batchScenarioEntityCount);
+    CHECK(testCase.GetMaxDownloadsInFlight() == CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_DEFAULT);
+}
+
+TEST_CASE("ExtensionManager::DownloadBatch starts no new downloads after a failure")
+{
+    ExtensionManagerDownloadTestCase testCase{ DownloadTestScenario::BatchDownloadStopsAfterFailure };
+    REQUIRE_NOTHROW(testCase.RunScenario());
+
+    CHECK(testCase.GetActualResult() == testCase.GetExpectedResult());
+
+    // Only the downloads already in flight when the second file failed were started.
+    CHECK(testCase.GetStartedDownloadCount() <= CONTENT_DOWNLOADER_MAX_CONCURRENT_DOWNLOADS_DEFAULT);
+}
+
+TEST_CASE("ExtensionManager::DownloadBatch reports the first failure in batch order")
+{
+    ExtensionManagerDownloadTestCase testCase{ DownloadTestScenario::BatchDownloadFirstFailureInBatchOrder };
+    REQUIRE_NOTHROW(testCase.RunScenario());
+
+    // The fourth file fails before the third, but the third file's failure is reported.
+    CHECK(testCase.GetActualResult() == testCase.GetExpectedResult());
+}
+
+TEST_CASE("ExtensionManager::DownloadBatch downloads one file at a time if the downloader has not opted in")
+{
+    ExtensionManagerDownloadTestCase testCase{ DownloadTestScenario::BatchDownloadWithoutConcurrentCalls };
+    REQUIRE_NOTHROW(testCase.RunScenario());
+
+    CHECK(testCase.GetActualResult() == testCase.GetExpectedResult());
+    CHECK(testCase.GetStartedDownloadCount() == batchScenarioEntityCount);
+    CHECK(testCase.GetMaxDownloadsInFlight() == 1);
+}
@@ -129,6 +129,15 @@ typedef char* (*SelectComponentsProc)(const char* selector);
  */
 typedef char* (*GetAllComponentsProc)();
 
+/**
+ * @brief Optional. Returns a version string of the component inventory, e.g. an etag or a change counter.
+ * The string must change whenever the result of GetAllComponents or SelectComponents may change.
+ * The agent reuses component data it has already retrieved for as long as the version stays the same.
+ * @return Returns the version string, or nullptr if unknown.
+ * Caller must call FreeComponentsDataString function when done with the returned string.
+ */
+typedef char* (*GetComponentsVersionProc)();
+
 /**
  * @brief Free string buffer previously returned by Component Enumerator APIs.
  * @param string A pointer to string to be freed.
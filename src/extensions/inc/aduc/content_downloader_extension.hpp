@@ -21,6 +21,15 @@ typedef ADUC_Result (*DownloadProc)(
     unsigned int timeoutInSeconds,
     ADUC_DownloadProgressCallback downloadProgressCallback);
 
+typedef ADUC_Result (*DownloadWithDigestProc)(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64,
+    size_t digestBase64Size);
+
 EXTERN_C_END
 
 #endif // ADUC_CONTENT_DOWNLOADER_EXTENSION_HPP
@@ -18,6 +18,11 @@ struct tagADUC_WorkflowData;
 /**
  * @interface ContentHandler
  * @brief Interface for content specific handler implementations.
+ *
+ * By default, the agent calls a handler instance from one thread at a time. A handler whose methods can run
+ * concurrently, on different step workflows, may export `bool SupportsConcurrentCalls()` returning true
+ * (see CONTENT_HANDLER__SupportsConcurrentCalls__EXPORT_SYMBOL). The steps handler then may, for example,
+ * download a step's payloads while the previous step installs, or process several components at the same time.
  */
 class ContentHandler
 {
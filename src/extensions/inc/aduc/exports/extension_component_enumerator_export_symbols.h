@@ -57,6 +57,16 @@
  */
 #define COMPONENT_ENUMERATOR__SelectComponents__EXPORT_SYMBOL "SelectComponents"
 
+/**
+ * @brief Optional. Returns a version string of the component inventory that changes whenever the inventory changes.
+ * Enumerators that do not export it have their component data cached for the duration of a deployment.
+ *
+ * @return Returns the version string, or nullptr if unknown.
+ * Caller must call FreeComponentsDataString function when done with the returned string.
+ * @details char* GetComponentsVersion()
+ */
+#define COMPONENT_ENUMERATOR__GetComponentsVersion__EXPORT_SYMBOL "GetComponentsVersion"
+
 /**
  * @brief Frees the components data string allocated by GetAllComponents.
  *
@@ -45,4 +45,40 @@ ADUC_Result Download(
  */
 #define CONTENT_DOWNLOADER__Download__EXPORT_SYMBOL "Download"
 
+/**
+ * @brief Optional download export that also hands back the digest of the downloaded content.
+ *
+ * @details Same as Download, but on success @p digestBase64 receives the base64 encoded digest,
+ * computed with the algorithm of the entity's first hash, of the content as it was written to disk.
+ * This lets the agent verify the payload with a digest compare instead of reading the file back.
+ * An empty @p digestBase64 on success means the digest is not available and the agent hashes the file itself.
+ *
+ * @param entity The file entity.
+ * @param workflowId The workflow id.
+ * @param workFolder The work folder for the update payloads.
+ * @param timeoutInSeconds The maximum number of seconds to wait to receive data whilst network stays up before the download will timeout.
+ * @param downloadProgressCallback The download progress callback function.
+ * @param digestBase64 The output buffer for the null-terminated, base64 encoded digest.
+ * @param digestBase64Size The size of @p digestBase64.
+ * @return ADUC_Result The result.
+ * @details
+ADUC_Result DownloadWithDigest(
+    const ADUC_FileEntity* entity,
+    const char* workflowId,
+    const char* workFolder,
+    unsigned int timeoutInSeconds,
+    ADUC_DownloadProgressCallback downloadProgressCallback,
+    char* digestBase64,
+    size_t digestBase64Size)
+ */
+#define CONTENT_DOWNLOADER__DownloadWithDigest__EXPORT_SYMBOL "DownloadWithDigest"
+
+/**
+ * @brief Optional. Tells whether Download and DownloadWithDigest may be called from more than one thread at a time,
+ * each call for a different file. Without this symbol, the downloader is never called concurrently.
+ * @return bool true if concurrent calls are supported.
+ * @details bool SupportsConcurrentCalls()
+ */
+#define CONTENT_DOWNLOADER__SupportsConcurrentCalls__EXPORT_SYMBOL "SupportsConcurrentCalls"
+
 #endif // EXTENSION_CONTENT_DOWNLOADER_EXPORT_SYMBOLS_H
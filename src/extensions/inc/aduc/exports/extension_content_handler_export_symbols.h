@@ -23,4 +23,12 @@
  */
 #define CONTENT_HANDLER__CreateUpdateContentHandlerExtension__EXPORT_SYMBOL "CreateUpdateContentHandlerExtension"
 
+/**
+ * @brief Optional. Tells whether the handler's methods may be called from more than one thread at a time, each
+ * call with a different step workflow. Without this symbol, a handler is never called concurrently.
+ * @return bool true if concurrent calls are supported.
+ * @details bool SupportsConcurrentCalls()
+ */
+#define CONTENT_HANDLER__SupportsConcurrentCalls__EXPORT_SYMBOL "SupportsConcurrentCalls"
+
 #endif // EXTENSION_CONTENT_HANDLER_EXPORT_SYMBOLS
@@ -190,9 +190,8 @@ ADUC_Result ScriptHandlerImpl::Download(const tagADUC_WorkflowData* workflowData
     ADUC_WorkflowHandle workflowHandle = workflowData->WorkflowHandle;
     char* installedCriteria = nullptr;
     char* workFolder = workflow_get_workfolder(workflowData->WorkflowHandle);
-    ADUC_FileEntity fileEntity;
-    memset(&fileEntity, 0, sizeof(fileEntity));
     const size_t fileCount = workflow_get_update_files_count(workflowHandle);
+    std::vector<ADUC_FileEntity> fileEntities(fileCount); // zero-initialized
     ADUC_Result result = Script_Handler_DownloadPrimaryScriptFile(workflowHandle);
 
     if (IsAducResultCodeFailure(result.ResultCode))
@@ -214,32 +213,31 @@ ADUC_Result ScriptHandlerImpl::Download(const tagADUC_WorkflowData* workflowData
 
     for (size_t i = 0; i < fileCount; i++)
     {
-        Log_Info("Downloading file #%u", i);
-
-        if (!workflow_get_update_file(workflowHandle, i, &fileEntity))
+        if (!workflow_get_update_file(workflowHandle, i, &fileEntities[i]))
         {
             result.ResultCode = ADUC_Result_Failure;
             result.ExtendedResultCode = ADUC_ERC_SCRIPT_HANDLER_DOWNLOAD_FAILURE_GET_PAYLOAD_FILE_ENTITY;
             goto done;
         }
+    }
 
-        try
-        {
-            result = ExtensionManager::Download(
-                &fileEntity, workflowHandle, &Default_ExtensionManager_Download_Options, nullptr);
-            ADUC_FileEntity_Uninit(&fileEntity);
-        }
-        catch (...)
-        {
-            result.ResultCode = ADUC_Result_Failure;
-            result.ExtendedResultCode = ADUC_ERC_SCRIPT_HANDLER_DOWNLOAD_PAYLOAD_FILE_FAILURE_UNKNOWNEXCEPTION;
-        }
+    Log_Info("Downloading %zu script payload file(s)", fileCount);
 
-        if (IsAducResultCodeFailure(result.ResultCode))
-        {
-            Log_Error("Cannot download script payload file#%d. (0x%X)", i, result.ExtendedResultCode);
-            goto done;
-        }
+    try
+    {
+        result = ExtensionManager::DownloadBatch(
+            fileEntities.data(), fileCount, workflowHandle, &Default_ExtensionManager_Download_Options, nullptr);
+    }
+    catch (...)
+    {
+        result.ResultCode = ADUC_Result_Failure;
+        result.ExtendedResultCode = ADUC_ERC_SCRIPT_HANDLER_DOWNLOAD_PAYLOAD_FILE_FAILURE_UNKNOWNEXCEPTION;
+    }
+
+    if (IsAducResultCodeFailure(result.ResultCode))
+    {
+        Log_Error("Cannot download script payload files. (0x%X)", result.ExtendedResultCode);
+        goto done;
     }
 
     // Invoke primary script to download additional files, if required.
@@ -247,7 +245,10 @@ ADUC_Result ScriptHandlerImpl::Download(const tagADUC_WorkflowData* workflowData
 
 done:
     workflow_free_string(workFolder);
-    ADUC_FileEntity_Uninit(&fileEntity);
+    for (auto& fileEntity : fileEntities)
+    {
+        ADUC_FileEntity_Uninit(&fileEntity);
+    }
     workflow_free_string(installedCriteria);
     Log_Info("Script_Handler download task end.");
     return result;
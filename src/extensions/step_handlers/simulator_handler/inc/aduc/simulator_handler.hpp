@@ -19,6 +19,12 @@ EXTERN_C_BEGIN
  */
 EXPORTED_METHOD ContentHandler* CreateUpdateContentHandlerExtension(ADUC_LOG_SEVERITY logLevel);
 
+/**
+ * @brief Tells the agent that the simulator may be called concurrently, on different step workflows.
+ * @return true.
+ */
+EXPORTED_METHOD bool SupportsConcurrentCalls();
+
 EXTERN_C_END
 
 /**
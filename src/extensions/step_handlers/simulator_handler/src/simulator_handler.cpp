@@ -67,6 +67,17 @@ EXPORTED_METHOD ADUC_Result GetContractInfo(ADUC_ExtensionContractInfo* contract
     return ADUC_Result{ ADUC_GeneralResult_Success, 0 };
 }
 
+/**
+ * @brief Tells the agent that the handler may be called concurrently, on different step workflows.
+ * The handler has no mutable state; each call reads the simulator data file into its own json value.
+ *
+ * @return bool true.
+ */
+EXPORTED_METHOD bool SupportsConcurrentCalls()
+{
+    return true;
+}
+
 //
 // END Shared Library Export Functions
 /////////////////////////////////////////////////////////////////////////////
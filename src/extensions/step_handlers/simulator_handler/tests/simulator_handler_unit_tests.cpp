@@ -15,6 +15,8 @@ using Catch::Matchers::Equals;
 #include <fstream>
 #include <memory>
 #include <string.h>
+#include <thread>
+#include <vector>
 
 // NOLINTNEXTLINE(cppcoreguidelines-special-member-functions)
 class SimulatorHandlerDataFile
@@ -547,3 +549,55 @@ TEST_CASE("Restore Succeeded 1100")
 
     workflow_free(handle);
 }
+
+TEST_CASE("Concurrent calls on separate workflows")
+{
+    // The steps handler only calls a handler from several threads if it exports SupportsConcurrentCalls.
+    REQUIRE(SupportsConcurrentCalls());
+
+    SimulatorHandlerDataFile simData(installFailed33333);
+
+    std::unique_ptr<ContentHandler> simHandler{ CreateUpdateContentHandlerExtension(ADUC_LOG_DEBUG) };
+
+    const int threadCount = 4;
+    const int callsPerThread = 50;
+    std::vector<ADUC_WorkflowHandle> handles(threadCount, nullptr);
+    std::vector<int> unexpectedResults(threadCount, 0);
+
+    for (ADUC_WorkflowHandle& handle : handles)
+    {
+        ADUC_Result result = workflow_init(action_process_deployment, false, &handle);
+        REQUIRE(result.ResultCode != 0);
+    }
+
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([&simHandler, &handles, &unexpectedResults, t]() {
+            ADUC_WorkflowData testWorkflow{};
+            testWorkflow.WorkflowHandle = handles[t];
+
+            for (int i = 0; i < callsPerThread; i++)
+            {
+                ADUC_Result result = simHandler->Install(&testWorkflow);
+                if (result.ResultCode != 0 || result.ExtendedResultCode != 33333)
+                {
+                    unexpectedResults[t]++;
+                }
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    for (int t = 0; t < threadCount; t++)
+    {
+        INFO("thread " << t);
+        CHECK(unexpectedResults[t] == 0);
+        CHECK_THAT(workflow_peek_result_details(handles[t]), Equals("Mock failure result - 33333"));
+        workflow_free(handles[t]);
+    }
+}
@@ -30,6 +30,7 @@
 #include <fstream>
 #include <memory>
 #include <string>
+#include <vector>
 
 #include <parson.h>
 
@@ -328,9 +329,8 @@ ADUC_Result SWUpdateHandlerImpl::Download(const tagADUC_WorkflowData* workflowDa
     ADUC_WorkflowHandle workflowHandle = workflowData->WorkflowHandle;
     char* installedCriteria = nullptr;
     char* workFolder = workflow_get_workfolder(workflowData->WorkflowHandle);
-    ADUC_FileEntity fileEntity;
-    memset(&fileEntity, 0, sizeof(fileEntity));
     size_t fileCount = workflow_get_update_files_count(workflowHandle);
+    std::vector<ADUC_FileEntity> fileEntities(fileCount); // zero-initialized
     ADUC_Result result = SWUpdate_Handler_DownloadScriptFile(workflowHandle);
 
     if (IsAducResultCodeFailure(result.ResultCode))
@@ -350,33 +350,33 @@ ADUC_Result SWUpdateHandlerImpl::Download(const tagADUC_WorkflowData* workflowDa
 
     result = { ADUC_Result_Download_Success };
 
-    for (int i = 0; i < fileCount; i++)
+    for (size_t i = 0; i < fileCount; i++)
     {
-        Log_Info("Downloading file #%d", i);
-
-        if (!workflow_get_update_file(workflowHandle, i, &fileEntity))
+        if (!workflow_get_update_file(workflowHandle, i, &fileEntities[i]))
         {
             result.ResultCode = ADUC_Result_Failure;
             result.ExtendedResultCode = ADUC_ERC_SWUPDATE_HANDLER_DOWNLOAD_FAILURE_GET_PAYLOAD_FILE_ENTITY;
             goto done;
         }
+    }
 
-        try
-        {
-            result = ExtensionManager::Download(
-                &fileEntity, workflowHandle, &Default_ExtensionManager_Download_Options, nullptr);
-        }
-        catch (...)
-        {
-            result.ResultCode = ADUC_Result_Failure;
-            result.ExtendedResultCode = ADUC_ERC_SWUPDATE_HANDLER_DOWNLOAD_PAYLOAD_FILE_FAILURE_UNKNOWNEXCEPTION;
-        }
+    Log_Info("Downloading %zu payload file(s)", fileCount);
 
-        if (IsAducResultCodeFailure(result.ResultCode))
-        {
-            Log_Error("Cannot download payload file#%d. (0x%X)", i, result.ExtendedResultCode);
-            goto done;
-        }
+    try
+    {
+        result = ExtensionManager::DownloadBatch(
+            fileEntities.data(), fileCount, workflowHandle, &Default_ExtensionManager_Download_Options, nullptr);
+    }
+    catch (...)
+    {
+        result.ResultCode = ADUC_Result_Failure;
+        result.ExtendedResultCode = ADUC_ERC_SWUPDATE_HANDLER_DOWNLOAD_PAYLOAD_FILE_FAILURE_UNKNOWNEXCEPTION;
+    }
+
+    if (IsAducResultCodeFailure(result.ResultCode))
+    {
+        Log_Error("Cannot download payload files. (0x%X)", result.ExtendedResultCode);
+        goto done;
     }
 
     // Invoke primary script to download additional files, if required.
@@ -384,7 +384,10 @@ ADUC_Result SWUpdateHandlerImpl::Download(const tagADUC_WorkflowData* workflowDa
 
 done:
     workflow_free_string(workFolder);
-    ADUC_FileEntity_Uninit(&fileEntity);
+    for (auto& fileEntity : fileEntities)
+    {
+        ADUC_FileEntity_Uninit(&fileEntity);
+    }
     workflow_free_string(installedCriteria);
     Log_Info("SWUpdate_Handler download task end.");
     return result;
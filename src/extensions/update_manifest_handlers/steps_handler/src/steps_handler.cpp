@@ -9,6 +9,7 @@
 
 #include "aduc/calloc_wrapper.hpp" // cstr_wrapper
 #include "aduc/component_enumerator_extension.hpp"
+#include "aduc/config_utils.h"
 #include "aduc/extension_manager.hpp"
 #include "aduc/extension_manager_download_options.h"
 #include "aduc/logging.h"
@@ -16,13 +17,20 @@
 #include "aduc/string_c_utils.h" // IsNullOrEmpty
 #include "aduc/string_utils.hpp"
 #include "aduc/system_utils.h"
+#include "aduc/timing_utils.h"
 #include "aduc/workflow_utils.h"
 
 #include <azure_c_shared_utility/crt_abstractions.h> // mallocAndStrcpy
 #include <azure_c_shared_utility/strings.h> // STRING_*
+#include <algorithm>
+#include <atomic>
+#include <mutex>
 #include <parson.h>
 #include <sstream>
 #include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
 
 // keep this last to avoid interfering with system headers
 #include "aduc/aduc_banned.h"
@@ -45,6 +53,75 @@ static bool IsStepsHandlerExtraDebugLogsEnabled()
     return (!IsNullOrEmpty(getenv("DU_AGENT_ENABLE_STEPS_HANDLER_EXTRA_DEBUG_LOGS")));
 }
 
+/**
+ * @brief Check whether to download the next step's payloads while the current step installs.
+ *
+ * @return true if 'pipelineStepDownloads' is set in du-config.json
+ */
+static bool IsPipelineStepDownloadsEnabled()
+{
+    bool enabled = false;
+    const ADUC_ConfigInfo* config = ADUC_ConfigInfo_GetInstance();
+    if (config != nullptr)
+    {
+        enabled = config->pipelineStepDownloads;
+        ADUC_ConfigInfo_ReleaseInstance(config);
+    }
+
+    return enabled;
+}
+
+/**
+ * @brief Records a deployment timing span of a step's install or apply for the lifetime of the object.
+ */
+class StepTimingSpan
+{
+public:
+    StepTimingSpan(const char* phase, ADUC_WorkflowHandle stepHandle, const char* stepUpdateType) :
+        _stepHandle(stepHandle)
+    {
+        ADUC_Timing_BeginSpan(
+            &_span, phase, stepUpdateType, workflow_get_level(stepHandle), workflow_get_step_index(stepHandle));
+    }
+
+    ~StepTimingSpan()
+    {
+        ADUC_Timing_EndSpan(workflow_get_timing_report(_stepHandle), &_span);
+    }
+
+    StepTimingSpan(const StepTimingSpan&) = delete;
+    StepTimingSpan& operator=(const StepTimingSpan&) = delete;
+
+private:
+    ADUC_WorkflowHandle _stepHandle;
+    ADUC_TimingSpan _span;
+};
+
+/**
+ * @brief Makes the deployment's timing report the current report of this handler module for the lifetime of the
+ * object, so that spans recorded without a workflow at hand (e.g. hashing, handler loading) are not lost.
+ */
+class CurrentTimingReportScope
+{
+public:
+    explicit CurrentTimingReportScope(ADUC_WorkflowHandle handle) : _previous(ADUC_Timing_AcquireCurrentReport())
+    {
+        ADUC_Timing_SetCurrentReport(workflow_get_timing_report(handle));
+    }
+
+    ~CurrentTimingReportScope()
+    {
+        ADUC_Timing_SetCurrentReport(_previous);
+        ADUC_TimingReport_Release(_previous);
+    }
+
+    CurrentTimingReportScope(const CurrentTimingReportScope&) = delete;
+    CurrentTimingReportScope& operator=(const CurrentTimingReportScope&) = delete;
+
+private:
+    ADUC_TimingReport* _previous;
+};
+
 /**
  * @brief Destructor for the Steps Handler Impl class.
  */
@@ -53,19 +130,82 @@ StepsHandlerImpl::~StepsHandlerImpl() // override
     ADUC_Logging_Uninit();
 }
 
+/**
+ * @brief Downloads the detached update manifest files of all reference steps as one concurrent batch.
+ * The per-step download in PrepareStepsWorkflowDataObject then only re-validates the downloaded file.
+ *
+ * @param handle A workflow data object handle.
+ * @param stepCount The number of steps in the workflow.
+ * @return ADUC_Result
+ */
+static ADUC_Result DownloadDetachedManifestFiles(ADUC_WorkflowHandle handle, size_t stepCount)
+{
+    ADUC_Result result = { ADUC_Result_Download_Success };
+    std::vector<ADUC_FileEntity> entities;
+
+    for (size_t i = 0; i < stepCount; i++)
+    {
+        if (workflow_is_inline_step(handle, i))
+        {
+            continue;
+        }
+
+        ADUC_FileEntity entity;
+        memset(&entity, 0, sizeof(entity));
+
+        if (!workflow_get_step_detached_manifest_file(handle, i, &entity))
+        {
+            Log_Error("Cannot get a detached Update manifest file entity for step#%lu", i);
+            result.ResultCode = ADUC_Result_Failure;
+            result.ExtendedResultCode = ADUC_ERC_STEPS_HANDLER_GET_FILE_ENTITY_FAILURE;
+            goto done;
+        }
+
+        entities.push_back(entity);
+    }
+
+    if (entities.empty())
+    {
+        goto done;
+    }
+
+    Log_Info("Downloading %lu detached Update manifest file(s).", entities.size());
+
+    try
+    {
+        result = ExtensionManager::DownloadBatch(
+            entities.data(), entities.size(), handle, &Default_ExtensionManager_Download_Options, nullptr);
+    }
+    catch (...)
+    {
+        result.ResultCode = ADUC_Result_Failure;
+        result.ExtendedResultCode = ADUC_ERC_STEPS_HANDLER_DOWNLOAD_FAILURE_UNKNOWNEXCEPTION;
+    }
+
+done:
+    for (auto& entity : entities)
+    {
+        ADUC_FileEntity_Uninit(&entity);
+    }
+
+    return result;
+}
+
 /**
  * @brief Ensure all steps' workflow data objects are created.
  *
  * Algorithm:
  *    Start from a given parent workflow ( @p handle )
  *
+ *       download all reference steps' detached-manifest files as one concurrent batch
+ *
  *       foreach step in steps {
  *
  *          if in-line step {
  *              - create child workflow for this step (inherit some file entities from parent workflow )
  *              - copy parent workflow's selected components into child workflow
  *          } else {
- *              - download this reference step detached-manifest file
+ *              - download (validate) this reference step detached-manifest file
  *              - create child workflow for this step from manifest file (inherit some file entities from parent workflow)
  *              - select target components based on this step workflow's compatibilities
  *                  Note: components-enumerator extension is not registered, the reference step will be applied to host device (selected component is empty)
@@ -101,6 +241,22 @@ ADUC_Result PrepareStepsWorkflowDataObject(ADUC_WorkflowHandle handle)
         }
 
         Log_Debug("Creating workflow for %lu step(s). Parent's level: %d", stepCount, workflowLevel);
+
+        if (workflowLevel == 0)
+        {
+            // This module has its own copy of the component cache, which the agent's per-deployment invalidation
+            // does not reach. Re-enumerate components once per top-level workflow.
+            ExtensionManager::InvalidateComponentsCache();
+        }
+
+        // For 'microsoft/steps:1' implementation, abort download task as soon as an error occurs.
+        result = DownloadDetachedManifestFiles(handle, stepCount);
+        if (IsAducResultCodeFailure(result.ResultCode))
+        {
+            Log_Error("An error occurred while downloading manifest files (erc:%d)", result.ExtendedResultCode);
+            goto done;
+        }
+
         for (size_t i = 0; i < stepCount; i++)
         {
             STRING_HANDLE childId = nullptr;
@@ -360,11 +516,39 @@ done:
     return result;
 }
 
-static ADUC_Result DoV1DownloadWork(
-    ADUC_WorkflowData* stepWorkflow,
-    ContentHandler* contentHandler,
-    ADUC_WorkflowHandle handle,
-    ADUC_WorkflowHandle stepHandle)
+/**
+ * @brief Downloads the payloads of one step.
+ * Only touches the step's own workflow, so it may run on a background thread.
+ *
+ * @param contentHandler The step's handler.
+ * @param stepWorkflow A wrapper workflow holding the step handle.
+ * @return ADUC_Result The download result.
+ */
+static ADUC_Result DownloadStepPayloads(ContentHandler* contentHandler, ADUC_WorkflowData* stepWorkflow)
+{
+    ADUC_Result result{};
+
+    try
+    {
+        result = contentHandler->Download(stepWorkflow);
+    }
+    catch (...)
+    {
+        result.ResultCode = ADUC_Result_Failure;
+        result.ExtendedResultCode = ADUC_ERC_STEPS_HANDLER_DOWNLOAD_UNKNOWN_EXCEPTION_DOWNLOAD_CONTENT;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Downloads the payloads of one step, unless the step is already installed.
+ *
+ * @param contentHandler The step's handler.
+ * @param stepWorkflow A wrapper workflow holding the step handle.
+ * @return ADUC_Result The download result, or ADUC_Result_Install_Skipped_UpdateAlreadyInstalled.
+ */
+static ADUC_Result DownloadStepContent(ContentHandler* contentHandler, ADUC_WorkflowData* stepWorkflow)
 {
     ADUC_Result result{};
 
@@ -384,31 +568,192 @@ static ADUC_Result DoV1DownloadWork(
     {
         result.ResultCode = ADUC_Result_Install_Skipped_UpdateAlreadyInstalled;
         result.ExtendedResultCode = 0;
-        workflow_set_result(stepHandle, result);
-        workflow_set_result_details(handle, workflow_peek_result_details(stepHandle));
+        workflow_set_result(stepWorkflow->WorkflowHandle, result);
         // The current instance is already up-to-date, continue checking the next instance.
     }
     else
     {
         // Try to download content for current instance and step.
-        try
-        {
-            result = contentHandler->Download(stepWorkflow);
-        }
-        catch (...)
+        result = DownloadStepPayloads(contentHandler, stepWorkflow);
+    }
+
+    return result;
+}
+
+static ADUC_Result DoV1DownloadWork(
+    ADUC_WorkflowData* stepWorkflow,
+    ContentHandler* contentHandler,
+    ADUC_WorkflowHandle handle,
+    ADUC_WorkflowHandle stepHandle)
+{
+    ADUC_Result result = DownloadStepContent(contentHandler, stepWorkflow);
+
+    if (IsAducResultCodeFailure(result.ResultCode)
+        || result.ResultCode == ADUC_Result_Install_Skipped_UpdateAlreadyInstalled)
+    {
+        // Propagate item's resultDetails to parent.
+        workflow_set_result_details(handle, workflow_peek_result_details(stepHandle));
+    }
+
+    return result;
+}
+
+/**
+ * @brief Downloads one step's payloads on a background thread, so that the download overlaps
+ * the previous step's install. Used by StepsHandler_Install when 'pipelineStepDownloads' is set.
+ *
+ * The background thread only calls Download. Whether the step is installed is checked in the foreground,
+ * once the previous step is done, as the previous step may change the answer.
+ * A download whose step will not be installed, e.g. because a reboot was requested, is cancelled.
+ */
+class StepDownloadPrefetch
+{
+public:
+    StepDownloadPrefetch() = default;
+
+    // Delete copy ctor, copy assignment, move ctor and move assignment operators.
+    StepDownloadPrefetch(const StepDownloadPrefetch&) = delete;
+    StepDownloadPrefetch& operator=(const StepDownloadPrefetch&) = delete;
+    StepDownloadPrefetch(StepDownloadPrefetch&&) = delete;
+    StepDownloadPrefetch& operator=(StepDownloadPrefetch&&) = delete;
+
+    ~StepDownloadPrefetch()
+    {
+        Cancel();
+    }
+
+    void Start(
+        ADUC_WorkflowHandle handle,
+        size_t stepIndex,
+        const char* serializedComponentString,
+        const ContentHandler* foregroundHandler);
+
+    /**
+     * @brief Whether a background download of step @p stepIndex was started and has not been waited for.
+     */
+    bool IsPending(size_t stepIndex) const
+    {
+        return _thread.joinable() && _stepIndex == stepIndex;
+    }
+
+    /**
+     * @brief Waits for the background download, if any.
+     * @return ADUC_Result The result of the last background download.
+     */
+    ADUC_Result Wait()
+    {
+        if (_thread.joinable())
         {
-            result.ResultCode = ADUC_Result_Failure;
-            result.ExtendedResultCode = ADUC_ERC_STEPS_HANDLER_DOWNLOAD_UNKNOWN_EXCEPTION_DOWNLOAD_CONTENT;
+            _thread.join();
         }
 
-        if (IsAducResultCodeFailure(result.ResultCode))
+        return _result;
+    }
+
+    /**
+     * @brief Cancels the background download, if any, as its step will not be installed.
+     * Files not started yet are not downloaded. This waits for a file already downloading, as the content
+     * downloader cannot be interrupted.
+     */
+    void Cancel()
+    {
+        if (!_thread.joinable())
         {
-            // Propagate item's resultDetails to parent.
-            workflow_set_result_details(handle, workflow_peek_result_details(stepHandle));
+            return;
         }
+
+        Log_Info("Cancelling the background download for step #%lu.", _stepIndex);
+
+        workflow_set_download_cancel_requested(_stepWorkflow.WorkflowHandle, true);
+        _thread.join();
+
+        // The step workflow is reused by the next component and the next phase.
+        workflow_set_download_cancel_requested(_stepWorkflow.WorkflowHandle, false);
     }
 
-    return result;
+private:
+    std::thread _thread;
+    size_t _stepIndex = 0;
+    ADUC_WorkflowData _stepWorkflow = {};
+    ADUC_Result _result = { ADUC_Result_Failure, 0 };
+};
+
+/**
+ * @brief Starts downloading the payloads of step @p stepIndex in the background.
+ * The step's selected components and handler are set up on the calling thread. If any of that fails,
+ * nothing is started and the step is downloaded in the foreground when its turn comes, reporting the error.
+ * Nothing is started either if that could call one handler from both threads, unless the handler supports it:
+ * that is, if the step's handler is @p foregroundHandler, or either step is a reference step, whose steps
+ * handler may call any handler.
+ *
+ * @param handle The parent workflow handle.
+ * @param stepIndex The index of the step to download.
+ * @param serializedComponentString The current component, or nullptr.
+ * @param foregroundHandler The handler of the previous step, which the calling thread keeps using meanwhile.
+ */
+void StepDownloadPrefetch::Start(
+    ADUC_WorkflowHandle handle,
+    size_t stepIndex,
+    const char* serializedComponentString,
+    const ContentHandler* foregroundHandler)
+{
+    ContentHandler* contentHandler = nullptr;
+    ADUC_ExtensionContractInfo contractInfo{};
+    ADUC_WorkflowHandle stepHandle = workflow_get_child(handle, stepIndex);
+    const char* stepUpdateType = workflow_is_inline_step(handle, stepIndex)
+        ? workflow_peek_update_manifest_step_handler(handle, stepIndex)
+        : DEFAULT_REF_STEP_HANDLER;
+
+    Wait();
+
+    if (stepHandle == nullptr)
+    {
+        return;
+    }
+
+    if (serializedComponentString != nullptr && workflow_is_inline_step(handle, stepIndex)
+        && !workflow_set_selected_components(stepHandle, serializedComponentString))
+    {
+        return;
+    }
+
+    if (IsAducResultCodeFailure(
+            ExtensionManager::LoadUpdateContentHandlerExtension(stepUpdateType, &contentHandler).ResultCode))
+    {
+        return;
+    }
+
+    contractInfo = contentHandler->GetContractInfo();
+    if (!ADUC_ContractUtils_IsV1Contract(&contractInfo))
+    {
+        return;
+    }
+
+    if (!ExtensionManager::SupportsConcurrentCalls(contentHandler)
+        && (contentHandler == foregroundHandler || !workflow_is_inline_step(handle, stepIndex)
+            || !workflow_is_inline_step(handle, stepIndex - 1)))
+    {
+        Log_Debug("Step #%lu may share a handler with the current step. Downloading it in the foreground.", stepIndex);
+        return;
+    }
+
+    _stepIndex = stepIndex;
+    _stepWorkflow = {};
+    _stepWorkflow.WorkflowHandle = stepHandle;
+    _result = { ADUC_Result_Failure, 0 };
+
+    Log_Info("Downloading step #%lu in the background.", stepIndex);
+
+    try
+    {
+        _thread = std::thread([this, contentHandler]() {
+            _result = DownloadStepPayloads(contentHandler, &_stepWorkflow);
+        });
+    }
+    catch (const std::system_error& e)
+    {
+        Log_Warn("Cannot start the background download for step #%lu: %s", stepIndex, e.what());
+    }
 }
 
 static ADUC_Result handleUnsupportedContractVersion(
@@ -484,6 +829,530 @@ done:
     return result;
 }
 
+/**
+ * @brief Get the maximum number of selected components to process at the same time.
+ *
+ * @return unsigned int The 'maxConcurrentComponents' setting in du-config.json, or 1 if not set.
+ */
+static unsigned int GetMaxConcurrentComponents()
+{
+    unsigned int ret = 1;
+    const ADUC_ConfigInfo* config = ADUC_ConfigInfo_GetInstance();
+    if (config != nullptr)
+    {
+        if (config->maxConcurrentComponents != 0)
+        {
+            ret = config->maxConcurrentComponents;
+        }
+
+        ADUC_ConfigInfo_ReleaseInstance(config);
+    }
+
+    return ret;
+}
+
+/**
+ * @brief The steps of one selected component, processed by a component worker on its own step workflows.
+ */
+struct ComponentRun
+{
+    std::vector<ADUC_WorkflowHandle> stepHandles; /**< Step workflows for this component, parented to the steps workflow. */
+    std::vector<ADUC_Result> stepResults; /**< The result of each step, in step order. */
+    std::string resultDetails; /**< The result details of the failing step, if any. */
+    ADUC_Result result = { ADUC_Result_Failure, 0 }; /**< The component's result. */
+    bool attempted = false; /**< Whether a worker picked up this component. */
+};
+
+/**
+ * @brief Shared state of the component workers.
+ */
+struct ComponentRunContext
+{
+    ADUC_WorkflowHandle handle; /**< The steps workflow. */
+    bool isPipelined; /**< Whether 'Install' downloads each step's payloads. */
+    std::vector<std::mutex> stepDownloadLocks; /**< Serializes each step's download, as components share payloads. */
+    std::atomic<bool> stopped{ false }; /**< Set on failure or immediate reboot / agent restart request. */
+
+    ComponentRunContext(ADUC_WorkflowHandle workflowHandle, bool pipelined, size_t stepsCount) :
+        handle(workflowHandle), isPipelined(pipelined), stepDownloadLocks(stepsCount)
+    {
+    }
+};
+
+/**
+ * @brief Records the failure of step @p stepIndex of @p run, and its result details.
+ */
+static void SetComponentStepFailure(ComponentRun& run, size_t stepIndex, const ADUC_Result& result)
+{
+    const char* details = workflow_peek_result_details(run.stepHandles[stepIndex]);
+
+    run.result = result;
+    run.stepResults[stepIndex] = result;
+    if (run.resultDetails.empty() && details != nullptr)
+    {
+        run.resultDetails = details;
+    }
+}
+
+/**
+ * @brief Loads the handler of step @p stepIndex for a component worker.
+ *
+ * @return ContentHandler* The handler, or nullptr if it cannot be loaded or has an unsupported contract version.
+ */
+static ContentHandler* LoadComponentStepHandler(ADUC_WorkflowHandle handle, size_t stepIndex, ComponentRun& run)
+{
+    ContentHandler* contentHandler = nullptr;
+    const char* stepUpdateType = workflow_peek_update_manifest_step_handler(handle, stepIndex);
+    std::stringstream details;
+
+    ADUC_Result result = ExtensionManager::LoadUpdateContentHandlerExtension(stepUpdateType, &contentHandler);
+    if (IsAducResultCodeFailure(result.ResultCode))
+    {
+        details << "Cannot load a handler for step #" << stepIndex
+                << " (handler :" << (stepUpdateType == nullptr ? "NULL" : stepUpdateType) << ")";
+        Log_Error("%s", details.str().c_str());
+        run.resultDetails = details.str();
+        SetComponentStepFailure(run, stepIndex, result);
+        return nullptr;
+    }
+
+    ADUC_ExtensionContractInfo contractInfo = contentHandler->GetContractInfo();
+    if (!ADUC_ContractUtils_IsV1Contract(&contractInfo))
+    {
+        details << "Unsupported step handler contract version " << contractInfo.majorVer << "."
+                << contractInfo.minorVer << " for '" << stepUpdateType << "'";
+        Log_Error("%s", details.str().c_str());
+        run.resultDetails = details.str();
+        SetComponentStepFailure(
+            run, stepIndex, { ADUC_Result_Failure, ADUC_ERC_UPDATE_CONTENT_HANDLER_UNSUPPORTED_CONTRACT_VERSION });
+        return nullptr;
+    }
+
+    return contentHandler;
+}
+
+/**
+ * @brief Downloads the payloads of step @p stepIndex for a component worker.
+ * A step's payloads are the same for every component, so only one component downloads them at a time,
+ * and the others just re-validate the downloaded files.
+ *
+ * @return true if the step is downloaded or already installed.
+ */
+static bool DownloadComponentStep(
+    ComponentRunContext& context, ComponentRun& run, size_t stepIndex, ContentHandler* contentHandler)
+{
+    ADUC_WorkflowData stepWorkflow = {};
+    stepWorkflow.WorkflowHandle = run.stepHandles[stepIndex];
+
+    ADUC_Result result;
+    {
+        std::lock_guard<std::mutex> lock{ context.stepDownloadLocks[stepIndex] };
+        result = DownloadStepContent(contentHandler, &stepWorkflow);
+    }
+
+    if (IsAducResultCodeFailure(result.ResultCode))
+    {
+        SetComponentStepFailure(run, stepIndex, result);
+        return false;
+    }
+
+    run.stepResults[stepIndex] = result;
+    return true;
+}
+
+/**
+ * @brief Performs the 'Download' task of every step for one component. Runs on a component worker.
+ */
+static void DownloadComponentSteps(ComponentRunContext& context, ComponentRun& run)
+{
+    run.result = { ADUC_Result_Download_Success, 0 };
+
+    for (size_t i = 0; i < run.stepHandles.size(); i++)
+    {
+        if (context.isPipelined && i > 0)
+        {
+            // The remaining steps are downloaded during 'Install'.
+            break;
+        }
+
+        ContentHandler* contentHandler = LoadComponentStepHandler(context.handle, i, run);
+        if (contentHandler == nullptr || !DownloadComponentStep(context, run, i, contentHandler))
+        {
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Performs the 'Install' task of every step for one component. Runs on a component worker.
+ * Mirrors the per-step backup, install, apply and restore sequence of StepsHandler_Install.
+ */
+static void InstallComponentSteps(ComponentRunContext& context, ComponentRun& run)
+{
+    run.result = { ADUC_Result_Install_Success, 0 };
+
+    for (size_t i = 0; i < run.stepHandles.size(); i++)
+    {
+        ADUC_WorkflowHandle stepHandle = run.stepHandles[i];
+        ADUC_WorkflowData stepWorkflow = {};
+        stepWorkflow.WorkflowHandle = stepHandle;
+        ADUC_Result result{};
+
+        ContentHandler* contentHandler = LoadComponentStepHandler(context.handle, i, run);
+        if (contentHandler == nullptr)
+        {
+            return;
+        }
+
+        if (context.isPipelined && !DownloadComponentStep(context, run, i, contentHandler))
+        {
+            return;
+        }
+
+        try
+        {
+            result = contentHandler->IsInstalled(&stepWorkflow);
+        }
+        catch (...)
+        {
+            // Cannot determine whether the step has been applied, so, we'll try to process the step.
+            result = { ADUC_Result_IsInstalled_NotInstalled, 0 };
+        }
+
+        if (IsAducResultCodeSuccess(result.ResultCode) && result.ResultCode == ADUC_Result_IsInstalled_Installed)
+        {
+            result = { ADUC_Result_Install_Skipped_UpdateAlreadyInstalled, 0 };
+            workflow_set_result(stepHandle, result);
+            goto stepDone;
+        }
+
+        try
+        {
+            result = contentHandler->Backup(&stepWorkflow);
+        }
+        catch (...)
+        {
+            result = { ADUC_Result_Failure, ADUC_ERC_STEPS_HANDLER_INSTALL_UNKNOWN_EXCEPTION_BACKUP_CHILD_STEP };
+        }
+
+        if (IsAducResultCodeFailure(result.ResultCode))
+        {
+            SetComponentStepFailure(run, i, result);
+            return;
+        }
+
+        try
+        {
+            StepTimingSpan installSpan{ ADUC_TIMING_PHASE_INSTALL,
+                                        stepHandle,
+                                        workflow_peek_update_manifest_step_handler(context.handle, i) };
+            result = contentHandler->Install(&stepWorkflow);
+        }
+        catch (...)
+        {
+            Log_Error("The handler throws an exception inside Install().");
+            SetComponentStepFailure(
+                run, i, { ADUC_Result_Failure, ADUC_ERC_STEPS_HANDLER_INSTALL_UNKNOWN_EXCEPTION_INSTALL_CHILD_STEP });
+            return;
+        }
+
+        if (workflow_is_immediate_reboot_requested(stepHandle)
+            || workflow_is_immediate_agent_restart_requested(stepHandle))
+        {
+            goto stepDone;
+        }
+
+        if (result.ResultCode == ADUC_Result_Install_Skipped_UpdateAlreadyInstalled
+            || result.ResultCode == ADUC_Result_Install_Skipped_NoMatchingComponents)
+        {
+            goto stepDone;
+        }
+
+        if (IsAducResultCodeFailure(result.ResultCode))
+        {
+            SetComponentStepFailure(run, i, result);
+
+            try
+            {
+                contentHandler->Restore(&stepWorkflow);
+            }
+            catch (...)
+            {
+                Log_Warn("Unexpected error happened during restore action.");
+            }
+
+            return;
+        }
+
+        try
+        {
+            StepTimingSpan applySpan{ ADUC_TIMING_PHASE_APPLY,
+                                      stepHandle,
+                                      workflow_peek_update_manifest_step_handler(context.handle, i) };
+            result = contentHandler->Apply(&stepWorkflow);
+        }
+        catch (...)
+        {
+            Log_Error("The handler throws an exception inside Apply().");
+            SetComponentStepFailure(
+                run, i, { ADUC_Result_Failure, ADUC_ERC_STEPS_HANDLER_INSTALL_UNKNOWN_EXCEPTION_APPLY_CHILD_STEP });
+            return;
+        }
+
+        if (IsAducResultCodeFailure(result.ResultCode))
+        {
+            SetComponentStepFailure(run, i, result);
+
+            try
+            {
+                Log_Info("Failed to install or apply. Try to restore now...");
+                contentHandler->Restore(&stepWorkflow);
+            }
+            catch (...)
+            {
+                Log_Warn("Unexpected error happened during restore action.");
+            }
+
+            return;
+        }
+
+    stepDone:
+        run.stepResults[i] = result;
+        workflow_set_result(stepHandle, result);
+
+        // Reboot and agent restart requests are kept on the root workflow, so they are already visible to the caller.
+        if (workflow_is_immediate_reboot_requested(stepHandle)
+            || workflow_is_immediate_agent_restart_requested(stepHandle))
+        {
+            // Skip the remaining steps and components.
+            context.stopped = true;
+            return;
+        }
+
+        if (workflow_is_reboot_requested(stepHandle) || workflow_is_agent_restart_requested(stepHandle))
+        {
+            // Skip the remaining steps of this component.
+            return;
+        }
+    }
+}
+
+/**
+ * @brief Processes the selected components of @p handle concurrently, up to 'maxConcurrentComponents' at a time.
+ *
+ * Each component gets its own step workflows, so components never share step state. Steps still run in order
+ * within a component. A failure stops components that have not started yet. Results are aggregated in
+ * component order: the first failing component's result and result details are reported on @p handle,
+ * and its step results (or, if all succeeded, the last component's) on the steps' child workflows.
+ *
+ * @param handle The steps workflow.
+ * @param selectedComponentsArray The selected components.
+ * @param workerCount The number of components to process at a time.
+ * @param isInstall Whether to perform the 'Install' task, otherwise the 'Download' task.
+ * @param isPipelined Whether step payloads are downloaded during 'Install'.
+ * @return ADUC_Result The aggregated result.
+ */
+static ADUC_Result ProcessComponentsConcurrently(
+    ADUC_WorkflowHandle handle,
+    JSON_Array* selectedComponentsArray,
+    size_t workerCount,
+    bool isInstall,
+    bool isPipelined)
+{
+    ADUC_Result result = { isInstall ? ADUC_Result_Install_Success : ADUC_Result_Download_Success, 0 };
+    const size_t componentsCount = json_array_get_count(selectedComponentsArray);
+    const size_t stepsCount = workflow_get_children_count(handle);
+    std::vector<ComponentRun> runs(componentsCount);
+    ComponentRunContext context{ handle, isPipelined, stepsCount };
+    std::atomic<size_t> nextIndex{ 0 };
+    std::vector<std::thread> threads;
+    const ComponentRun* reportedRun = nullptr;
+
+    // Create every component's step workflows up front, since creating them touches the shared manifest.
+    for (size_t iCom = 0; iCom < componentsCount; iCom++)
+    {
+        ComponentRun& run = runs[iCom];
+        char* serializedComponentString = CreateComponentSerializedString(selectedComponentsArray, iCom);
+
+        run.stepResults.assign(stepsCount, ADUC_Result{ ADUC_Result_Failure, 0 });
+
+        for (size_t i = 0; i < stepsCount; i++)
+        {
+            ADUC_WorkflowHandle stepHandle = nullptr;
+
+            // Keep 'result' as the success code to report if every component succeeds.
+            ADUC_Result createResult = workflow_create_from_inline_step(handle, i, &stepHandle);
+            if (IsAducResultCodeFailure(createResult.ResultCode))
+            {
+                result = createResult;
+                workflow_set_result_details(handle, "Cannot create workflow for step #%lu of component #%lu", i, iCom);
+                json_free_serialized_string(serializedComponentString);
+                goto done;
+            }
+
+            run.stepHandles.push_back(stepHandle);
+            workflow_set_step_index(stepHandle, i);
+            workflow_set_parent(stepHandle, handle);
+
+            if (serializedComponentString == nullptr
+                || !workflow_set_selected_components(stepHandle, serializedComponentString))
+            {
+                result = { ADUC_Result_Failure, ADUC_ERC_STEPS_HANDLER_SET_SELECTED_COMPONENTS_FAILURE };
+                workflow_set_result_details(handle, "Cannot select target component(s) for step #%lu", i);
+                json_free_serialized_string(serializedComponentString);
+                goto done;
+            }
+        }
+
+        json_free_serialized_string(serializedComponentString);
+    }
+
+    Log_Info("Processing %lu component(s), up to %lu at a time.", componentsCount, workerCount);
+
+    {
+        auto worker = [&]() {
+            for (size_t iCom = nextIndex++; iCom < componentsCount && !context.stopped; iCom = nextIndex++)
+            {
+                ComponentRun& run = runs[iCom];
+                run.attempted = true;
+
+                if (isInstall)
+                {
+                    InstallComponentSteps(context, run);
+                }
+                else
+                {
+                    DownloadComponentSteps(context, run);
+                }
+
+                if (IsAducResultCodeFailure(run.result.ResultCode))
+                {
+                    Log_Error(
+                        "Component #%lu failed. (rc:%d, erc:0x%X)",
+                        iCom,
+                        run.result.ResultCode,
+                        run.result.ExtendedResultCode);
+                    context.stopped = true;
+                }
+            }
+        };
+
+        // The calling thread is one of the workers.
+        threads.reserve(workerCount - 1);
+        for (size_t t = 1; t < workerCount; ++t)
+        {
+            try
+            {
+                threads.emplace_back(worker);
+            }
+            catch (const std::system_error& e)
+            {
+                // Carry on with the workers that did start.
+                Log_Warn("Cannot start component worker thread: %s", e.what());
+                break;
+            }
+        }
+
+        worker();
+
+        for (auto& thread : threads)
+        {
+            thread.join();
+        }
+    }
+
+    // Report the first failure in component order, skipping components that were never started.
+    for (const ComponentRun& run : runs)
+    {
+        if (!run.attempted)
+        {
+            continue;
+        }
+
+        reportedRun = &run;
+        if (IsAducResultCodeFailure(run.result.ResultCode))
+        {
+            result = run.result;
+            if (!run.resultDetails.empty())
+            {
+                workflow_set_result_details(handle, "%s", run.resultDetails.c_str());
+            }
+            break;
+        }
+    }
+
+    if (reportedRun != nullptr)
+    {
+        for (size_t i = 0; i < stepsCount; i++)
+        {
+            workflow_set_result(workflow_get_child(handle, i), reportedRun->stepResults[i]);
+        }
+    }
+
+done:
+    for (ComponentRun& run : runs)
+    {
+        for (ADUC_WorkflowHandle stepHandle : run.stepHandles)
+        {
+            workflow_free(stepHandle);
+        }
+    }
+
+    return result;
+}
+
+/**
+ * @brief Check whether the selected components of @p handle can be processed concurrently.
+ * Only steps whose children are all inline steps, whose handlers all support concurrent calls,
+ * with more than one selected component, qualify.
+ *
+ * @param handle The steps workflow.
+ * @param selectedComponentsArray Receives the selected components.
+ * @param workerCount Receives the number of components to process at a time.
+ * @return true if 'maxConcurrentComponents' allows more than one component at a time, and the steps qualify.
+ */
+static bool ShouldProcessComponentsConcurrently(
+    ADUC_WorkflowHandle handle, JSON_Array** selectedComponentsArray, size_t* workerCount)
+{
+    const unsigned int maxConcurrentComponents = GetMaxConcurrentComponents();
+    const size_t stepsCount = workflow_get_children_count(handle);
+
+    if (maxConcurrentComponents <= 1 || workflow_get_level(handle) == 0
+        || !ExtensionManager::IsComponentsEnumeratorRegistered())
+    {
+        return false;
+    }
+
+    for (size_t i = 0; i < stepsCount; i++)
+    {
+        ContentHandler* contentHandler = nullptr;
+
+        if (!workflow_is_inline_step(handle, i))
+        {
+            return false;
+        }
+
+        // Component workers call each step's handler from several threads.
+        ADUC_Result loadResult = ExtensionManager::LoadUpdateContentHandlerExtension(
+            workflow_peek_update_manifest_step_handler(handle, i), &contentHandler);
+        if (IsAducResultCodeFailure(loadResult.ResultCode)
+            || !ExtensionManager::SupportsConcurrentCalls(contentHandler))
+        {
+            Log_Debug("Step #%lu handler does not support concurrent calls. Processing components one at a time.", i);
+            return false;
+        }
+    }
+
+    if (IsAducResultCodeFailure(GetSelectedComponentsArray(handle, selectedComponentsArray).ResultCode)
+        || json_array_get_count(*selectedComponentsArray) <= 1)
+    {
+        return false;
+    }
+
+    *workerCount = std::min<size_t>(maxConcurrentComponents, json_array_get_count(*selectedComponentsArray));
+    return true;
+}
+
 /**
  * @brief Performs 'Download' task by iterating through all steps and invoke each step's handler
  * to download file(s), if needed.
@@ -510,6 +1379,8 @@ static ADUC_Result StepsHandler_Download(const tagADUC_WorkflowData* workflowDat
     int selectedComponentsCount = 0;
     char* serializedComponentString = nullptr;
     bool isComponentsEnumeratorRegistered = ExtensionManager::IsComponentsEnumeratorRegistered();
+    bool isPipelined = IsPipelineStepDownloadsEnabled();
+    size_t componentWorkerCount = 0;
     int createResult = 0;
 
     if (workflow_is_cancel_requested(handle))
@@ -554,6 +1425,13 @@ static ADUC_Result StepsHandler_Download(const tagADUC_WorkflowData* workflowDat
         goto done;
     }
 
+    if (ShouldProcessComponentsConcurrently(handle, &selectedComponentsArray, &componentWorkerCount))
+    {
+        result = ProcessComponentsConcurrently(
+            handle, selectedComponentsArray, componentWorkerCount, false /* isInstall */, isPipelined);
+        goto done;
+    }
+
     // For each selected component, perform step's backup, install & apply phase, restore phase if needed, in order.
     for (size_t iCom = 0, stepsCount = workflow_get_children_count(handle); iCom < selectedComponentsCount; iCom++)
     {
@@ -565,6 +1443,12 @@ static ADUC_Result StepsHandler_Download(const tagADUC_WorkflowData* workflowDat
         //
         for (size_t i = 0; i < stepsCount; i++)
         {
+            if (isPipelined && i > 0)
+            {
+                // The remaining steps are downloaded during 'Install', while the previous step installs.
+                break;
+            }
+
             if (IsStepsHandlerExtraDebugLogsEnabled())
             {
                 Log_Debug(
@@ -702,6 +1586,7 @@ done:
  */
 ADUC_Result StepsHandlerImpl::Download(const tagADUC_WorkflowData* workflowData)
 {
+    CurrentTimingReportScope timingScope{ workflowData->WorkflowHandle };
     return StepsHandler_Download(workflowData);
 }
 
@@ -761,6 +1646,9 @@ static ADUC_Result StepsHandler_Install(const tagADUC_WorkflowData* workflowData
     int selectedComponentsCount = 0;
     char* serializedComponentString = nullptr;
     bool isComponentsEnumeratorRegistered = ExtensionManager::IsComponentsEnumeratorRegistered();
+    bool isPipelined = IsPipelineStepDownloadsEnabled();
+    StepDownloadPrefetch prefetch;
+    size_t componentWorkerCount = 0;
     int createResult = 0;
 
     if (workflow_is_cancel_requested(handle))
@@ -842,6 +1730,20 @@ static ADUC_Result StepsHandler_Install(const tagADUC_WorkflowData* workflowData
         }
     }
 
+    if (selectedComponentsCount > 1
+        && ShouldProcessComponentsConcurrently(handle, &selectedComponentsArray, &componentWorkerCount))
+    {
+        result = ProcessComponentsConcurrently(
+            handle, selectedComponentsArray, componentWorkerCount, true /* isInstall */, isPipelined);
+        if (IsAducResultCodeFailure(result.ResultCode) || workflow_is_immediate_reboot_requested(handle)
+            || workflow_is_immediate_agent_restart_requested(handle))
+        {
+            goto done;
+        }
+
+        goto componentsDone;
+    }
+
     // For each selected component, perform step's backup, install & apply phase, restore phase if needed, in order.
     for (size_t iCom = 0, stepsCount = workflow_get_children_count(handle); iCom < selectedComponentsCount; iCom++)
     {
@@ -906,6 +1808,42 @@ static ADUC_Result StepsHandler_Install(const tagADUC_WorkflowData* workflowData
                 goto done;
             }
 
+            if (isPipelined)
+            {
+                ADUC_ExtensionContractInfo contractInfo = contentHandler->GetContractInfo();
+                if (!ADUC_ContractUtils_IsV1Contract(&contractInfo))
+                {
+                    result = handleUnsupportedContractVersion(&contractInfo, stepUpdateType, handle);
+                    goto done;
+                }
+
+                // Wait for this step's background download, if any.
+                result = { ADUC_Result_Failure, 0 };
+                if (prefetch.IsPending(i))
+                {
+                    result = prefetch.Wait();
+                }
+
+                // Download (re-validate) it now if none was started, or retry a failed one, as the step
+                // may turn out to be installed already.
+                if (IsAducResultCodeFailure(result.ResultCode))
+                {
+                    result = DownloadStepContent(contentHandler, &stepWorkflow);
+                }
+
+                if (IsAducResultCodeFailure(result.ResultCode))
+                {
+                    // Nothing of this step is installed yet, so there is nothing to restore.
+                    workflow_set_result_details(handle, workflow_peek_result_details(stepHandle));
+                    goto done;
+                }
+
+                if (i + 1 < stepsCount)
+                {
+                    prefetch.Start(handle, i + 1, serializedComponentString, contentHandler);
+                }
+            }
+
             // If this item is already installed, skip to the next one.
             try
             {
@@ -953,6 +1891,7 @@ static ADUC_Result StepsHandler_Install(const tagADUC_WorkflowData* workflowData
             //
             try
             {
+                StepTimingSpan installSpan{ ADUC_TIMING_PHASE_INSTALL, stepHandle, stepUpdateType };
                 result = contentHandler->Install(&stepWorkflow);
             }
             catch (...)
@@ -1011,6 +1950,7 @@ static ADUC_Result StepsHandler_Install(const tagADUC_WorkflowData* workflowData
             //
             try
             {
+                StepTimingSpan applySpan{ ADUC_TIMING_PHASE_APPLY, stepHandle, stepUpdateType };
                 result = contentHandler->Apply(&stepWorkflow);
                 Log_Debug("Step's apply() return r:0x%x rc:0x%x", result.ResultCode, result.ExtendedResultCode);
             }
@@ -1085,6 +2025,9 @@ static ADUC_Result StepsHandler_Install(const tagADUC_WorkflowData* workflowData
         } // steps
 
     componentDone:
+        // Cancel a background download for a step that was skipped, e.g. because a reboot was requested.
+        prefetch.Cancel();
+
         json_free_serialized_string(serializedComponentString);
         serializedComponentString = nullptr;
 
@@ -1094,6 +2037,7 @@ static ADUC_Result StepsHandler_Install(const tagADUC_WorkflowData* workflowData
         }
     }
 
+componentsDone:
     if (workflow_is_cancel_requested(workflowData->WorkflowHandle))
     {
         result.ResultCode = ADUC_Result_Failure_Cancelled;
@@ -1113,6 +2057,8 @@ done:
     // Alternatively, we can persist child workflow state, to free up some memory, and
     // load the state when needed in the next phase
 
+    prefetch.Cancel();
+
     workflow_set_result(handle, result);
 
     if (IsAducResultCodeSuccess(result.ResultCode))
@@ -1141,6 +2087,7 @@ done:
  */
 ADUC_Result StepsHandlerImpl::Install(const tagADUC_WorkflowData* workflowData)
 {
+    CurrentTimingReportScope timingScope{ workflowData->WorkflowHandle };
     return StepsHandler_Install(workflowData);
 }
 
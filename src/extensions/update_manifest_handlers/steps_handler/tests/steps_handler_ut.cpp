@@ -0,0 +1,469 @@
+/**
+ * @file steps_handler_ut.cpp
+ * @brief Unit tests for the order and concurrency of the steps handler's calls to step handlers.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "aduc/steps_handler.hpp"
+
+#include <aduc/config_utils.h>
+#include <aduc/extension_manager.hpp>
+#include <aduc/system_utils.h> // ADUC_SystemUtils_GetTemporaryPathName, ADUC_SystemUtils_RmDirRecursive
+#include <aduc/types/adu_core.h> // ADUC_Result_*
+#include <aduc/types/workflow.h> // ADUC_WorkflowData
+#include <aduc/workflow_utils.h>
+#include <aducpal/dlfcn.h> // ADUCPAL_dlopen, ADUCPAL_dlclose
+#include <aducpal/stdlib.h> // setenv
+
+#include <catch2/catch.hpp>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib> // mkdtemp
+#include <functional>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+static bool WaitFor(const std::function<bool()>& condition);
+
+/**
+ * @brief A step handler that records its calls. Every call takes a little while, so that overlapping calls show.
+ */
+class MockStepHandler : public ContentHandler
+{
+public:
+    MockStepHandler() = default;
+
+    std::atomic<int> callCount{ 0 };
+    std::atomic<int> downloadCount{ 0 };
+    std::atomic<int> installCount{ 0 };
+    std::atomic<int> callsInFlight{ 0 };
+    std::atomic<int> maxCallsInFlight{ 0 };
+    std::atomic<bool> isInstalled{ false };
+    std::atomic<bool> downloadedBeforeInstall{ false };
+    std::atomic<bool> downloadWaitsForCancel{ false };
+    std::atomic<bool> downloadCancelled{ false };
+    std::atomic<bool> requestImmediateReboot{ false };
+    std::function<void()> onInstall;
+
+    ADUC_Result Download(const tagADUC_WorkflowData* workflowData) override
+    {
+        CallScope scope{ *this };
+        downloadCount++;
+        if (downloadWaitsForCancel)
+        {
+            // Like a handler downloading its files one at a time, that stops once downloads are cancelled.
+            downloadCancelled = WaitFor([workflowData]() {
+                return workflow_is_download_cancel_requested(workflowData->WorkflowHandle);
+            });
+            if (downloadCancelled)
+            {
+                return { ADUC_Result_Failure_Cancelled, 0 };
+            }
+        }
+
+        return { ADUC_Result_Download_Success, 0 };
+    }
+
+    ADUC_Result Backup(const tagADUC_WorkflowData* /* workflowData */) override
+    {
+        CallScope scope{ *this };
+        return { ADUC_Result_Backup_Success, 0 };
+    }
+
+    ADUC_Result Install(const tagADUC_WorkflowData* workflowData) override
+    {
+        CallScope scope{ *this };
+        downloadedBeforeInstall = downloadCount > 0;
+        if (onInstall)
+        {
+            onInstall();
+        }
+
+        installCount++;
+        if (requestImmediateReboot)
+        {
+            workflow_request_immediate_reboot(workflowData->WorkflowHandle);
+            return { ADUC_Result_Install_RequiredImmediateReboot, 0 };
+        }
+
+        return { ADUC_Result_Install_Success, 0 };
+    }
+
+    ADUC_Result Apply(const tagADUC_WorkflowData* /* workflowData */) override
+    {
+        CallScope scope{ *this };
+        return { ADUC_Result_Apply_Success, 0 };
+    }
+
+    ADUC_Result Restore(const tagADUC_WorkflowData* /* workflowData */) override
+    {
+        CallScope scope{ *this };
+        return { ADUC_Result_Restore_Success, 0 };
+    }
+
+    ADUC_Result Cancel(const tagADUC_WorkflowData* /* workflowData */) override
+    {
+        CallScope scope{ *this };
+        return { ADUC_Result_Cancel_Success, 0 };
+    }
+
+    ADUC_Result IsInstalled(const tagADUC_WorkflowData* /* workflowData */) override
+    {
+        CallScope scope{ *this };
+        return { isInstalled ? ADUC_Result_IsInstalled_Installed : ADUC_Result_IsInstalled_NotInstalled, 0 };
+    }
+
+private:
+    class CallScope
+    {
+    public:
+        explicit CallScope(MockStepHandler& handler) : _handler(handler)
+        {
+            _handler.callCount++;
+            int inFlight = ++_handler.callsInFlight;
+            int max = _handler.maxCallsInFlight;
+            while (inFlight > max && !_handler.maxCallsInFlight.compare_exchange_weak(max, inFlight))
+            {
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        }
+
+        ~CallScope()
+        {
+            _handler.callsInFlight--;
+        }
+
+        CallScope(const CallScope&) = delete;
+        CallScope& operator=(const CallScope&) = delete;
+
+    private:
+        MockStepHandler& _handler;
+    };
+};
+
+/**
+ * @brief A temporary work folder for the steps workflow, removed at the end of the test.
+ */
+class TestWorkFolder
+{
+public:
+    TestWorkFolder()
+    {
+        std::string folderTemplate =
+            std::string{ ADUC_SystemUtils_GetTemporaryPathName() } + "/steps_handler_ut_XXXXXX";
+        std::vector<char> folder{ folderTemplate.begin(), folderTemplate.end() };
+        folder.push_back('\0');
+        REQUIRE(mkdtemp(folder.data()) != nullptr);
+        _path = folder.data();
+    }
+
+    TestWorkFolder(const TestWorkFolder&) = delete;
+    TestWorkFolder& operator=(const TestWorkFolder&) = delete;
+    TestWorkFolder(TestWorkFolder&&) = delete;
+    TestWorkFolder& operator=(TestWorkFolder&&) = delete;
+
+    ~TestWorkFolder()
+    {
+        (void)ADUC_SystemUtils_RmDirRecursive(_path.c_str());
+    }
+
+    const char* GetPath() const
+    {
+        return _path.c_str();
+    }
+
+private:
+    std::string _path;
+};
+
+/**
+ * @brief Uses the test config, with 'pipelineStepDownloads' set and 'maxConcurrentComponents' of 2,
+ * for the lifetime of the object.
+ */
+class TestConfig
+{
+public:
+    TestConfig()
+    {
+        std::string path{ ADUC_TEST_DATA_FOLDER };
+        path += "/steps_handler_test_config";
+        ADUCPAL_setenv(ADUC_CONFIG_FOLDER_ENV, path.c_str(), 1);
+        _config = ADUC_ConfigInfo_GetInstance();
+        REQUIRE(_config != nullptr);
+    }
+
+    TestConfig(const TestConfig&) = delete;
+    TestConfig& operator=(const TestConfig&) = delete;
+    TestConfig(TestConfig&&) = delete;
+    TestConfig& operator=(TestConfig&&) = delete;
+
+    ~TestConfig()
+    {
+        ADUC_ConfigInfo_ReleaseInstance(_config);
+    }
+
+private:
+    const ADUC_ConfigInfo* _config;
+};
+
+/**
+ * @brief Registers a component enumerator for the lifetime of the object. Its functions are never called,
+ * as the tests set the selected components on the workflow.
+ */
+class TestComponentEnumerator
+{
+public:
+    TestComponentEnumerator() : _lib(ADUCPAL_dlopen(nullptr, RTLD_LAZY))
+    {
+        REQUIRE(_lib != nullptr);
+        REQUIRE(IsAducResultCodeSuccess(ExtensionManager::SetComponentEnumeratorLibrary(_lib).ResultCode));
+    }
+
+    TestComponentEnumerator(const TestComponentEnumerator&) = delete;
+    TestComponentEnumerator& operator=(const TestComponentEnumerator&) = delete;
+    TestComponentEnumerator(TestComponentEnumerator&&) = delete;
+    TestComponentEnumerator& operator=(TestComponentEnumerator&&) = delete;
+
+    ~TestComponentEnumerator()
+    {
+        ExtensionManager::SetComponentEnumeratorLibrary(nullptr);
+        ADUCPAL_dlclose(_lib);
+    }
+
+private:
+    void* _lib;
+};
+
+static const char* const TwoSelectedComponents = R"({"components":[{"id":"a"},{"id":"b"}]})";
+
+/**
+ * @brief Makes an update action with two inline steps and no payloads.
+ */
+static std::string MakeTwoStepUpdateAction(const char* step0Handler, const char* step1Handler)
+{
+    std::stringstream action;
+    action << R"({"workflow":{"action":3,"id":"4a6e3b8c-2f0d-4c51-9b7a-5d2e8f1c0a93"},)"
+           << R"("updateManifest":"{\"manifestVersion\":\"4\",)"
+           << R"(\"updateId\":{\"provider\":\"Contoso\",\"name\":\"Steps\",\"version\":\"1.0\"},)"
+           << R"(\"compatibility\":[{\"deviceManufacturer\":\"contoso\",\"deviceModel\":\"espresso-v1\"}],)"
+           << R"(\"instructions\":{\"steps\":[)"
+           << R"({\"handler\":\")" << step0Handler << R"(\",\"files\":[],\"handlerProperties\":{}},)"
+           << R"({\"handler\":\")" << step1Handler << R"(\",\"files\":[],\"handlerProperties\":{}}]},)"
+           << R"(\"files\":{},\"createdDateTime\":\"2022-03-28T22:36:07.8445392Z\"}"})";
+    return action.str();
+}
+
+/**
+ * @brief Waits up to 5 seconds for @p condition.
+ */
+static bool WaitFor(const std::function<bool()>& condition)
+{
+    for (int i = 0; i < 5000 && !condition(); i++)
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    return condition();
+}
+
+/**
+ * @brief Runs the steps handler's Download then Install on the update action @p updateAction.
+ * @param level The workflow level. 1 for the steps of a reference step.
+ * @param selectedComponents The selected components of a level 1 workflow, or nullptr.
+ * @param[out] downloadResult The Download result.
+ * @param[out] installResult The Install result.
+ */
+static void RunStepsHandler(
+    const std::string& updateAction,
+    int level,
+    const char* selectedComponents,
+    ADUC_Result& downloadResult,
+    ADUC_Result& installResult)
+{
+    TestWorkFolder workFolder;
+    ADUC_WorkflowHandle handle = nullptr;
+
+    ADUC_Result result = workflow_init(updateAction.c_str(), false /* validateManifest */, &handle);
+    REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+    REQUIRE(workflow_set_workfolder(handle, "%s", workFolder.GetPath()));
+    workflow_set_level(handle, level);
+    if (selectedComponents != nullptr)
+    {
+        REQUIRE(workflow_set_selected_components(handle, selectedComponents));
+    }
+
+    ADUC_WorkflowData workflowData = {};
+    workflowData.WorkflowHandle = handle;
+
+    std::unique_ptr<ContentHandler> stepsHandler{ StepsHandlerImpl::CreateContentHandler() };
+    REQUIRE(stepsHandler != nullptr);
+
+    downloadResult = stepsHandler->Download(&workflowData);
+    installResult = { ADUC_Result_Failure, 0 };
+    if (IsAducResultCodeSuccess(downloadResult.ResultCode))
+    {
+        installResult = stepsHandler->Install(&workflowData);
+    }
+
+    workflow_free(handle);
+}
+
+TEST_CASE("Pipelined install checks IsInstalled of the next step after the current step")
+{
+    TestConfig config;
+
+    // Step 1 is installed until step 0 installs. Step 0's install waits for the steps handler to start on step 1,
+    // so that a background IsInstalled call on step 1 would see the stale answer.
+    auto* step0Handler = new MockStepHandler{};
+    auto* step1Handler = new MockStepHandler{};
+    step1Handler->isInstalled = true;
+    step0Handler->onInstall = [step1Handler]() {
+        WaitFor([step1Handler]() { return step1Handler->callCount > 0; });
+        step1Handler->isInstalled = false;
+    };
+
+    REQUIRE(IsAducResultCodeSuccess(
+        ExtensionManager::SetUpdateContentHandlerExtension("test/step-zero:1", step0Handler).ResultCode));
+    REQUIRE(IsAducResultCodeSuccess(
+        ExtensionManager::SetUpdateContentHandlerExtension("test/step-one:1", step1Handler).ResultCode));
+
+    ADUC_Result downloadResult{};
+    ADUC_Result installResult{};
+    RunStepsHandler(
+        MakeTwoStepUpdateAction("test/step-zero:1", "test/step-one:1"),
+        0 /* level */,
+        nullptr /* selectedComponents */,
+        downloadResult,
+        installResult);
+
+    CHECK(downloadResult.ResultCode == ADUC_Result_Download_Success);
+    CHECK(installResult.ResultCode == ADUC_Result_Install_Success);
+    CHECK(step0Handler->installCount == 1);
+    CHECK(step1Handler->installCount == 1);
+    CHECK(step1Handler->downloadedBeforeInstall);
+
+    ExtensionManager::Uninit();
+}
+
+TEST_CASE("Pipelined install calls a step handler from one thread at a time")
+{
+    TestConfig config;
+
+    auto* stepHandler = new MockStepHandler{};
+    REQUIRE(IsAducResultCodeSuccess(
+        ExtensionManager::SetUpdateContentHandlerExtension("test/step:1", stepHandler).ResultCode));
+
+    ADUC_Result downloadResult{};
+    ADUC_Result installResult{};
+    RunStepsHandler(
+        MakeTwoStepUpdateAction("test/step:1", "test/step:1"),
+        0 /* level */,
+        nullptr /* selectedComponents */,
+        downloadResult,
+        installResult);
+
+    CHECK(downloadResult.ResultCode == ADUC_Result_Download_Success);
+    CHECK(installResult.ResultCode == ADUC_Result_Install_Success);
+    CHECK(stepHandler->installCount == 2);
+    CHECK(stepHandler->maxCallsInFlight == 1);
+
+    ExtensionManager::Uninit();
+}
+
+TEST_CASE("Pipelined install cancels the next step's download when a reboot is requested")
+{
+    TestConfig config;
+
+    // Step 1's download only returns once it is cancelled, or after 5 seconds.
+    auto* step0Handler = new MockStepHandler{};
+    auto* step1Handler = new MockStepHandler{};
+    step0Handler->requestImmediateReboot = true;
+    step1Handler->downloadWaitsForCancel = true;
+    step0Handler->onInstall = [step1Handler]() {
+        WaitFor([step1Handler]() { return step1Handler->downloadCount > 0; });
+    };
+
+    REQUIRE(IsAducResultCodeSuccess(
+        ExtensionManager::SetUpdateContentHandlerExtension("test/step-zero:1", step0Handler).ResultCode));
+    REQUIRE(IsAducResultCodeSuccess(
+        ExtensionManager::SetUpdateContentHandlerExtension("test/step-one:1", step1Handler).ResultCode));
+
+    ADUC_Result downloadResult{};
+    ADUC_Result installResult{};
+    RunStepsHandler(
+        MakeTwoStepUpdateAction("test/step-zero:1", "test/step-one:1"),
+        0 /* level */,
+        nullptr /* selectedComponents */,
+        downloadResult,
+        installResult);
+
+    CHECK(downloadResult.ResultCode == ADUC_Result_Download_Success);
+    CHECK(installResult.ResultCode == ADUC_Result_Install_RequiredImmediateReboot);
+    CHECK(step0Handler->installCount == 1);
+    CHECK(step1Handler->downloadCount == 1);
+    CHECK(step1Handler->downloadCancelled);
+    CHECK(step1Handler->installCount == 0);
+
+    ExtensionManager::Uninit();
+}
+
+TEST_CASE("Concurrent components report the exact success codes")
+{
+    TestConfig config;
+    TestComponentEnumerator enumerator;
+
+    auto* stepHandler = new MockStepHandler{};
+    const bool supportsConcurrentCalls = true;
+    REQUIRE(IsAducResultCodeSuccess(
+        ExtensionManager::SetUpdateContentHandlerExtension("test/step:1", stepHandler, supportsConcurrentCalls)
+            .ResultCode));
+
+    ADUC_Result downloadResult{};
+    ADUC_Result installResult{};
+    RunStepsHandler(
+        MakeTwoStepUpdateAction("test/step:1", "test/step:1"),
+        1 /* level */,
+        TwoSelectedComponents,
+        downloadResult,
+        installResult);
+
+    CHECK(downloadResult.ResultCode == ADUC_Result_Download_Success);
+    CHECK(downloadResult.ExtendedResultCode == 0);
+    CHECK(installResult.ResultCode == ADUC_Result_Install_Success);
+    CHECK(installResult.ExtendedResultCode == 0);
+    CHECK(stepHandler->installCount == 4);
+
+    ExtensionManager::Uninit();
+}
+
+TEST_CASE("Components are processed one at a time when a step handler does not support concurrent calls")
+{
+    TestConfig config;
+    TestComponentEnumerator enumerator;
+
+    auto* stepHandler = new MockStepHandler{};
+    REQUIRE(IsAducResultCodeSuccess(
+        ExtensionManager::SetUpdateContentHandlerExtension("test/step:1", stepHandler).ResultCode));
+
+    ADUC_Result downloadResult{};
+    ADUC_Result installResult{};
+    RunStepsHandler(
+        MakeTwoStepUpdateAction("test/step:1", "test/step:1"),
+        1 /* level */,
+        TwoSelectedComponents,
+        downloadResult,
+        installResult);
+
+    CHECK(downloadResult.ResultCode == ADUC_Result_Download_Success);
+    CHECK(installResult.ResultCode == ADUC_Result_Install_Success);
+    CHECK(stepHandler->installCount == 4);
+    CHECK(stepHandler->maxCallsInFlight == 1);
+
+    ExtensionManager::Uninit();
+}
@@ -1511,12 +1511,36 @@ MAKE_ADUC_EXTENDEDRESULTCODE_FOR_FACILITY_ADUC_FACILITY_UNUSED_F(const int32_t c
 #define ADUC_ERROR_DELIVERY_OPTIMIZATION_DOWNLOADER_BAD_INIT_DATA \
     MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_DELIVERY_OPTIMIZATION(2)
 
+/**
+ * @brief ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_INIT_FAILURE, ERC Value: 1075838977 (0x40200001)
+ */
+#define ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_INIT_FAILURE \
+    MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_SIMPLE_HTTP_DOWNLOADER(1)
+
+/**
+ * @brief ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_FILE_WRITE_FAILURE, ERC Value: 1075838978 (0x40200002)
+ */
+#define ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_FILE_WRITE_FAILURE \
+    MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_SIMPLE_HTTP_DOWNLOADER(2)
+
+/**
+ * @brief ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_TIMEOUT, ERC Value: 1075838979 (0x40200003)
+ */
+#define ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_TIMEOUT \
+    MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_SIMPLE_HTTP_DOWNLOADER(3)
+
 /**
  * @brief ADUC_ERROR_CURL_DOWNLOADER_INVALID_FILE_HASH, ERC Value: 1076887553 (0x40300001)
  */
 #define ADUC_ERROR_CURL_DOWNLOADER_INVALID_FILE_HASH \
     MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_CURL_DOWNLOADER(1)
 
+/**
+ * @brief ADUC_ERROR_CURL_DOWNLOADER_FILE_WRITE_FAILURE, ERC Value: 1076887554 (0x40300002)
+ */
+#define ADUC_ERROR_CURL_DOWNLOADER_FILE_WRITE_FAILURE \
+    MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_CURL_DOWNLOADER(2)
+
 /**
  * @brief ADUC_ERC_COMPONENT_ENUMERATOR_GETALLCOMPONENTS_NOTIMP, ERC Value: 1879048193 (0x70000001)
  */
@@ -2402,4 +2426,10 @@ static inline ADUC_Result_t MAKE_ADUC_DELIVERY_OPTIMIZATION_EXTENDEDRESULTCODE(c
 #define ADUC_ERROR_CURL_DOWNLOADER_EXTERNAL_FAILURE(exitCode) \
     MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_CURL_DOWNLOADER((0x1000 + exitCode))
 
+#define ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_CURL_FAILURE(curlCode) \
+    MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_SIMPLE_HTTP_DOWNLOADER((0x1000 + curlCode))
+
+#define ADUC_ERROR_SIMPLE_HTTP_DOWNLOADER_HTTP_FAILURE(httpStatus) \
+    MAKE_ADUC_EXTENDEDRESULTCODE_FOR_COMPONENT_ADUC_CONTENT_DOWNLOADER_SIMPLE_HTTP_DOWNLOADER((0x2000 + httpStatus))
+
 #endif // ADUC_RESULT_H
@@ -8,6 +8,7 @@
 typedef unsigned int clockid_t;
 
 #    define CLOCK_REALTIME 0
+#    define CLOCK_MONOTONIC 1
 
 #    ifdef __cplusplus
 extern "C"
@@ -11,7 +11,18 @@ int ADUCPAL_clock_gettime(clockid_t clk_id, struct timespec* tp)
 #define FILETIME_1970 116444736000000000ull /* seconds between 1/1/1601 and 1/1/1970 */
 #define HECTONANOSEC_PER_SEC 10000000ull
 
-    // Note: Only CLOCK_REALTIME supported.
+    // Note: Only CLOCK_REALTIME and CLOCK_MONOTONIC supported.
+    if (clk_id == CLOCK_MONOTONIC)
+    {
+        LARGE_INTEGER frequency;
+        LARGE_INTEGER counter;
+        QueryPerformanceFrequency(&frequency);
+        QueryPerformanceCounter(&counter);
+        tp->tv_sec = (time_t)(counter.QuadPart / frequency.QuadPart);
+        tp->tv_nsec = (long)((counter.QuadPart % frequency.QuadPart) * 1000000000ull / frequency.QuadPart);
+        return 0;
+    }
+
     if (clk_id != CLOCK_REALTIME)
     {
         _set_errno(ENOSYS);
@@ -23,12 +23,17 @@
 // a dozen and 64 lines, with du-agent.* logs having 100-300 lines. A value of
 // 128 was chosen to balance a smaller working set (41 KB) with log responsiveness
 // when tailing logs and allowing for diagnostics upload.
+//
+// The buffer is a ring drained by a background log writer thread, so the number of lines must be a power of two.
 #define ZLOG_BUFFER_LINE_MAXCHARS 328
 #define ZLOG_BUFFER_MAXLINES 128
 
+// Buffered lines are written at least this often.
 #define ZLOG_FLUSH_INTERVAL_SEC 30
+// How often the log writer thread wakes up to check the buffer.
 #define ZLOG_SLEEP_TIME_SEC 2
 // In practice: flush size < .8 * BUFFER_SIZE
+// The log writer thread is woken to flush once this many lines are buffered.
 #define ZLOG_BUFFER_FLUSH_MAXLINES (0.8 * ZLOG_BUFFER_MAXLINES)
 
 // Maximum number of log files to keep
@@ -10,13 +10,14 @@
 
 #include <aducpal/dirent.h>
 #include <aducpal/sys_time.h> // gettimeofday
-#include <aducpal/time.h> // clock_gettime, gmtime_r
+#include <aducpal/time.h> // clock_gettime, gmtime_r, nanosleep
 #include <aducpal/unistd.h> // getpid, sleep, syscall
 
 #include <errno.h>
 #include <pthread.h>
 #include <stdarg.h>
 #include <stdbool.h>
+#include <stdint.h> // int64_t
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h> // for strcmp, memset, strlen, etc.
@@ -24,6 +25,30 @@
 #include <sys/types.h>
 #include <time.h>
 
+#if defined(WIN32)
+#    include <windows.h> // Interlocked*
+#    define ZLOG_ATOMIC_LOAD(ptr) InterlockedCompareExchange64((volatile LONG64*)(ptr), 0, 0)
+#    define ZLOG_ATOMIC_STORE(ptr, value) InterlockedExchange64((volatile LONG64*)(ptr), (LONG64)(value))
+#    define ZLOG_ATOMIC_CAS(ptr, expected, desired) \
+        (InterlockedCompareExchange64((volatile LONG64*)(ptr), (LONG64)(desired), (LONG64)(expected)) \
+         == (LONG64)(expected))
+#    define ZLOG_THREAD_LOCAL __declspec(thread)
+
+// There is no writev on Windows, so batches are written record by record through the stdio stream.
+struct iovec
+{
+    void* iov_base;
+    size_t iov_len;
+};
+#else
+#    include <sys/uio.h> // writev
+#    define ZLOG_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#    define ZLOG_ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#    define ZLOG_ATOMIC_CAS(ptr, expected, desired) \
+        __atomic_compare_exchange_n((ptr), &(expected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+#    define ZLOG_THREAD_LOCAL __thread
+#endif
+
 #include "zlog-config.h"
 #include "zlog.h"
 
@@ -51,18 +76,59 @@ static char* zlog_file_log_dir = NULL;
 static char* zlog_file_log_prefix = NULL;
 static time_t zlog_last_flushed = 0;
 
-char _zlog_buffer[ZLOG_BUFFER_MAXLINES][ZLOG_BUFFER_LINE_MAXCHARS];
-static int _zlog_buffer_count = 0;
+// Size of the current log file, including everything written by the log writer so far.
+static size_t zlog_file_size = 0;
+
+// Whether log lines should be queued for the log file. Unlike zlog_fout, this does not change on roll-over.
+static bool zlog_file_log_enabled = false;
+
+/**
+ * @brief A preformatted log record in the log ring.
+ * Records that do not fit in @p line (multi-line logs) are kept in @p heap_line instead.
+ */
+typedef struct tagZLOG_RECORD
+{
+    int64_t sequence; // Vyukov ring sequence: position when free, position + 1 when published.
+    size_t len;
+    char* heap_line;
+    char line[ZLOG_BUFFER_LINE_MAXCHARS];
+} ZLOG_RECORD;
+
+// Lock-free multi-producer ring of records waiting to be written to the log file.
+// Any thread can publish; only the holder of _zlog_buffer_mutex consumes.
+static ZLOG_RECORD _zlog_ring[ZLOG_BUFFER_MAXLINES];
+static int64_t _zlog_ring_enqueue_pos = 0;
+static int64_t _zlog_ring_dequeue_pos = 0;
+static bool _zlog_ring_initialized = false;
+
+// Serializes consumers of the ring and everything touching zlog_fout.
 static pthread_mutex_t _zlog_buffer_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+// Background log writer state. _zlog_writer_mutex only guards the wait, never file I/O.
+static pthread_t _zlog_writer_thread;
+static bool _zlog_writer_started = false;
+static bool _zlog_writer_stop = false;
+static int64_t _zlog_writer_wake_requested = 0;
+static pthread_mutex_t _zlog_writer_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t _zlog_writer_cond = PTHREAD_COND_INITIALIZER;
+
+// Per-thread cache of the date and time part of the prelude, which only changes once per second.
+static ZLOG_THREAD_LOCAL time_t _zlog_cached_seconds = -1;
+static ZLOG_THREAD_LOCAL char _zlog_cached_datetime[sizeof("2020-07-01T18:21:26")];
+
 struct tm* get_current_utctime();
 bool get_current_utctime_filename(char* fullpath, size_t fullpath_len);
 static inline void _zlog_buffer_lock(void);
 static inline void _zlog_buffer_unlock(void);
 static void _zlog_roll_over_if_file_size_too_large(size_t additional_log_len);
 static void _zlog_flush_buffer(void);
-static inline char* zlog_lock_and_get_buffer(void);
-static inline void zlog_finish_buffer_and_unlock(void);
+static ZLOG_RECORD* zlog_claim_record(int64_t* claimed_pos);
+static void zlog_publish_record(ZLOG_RECORD* record);
+static void zlog_flush_through(int64_t pos);
+static void zlog_backoff(unsigned int* attempt);
+static void zlog_wake_writer(void);
+static bool zlog_start_writer(void);
+static void zlog_stop_writer(void);
 void zlog_ensure_at_most_n_logfiles(int max_num);
 
 static bool zlog_is_file_log_open()
@@ -79,6 +145,26 @@ static void zlog_close_file_log()
     }
 }
 
+// Opens a new timestamped log file and records its current size.
+static bool zlog_open_file_log(char* fullpath, size_t fullpath_len)
+{
+    if (!get_current_utctime_filename(fullpath, fullpath_len))
+    {
+        return false;
+    }
+
+    zlog_fout = fopen(fullpath, "a+");
+    if (zlog_fout == NULL)
+    {
+        return false;
+    }
+
+    // The file name is only unique to the second, so it may already have content.
+    long size = (fseek(zlog_fout, 0, SEEK_END) == 0) ? ftell(zlog_fout) : -1;
+    zlog_file_size = (size > 0) ? (size_t)size : 0;
+    return true;
+}
+
 static bool zlog_is_stdout_a_tty()
 {
     return (ADUCPAL_isatty(fileno(stdout)) != 0);
@@ -171,17 +257,28 @@ int zlog_init(
 
         // Timestamp the log file
         char zlog_file_log_fullpath[512];
-        if (!get_current_utctime_filename(zlog_file_log_fullpath, sizeof(zlog_file_log_fullpath)))
+        if (!zlog_open_file_log(zlog_file_log_fullpath, sizeof(zlog_file_log_fullpath)))
         {
-            // When error occurs to snprintf filepath, return false
             return -1;
         }
 
-        zlog_fout = fopen(zlog_file_log_fullpath, "a+");
-        if (zlog_fout == NULL)
+        if (!_zlog_ring_initialized)
         {
-            return -1;
+            for (int64_t i = 0; i < ZLOG_BUFFER_MAXLINES; i++)
+            {
+                _zlog_ring[i].sequence = i;
+            }
+            _zlog_ring_initialized = true;
+        }
+
+        zlog_file_log_enabled = true;
+
+        if (!zlog_start_writer())
+        {
+            // Still log to file, but flush on the logging thread as before.
+            log_warn("Unable to start log writer thread.");
         }
+
         log_debug("Log file created: %s", zlog_file_log_fullpath);
 
         zlog_ensure_at_most_n_logfiles(ZLOG_MAX_FILE_COUNT);
@@ -200,12 +297,19 @@ void zlog_flush_buffer(void)
 // Caller should NOT hold the lock
 void zlog_finish(void)
 {
-    zlog_flush_buffer();
+    zlog_stop_writer();
+
+    zlog_file_log_enabled = false;
 
+    _zlog_buffer_lock();
+    _zlog_flush_buffer();
     zlog_close_file_log();
+    _zlog_buffer_unlock();
 
     free(zlog_file_log_dir);
+    zlog_file_log_dir = NULL;
     free(zlog_file_log_prefix);
+    zlog_file_log_prefix = NULL;
 }
 
 #define MAX_FUNCTION_NAME 64
@@ -219,7 +323,9 @@ void zlog_finish(void)
 //       Max numeric assignable is in /proc/sys/kernel/pid_max but that
 //       could change while running, so using PID_MAX_LIMIT as defined
 //       in Linux kernel include/linux/threads.h
-#define PRELUDE_FORMAT "%04d-%02d-%02dT%02d:%02d:%02d.%04dZ %d[%d]"
+// (cached datetime, fraction, pid, tid)
+#define PRELUDE_FORMAT "%s.%04dZ %d[%d]"
+#define DATETIME_FORMAT "%04d-%02d-%02dT%02d:%02d:%02d"
 #define PRELUDE_SAMPLE "2020-07-01T18:21:26.1234Z 4194304[4194304]"
 #define PRELUDE_BUFFER_SIZE sizeof(PRELUDE_SAMPLE)
 
@@ -237,7 +343,7 @@ void zlog_log(enum ZLOG_SEVERITY msg_level, const char* func, unsigned int line,
 {
     const bool console_log_needed =
         (log_setting.console_logging_mode != ZLOG_CLM_DISABLED) && (msg_level >= log_setting.console_level);
-    const bool file_log_needed = zlog_is_file_log_open() && (msg_level >= log_setting.file_level);
+    const bool file_log_needed = zlog_file_log_enabled && (msg_level >= log_setting.file_level);
 
     if (!console_log_needed && !file_log_needed)
     {
@@ -253,22 +359,44 @@ void zlog_log(enum ZLOG_SEVERITY msg_level, const char* func, unsigned int line,
 
     const time_t seconds = curtime.tv_sec;
 
-    struct tm gmtval;
-    struct tm* tmval = ADUCPAL_gmtime_r(&seconds, &gmtval);
+    if (seconds != _zlog_cached_seconds)
+    {
+        struct tm gmtval;
+        struct tm* tmval = ADUCPAL_gmtime_r(&seconds, &gmtval);
 
-    if (tmval != NULL)
+        _zlog_cached_datetime[0] = '\0';
+        _zlog_cached_seconds = -1;
+
+        if (tmval != NULL)
+        {
+            // % 100 below to ensure the values fit in 2-digits template.
+            int ret = snprintf(
+                _zlog_cached_datetime,
+                sizeof(_zlog_cached_datetime),
+                DATETIME_FORMAT,
+                tmval->tm_year + 1900,
+                tmval->tm_mon + 1,
+                tmval->tm_mday % 100,
+                tmval->tm_hour % 100,
+                tmval->tm_min % 100,
+                tmval->tm_sec % 100);
+
+            if (ret < 0)
+            {
+                return;
+            }
+
+            _zlog_cached_seconds = seconds;
+        }
+    }
+
+    if (_zlog_cached_seconds != -1)
     {
-        // % 100 below to ensure the values fit in 2-digits template.
         int ret = snprintf(
             prelude_buffer,
             PRELUDE_BUFFER_SIZE,
             PRELUDE_FORMAT,
-            tmval->tm_year + 1900,
-            tmval->tm_mon + 1,
-            tmval->tm_mday % 100,
-            tmval->tm_hour % 100,
-            tmval->tm_min % 100,
-            tmval->tm_sec % 100,
+            _zlog_cached_datetime,
             (int)(curtime.tv_nsec / 100000),
             ADUCPAL_getpid(),
             (pid_t)ADUCPAL_syscall(SYS_gettid) /* cannot call gettid() directly */
@@ -348,13 +476,15 @@ void zlog_log(enum ZLOG_SEVERITY msg_level, const char* func, unsigned int line,
 
     if (file_log_needed)
     {
+        // Only format the record here; the log writer thread does the file I/O.
+        int64_t record_pos = 0;
+        ZLOG_RECORD* record = zlog_claim_record(&record_pos);
+
         if ((full_log_len + RESERVED_INFO_SIZE) < ZLOG_BUFFER_LINE_MAXCHARS)
         {
-            // The log can fit in one line. Just add to zlog buffer.
-            char* buffer = zlog_lock_and_get_buffer();
-
-            (void)snprintf(
-                buffer,
+            // The log can fit in one line.
+            int ret = snprintf(
+                record->line,
                 ZLOG_BUFFER_LINE_MAXCHARS,
                 LOG_FORMAT,
                 prelude_buffer,
@@ -363,34 +493,73 @@ void zlog_log(enum ZLOG_SEVERITY msg_level, const char* func, unsigned int line,
                 func,
                 line);
 
-            zlog_finish_buffer_and_unlock();
+            record->len = (ret < 0) ? 0 : strlen(record->line);
         }
         else
         {
-            // The log is too long, let's flush the buffer then write to log file directly.
-            _zlog_buffer_lock();
-            _zlog_flush_buffer();
+            // The log is too long for a line, so write it as a multi-line log from the heap.
+            size_t heap_line_size = full_log_len + sizeof(MULTILINE_BEGIN_FORMAT) + sizeof(MULTILINE_END_FORMAT)
+                + (PRELUDE_BUFFER_SIZE + MAX_FUNCTION_NAME) * 2;
 
-            _zlog_roll_over_if_file_size_too_large(
-                full_log_len + sizeof(MULTILINE_BEGIN_FORMAT) + sizeof(MULTILINE_END_FORMAT)
-                + (PRELUDE_BUFFER_SIZE + MAX_FUNCTION_NAME) * 2);
-            fprintf(zlog_fout, MULTILINE_BEGIN_FORMAT, prelude_buffer, level_names[msg_level], func, line);
-
-            va_start(va, fmt);
-            (void)vfprintf(zlog_fout, fmt, va);
-            va_end(va);
+            record->heap_line = (char*)malloc(heap_line_size);
+            if (record->heap_line != NULL)
+            {
+                size_t offset = 0;
+                int ret = snprintf(
+                    record->heap_line,
+                    heap_line_size,
+                    MULTILINE_BEGIN_FORMAT,
+                    prelude_buffer,
+                    level_names[msg_level],
+                    func,
+                    line);
+                offset += (ret < 0) ? 0 : (size_t)ret;
+
+                if (offset < heap_line_size)
+                {
+                    va_start(va, fmt);
+                    ret = vsnprintf(record->heap_line + offset, heap_line_size - offset, fmt, va);
+                    va_end(va);
+                    offset += (ret < 0) ? 0 : (size_t)ret;
+                }
+
+                if (offset < heap_line_size)
+                {
+                    (void)snprintf(
+                        record->heap_line + offset,
+                        heap_line_size - offset,
+                        MULTILINE_END_FORMAT,
+                        prelude_buffer,
+                        level_names[msg_level],
+                        func,
+                        line);
+                }
+
+                record->len = strlen(record->heap_line);
+            }
+        }
 
-            fprintf(zlog_fout, MULTILINE_END_FORMAT, prelude_buffer, level_names[msg_level], func, line);
-            fflush(zlog_fout);
+        zlog_publish_record(record);
 
-            _zlog_buffer_unlock();
+#ifdef ZLOG_FORCE_FLUSH_BUFFER
+        zlog_flush_through(record_pos);
+#else
+        if (msg_level == ZLOG_ERROR)
+        {
+            // Errors are written before returning, so they survive a crash right after.
+            zlog_flush_through(record_pos);
         }
-    }
-
-    if (msg_level == ZLOG_ERROR || (seconds - zlog_last_flushed) >= ZLOG_FLUSH_INTERVAL_SEC)
-    {
-        zlog_flush_buffer();
-        zlog_last_flushed = seconds;
+        else if (!_zlog_writer_started && (seconds - zlog_last_flushed) >= ZLOG_FLUSH_INTERVAL_SEC)
+        {
+            zlog_flush_buffer();
+        }
+        else if (
+            (ZLOG_ATOMIC_LOAD(&_zlog_ring_enqueue_pos) - ZLOG_ATOMIC_LOAD(&_zlog_ring_dequeue_pos))
+            >= (int64_t)ZLOG_BUFFER_FLUSH_MAXLINES)
+        {
+            zlog_wake_writer();
+        }
+#endif
     }
 }
 
@@ -429,6 +598,7 @@ bool get_current_utctime_filename(char* fullpath, size_t fullpath_len)
 }
 
 // Roll over to a new log file if the current file size + additional_log_len exceeds ZLOG_FILE_MAX_SIZE_KB * 1024.
+// Caller should hold the lock
 static void _zlog_roll_over_if_file_size_too_large(size_t additional_log_len)
 {
     if (!zlog_is_file_log_open())
@@ -436,16 +606,8 @@ static void _zlog_roll_over_if_file_size_too_large(size_t additional_log_len)
         return;
     }
 
-    long ftellVal = ftell(zlog_fout);
-
-    // Some error occurred
-    if (ftellVal < 0)
-    {
-        return;
-    }
-
     // Roll over to new log file once the current file size exceeds the limit
-    if (((size_t)ftellVal + additional_log_len) > (ZLOG_FILE_MAX_SIZE_KB * 1024))
+    if ((zlog_file_size + additional_log_len) > (ZLOG_FILE_MAX_SIZE_KB * 1024))
     {
         zlog_close_file_log();
 
@@ -453,61 +615,264 @@ static void _zlog_roll_over_if_file_size_too_large(size_t additional_log_len)
         zlog_ensure_at_most_n_logfiles(ZLOG_MAX_FILE_COUNT);
 
         // Timestamp the new log file
-        char zlog_file_log_fullpath[512];
-        if (!get_current_utctime_filename(zlog_file_log_fullpath, sizeof(zlog_file_log_fullpath)))
-        {
-            return;
-        }
-
         // INVARIANT: zlog_fout == NULL due to zlog_close_file_log() call above.
-        zlog_fout = fopen(zlog_file_log_fullpath, "a");
+        char zlog_file_log_fullpath[512];
+        (void)zlog_open_file_log(zlog_file_log_fullpath, sizeof(zlog_file_log_fullpath));
     }
 }
 
+// Writes a batch of records to the log file with a single system call where possible.
 // Caller should hold the lock
-static void _zlog_flush_buffer()
+static void _zlog_write_batch(struct iovec* iov, int count, size_t batch_len)
 {
-    if (!zlog_is_file_log_open())
+    if (count == 0 || !zlog_is_file_log_open())
     {
         return;
     }
 
-    // Flush buffer to file
-    int i = 0;
-    for (i = 0; i < _zlog_buffer_count; i++)
+#if defined(WIN32)
+    for (int i = 0; i < count; i++)
     {
-        _zlog_roll_over_if_file_size_too_large(strlen(_zlog_buffer[i]));
-        fputs(_zlog_buffer[i], zlog_fout);
+        fwrite(iov[i].iov_base, 1, iov[i].iov_len, zlog_fout);
     }
     fflush(zlog_fout);
+#else
+    // zlog_fout is never written through stdio, so there is no stream buffer to keep in sync.
+    (void)writev(fileno(zlog_fout), iov, count);
+#endif
+
+    // Count the bytes even if the write failed, so that a full disk still rolls over and cleans up.
+    zlog_file_size += batch_len;
+}
+
+// Releases the records in [_zlog_ring_dequeue_pos, end) back to the producers.
+// Caller should hold the lock
+static void _zlog_release_records(int64_t end)
+{
+    for (int64_t pos = _zlog_ring_dequeue_pos; pos < end; pos++)
+    {
+        ZLOG_RECORD* record = &_zlog_ring[pos & (ZLOG_BUFFER_MAXLINES - 1)];
+
+        free(record->heap_line);
+        record->heap_line = NULL;
+        record->len = 0;
+        ZLOG_ATOMIC_STORE(&record->sequence, pos + ZLOG_BUFFER_MAXLINES);
+    }
+
+    ZLOG_ATOMIC_STORE(&_zlog_ring_dequeue_pos, end);
+}
+
+// Writes all published records to the log file, rolling over between batches as needed.
+// Caller should hold the lock
+static void _zlog_flush_buffer()
+{
+    struct iovec iov[ZLOG_BUFFER_MAXLINES];
+    int count = 0;
+    size_t batch_len = 0;
+    int64_t pos = _zlog_ring_dequeue_pos;
+
+    for (;;)
+    {
+        ZLOG_RECORD* record = &_zlog_ring[pos & (ZLOG_BUFFER_MAXLINES - 1)];
+        const bool published = ZLOG_ATOMIC_LOAD(&record->sequence) == pos + 1;
+
+        if (published && record->len == 0)
+        {
+            // Formatting failed; nothing to write.
+            pos++;
+            continue;
+        }
+
+        if (published && count < ZLOG_BUFFER_MAXLINES
+            && (count == 0 || (zlog_file_size + batch_len + record->len) <= (ZLOG_FILE_MAX_SIZE_KB * 1024)))
+        {
+            iov[count].iov_base = (record->heap_line != NULL) ? record->heap_line : record->line;
+            iov[count].iov_len = record->len;
+            count++;
+            batch_len += record->len;
+            pos++;
+            continue;
+        }
+
+        // Either the ring is drained, or the next record belongs in the next batch or file.
+        if (count > 0)
+        {
+            _zlog_roll_over_if_file_size_too_large(batch_len);
+            _zlog_write_batch(iov, count, batch_len);
+        }
 
-    _zlog_buffer_count = 0;
+        _zlog_release_records(pos);
+        count = 0;
+        batch_len = 0;
+
+        if (!published)
+        {
+            break;
+        }
+    }
 
     _zlog_roll_over_if_file_size_too_large(0);
+
+    zlog_last_flushed = time(NULL);
 }
 
+// Writes records until the one claimed at pos is in the log file.
 // Caller should NOT hold the lock
-static inline char* zlog_lock_and_get_buffer(void)
+static void zlog_flush_through(int64_t pos)
 {
-    _zlog_buffer_lock();
-    // Flush the buffer if it is full
-    if (_zlog_buffer_count == ZLOG_BUFFER_MAXLINES)
+    unsigned int attempt = 0;
+
+    for (;;)
     {
-        _zlog_flush_buffer();
+        zlog_flush_buffer();
+
+        if (ZLOG_ATOMIC_LOAD(&_zlog_ring_dequeue_pos) > pos)
+        {
+            return;
+        }
+
+        // An earlier record is claimed but not yet published, and records are written in order.
+        zlog_backoff(&attempt);
     }
+}
 
-    // allocate buffer
-    _zlog_buffer_count++;
-    return _zlog_buffer[_zlog_buffer_count - 1];
+// Sleeps while another producer finishes formatting its record, starting at 1 us and doubling up to about 1 ms.
+static void zlog_backoff(unsigned int* attempt)
+{
+    struct timespec delay;
+    delay.tv_sec = 0;
+    delay.tv_nsec = 1000L << ((*attempt < 10) ? *attempt : 10);
+    (void)ADUCPAL_nanosleep(&delay, NULL);
+    (*attempt)++;
 }
 
-// Caller should hold the lock
-static inline void zlog_finish_buffer_and_unlock()
+// Claims the next record in the ring, draining the ring on this thread if the log writer is behind.
+// Caller should NOT hold the lock
+static ZLOG_RECORD* zlog_claim_record(int64_t* claimed_pos)
 {
-#ifdef ZLOG_FORCE_FLUSH_BUFFER
-    _zlog_flush_buffer();
-#endif
-    _zlog_buffer_unlock();
+    unsigned int attempt = 0;
+    int64_t pos = ZLOG_ATOMIC_LOAD(&_zlog_ring_enqueue_pos);
+
+    for (;;)
+    {
+        ZLOG_RECORD* record = &_zlog_ring[pos & (ZLOG_BUFFER_MAXLINES - 1)];
+        int64_t available = ZLOG_ATOMIC_LOAD(&record->sequence) - pos;
+
+        if (available == 0)
+        {
+            // The record is free; claim it, unless another producer got it first.
+            if (ZLOG_ATOMIC_CAS(&_zlog_ring_enqueue_pos, pos, pos + 1))
+            {
+                *claimed_pos = pos;
+                return record;
+            }
+        }
+        else if (available < 0)
+        {
+            // The ring is full; write it out here rather than drop logs.
+            const int64_t dequeue_pos = ZLOG_ATOMIC_LOAD(&_zlog_ring_dequeue_pos);
+            zlog_flush_buffer();
+
+            if (ZLOG_ATOMIC_LOAD(&_zlog_ring_dequeue_pos) == dequeue_pos)
+            {
+                // Nothing could be written because the oldest record is still being formatted.
+                zlog_backoff(&attempt);
+            }
+
+            pos = ZLOG_ATOMIC_LOAD(&_zlog_ring_enqueue_pos);
+        }
+        else
+        {
+            pos = ZLOG_ATOMIC_LOAD(&_zlog_ring_enqueue_pos);
+        }
+    }
+}
+
+// Makes a record claimed by zlog_claim_record visible to the log writer.
+static void zlog_publish_record(ZLOG_RECORD* record)
+{
+    // Only the claiming thread touches a claimed record, so its sequence is still the claimed position.
+    ZLOG_ATOMIC_STORE(&record->sequence, record->sequence + 1);
+}
+
+// Asks the log writer thread to flush now instead of at its next periodic wakeup.
+static void zlog_wake_writer(void)
+{
+    if (!_zlog_writer_started || ZLOG_ATOMIC_LOAD(&_zlog_writer_wake_requested) != 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&_zlog_writer_mutex);
+    ZLOG_ATOMIC_STORE(&_zlog_writer_wake_requested, 1);
+    pthread_cond_signal(&_zlog_writer_cond);
+    pthread_mutex_unlock(&_zlog_writer_mutex);
+}
+
+static void* zlog_writer_main(void* arg)
+{
+    (void)arg;
+
+    pthread_mutex_lock(&_zlog_writer_mutex);
+
+    while (!_zlog_writer_stop)
+    {
+        if (ZLOG_ATOMIC_LOAD(&_zlog_writer_wake_requested) == 0)
+        {
+            struct timespec deadline;
+            ADUCPAL_clock_gettime(CLOCK_REALTIME, &deadline);
+            deadline.tv_sec += ZLOG_SLEEP_TIME_SEC;
+            (void)pthread_cond_timedwait(&_zlog_writer_cond, &_zlog_writer_mutex, &deadline);
+        }
+
+        const bool wake_requested = ZLOG_ATOMIC_LOAD(&_zlog_writer_wake_requested) != 0;
+        ZLOG_ATOMIC_STORE(&_zlog_writer_wake_requested, 0);
+        pthread_mutex_unlock(&_zlog_writer_mutex);
+
+        const int64_t pending = ZLOG_ATOMIC_LOAD(&_zlog_ring_enqueue_pos) - ZLOG_ATOMIC_LOAD(&_zlog_ring_dequeue_pos);
+
+        _zlog_buffer_lock();
+        if (wake_requested || pending >= (int64_t)ZLOG_BUFFER_FLUSH_MAXLINES
+            || (pending > 0 && (time(NULL) - zlog_last_flushed) >= ZLOG_FLUSH_INTERVAL_SEC))
+        {
+            _zlog_flush_buffer();
+        }
+        _zlog_buffer_unlock();
+
+        pthread_mutex_lock(&_zlog_writer_mutex);
+    }
+
+    pthread_mutex_unlock(&_zlog_writer_mutex);
+    return NULL;
+}
+
+static bool zlog_start_writer(void)
+{
+    if (_zlog_writer_started)
+    {
+        return true;
+    }
+
+    _zlog_writer_stop = false;
+    _zlog_writer_started = (pthread_create(&_zlog_writer_thread, NULL, zlog_writer_main, NULL) == 0);
+    return _zlog_writer_started;
+}
+
+// Stops the log writer thread. Records it has not written yet stay in the ring.
+static void zlog_stop_writer(void)
+{
+    if (!_zlog_writer_started)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&_zlog_writer_mutex);
+    _zlog_writer_stop = true;
+    pthread_cond_signal(&_zlog_writer_cond);
+    pthread_mutex_unlock(&_zlog_writer_mutex);
+
+    pthread_join(_zlog_writer_thread, NULL);
+    _zlog_writer_started = false;
 }
 
 // Clean up until max of num old log files left
@@ -0,0 +1,190 @@
+/**
+ * @file zlog_ut.cpp
+ * @brief Unit Tests for zlog file logging.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <catch2/catch.hpp>
+
+#include "zlog-config.h"
+#include "zlog.h"
+#include <algorithm>
+#include <aduc/system_utils.h>
+#include <cstdio>
+#include <cstring>
+#include <dirent.h>
+#include <fstream>
+#include <map>
+#include <string>
+#include <thread>
+#include <vector>
+
+#define TEST_LOG_FILE_PREFIX "zlog-ut"
+
+class TestCaseFixture
+{
+public:
+    TestCaseFixture() : m_testPath{ ADUC_SystemUtils_GetTemporaryPathName() }
+    {
+        m_testPath += "/zlog_ut";
+
+        (void)ADUC_SystemUtils_RmDirRecursive(m_testPath.c_str());
+        REQUIRE(ADUC_SystemUtils_MkDirRecursiveDefault(m_testPath.c_str()) == 0);
+        REQUIRE(
+            zlog_init(m_testPath.c_str(), TEST_LOG_FILE_PREFIX, ZLOG_DISABLED, ZLOG_ENABLED, ZLOG_INFO, ZLOG_INFO)
+            == 0);
+    }
+
+    ~TestCaseFixture()
+    {
+        zlog_finish();
+        (void)ADUC_SystemUtils_RmDirRecursive(m_testPath.c_str());
+    }
+
+    /**
+     * @brief Reads the lines of all log files in the test path, oldest file first.
+     *
+     * @return std::vector<std::string> The log lines.
+     */
+    std::vector<std::string> ReadLogLines() const
+    {
+        std::vector<std::string> fileNames;
+
+        DIR* dir = opendir(m_testPath.c_str());
+        REQUIRE(dir != nullptr);
+
+        for (struct dirent* entry = readdir(dir); entry != nullptr; entry = readdir(dir))
+        {
+            if (strstr(entry->d_name, TEST_LOG_FILE_PREFIX) != nullptr)
+            {
+                fileNames.emplace_back(entry->d_name);
+            }
+        }
+        closedir(dir);
+
+        // Log file names are timestamped, so sorting them puts them in the order they were written.
+        std::sort(fileNames.begin(), fileNames.end());
+
+        std::vector<std::string> lines;
+        for (const std::string& fileName : fileNames)
+        {
+            std::ifstream file{ m_testPath + "/" + fileName };
+            std::string line;
+            while (std::getline(file, line))
+            {
+                lines.push_back(line);
+            }
+        }
+
+        return lines;
+    }
+
+private:
+    std::string m_testPath;
+};
+
+/**
+ * @brief Gets the line number of each thread's "thread <t> line <n>" logs, in the order they were written.
+ *
+ * @param lines The log lines.
+ * @return std::map<int, std::vector<int>> The line numbers, keyed by thread.
+ */
+static std::map<int, std::vector<int>> GetLoggedLineNumbers(const std::vector<std::string>& lines)
+{
+    std::map<int, std::vector<int>> lineNumbers;
+
+    for (const std::string& line : lines)
+    {
+        const size_t pos = line.find("] thread ");
+        if (pos == std::string::npos)
+        {
+            continue;
+        }
+
+        int thread = 0;
+        int number = 0;
+        if (sscanf(line.c_str() + pos, "] thread %d line %d", &thread, &number) == 2)
+        {
+            lineNumbers[thread].push_back(number);
+        }
+    }
+
+    return lineNumbers;
+}
+
+static std::vector<int> GetExpectedLineNumbers(int count)
+{
+    std::vector<int> lineNumbers;
+    for (int i = 0; i < count; i++)
+    {
+        lineNumbers.push_back(i);
+    }
+    return lineNumbers;
+}
+
+TEST_CASE_METHOD(TestCaseFixture, "Error logs are in the log file when log_error returns")
+{
+    for (int i = 0; i < 10; i++)
+    {
+        log_info("thread 0 line %d", i);
+    }
+
+    log_error("error marker");
+
+    // No flush or zlog_finish here; the error log must already be written, along with everything before it.
+    const std::vector<std::string> lines = ReadLogLines();
+
+    CHECK(GetLoggedLineNumbers(lines)[0] == GetExpectedLineNumbers(10));
+    CHECK(std::any_of(lines.begin(), lines.end(), [](const std::string& line) {
+        return line.find("[E] error marker") != std::string::npos;
+    }));
+}
+
+TEST_CASE_METHOD(TestCaseFixture, "Logs are written in order across ring wrap-around")
+{
+    const int count = 4 * ZLOG_BUFFER_MAXLINES;
+
+    for (int i = 0; i < count; i++)
+    {
+        log_info("thread 0 line %d", i);
+    }
+
+    zlog_flush_buffer();
+
+    CHECK(GetLoggedLineNumbers(ReadLogLines())[0] == GetExpectedLineNumbers(count));
+}
+
+TEST_CASE_METHOD(TestCaseFixture, "Concurrent logs that fill the ring are all written in per-thread order")
+{
+    const int threadCount = 4;
+    const int countPerThread = 2 * ZLOG_BUFFER_MAXLINES;
+
+    // Together the threads log faster than the log writer thread drains the ring, so they also drain it themselves.
+    std::vector<std::thread> threads;
+    for (int t = 0; t < threadCount; t++)
+    {
+        threads.emplace_back([t]() {
+            for (int i = 0; i < countPerThread; i++)
+            {
+                log_info("thread %d line %d", t, i);
+            }
+        });
+    }
+
+    for (std::thread& thread : threads)
+    {
+        thread.join();
+    }
+
+    zlog_flush_buffer();
+
+    std::map<int, std::vector<int>> lineNumbers = GetLoggedLineNumbers(ReadLogLines());
+
+    CHECK(lineNumbers.size() == threadCount);
+    for (int t = 0; t < threadCount; t++)
+    {
+        INFO("thread " << t);
+        CHECK(lineNumbers[t] == GetExpectedLineNumbers(countPerThread));
+    }
+}
@@ -8,6 +8,7 @@
 
 #include "aduc/rootkey_workflow.h"
 
+#include <aduc/hash_utils.h> // ADUC_HashUtils_GetFileHashUncached
 #include <aduc/logging.h>
 #include <aduc/rootkeypackage_do_download.h>
 #include <aduc/rootkeypackage_download.h>
@@ -17,10 +18,43 @@
 #include <aduc/types/adu_core.h> // ADUC_Result_RootKey_Continue
 #include <azure_c_shared_utility/crt_abstractions.h>
 #include <azure_c_shared_utility/strings.h>
-#include <parson.h>
 #include <root_key_util.h>
 
 #include <stdlib.h>
+#include <string.h> // strcmp
+
+/**
+ * @brief The SHA256 digest of the last root key package that was verified and is known to match the local store.
+ * @details Delivery Optimization has no conditional (ETag/If-Modified-Since) download, so the package is still fetched
+ * for every deployment; but when its bytes are unchanged, the parse/verify/compare chain is skipped. Only accessed by
+ * RootKeyWorkflow_UpdateRootKeys, which is called on the main thread.
+ */
+static char* s_lastVerifiedPackageDigest = NULL;
+
+/**
+ * @brief Gets whether the package with @p packageDigest is the last one verified against the local store.
+ *
+ * @param packageDigest The SHA256 digest of the downloaded root key package.
+ * @return true if the package is unchanged and the local store still exists.
+ */
+static bool IsPackageUnchangedSinceLastVerified(const char* packageDigest)
+{
+    return s_lastVerifiedPackageDigest != NULL && packageDigest != NULL
+        && strcmp(s_lastVerifiedPackageDigest, packageDigest) == 0
+        && ADUC_SystemUtils_Exists(ADUC_ROOTKEY_STORE_PACKAGE_PATH);
+}
+
+/**
+ * @brief Remembers the digest of the package that was verified and now matches the local store.
+ *
+ * @param[in,out] packageDigest The digest. Ownership is transferred and the pointer set to NULL.
+ */
+static void RememberVerifiedPackage(char** packageDigest)
+{
+    free(s_lastVerifiedPackageDigest);
+    s_lastVerifiedPackageDigest = *packageDigest;
+    *packageDigest = NULL;
+}
 
 /**
  * @brief Downloads the root key package and updates local store with it if different from current.
@@ -37,8 +71,7 @@ ADUC_Result RootKeyWorkflow_UpdateRootKeys(const char* workflowId, const char* w
 
     STRING_HANDLE downloadedFilePath = NULL;
     STRING_HANDLE fileDest = NULL;
-    JSON_Value* rootKeyPackageJsonValue = NULL;
-    char* rootKeyPackageJsonString = NULL;
+    char* packageDigest = NULL;
     ADUC_RootKeyPackage rootKeyPackage;
 
     memset(&rootKeyPackage, 0, sizeof(ADUC_RootKeyPackage));
@@ -66,26 +99,29 @@ ADUC_Result RootKeyWorkflow_UpdateRootKeys(const char* workflowId, const char* w
         goto done;
     }
 
-    rootKeyPackageJsonValue = json_parse_file(STRING_c_str(downloadedFilePath));
-
-    if (rootKeyPackageJsonValue == NULL)
+    // Failing to hash the package only means it cannot be matched against the last verified one.
+    // The digest cache keys on file metadata, which a re-download can leave unchanged, so always read the bytes.
+    if (!ADUC_HashUtils_GetFileHashUncached(STRING_c_str(downloadedFilePath), SHA256, &packageDigest))
     {
-        result.ExtendedResultCode = ADUC_ERC_ROOTKEY_PKG_FAIL_JSON_PARSE;
-        goto done;
+        Log_Warn("Fail hash root key package; verifying it in full.");
     }
-
-    rootKeyPackageJsonString = json_serialize_to_string(rootKeyPackageJsonValue);
-
-    if (rootKeyPackageJsonString == NULL)
+    else if (IsPackageUnchangedSinceLastVerified(packageDigest))
     {
-        result.ExtendedResultCode = ADUC_ERC_ROOTKEY_PKG_FAIL_JSON_SERIALIZE;
+        // This is a success, but skips writing to local store and includes informational ERC.
+        result.ResultCode = ADUC_Result_RootKey_Continue;
+        result.ExtendedResultCode = ADUC_ERC_ROOTKEY_PKG_UNCHANGED;
         goto done;
     }
 
-    tmpResult = ADUC_RootKeyPackageUtils_Parse(rootKeyPackageJsonString, &rootKeyPackage);
+    tmpResult = ADUC_RootKeyPackageUtils_ParseFile(STRING_c_str(downloadedFilePath), &rootKeyPackage);
 
     if (IsAducResultCodeFailure(tmpResult.ResultCode))
     {
+        if (tmpResult.ExtendedResultCode == ADUC_ERC_UTILITIES_ROOTKEYPKG_UTIL_ERROR_BAD_JSON)
+        {
+            tmpResult.ExtendedResultCode = ADUC_ERC_ROOTKEY_PKG_FAIL_JSON_PARSE;
+        }
+
         result = tmpResult;
         goto done;
     }
@@ -137,6 +173,7 @@ ADUC_Result RootKeyWorkflow_UpdateRootKeys(const char* workflowId, const char* w
         // This is a success, but skips writing to local store and includes informational ERC.
         result.ResultCode = ADUC_Result_RootKey_Continue;
         result.ExtendedResultCode = ADUC_ERC_ROOTKEY_PKG_UNCHANGED;
+        RememberVerifiedPackage(&packageDigest);
         goto done;
     }
 
@@ -156,6 +193,8 @@ ADUC_Result RootKeyWorkflow_UpdateRootKeys(const char* workflowId, const char* w
         goto done;
     }
 
+    RememberVerifiedPackage(&packageDigest);
+
     result.ResultCode = ADUC_GeneralResult_Success;
     result.ExtendedResultCode = ADUC_ERC_ROOTKEY_PACKAGE_CHANGED;
 
@@ -166,6 +205,10 @@ done:
         if (IsAducResultCodeFailure(result.ResultCode))
         {
             Log_Error("Fail update root keys, ERC 0x%08x", result.ExtendedResultCode);
+
+            // The local store may no longer match the last verified package.
+            free(s_lastVerifiedPackageDigest);
+            s_lastVerifiedPackageDigest = NULL;
         }
         else
         {
@@ -181,8 +224,7 @@ done:
 
     STRING_delete(downloadedFilePath);
     STRING_delete(fileDest);
-    json_value_free(rootKeyPackageJsonValue);
-    free(rootKeyPackageJsonString);
+    free(packageDigest);
 
     ADUC_RootKeyPackageUtils_Destroy(&rootKeyPackage);
     return result;
@@ -0,0 +1,54 @@
+/**
+ * @file arena.h
+ * @brief A bump allocator for objects that share a lifetime and are released together.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#ifndef ADUC_ARENA_H
+#define ADUC_ARENA_H
+
+#include <aduc/c_utils.h>
+
+#include <stddef.h> // for size_t
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief Default size of the blocks the arena carves allocations from.
+ */
+#define ADUC_ARENA_DEFAULT_BLOCK_SIZE 4096
+
+typedef struct tagADUC_ArenaBlock ADUC_ArenaBlock;
+
+/**
+ * @brief An arena. Allocations are released all at once by ADUC_Arena_Free(), or back to a mark by ADUC_Arena_Rewind().
+ */
+typedef struct tagADUC_Arena ADUC_Arena;
+
+/**
+ * @brief A position in an arena, see ADUC_Arena_GetMark().
+ */
+typedef struct tagADUC_ArenaMark
+{
+    ADUC_ArenaBlock* Block; /**< The current block when the mark was taken. */
+    size_t Used; /**< The bytes used in Block when the mark was taken. */
+} ADUC_ArenaMark;
+
+ADUC_Arena* ADUC_Arena_Create(size_t blockSize);
+
+void ADUC_Arena_Free(ADUC_Arena* arena);
+
+void* ADUC_Arena_Alloc(ADUC_Arena* arena, size_t size);
+
+void* ADUC_Arena_AllocArray(ADUC_Arena* arena, size_t count, size_t size);
+
+char* ADUC_Arena_StrDup(ADUC_Arena* arena, const char* str);
+
+ADUC_ArenaMark ADUC_Arena_GetMark(const ADUC_Arena* arena);
+
+void ADUC_Arena_Rewind(ADUC_Arena* arena, ADUC_ArenaMark mark);
+
+EXTERN_C_END
+
+#endif // ADUC_ARENA_H
@@ -0,0 +1,211 @@
+/**
+ * @file arena.c
+ * @brief Implements a bump allocator for objects that share a lifetime and are released together.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "aduc/arena.h"
+
+#include <stdint.h> // for SIZE_MAX
+#include <stdlib.h> // for malloc, free
+#include <string.h> // for memset, memcpy, strlen
+
+// keep this last to avoid interfering with system headers
+#include "aduc/aduc_banned.h"
+
+// Alignment of every allocation, enough for any of the scalar and pointer types the agent stores.
+#define ARENA_ALIGNMENT (2 * sizeof(void*))
+
+#define ARENA_ALIGN_UP(n) (((n) + (ARENA_ALIGNMENT - 1)) & ~(ARENA_ALIGNMENT - 1))
+
+/**
+ * @brief A chunk of memory that allocations are carved from. The data follows the header.
+ */
+struct tagADUC_ArenaBlock
+{
+    ADUC_ArenaBlock* Previous; /**< The block that was current before this one. */
+    size_t Size; /**< The size of the data. */
+    size_t Used; /**< The bytes of the data handed out. */
+};
+
+struct tagADUC_Arena
+{
+    ADUC_ArenaBlock* Current; /**< The block allocations are carved from. NULL until the first allocation. */
+    size_t BlockSize; /**< The default size of a block's data. */
+};
+
+// Blocks are allocated with their header, rounded up so the data is aligned.
+#define ARENA_BLOCK_HEADER_SIZE ARENA_ALIGN_UP(sizeof(ADUC_ArenaBlock))
+
+static unsigned char* ArenaBlockData(ADUC_ArenaBlock* block)
+{
+    return (unsigned char*)block + ARENA_BLOCK_HEADER_SIZE;
+}
+
+/**
+ * @brief Creates an arena.
+ *
+ * @param blockSize The size of the blocks to carve allocations from, or 0 for ADUC_ARENA_DEFAULT_BLOCK_SIZE.
+ * Larger allocations get a block of their own.
+ * @return ADUC_Arena* The arena, or NULL on allocation failure. Caller must call ADUC_Arena_Free().
+ */
+ADUC_Arena* ADUC_Arena_Create(size_t blockSize)
+{
+    ADUC_Arena* arena = malloc(sizeof(*arena));
+    if (arena == NULL)
+    {
+        return NULL;
+    }
+
+    arena->Current = NULL;
+    arena->BlockSize = blockSize == 0 ? ADUC_ARENA_DEFAULT_BLOCK_SIZE : ARENA_ALIGN_UP(blockSize);
+
+    return arena;
+}
+
+/**
+ * @brief Frees the arena and every allocation made from it.
+ *
+ * @param arena The arena. May be NULL.
+ */
+void ADUC_Arena_Free(ADUC_Arena* arena)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    ADUC_ArenaMark start = { NULL, 0 };
+    ADUC_Arena_Rewind(arena, start);
+
+    free(arena);
+}
+
+/**
+ * @brief Allocates zero-initialized memory from the arena.
+ * The memory stays valid until the arena is freed or rewound to a mark taken before this call.
+ *
+ * @param arena The arena.
+ * @param size The size in bytes.
+ * @return void* The aligned memory, or NULL on failure. Must not be passed to free().
+ */
+void* ADUC_Arena_Alloc(ADUC_Arena* arena, size_t size)
+{
+    if (arena == NULL || size > SIZE_MAX - ARENA_BLOCK_HEADER_SIZE - ARENA_ALIGNMENT)
+    {
+        return NULL;
+    }
+
+    size = ARENA_ALIGN_UP(size == 0 ? 1 : size);
+
+    ADUC_ArenaBlock* block = arena->Current;
+    if (block == NULL || block->Size - block->Used < size)
+    {
+        size_t dataSize = size > arena->BlockSize ? size : arena->BlockSize;
+
+        block = malloc(ARENA_BLOCK_HEADER_SIZE + dataSize);
+        if (block == NULL)
+        {
+            return NULL;
+        }
+
+        block->Previous = arena->Current;
+        block->Size = dataSize;
+        block->Used = 0;
+        arena->Current = block;
+    }
+
+    void* memory = ArenaBlockData(block) + block->Used;
+    block->Used += size;
+
+    memset(memory, 0, size);
+    return memory;
+}
+
+/**
+ * @brief Allocates a zero-initialized array from the arena.
+ *
+ * @param arena The arena.
+ * @param count The count of elements.
+ * @param size The size in bytes of an element.
+ * @return void* The aligned memory, or NULL on failure or overflow. Must not be passed to free().
+ */
+void* ADUC_Arena_AllocArray(ADUC_Arena* arena, size_t count, size_t size)
+{
+    if (size != 0 && count > SIZE_MAX / size)
+    {
+        return NULL;
+    }
+
+    return ADUC_Arena_Alloc(arena, count * size);
+}
+
+/**
+ * @brief Copies a string into the arena.
+ *
+ * @param arena The arena.
+ * @param str The string to copy.
+ * @return char* The copy, or NULL if @p str is NULL or on failure. Must not be passed to free().
+ */
+char* ADUC_Arena_StrDup(ADUC_Arena* arena, const char* str)
+{
+    if (str == NULL)
+    {
+        return NULL;
+    }
+
+    size_t size = strlen(str) + 1;
+    char* copy = ADUC_Arena_Alloc(arena, size);
+    if (copy != NULL)
+    {
+        memcpy(copy, str, size);
+    }
+
+    return copy;
+}
+
+/**
+ * @brief Gets the current position of the arena, to release later allocations with ADUC_Arena_Rewind().
+ *
+ * @param arena The arena.
+ * @return ADUC_ArenaMark The mark.
+ */
+ADUC_ArenaMark ADUC_Arena_GetMark(const ADUC_Arena* arena)
+{
+    ADUC_ArenaMark mark = { NULL, 0 };
+
+    if (arena != NULL && arena->Current != NULL)
+    {
+        mark.Block = arena->Current;
+        mark.Used = arena->Current->Used;
+    }
+
+    return mark;
+}
+
+/**
+ * @brief Releases every allocation made after @p mark was taken. Blocks allocated since are freed.
+ *
+ * @param arena The arena.
+ * @param mark A mark of this arena, that must not predate a rewind to an earlier mark.
+ */
+void ADUC_Arena_Rewind(ADUC_Arena* arena, ADUC_ArenaMark mark)
+{
+    if (arena == NULL)
+    {
+        return;
+    }
+
+    while (arena->Current != NULL && arena->Current != mark.Block)
+    {
+        ADUC_ArenaBlock* previous = arena->Current->Previous;
+        free(arena->Current);
+        arena->Current = previous;
+    }
+
+    if (arena->Current != NULL)
+    {
+        arena->Current->Used = mark.Used;
+    }
+}
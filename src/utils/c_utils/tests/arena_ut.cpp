@@ -0,0 +1,108 @@
+/**
+ * @file arena_ut.cpp
+ * @brief Unit Tests for the arena allocator
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <catch2/catch.hpp>
+using Catch::Matchers::Equals;
+
+#include "aduc/arena.h"
+
+#include <cstdint>
+#include <cstring>
+
+TEST_CASE("ADUC_Arena_Alloc")
+{
+    ADUC_Arena* arena = ADUC_Arena_Create(64);
+    REQUIRE(arena != nullptr);
+
+    SECTION("Allocations are zeroed, aligned and distinct")
+    {
+        auto* a = static_cast<unsigned char*>(ADUC_Arena_Alloc(arena, 3));
+        auto* b = static_cast<unsigned char*>(ADUC_Arena_Alloc(arena, 8));
+        REQUIRE(a != nullptr);
+        REQUIRE(b != nullptr);
+        CHECK(a != b);
+        CHECK(reinterpret_cast<uintptr_t>(a) % sizeof(void*) == 0);
+        CHECK(reinterpret_cast<uintptr_t>(b) % sizeof(void*) == 0);
+        CHECK(a[0] == 0);
+        CHECK(b[7] == 0);
+    }
+
+    SECTION("Allocation larger than a block")
+    {
+        auto* big = static_cast<unsigned char*>(ADUC_Arena_Alloc(arena, 1000));
+        REQUIRE(big != nullptr);
+        memset(big, 0xAB, 1000);
+
+        auto* small = static_cast<unsigned char*>(ADUC_Arena_Alloc(arena, 16));
+        REQUIRE(small != nullptr);
+        CHECK(small[0] == 0);
+        CHECK(big[999] == 0xAB);
+    }
+
+    SECTION("Array overflow")
+    {
+        CHECK(ADUC_Arena_AllocArray(arena, SIZE_MAX / 2, 4) == nullptr);
+    }
+
+    ADUC_Arena_Free(arena);
+}
+
+TEST_CASE("ADUC_Arena_StrDup")
+{
+    ADUC_Arena* arena = ADUC_Arena_Create(0);
+    REQUIRE(arena != nullptr);
+
+    const char* source = "contoso-motor-installscript.sh";
+    char* copy = ADUC_Arena_StrDup(arena, source);
+    REQUIRE(copy != nullptr);
+    CHECK(copy != source);
+    CHECK_THAT(copy, Equals(source));
+
+    CHECK(ADUC_Arena_StrDup(arena, nullptr) == nullptr);
+
+    ADUC_Arena_Free(arena);
+}
+
+TEST_CASE("ADUC_Arena_Rewind")
+{
+    ADUC_Arena* arena = ADUC_Arena_Create(64);
+    REQUIRE(arena != nullptr);
+
+    SECTION("Rewind within a block reuses the memory")
+    {
+        REQUIRE(ADUC_Arena_Alloc(arena, 8) != nullptr);
+
+        ADUC_ArenaMark mark = ADUC_Arena_GetMark(arena);
+        void* first = ADUC_Arena_Alloc(arena, 8);
+        memset(first, 0xFF, 8);
+
+        ADUC_Arena_Rewind(arena, mark);
+
+        auto* second = static_cast<unsigned char*>(ADUC_Arena_Alloc(arena, 8));
+        CHECK(second == first);
+        CHECK(second[0] == 0);
+    }
+
+    SECTION("Rewind across blocks")
+    {
+        ADUC_ArenaMark mark = ADUC_Arena_GetMark(arena);
+        for (int i = 0; i < 10; ++i)
+        {
+            REQUIRE(ADUC_Arena_Alloc(arena, 48) != nullptr);
+        }
+
+        ADUC_Arena_Rewind(arena, mark);
+
+        ADUC_ArenaMark empty = ADUC_Arena_GetMark(arena);
+        CHECK(empty.Block == nullptr);
+        CHECK(empty.Used == 0);
+
+        REQUIRE(ADUC_Arena_Alloc(arena, 48) != nullptr);
+    }
+
+    ADUC_Arena_Free(arena);
+}
@@ -80,6 +80,16 @@ typedef struct tagADUC_ConfigInfo
     unsigned int
         downloadTimeoutInMinutes; /**< The timeout for downloading an update payload. A value of zero means to use the default. */
 
+    unsigned int
+        maxConcurrentDownloads; /**< The maximum number of payload files downloaded at the same time, up to 16, if the content downloader supports concurrent calls. A value of zero means to use the default of 4. */
+
+    bool pipelineStepDownloads; /**< Whether the steps handler downloads the next step's payloads while the current step installs. */
+
+    unsigned int
+        maxConcurrentComponents; /**< The maximum number of selected components the steps handler processes at the same time. A value of zero means one at a time. */
+
+    bool reportDeploymentTimings; /**< Whether to report per-phase deployment timings in the agent's reported property. */
+
     const char* aduShellFolder; /**< The folder where ADU shell is installed. */
 
     char* aduShellFilePath; /**< The full path to ADU shell binary. */
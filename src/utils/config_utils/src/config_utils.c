@@ -51,6 +51,10 @@ static const char* CONFIG_MANUFACTURER = "manufacturer";
 static const char* CONFIG_MODEL = "model";
 static const char* CONFIG_SCHEMA_VERSION = "schemaVersion";
 static const char* CONFIG_DOWNLOAD_TIMEOUT_IN_MINUTES = "downloadTimeoutInMinutes";
+static const char* CONFIG_MAX_CONCURRENT_DOWNLOADS = "maxConcurrentDownloads";
+static const char* CONFIG_PIPELINE_STEP_DOWNLOADS = "pipelineStepDownloads";
+static const char* CONFIG_MAX_CONCURRENT_COMPONENTS = "maxConcurrentComponents";
+static const char* CONFIG_REPORT_DEPLOYMENT_TIMINGS = "reportDeploymentTimings";
 
 static const char* CONFIG_NAME = "name";
 static const char* CONFIG_RUN_AS = "runas";
@@ -413,6 +417,17 @@ bool ADUC_ConfigInfo_Init(ADUC_ConfigInfo* config, const char* configFolder)
     ADUC_JSON_GetUnsignedIntegerField(
         config->rootJsonValue, CONFIG_DOWNLOAD_TIMEOUT_IN_MINUTES, &(config->downloadTimeoutInMinutes));
 
+    // Note: max concurrent downloads is optional.
+    ADUC_JSON_GetUnsignedIntegerField(
+        config->rootJsonValue, CONFIG_MAX_CONCURRENT_DOWNLOADS, &(config->maxConcurrentDownloads));
+
+    // Note: max concurrent components is optional.
+    ADUC_JSON_GetUnsignedIntegerField(
+        config->rootJsonValue, CONFIG_MAX_CONCURRENT_COMPONENTS, &(config->maxConcurrentComponents));
+
+    config->pipelineStepDownloads = json_object_get_boolean(root_object, CONFIG_PIPELINE_STEP_DOWNLOADS) == 1;
+    config->reportDeploymentTimings = json_object_get_boolean(root_object, CONFIG_REPORT_DEPLOYMENT_TIMINGS) == 1;
+
     // Ensure that adu-shell folder is valid.
     config->aduShellFolder = ADUC_JSON_GetStringFieldPtr(config->rootJsonValue, CONFIG_ADU_SHELL_FOLDER);
 
@@ -281,6 +281,10 @@ static const char* validConfigContentDownloadTimeout =
         R"("manufacturer": "device_info_manufacturer",)"
         R"("model": "device_info_model",)"
         R"("downloadTimeoutInMinutes": 1440,)"
+        R"("maxConcurrentDownloads": 6,)"
+        R"("pipelineStepDownloads": true,)"
+        R"("maxConcurrentComponents": 8,)"
+        R"("reportDeploymentTimings": true,)"
         R"("compatPropertyNames": "manufacturer,model",)"
         R"("agents": [)"
             R"({ )"
@@ -519,6 +523,10 @@ TEST_CASE_METHOD(GlobalMockHookTestCaseFixture, "ADUC_ConfigInfo_Init Functional
 
         CHECK(ADUC_ConfigInfo_Init(&config, "/etc/adu"));
         CHECK(config.downloadTimeoutInMinutes == 1440);
+        CHECK(config.maxConcurrentDownloads == 6);
+        CHECK(config.pipelineStepDownloads);
+        CHECK(config.maxConcurrentComponents == 8);
+        CHECK(config.reportDeploymentTimings);
 
         ADUC_ConfigInfo_UnInit(&config);
     }
@@ -532,6 +540,10 @@ TEST_CASE_METHOD(GlobalMockHookTestCaseFixture, "ADUC_ConfigInfo_Init Functional
 
         CHECK(ADUC_ConfigInfo_Init(&config, "/etc/adu"));
         CHECK(config.downloadTimeoutInMinutes == 0);
+        CHECK(config.maxConcurrentDownloads == 0);
+        CHECK_FALSE(config.pipelineStepDownloads);
+        CHECK(config.maxConcurrentComponents == 0);
+        CHECK_FALSE(config.reportDeploymentTimings);
         ADUC_ConfigInfo_UnInit(&config);
     }
 
@@ -27,6 +27,24 @@ EXTERN_C_BEGIN
 // Signature Verification
 //
 
+/**
+ * @brief A reusable signature verification context. See CryptoUtils_CreateVerifyContext().
+ */
+typedef struct tagCryptoUtils_VerifyContext* CryptoVerifyContextHandle;
+
+CryptoVerifyContextHandle CryptoUtils_CreateVerifyContext(void);
+
+void CryptoUtils_FreeVerifyContext(CryptoVerifyContextHandle context);
+
+bool CryptoUtils_IsValidSignatureWithContext(
+    CryptoVerifyContextHandle context,
+    const char* alg,
+    const uint8_t* expectedSignature,
+    size_t sigLength,
+    const uint8_t* blob,
+    size_t blobLength,
+    CryptoKeyHandle keyToSign);
+
 bool CryptoUtils_IsValidSignature(
     const char* alg,
     const uint8_t* expectedSignature,
@@ -35,6 +53,16 @@ bool CryptoUtils_IsValidSignature(
     size_t blobLength,
     CryptoKeyHandle keyToSign);
 
+bool CryptoUtils_IsValidSignatureWithLongLivedKey(
+    const char* alg,
+    const uint8_t* expectedSignature,
+    size_t sigLength,
+    const uint8_t* blob,
+    size_t blobLength,
+    CryptoKeyHandle keyToSign);
+
+void CryptoUtils_UninitSharedVerifyContext(void);
+
 //
 // Key Helper Functions
 //
@@ -51,6 +79,8 @@ CryptoKeyHandle GetRootKeyForKeyID(const char* kid);
 
 void CryptoUtils_FreeCryptoKeyHandle(CryptoKeyHandle key);
 
+CryptoKeyHandle CryptoUtils_DuplicateCryptoKeyHandle(CryptoKeyHandle key);
+
 CONSTBUFFER_HANDLE CryptoUtils_CreateSha256Hash(const CONSTBUFFER_HANDLE buf);
 
 CONSTBUFFER_HANDLE CryptoUtils_GenerateRsaPublicKey(const char* modulus_b64url, const char* exponent_b64url);
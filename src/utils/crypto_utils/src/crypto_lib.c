@@ -19,7 +19,9 @@
 #endif
 
 #include <openssl/rsa.h>
+#include <pthread.h>
 #include <stdio.h>
+#include <stdlib.h> // for calloc, free
 #include <string.h>
 
 #include <aducpal/strings.h> // strcasecmp
@@ -83,6 +85,42 @@ Algorithm_Id AlgorithmIdFromString(const char* alg)
     return algorithmId;
 }
 
+/**
+ * @brief Initializes @p mdctx for verifying RS256 signatures with @p key.
+ * @details This RS256 implementation uses the RSA_PKCS1_PADDING type.
+ *
+ * @param mdctx the digest context to initialize
+ * @param key the public key for the RS256 validation
+ * @returns true on success, false otherwise
+ */
+static bool InitRS256VerifyContext(EVP_MD_CTX* mdctx, EVP_PKEY* key)
+{
+    // Owned by mdctx.
+    EVP_PKEY_CTX* ctx = NULL;
+
+    if (EVP_DigestVerifyInit(mdctx, &ctx, EVP_sha256(), NULL, key) != 1)
+    {
+        return false;
+    }
+
+    return EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) > 0;
+}
+
+/**
+ * @brief Verifies @p signature over @p blob using @p mdctx, which must have been initialized for verification.
+ * @details @p mdctx cannot be used for another verification afterwards.
+ */
+static bool DigestVerify(
+    EVP_MD_CTX* mdctx, const uint8_t* signature, size_t sigLength, const uint8_t* blob, size_t blobLength)
+{
+#if OPENSSL_VERSION_NUMBER >= 0x10101000L
+    return EVP_DigestVerify(mdctx, signature, sigLength, blob, blobLength) == 1;
+#else
+    return EVP_DigestVerifyUpdate(mdctx, blob, blobLength) == 1
+        && EVP_DigestVerifyFinal(mdctx, signature, sigLength) == 1;
+#endif
+}
+
 /**
  * @brief Verifies the @p signature using RS256 on the @p blob and the @p key.
  * @details This RS256 implementation uses the RSA_PKCS1_PADDING type.
@@ -102,81 +140,253 @@ bool VerifyRS256Signature(
     CryptoKeyHandle keyToSign)
 {
     bool success = false;
-    EVP_MD_CTX* mdctx = NULL;
-    EVP_PKEY_CTX* ctx = NULL;
+    EVP_MD_CTX* mdctx = EVP_MD_CTX_new();
 
-    uint8_t digest[32];
-    const size_t digest_len = ARRAY_SIZE(digest);
-
-    if ((mdctx = EVP_MD_CTX_new()) == NULL)
+    if (mdctx == NULL)
     {
         goto done;
     }
 
-    const EVP_MD* hash_alg = EVP_sha256();
-    if (EVP_DigestInit_ex(mdctx, hash_alg, NULL) != 1)
+    if (!InitRS256VerifyContext(mdctx, CryptoKeyHandleToEVP_PKEY(keyToSign)))
     {
         goto done;
     }
 
-    if (EVP_DigestUpdate(mdctx, blob, blobLength) != 1)
+    success = DigestVerify(mdctx, signature, sigLength, blob, blobLength);
+
+done:
+
+    EVP_MD_CTX_free(mdctx);
+
+    return success;
+}
+
+//
+// Signature Verification Contexts
+//
+// Setting up verification for a key (provider lookup, key checks, padding and digest parameters) costs more than the
+// verification itself for the small blobs verified here. A context keeps a verification-ready digest context for each
+// of the last keys used, and copies it for each verification.
+//
+
+/**
+ * @brief The maximum number of keys with a cached digest context. The least recently used key is evicted first.
+ */
+#define CRYPTO_VERIFY_CONTEXT_MAX_KEYS 8
+
+typedef struct tagCryptoUtils_VerifyContextEntry
+{
+    EVP_PKEY* key; //!< The key, which the entry holds a reference to so it cannot be confused with a later key.
+    EVP_MD_CTX* initializedCtx; //!< A digest context initialized for RS256 verification with key.
+    uint64_t lastUsed; //!< The value of the context's use counter when the entry was last used.
+} CryptoUtils_VerifyContextEntry;
+
+struct tagCryptoUtils_VerifyContext
+{
+    pthread_mutex_t mutex; //!< Guards all other members.
+    CryptoUtils_VerifyContextEntry entries[CRYPTO_VERIFY_CONTEXT_MAX_KEYS];
+    EVP_MD_CTX* workCtx; //!< The digest context each verification is done in.
+    uint64_t useCounter;
+};
+
+static pthread_mutex_t s_sharedVerifyContextMutex = PTHREAD_MUTEX_INITIALIZER;
+static CryptoVerifyContextHandle s_sharedVerifyContext = NULL;
+
+static void VerifyContextEntry_Clear(CryptoUtils_VerifyContextEntry* entry)
+{
+    EVP_MD_CTX_free(entry->initializedCtx);
+    EVP_PKEY_free(entry->key);
+    memset(entry, 0, sizeof(*entry));
+}
+
+/**
+ * @brief Gets the digest context initialized for @p key, creating it if needed. Caller holds the context's mutex.
+ * @returns the initialized digest context, or NULL on failure
+ */
+static EVP_MD_CTX* VerifyContext_GetInitializedCtx(CryptoVerifyContextHandle context, EVP_PKEY* key)
+{
+    CryptoUtils_VerifyContextEntry* entry = NULL;
+    EVP_MD_CTX* initializedCtx = NULL;
+
+    for (size_t i = 0; i < CRYPTO_VERIFY_CONTEXT_MAX_KEYS; ++i)
+    {
+        if (context->entries[i].key == key)
+        {
+            entry = &context->entries[i];
+            goto done;
+        }
+    }
+
+    initializedCtx = EVP_MD_CTX_new();
+
+    if (initializedCtx == NULL || !InitRS256VerifyContext(initializedCtx, key) || EVP_PKEY_up_ref(key) != 1)
     {
-        goto done;
+        EVP_MD_CTX_free(initializedCtx);
+        return NULL;
     }
 
-    unsigned int digest_len_temp = (unsigned int)digest_len;
-    if (EVP_DigestFinal_ex(mdctx, digest, &digest_len_temp) != 1)
+    // Use an empty entry, or evict the least recently used one.
+    entry = &context->entries[0];
+    for (size_t i = 0; i < CRYPTO_VERIFY_CONTEXT_MAX_KEYS && entry->key != NULL; ++i)
     {
-        goto done;
+        if (context->entries[i].key == NULL || context->entries[i].lastUsed < entry->lastUsed)
+        {
+            entry = &context->entries[i];
+        }
     }
 
-    EVP_PKEY* pu_key = CryptoKeyHandleToEVP_PKEY(keyToSign);
-    ctx = EVP_PKEY_CTX_new(pu_key, NULL);
+    VerifyContextEntry_Clear(entry);
+    entry->key = key;
+    entry->initializedCtx = initializedCtx;
 
-    if (ctx == NULL)
+done:
+
+    entry->lastUsed = ++context->useCounter;
+    return entry->initializedCtx;
+}
+
+/**
+ * @brief Verifies the @p signature using RS256 on the @p blob and the @p key, reusing the set up for @p key cached in
+ * @p context.
+ * @returns True if @p signature equals the one computer from the blob and key using RS256, False otherwise
+ */
+static bool VerifyRS256SignatureWithContext(
+    CryptoVerifyContextHandle context,
+    const uint8_t* signature,
+    size_t sigLength,
+    const uint8_t* blob,
+    size_t blobLength,
+    CryptoKeyHandle keyToSign)
+{
+    bool success = false;
+    EVP_PKEY* key = CryptoKeyHandleToEVP_PKEY(keyToSign);
+
+    if (key == NULL)
     {
-        goto done;
+        return false;
     }
 
-    if (EVP_PKEY_verify_init(ctx) <= 0)
+    pthread_mutex_lock(&context->mutex);
+
+    EVP_MD_CTX* initializedCtx = VerifyContext_GetInitializedCtx(context, key);
+
+    if (initializedCtx == NULL)
     {
         goto done;
     }
 
-    if (EVP_PKEY_CTX_set_rsa_padding(ctx, RSA_PKCS1_PADDING) <= 0)
+    if (EVP_MD_CTX_copy_ex(context->workCtx, initializedCtx) != 1)
     {
         goto done;
     }
 
-    if (EVP_PKEY_CTX_set_signature_md(ctx, hash_alg) <= 0)
+    success = DigestVerify(context->workCtx, signature, sigLength, blob, blobLength);
+
+done:
+
+    pthread_mutex_unlock(&context->mutex);
+
+    return success;
+}
+
+/**
+ * @brief Creates a signature verification context, which caches the per-key verification set up across calls to
+ * CryptoUtils_IsValidSignatureWithContext().
+ * @details The context holds a reference to each of the last few keys used with it. It may be used from multiple
+ * threads.
+ * @returns the context, or NULL on failure. Caller must free it with CryptoUtils_FreeVerifyContext().
+ */
+CryptoVerifyContextHandle CryptoUtils_CreateVerifyContext(void)
+{
+    CryptoVerifyContextHandle context = (CryptoVerifyContextHandle)calloc(1, sizeof(*context));
+
+    if (context == NULL)
     {
-        goto done;
+        return NULL;
     }
 
-    if (EVP_PKEY_verify(ctx, signature, sigLength, digest, digest_len) == 1)
+    context->workCtx = EVP_MD_CTX_new();
+
+    if (context->workCtx == NULL || pthread_mutex_init(&context->mutex, NULL) != 0)
     {
-        success = true;
+        EVP_MD_CTX_free(context->workCtx);
+        free(context);
+        return NULL;
     }
 
-done:
+    return context;
+}
 
-    if (mdctx != NULL)
+/**
+ * @brief Frees the verification context, and releases the keys it holds.
+ * @param context the context to free. May be NULL.
+ */
+void CryptoUtils_FreeVerifyContext(CryptoVerifyContextHandle context)
+{
+    if (context == NULL)
     {
-        EVP_MD_CTX_free(mdctx);
+        return;
     }
 
-    if (ctx != NULL)
+    for (size_t i = 0; i < CRYPTO_VERIFY_CONTEXT_MAX_KEYS; ++i)
     {
-        EVP_PKEY_CTX_free(ctx);
+        VerifyContextEntry_Clear(&context->entries[i]);
     }
 
-    return success;
+    EVP_MD_CTX_free(context->workCtx);
+    pthread_mutex_destroy(&context->mutex);
+    free(context);
 }
 
 //
 // Signature Verification
 //
 
+/**
+ * @brief Checks if the provided signature is valid using the associated algorithm and provided key, reusing the
+ * verification set up for @p keyToSign cached in @p context.
+ * @details the alg provided must be one of the currently supported ones.
+ * @param context the verification context created with CryptoUtils_CreateVerifyContext()
+ * @param alg the algorithm to use for signature verification
+ * @param expectedSignature the expected signature to validate
+ * @param sigLength the size of buffer @p expectedSignature
+ * @param blob buffer that contains the data for computing a signature to be checked against @p expectedSignature
+ * @param blobLength the size of buffer @p blob
+ * @param keyToSign key that should be used for generating the computed signature
+ * @returns true if the signature is valid, false if it is invalid
+ */
+bool CryptoUtils_IsValidSignatureWithContext(
+    CryptoVerifyContextHandle context,
+    const char* alg,
+    const uint8_t* expectedSignature,
+    size_t sigLength,
+    const uint8_t* blob,
+    size_t blobLength,
+    CryptoKeyHandle keyToSign)
+{
+    if (context == NULL || alg == NULL || expectedSignature == NULL || sigLength == 0 || blob == NULL
+        || blobLength == 0)
+    {
+        return false;
+    }
+    bool result = false;
+
+    Algorithm_Id algId = AlgorithmIdFromString(alg);
+
+    switch (algId)
+    {
+    case Alg_RSA256:
+        result = VerifyRS256SignatureWithContext(context, expectedSignature, sigLength, blob, blobLength, keyToSign);
+        break;
+
+    default:
+    case Alg_NotSupported:
+        result = false;
+    }
+
+    return result;
+}
+
 /**
  * @brief Checks if the provided signature is valid using the associated algorithm and provided key.
  * @details the alg provided must be one of the currently supported ones.
@@ -199,6 +409,7 @@ bool CryptoUtils_IsValidSignature(
     {
         return false;
     }
+
     bool result = false;
 
     Algorithm_Id algId = AlgorithmIdFromString(alg);
@@ -217,6 +428,68 @@ bool CryptoUtils_IsValidSignature(
     return result;
 }
 
+/**
+ * @brief Checks if the provided signature is valid using the associated algorithm and provided key, reusing the
+ * verification set up for @p keyToSign from earlier calls with the same key.
+ * @details Only for keys the caller keeps for a long time, e.g. root keys. The set up is cached in a context shared
+ * within the module, which holds a reference to each of the last few keys, so short-lived keys such as signing keys
+ * would only evict the long-lived ones. Use CryptoUtils_IsValidSignature() for those.
+ * @param alg the algorithm to use for signature verification
+ * @param expectedSignature the expected signature to validate
+ * @param sigLength the size of buffer @p expectedSignature
+ * @param blob buffer that contains the data for computing a signature to be checked against @p expectedSignature
+ * @param blobLength the size of buffer @p blob
+ * @param keyToSign the long-lived key that should be used for generating the computed signature
+ * @returns true if the signature is valid, false if it is invalid
+ */
+bool CryptoUtils_IsValidSignatureWithLongLivedKey(
+    const char* alg,
+    const uint8_t* expectedSignature,
+    size_t sigLength,
+    const uint8_t* blob,
+    size_t blobLength,
+    CryptoKeyHandle keyToSign)
+{
+    bool result = false;
+
+    // Held for the whole verification, so that CryptoUtils_UninitSharedVerifyContext() cannot free the context in use.
+    // Verifications with the context are serialized by the context anyway.
+    pthread_mutex_lock(&s_sharedVerifyContextMutex);
+
+    if (s_sharedVerifyContext == NULL)
+    {
+        s_sharedVerifyContext = CryptoUtils_CreateVerifyContext();
+    }
+
+    if (s_sharedVerifyContext != NULL)
+    {
+        result = CryptoUtils_IsValidSignatureWithContext(
+            s_sharedVerifyContext, alg, expectedSignature, sigLength, blob, blobLength, keyToSign);
+    }
+    else
+    {
+        result = CryptoUtils_IsValidSignature(alg, expectedSignature, sigLength, blob, blobLength, keyToSign);
+    }
+
+    pthread_mutex_unlock(&s_sharedVerifyContextMutex);
+
+    return result;
+}
+
+/**
+ * @brief Frees the verification context shared by CryptoUtils_IsValidSignatureWithLongLivedKey(), and releases the
+ * keys it holds. Called at shutdown; a later call to CryptoUtils_IsValidSignatureWithLongLivedKey() creates a new one.
+ */
+void CryptoUtils_UninitSharedVerifyContext(void)
+{
+    pthread_mutex_lock(&s_sharedVerifyContextMutex);
+
+    CryptoUtils_FreeVerifyContext(s_sharedVerifyContext);
+    s_sharedVerifyContext = NULL;
+
+    pthread_mutex_unlock(&s_sharedVerifyContextMutex);
+}
+
 CryptoKeyHandle RSAKey_ObjFromModulusBytesExponentInt(const uint8_t* N, size_t N_len, const unsigned int e)
 {
 #if OPENSSL_VERSION_NUMBER >= 0x30000000L
@@ -843,6 +1116,24 @@ void CryptoUtils_FreeCryptoKeyHandle(CryptoKeyHandle key)
     EVP_PKEY_free(CryptoKeyHandleToEVP_PKEY(key));
 }
 
+/**
+ * @brief Takes another reference to @p key, so a cached key can be handed out to a caller that frees it.
+ * @details The returned key must be freed with CryptoUtils_FreeCryptoKeyHandle()
+ * @param key the key to duplicate
+ * @return the same key with its reference count incremented; NULL on failure
+ */
+CryptoKeyHandle CryptoUtils_DuplicateCryptoKeyHandle(CryptoKeyHandle key)
+{
+    EVP_PKEY* pkey = CryptoKeyHandleToEVP_PKEY(key);
+
+    if (pkey == NULL || EVP_PKEY_up_ref(pkey) != 1)
+    {
+        return NULL;
+    }
+
+    return key;
+}
+
 /**
  * @brief Computes a SHA256 hash from bytes.
  *
@@ -121,6 +121,132 @@ TEST_CASE("Signature Verification")
             key));
     }
 
+    SECTION("Validating Signatures with a Reused Verify Context")
+    {
+        std::string signature{ "iSTgAEBXsd7AANkQMkaG-FAV6QOGUEuxuHg2YfSuWhtY"
+                               "XqbpM-jI5RVLKesSLCehK-lRC9x6-_LeyxNh1DOFc-Fa6oCEGwUj8ziOF_AT6s"
+                               "6EOmckqPrxuvCWtyYkkDRF74dtaK1jNA7SdXrZzvWCsMqOUMNz0gCoVR0Cs125"
+                               "4kFMRmRPVfEcjgT7j4lCpyDuWgr9SenSeqgKLYxjaaG0sRh9cdi2dKrwgaNaqA"
+                               "bHmCrrhxSPCTBzWMExZrLYzudEofyYHiVVRhSJpj0OQ18ecu4DPXV1Tct1y3k7"
+                               "LLio7n8izKuq2m3TxF9vPdqb9NP6Sc9-myaptpbFpHeFkUL-F5ytl_UBFKpwN9"
+                               "CL4wp6yZ-jdXNagrmU_qL1CyXw1omNCgTmJF3Gd3lyqKHHDerDs-MRpmKjwSwp"
+                               "ZCQJGDRcRovWyL12vjw3LBJMhmUxsEdBaZP5wGdsfD8ldKYFVFEcZ0orMNrUkS"
+                               "MAl6pIxtefEXiy5lqmiPzq_LJ1eRIrqY0_" };
+
+        std::string blob{ "eyJhbGciOiJSUzI1NiIsImtpZCI6IkFEVS4yMDA3MDIuUiJ9.eyJrdHkiOiJSU"
+                          "0EiLCJuIjoickhWQkVGS1IxdnNoZytBaElnL1NEUU8zeDRrajNDVVQ3ZkduSmh"
+                          "BbXVEaHZIZmozZ0h6aTBUMklBcUMxeDJCQ1dkT281djh0dW1xUmovbllwZzk3a"
+                          "mpQQ0t1Y2RPNm0zN2RjT21hNDZoN08wa0hwd0wzblVIR0VySjVEQS9hcFlud0V"
+                          "lc2V4VGpUOFNwLytiVHFXRW16Z0QzN3BmZEthcWp0SExHVmlZd1ZIUHp0QmFid"
+                          "3dqaEF2enlSWS95OU9mbXpEZlhtclkxcm8vKzJoRXFFeWt1andRRVlraGpKYSt"
+                          "CNDc2KzBtdUd5V0k1ZUl2L29sdDJSZVh4TWI5TWxsWE55b1AzYU5LSUppYlpNc"
+                          "zd1S2Npd2t5aVVJYVljTWpzOWkvUkV5K2xNOXZJWnFyZnBDVVh1M3RuMUtnYzJ"
+                          "Rcy9UZDh0TlRDR1Y2d3RWYXFpSXBUZFQ0UnJDZE1vTzVTTmVmZkR5YzJsQzd1O"
+                          "DUrb21Ua2NqUGptNmZhcGRJeUYycWVtdlNCRGZCN2NhajVESUkyNVd3NUVKY2F"
+                          "2ZnlQNTRtcU5RUTNHY01RYjJkZ2hpY2xwallvKzQzWmdZQ2RHdGFaZDJFZkxad"
+                          "0gzUWcyckRsZmsvaWEwLzF5cWlrL1haMW5zWlRpMEJjNUNwT01FcWZOSkZRazN"
+                          "CV29BMDVyQ1oiLCJlIjoiQVFBQiIsImFsZyI6IlJTMjU2Iiwia2lkIjoiQURVL"
+                          "jIwMDcwMi5SLlMifQ" };
+
+        CryptoKeyHandle key = nullptr;
+
+        ADUC_Result result = RootKeyUtility_GetKeyForKidFromHardcodedKeys(&key, "ADU.200702.R");
+
+        REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+        REQUIRE(key != nullptr);
+
+        ADUC::StringUtils::calloc_wrapper<uint8_t> d_sig_handle;
+        size_t sig_len = Base64URLDecode(signature.c_str(), d_sig_handle.address_of());
+
+        CryptoVerifyContextHandle context = CryptoUtils_CreateVerifyContext();
+        REQUIRE(context != nullptr);
+
+        const auto isValid = [&](const std::string& data) {
+            return CryptoUtils_IsValidSignatureWithContext(
+                context,
+                CRYPTO_UTILS_SIGNATURE_VALIDATION_ALG_RS256,
+                d_sig_handle.get(),
+                sig_len,
+                reinterpret_cast<const uint8_t*>(data.c_str()), // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                data.length(),
+                key);
+        };
+
+        CHECK(isValid(blob));
+        CHECK(isValid(blob));
+
+        std::string tamperedBlob{ blob };
+        tamperedBlob[0] = 'f';
+        CHECK(!isValid(tamperedBlob));
+        CHECK(isValid(blob));
+
+        // The context keeps its own reference to the key.
+        CryptoUtils_FreeCryptoKeyHandle(key);
+        CryptoUtils_FreeVerifyContext(context);
+    }
+
+    SECTION("Validating Signatures with a Long-Lived Key")
+    {
+        std::string signature{ "iSTgAEBXsd7AANkQMkaG-FAV6QOGUEuxuHg2YfSuWhtY"
+                               "XqbpM-jI5RVLKesSLCehK-lRC9x6-_LeyxNh1DOFc-Fa6oCEGwUj8ziOF_AT6s"
+                               "6EOmckqPrxuvCWtyYkkDRF74dtaK1jNA7SdXrZzvWCsMqOUMNz0gCoVR0Cs125"
+                               "4kFMRmRPVfEcjgT7j4lCpyDuWgr9SenSeqgKLYxjaaG0sRh9cdi2dKrwgaNaqA"
+                               "bHmCrrhxSPCTBzWMExZrLYzudEofyYHiVVRhSJpj0OQ18ecu4DPXV1Tct1y3k7"
+                               "LLio7n8izKuq2m3TxF9vPdqb9NP6Sc9-myaptpbFpHeFkUL-F5ytl_UBFKpwN9"
+                               "CL4wp6yZ-jdXNagrmU_qL1CyXw1omNCgTmJF3Gd3lyqKHHDerDs-MRpmKjwSwp"
+                               "ZCQJGDRcRovWyL12vjw3LBJMhmUxsEdBaZP5wGdsfD8ldKYFVFEcZ0orMNrUkS"
+                               "MAl6pIxtefEXiy5lqmiPzq_LJ1eRIrqY0_" };
+
+        std::string blob{ "eyJhbGciOiJSUzI1NiIsImtpZCI6IkFEVS4yMDA3MDIuUiJ9.eyJrdHkiOiJSU"
+                          "0EiLCJuIjoickhWQkVGS1IxdnNoZytBaElnL1NEUU8zeDRrajNDVVQ3ZkduSmh"
+                          "BbXVEaHZIZmozZ0h6aTBUMklBcUMxeDJCQ1dkT281djh0dW1xUmovbllwZzk3a"
+                          "mpQQ0t1Y2RPNm0zN2RjT21hNDZoN08wa0hwd0wzblVIR0VySjVEQS9hcFlud0V"
+                          "lc2V4VGpUOFNwLytiVHFXRW16Z0QzN3BmZEthcWp0SExHVmlZd1ZIUHp0QmFid"
+                          "3dqaEF2enlSWS95OU9mbXpEZlhtclkxcm8vKzJoRXFFeWt1andRRVlraGpKYSt"
+                          "CNDc2KzBtdUd5V0k1ZUl2L29sdDJSZVh4TWI5TWxsWE55b1AzYU5LSUppYlpNc"
+                          "zd1S2Npd2t5aVVJYVljTWpzOWkvUkV5K2xNOXZJWnFyZnBDVVh1M3RuMUtnYzJ"
+                          "Rcy9UZDh0TlRDR1Y2d3RWYXFpSXBUZFQ0UnJDZE1vTzVTTmVmZkR5YzJsQzd1O"
+                          "DUrb21Ua2NqUGptNmZhcGRJeUYycWVtdlNCRGZCN2NhajVESUkyNVd3NUVKY2F"
+                          "2ZnlQNTRtcU5RUTNHY01RYjJkZ2hpY2xwallvKzQzWmdZQ2RHdGFaZDJFZkxad"
+                          "0gzUWcyckRsZmsvaWEwLzF5cWlrL1haMW5zWlRpMEJjNUNwT01FcWZOSkZRazN"
+                          "CV29BMDVyQ1oiLCJlIjoiQVFBQiIsImFsZyI6IlJTMjU2Iiwia2lkIjoiQURVL"
+                          "jIwMDcwMi5SLlMifQ" };
+
+        CryptoKeyHandle key = nullptr;
+
+        ADUC_Result result = RootKeyUtility_GetKeyForKidFromHardcodedKeys(&key, "ADU.200702.R");
+
+        REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+        REQUIRE(key != nullptr);
+
+        ADUC::StringUtils::calloc_wrapper<uint8_t> d_sig_handle;
+        size_t sig_len = Base64URLDecode(signature.c_str(), d_sig_handle.address_of());
+
+        const auto isValid = [&](const std::string& data) {
+            return CryptoUtils_IsValidSignatureWithLongLivedKey(
+                CRYPTO_UTILS_SIGNATURE_VALIDATION_ALG_RS256,
+                d_sig_handle.get(),
+                sig_len,
+                reinterpret_cast<const uint8_t*>(data.c_str()), // NOLINT(cppcoreguidelines-pro-type-reinterpret-cast)
+                data.length(),
+                key);
+        };
+
+        CHECK(isValid(blob));
+        CHECK(isValid(blob));
+
+        std::string tamperedBlob{ blob };
+        tamperedBlob[0] = 'f';
+        CHECK(!isValid(tamperedBlob));
+
+        // The shared context is freed at shutdown, and created again if still needed.
+        CryptoUtils_UninitSharedVerifyContext();
+        CHECK(isValid(blob));
+        CryptoUtils_UninitSharedVerifyContext();
+
+        CryptoUtils_FreeCryptoKeyHandle(key);
+    }
+
     SECTION("Validating an Invalid Signature")
     {
         // Note: Signature has been garbled to create an invalid signature
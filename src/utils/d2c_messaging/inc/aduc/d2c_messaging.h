@@ -11,6 +11,7 @@
 #include "aduc/c_utils.h"
 #include <pthread.h>
 #include <stdbool.h>
+#include <stdint.h> // uint64_t
 
 #include <aducpal/time.h> // time_t
 
@@ -120,6 +121,7 @@ typedef struct _tagADUC_D2C_Message
     const char* originalContent; /**< The original content (message) */
     char* content; /**< The copy of the original content (message) */
     time_t contentSubmitTime; /**< Submit time */
+    uint64_t contentSubmitTimeMs; /**< Monotonic submit time in milliseconds, for deployment timing */
     ADUC_D2C_MESSAGE_HTTP_RESPONSE_CALLBACK
     responseCallback; /**< A callback that is called when received a http response from the cloud */
     ADUC_D2C_MESSAGE_COMPLETED_CALLBACK
@@ -147,6 +149,7 @@ typedef struct _tagADUC_D2C_Message_Processing_Context
 
     ADUC_D2C_Message message; /**< The message data to be send to the cloud service */
     ADUC_D2C_RetryStrategy* retryStrategy; /**< Retry strategy information */
+    bool coalescingEnabled; /**< Whether pending messages are merged into a single reported property patch */
     unsigned int retries; /**< Number of retries */
     time_t nextRetryTimeStampEpoch; /**< The next retry time stamp. This is the time since epoch, in seconds */
 } ADUC_D2C_Message_Processing_Context;
@@ -166,13 +169,24 @@ void ADUC_D2C_Messaging_Uninit();
 /**
  * @brief Performs messaging processing tasks.
  *
- * Note: must call this function every 100ms - 200ms to ensure that the Device to Cloud messages are processed in timely manner.
+ * Note: must call this function when woken by ADUC_Wakeup_Wait(), and every 100ms - 200ms while
+ *       ADUC_D2C_Messaging_HasInFlightMessages() returns true, to ensure that the Device to Cloud messages
+ *       are processed in timely manner. Retries are scheduled with ADUC_Wakeup_ScheduleAfter().
  *
  **/
 void ADUC_D2C_Messaging_DoWork();
 
 /**
- * @brief Submits the message to messaging utility queue. If the message for specified @p type already exist, it will be replaced by the latest message.
+ * @brief Checks whether any message is waiting to be sent or waiting for a response from the cloud.
+ *
+ * @return Returns true if the underlying transport needs to be serviced.
+ */
+bool ADUC_D2C_Messaging_HasInFlightMessages();
+
+/**
+ * @brief Submits the message to messaging utility queue. If coalescing is enabled for @p type, the message
+ *        is merged with the last pending message of that type into a single reported property patch, and the earlier
+ *        message completes with ADUC_D2C_Message_Status_Replaced. Otherwise, messages are sent in submission order.
  *
  *        IMPORTANT: The implementation of @p responseCallback, @p completedCallback, and @p statusChangedCallback MUST NOT
  *        call any ADUC_D2C_* functions. Otherwise, a dead-lock may occurs.
@@ -187,7 +201,10 @@ void ADUC_D2C_Messaging_DoWork();
  * @param statusChangedCallback A optional callback to be called when the messages status has changed.
  * @param userData An additional user data.
  *
- * @return Returns true if message successfully added to the pending-messages queue.
+ * @return Returns true if message successfully added to the pending-messages queue. If too many messages of @p type
+ *         were submitted since the last ADUC_D2C_Messaging_DoWork(), the newest one replaces the last unaccepted one.
+ *
+ * @remark Never blocks on the messaging state; safe to call from worker threads while the main thread is sending.
  */
 bool ADUC_D2C_Message_SendAsync(
     ADUC_D2C_Message_Type type,
@@ -198,6 +215,22 @@ bool ADUC_D2C_Message_SendAsync(
     ADUC_D2C_MESSAGE_STATUS_CHANGED_CALLBACK statusChangedCallback,
     void* userData);
 
+/**
+ * @brief Same as ADUC_D2C_Message_SendAsync(), but takes ownership of @p message instead of copying it.
+ *
+ * @param message The malloc'd message content. The messaging utility frees it, even when this function fails.
+ *
+ * @return Returns true if message successfully added to the pending-messages queue.
+ */
+bool ADUC_D2C_Message_SendOwnedAsync(
+    ADUC_D2C_Message_Type type,
+    void* cloudServiceHandle,
+    char* message,
+    ADUC_D2C_MESSAGE_HTTP_RESPONSE_CALLBACK responseCallback,
+    ADUC_D2C_MESSAGE_COMPLETED_CALLBACK completedCallback,
+    ADUC_D2C_MESSAGE_STATUS_CHANGED_CALLBACK statusChangedCallback,
+    void* userData);
+
 /**
  * @brief Sets the messaging transport. By default, the messaging utility will send messages to IoT Hub.
  *
@@ -217,6 +250,15 @@ void ADUC_D2C_Messaging_Set_Transport(ADUC_D2C_Message_Type type, ADUC_D2C_MESSA
  */
 void ADUC_D2C_Messaging_Set_Retry_Strategy(ADUC_D2C_Message_Type type, ADUC_D2C_RetryStrategy* strategy);
 
+/**
+ * @brief Enables or disables coalescing of pending messages for the specified @p type. Disabled by default.
+ * Only enable it for types whose messages are reported property patches (JSON merge patches).
+ *
+ * @param type The message type.
+ * @param enabled Whether consecutive pending messages are merged into a single reported property patch.
+ */
+void ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type type, bool enabled);
+
 /**
  * @brief The default message transport function.
  *
@@ -8,14 +8,34 @@
 #include "aduc/d2c_messaging.h"
 #include "aduc/client_handle_helper.h"
 #include "aduc/retry_utils.h"
+#include "aduc/timing_utils.h"
+#include "aduc/wakeup_utils.h"
 
 #include <limits.h>
 #include <math.h>
+#include <parson.h>
 #include <stdbool.h>
+#include <stdint.h> // int64_t
+#include <stdio.h> // snprintf
+#include <string.h> // memmove
 
 #include <aducpal/sys_time.h> // ADUCPAL_clock_gettime
 #include <aducpal/unistd.h>
 
+#if defined(WIN32)
+#    include <windows.h> // Interlocked*
+#    define D2C_ATOMIC_LOAD(ptr) InterlockedCompareExchange64((volatile LONG64*)(ptr), 0, 0)
+#    define D2C_ATOMIC_STORE(ptr, value) InterlockedExchange64((volatile LONG64*)(ptr), (LONG64)(value))
+#    define D2C_ATOMIC_CAS(ptr, expected, desired) \
+        (InterlockedCompareExchange64((volatile LONG64*)(ptr), (LONG64)(desired), (LONG64)(expected)) \
+         == (LONG64)(expected))
+#else
+#    define D2C_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#    define D2C_ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#    define D2C_ATOMIC_CAS(ptr, expected, desired) \
+        __atomic_compare_exchange_n((ptr), &(expected), (desired), false, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED)
+#endif
+
 #ifndef MAX
 #    define MAX(a, b) (((a) > (b)) ? (a) : (b))
 #endif
@@ -30,14 +50,57 @@
 #define MAX_RETRY_EXPONENT 9
 #define FATAL_ERROR_WAIT_TIME_SEC 10 // 10 seconds
 #define ONE_DAY_IN_SECONDS (1 * 24 * 60 * 60)
+#define MAX_PENDING_MESSAGES_PER_TYPE 8
+#define INCOMING_RING_SIZE 32 // Must be a power of two.
+
+/**
+ * @brief Messages of one type waiting to be sent, oldest first.
+ */
+typedef struct tagADUC_D2C_Pending_Message_Queue
+{
+    ADUC_D2C_Message messages[MAX_PENDING_MESSAGES_PER_TYPE]; /**< The queued messages */
+    unsigned int count; /**< Number of queued messages */
+} ADUC_D2C_Pending_Message_Queue;
 
-static pthread_mutex_t s_pendingMessageStoreMutex = PTHREAD_MUTEX_INITIALIZER;
+/**
+ * @brief A slot of the incoming message ring.
+ */
+typedef struct tagADUC_D2C_Incoming_Message_Cell
+{
+    int64_t sequence; /**< Equals the enqueue position when free, and that position + 1 once the message is published */
+    ADUC_D2C_Message message; /**< The submitted message */
+} ADUC_D2C_Incoming_Message_Cell;
+
+/**
+ * @brief Bounded lock-free multi-producer single-consumer ring of submitted messages of one type.
+ *
+ * Any thread may submit; only the thread holding the message type's processing context mutex consumes.
+ */
+typedef struct tagADUC_D2C_Incoming_Message_Ring
+{
+    ADUC_D2C_Incoming_Message_Cell cells[INCOMING_RING_SIZE]; /**< The slots */
+    int64_t enqueuePosition; /**< Next position to claim, shared by producers */
+    int64_t dequeuePosition; /**< Next position to consume */
+
+    // Holds the latest message submitted while the ring was full; a newer one replaces it.
+    // While it is occupied, submissions go here too, so that they are not accepted ahead of it.
+    pthread_mutex_t overflowMutex; /**< Guards overflowMessage */
+    ADUC_D2C_Message overflowMessage; /**< The overflow message, if hasOverflowMessage */
+    int64_t hasOverflowMessage; /**< Non-zero while overflowMessage is occupied; read without the lock */
+    int64_t coalescingEnabled; /**< Copy of the processing context's coalescingEnabled, for producers */
+} ADUC_D2C_Incoming_Message_Ring;
+
+// Serializes ADUC_D2C_Messaging_Init and ADUC_D2C_Messaging_Uninit only. Message processing of each type is
+// guarded by its processing context mutex, and message submission takes no lock.
+static pthread_mutex_t s_lifecycleMutex = PTHREAD_MUTEX_INITIALIZER;
 static bool s_core_initialized = false;
 
-static ADUC_D2C_Message s_pendingMessageStore[ADUC_D2C_Message_Type_Max];
+static ADUC_D2C_Incoming_Message_Ring s_incomingMessages[ADUC_D2C_Message_Type_Max];
+static ADUC_D2C_Pending_Message_Queue s_pendingMessageStore[ADUC_D2C_Message_Type_Max];
 static ADUC_D2C_Message_Processing_Context s_messageProcessingContext[ADUC_D2C_Message_Type_Max];
 
 static void ProcessMessage(ADUC_D2C_Message_Processing_Context* context);
+static void ScheduleNextRetry();
 
 static time_t GetTimeSinceEpochInSeconds()
 {
@@ -178,6 +241,26 @@ static void OnMessageProcessingCompleted(ADUC_D2C_Message* message, ADUC_D2C_Mes
         return;
     }
     SetMessageStatus(message, status);
+
+    // Replaced and canceled messages were never fully reported, so only time delivered or failed ones.
+    if (status == ADUC_D2C_Message_Status_Success || status == ADUC_D2C_Message_Status_Failed)
+    {
+        uint64_t now = ADUC_Timing_GetMonotonicTimeMs();
+        char detail[ADUC_TIMING_MAX_DETAIL_SIZE];
+        (void)snprintf(detail, sizeof(detail), "attempts:%u", message->attempts);
+
+        ADUC_TimingReport* report = ADUC_Timing_AcquireCurrentReport();
+        ADUC_TimingReport_RecordSpan(
+            report,
+            ADUC_TIMING_PHASE_REPORTING,
+            detail,
+            ADUC_TIMING_NO_LEVEL,
+            ADUC_TIMING_NO_LEVEL,
+            message->contentSubmitTimeMs,
+            now > message->contentSubmitTimeMs ? now - message->contentSubmitTimeMs : 0);
+        ADUC_TimingReport_Release(report);
+    }
+
     if (message->completedCallback != NULL)
     {
         message->completedCallback(message, status);
@@ -185,6 +268,286 @@ static void OnMessageProcessingCompleted(ADUC_D2C_Message* message, ADUC_D2C_Mes
     DestroyMessageData(message);
 }
 
+/**
+ * @brief Resets the @p ring to empty. Must not be called while other threads may submit.
+ *
+ * @return Returns false if the overflow mutex cannot be created.
+ */
+static bool IncomingMessageRing_Init(ADUC_D2C_Incoming_Message_Ring* ring)
+{
+    memset(ring, 0, sizeof(*ring));
+    for (int64_t i = 0; i < INCOMING_RING_SIZE; i++)
+    {
+        ring->cells[i].sequence = i;
+    }
+
+    return pthread_mutex_init(&ring->overflowMutex, NULL) == 0;
+}
+
+static char* CoalesceMessageContent(const char* earlierContent, const char* laterContent);
+
+/**
+ * @brief Stores @p message in the overflow slot of the @p ring, replacing the message already there, if any.
+ * If coalescing is enabled, the replaced message's content is merged into @p message when possible.
+ * Safe to call from any number of threads.
+ */
+static void IncomingMessageRing_PushOverflow(ADUC_D2C_Incoming_Message_Ring* ring, ADUC_D2C_Message* message)
+{
+    ADUC_D2C_Message replacedMessage;
+    memset(&replacedMessage, 0, sizeof(replacedMessage));
+
+    pthread_mutex_lock(&ring->overflowMutex);
+    if (ring->hasOverflowMessage)
+    {
+        replacedMessage = ring->overflowMessage;
+        if (D2C_ATOMIC_LOAD(&ring->coalescingEnabled))
+        {
+            char* coalesced = CoalesceMessageContent(replacedMessage.content, message->content);
+            if (coalesced != NULL)
+            {
+                free(message->content);
+                message->content = coalesced;
+            }
+        }
+    }
+    ring->overflowMessage = *message;
+    D2C_ATOMIC_STORE(&ring->hasOverflowMessage, 1);
+    pthread_mutex_unlock(&ring->overflowMutex);
+
+    if (replacedMessage.content != NULL)
+    {
+        Log_Warn("Too many messages submitted. Replacing unsent message. (s:%s)", replacedMessage.content);
+        OnMessageProcessingCompleted(&replacedMessage, ADUC_D2C_Message_Status_Replaced);
+    }
+}
+
+/**
+ * @brief Takes the message from the overflow slot of the @p ring. Only the consumer may call this.
+ *
+ * @return Returns false if the slot is empty.
+ */
+static bool IncomingMessageRing_PopOverflow(ADUC_D2C_Incoming_Message_Ring* ring, ADUC_D2C_Message* message)
+{
+    bool found = false;
+
+    if (!D2C_ATOMIC_LOAD(&ring->hasOverflowMessage))
+    {
+        return false;
+    }
+
+    pthread_mutex_lock(&ring->overflowMutex);
+    if (ring->hasOverflowMessage)
+    {
+        *message = ring->overflowMessage;
+        memset(&ring->overflowMessage, 0, sizeof(ring->overflowMessage));
+        D2C_ATOMIC_STORE(&ring->hasOverflowMessage, 0);
+        found = true;
+    }
+    pthread_mutex_unlock(&ring->overflowMutex);
+
+    return found;
+}
+
+/**
+ * @brief Publishes @p message to the @p ring without blocking. Safe to call from any number of threads.
+ *
+ * @return Returns false if the ring is full.
+ */
+static bool IncomingMessageRing_Push(ADUC_D2C_Incoming_Message_Ring* ring, const ADUC_D2C_Message* message)
+{
+    int64_t position = D2C_ATOMIC_LOAD(&ring->enqueuePosition);
+
+    for (;;)
+    {
+        ADUC_D2C_Incoming_Message_Cell* cell = &ring->cells[position & (INCOMING_RING_SIZE - 1)];
+        int64_t available = D2C_ATOMIC_LOAD(&cell->sequence) - position;
+
+        if (available == 0)
+        {
+            // The cell is free; claim it, unless another producer got it first.
+            if (D2C_ATOMIC_CAS(&ring->enqueuePosition, position, position + 1))
+            {
+                cell->message = *message;
+                D2C_ATOMIC_STORE(&cell->sequence, position + 1);
+                return true;
+            }
+        }
+        else if (available < 0)
+        {
+            // The consumer has not released this cell yet.
+            return false;
+        }
+        else
+        {
+            position = D2C_ATOMIC_LOAD(&ring->enqueuePosition);
+        }
+    }
+}
+
+/**
+ * @brief Takes the oldest published message from the @p ring. Only one thread may consume at a time.
+ *
+ * @return Returns false if the ring is empty.
+ */
+static bool IncomingMessageRing_Pop(ADUC_D2C_Incoming_Message_Ring* ring, ADUC_D2C_Message* message)
+{
+    ADUC_D2C_Incoming_Message_Cell* cell = &ring->cells[ring->dequeuePosition & (INCOMING_RING_SIZE - 1)];
+
+    if (D2C_ATOMIC_LOAD(&cell->sequence) != ring->dequeuePosition + 1)
+    {
+        return false;
+    }
+
+    *message = cell->message;
+    memset(&cell->message, 0, sizeof(cell->message));
+    D2C_ATOMIC_STORE(&cell->sequence, ring->dequeuePosition + INCOMING_RING_SIZE);
+    ring->dequeuePosition++;
+    return true;
+}
+
+/**
+ * @brief Removes the oldest message from the @p queue.
+ *
+ * @param queue The pending message queue. Must not be empty.
+ * @param[out] message Receives the removed message.
+ */
+static void DequeuePendingMessage(ADUC_D2C_Pending_Message_Queue* queue, ADUC_D2C_Message* message)
+{
+    *message = queue->messages[0];
+    queue->count--;
+    memmove(&queue->messages[0], &queue->messages[1], queue->count * sizeof(queue->messages[0]));
+    memset(&queue->messages[queue->count], 0, sizeof(queue->messages[0]));
+}
+
+/**
+ * @brief Merges reported property @p patch into @p target, such that sending @p target alone has the same effect
+ * on the device twin as sending the original @p target followed by @p patch (JSON merge patch, RFC 7386).
+ *
+ * @param target The earlier patch, updated in place.
+ * @param patch The later patch.
+ * @return Returns false if the combination cannot be expressed as a single patch. That is the case when
+ *         @p patch sets an object on a property that @p target sets to null or to a non-object value.
+ */
+static bool MergeReportedPropertyPatches(JSON_Object* target, const JSON_Object* patch)
+{
+    for (size_t i = 0; i < json_object_get_count(patch); ++i)
+    {
+        const char* name = json_object_get_name(patch, i);
+        JSON_Value* patchValue = json_object_get_value_at(patch, i);
+        JSON_Value* targetValue = json_object_get_value(target, name);
+
+        if (json_value_get_type(patchValue) == JSONObject && targetValue != NULL)
+        {
+            if (json_value_get_type(targetValue) != JSONObject)
+            {
+                return false;
+            }
+
+            if (!MergeReportedPropertyPatches(json_value_get_object(targetValue), json_value_get_object(patchValue)))
+            {
+                return false;
+            }
+
+            continue;
+        }
+
+        JSON_Value* valueCopy = json_value_deep_copy(patchValue);
+        if (valueCopy == NULL || json_object_set_value(target, name, valueCopy) != JSONSuccess)
+        {
+            json_value_free(valueCopy);
+            return false;
+        }
+    }
+
+    return true;
+}
+
+/**
+ * @brief Coalesces two reported property messages into one.
+ *
+ * @param earlierContent The content of the message that would have been sent first.
+ * @param laterContent The content of the message that would have been sent next.
+ * @return char* The combined content, or NULL if either content is not a JSON object or the two cannot be combined.
+ *         Caller must free() it.
+ */
+static char* CoalesceMessageContent(const char* earlierContent, const char* laterContent)
+{
+    char* coalesced = NULL;
+    char* serialized = NULL;
+    JSON_Value* earlierValue = json_parse_string(earlierContent);
+    JSON_Value* laterValue = json_parse_string(laterContent);
+
+    if (json_value_get_type(earlierValue) != JSONObject || json_value_get_type(laterValue) != JSONObject)
+    {
+        goto done;
+    }
+
+    if (!MergeReportedPropertyPatches(json_value_get_object(earlierValue), json_value_get_object(laterValue)))
+    {
+        goto done;
+    }
+
+    serialized = json_serialize_to_string(earlierValue);
+    if (serialized == NULL || mallocAndStrcpy_s(&coalesced, serialized) != 0)
+    {
+        coalesced = NULL;
+        goto done;
+    }
+
+done:
+    json_free_serialized_string(serialized);
+    json_value_free(laterValue);
+    json_value_free(earlierValue);
+
+    return coalesced;
+}
+
+/**
+ * @brief Moves messages submitted since the last call from the incoming ring, and then its overflow slot,
+ * to the pending queue, coalescing each with the last pending message if possible.
+ * Must be called with the message_processing_context mutex held.
+ *
+ * @param message_processing_context The processing context of the message type.
+ */
+static void AcceptIncomingMessages(ADUC_D2C_Message_Processing_Context* message_processing_context)
+{
+    ADUC_D2C_Message_Type type = message_processing_context->type;
+    ADUC_D2C_Pending_Message_Queue* queue = &s_pendingMessageStore[type];
+    ADUC_D2C_Incoming_Message_Ring* ring = &s_incomingMessages[type];
+    ADUC_D2C_Message incoming;
+
+    // The overflow message is newer than anything in the ring when it was stored, so it is accepted last.
+    while (IncomingMessageRing_Pop(ring, &incoming) || IncomingMessageRing_PopOverflow(ring, &incoming))
+    {
+        SetMessageStatus(&incoming, ADUC_D2C_Message_Status_Pending);
+
+        if (queue->count > 0 && message_processing_context->coalescingEnabled)
+        {
+            ADUC_D2C_Message* lastMessage = &queue->messages[queue->count - 1];
+            char* coalesced = CoalesceMessageContent(lastMessage->content, incoming.content);
+            if (coalesced != NULL)
+            {
+                Log_Debug("Coalescing with pending message. (t:%d, s:%s)", type, lastMessage->content);
+                free(incoming.content);
+                incoming.content = coalesced;
+                OnMessageProcessingCompleted(lastMessage, ADUC_D2C_Message_Status_Replaced);
+                queue->count--;
+            }
+        }
+
+        // Replace oldest pending message if the queue is full.
+        if (queue->count == MAX_PENDING_MESSAGES_PER_TYPE)
+        {
+            ADUC_D2C_Message oldestMessage;
+            DequeuePendingMessage(queue, &oldestMessage);
+            Log_Warn("Too many pending messages. Replacing oldest message. (t:%d, s:%s)", type, oldestMessage.content);
+            OnMessageProcessingCompleted(&oldestMessage, ADUC_D2C_Message_Status_Replaced);
+        }
+
+        queue->messages[queue->count++] = incoming;
+    }
+}
+
 /**
  * @brief The function that is called when a 'reported property' patch response is received from the IoT Hub.
  *
@@ -316,7 +679,8 @@ done:
 /**
  * @brief Performs messages processing tasks.
  *
- * Note: must call this function every 100ms - 200ms to ensure that the Device to Cloud messages
+ * Note: must call this function when woken by ADUC_Wakeup_Wait(), and every 100ms - 200ms while
+ *       ADUC_D2C_Messaging_HasInFlightMessages() returns true, to ensure that the Device to Cloud messages
  *       are processed in timely manner.
  *
  **/
@@ -326,16 +690,70 @@ void ADUC_D2C_Messaging_DoWork()
     {
         ProcessMessage(&s_messageProcessingContext[i]);
     }
+
+    ScheduleNextRetry();
+}
+
+/**
+ * @brief Checks whether any message is waiting to be sent or waiting for a response from the cloud.
+ *
+ * @return Returns true if the underlying transport needs to be serviced.
+ */
+bool ADUC_D2C_Messaging_HasInFlightMessages()
+{
+    bool inFlight = false;
+
+    for (int i = 0; i < ADUC_D2C_Message_Type_Max && !inFlight; i++)
+    {
+        pthread_mutex_lock(&s_messageProcessingContext[i].mutex);
+        AcceptIncomingMessages(&s_messageProcessingContext[i]);
+        inFlight = s_pendingMessageStore[i].count > 0
+            || (s_messageProcessingContext[i].message.content != NULL
+                && s_messageProcessingContext[i].message.status == ADUC_D2C_Message_Status_Waiting_For_Response);
+        pthread_mutex_unlock(&s_messageProcessingContext[i].mutex);
+    }
+
+    return inFlight;
+}
+
+/**
+ * @brief Schedules a main loop wakeup for the earliest pending retry, so that the loop does not need to poll for it.
+ */
+static void ScheduleNextRetry()
+{
+    bool hasRetry = false;
+    time_t nextRetryTime = 0;
+    time_t now = GetTimeSinceEpochInSeconds();
+
+    for (int i = 0; i < ADUC_D2C_Message_Type_Max; i++)
+    {
+        ADUC_D2C_Message_Processing_Context* context = &s_messageProcessingContext[i];
+        pthread_mutex_lock(&context->mutex);
+        if (context->message.content != NULL && context->message.status == ADUC_D2C_Message_Status_In_Progress
+            && (!hasRetry || context->nextRetryTimeStampEpoch < nextRetryTime))
+        {
+            hasRetry = true;
+            nextRetryTime = context->nextRetryTimeStampEpoch;
+        }
+        pthread_mutex_unlock(&context->mutex);
+    }
+
+    if (hasRetry)
+    {
+        ADUC_Wakeup_ScheduleAfter(nextRetryTime > now ? (unsigned int)(nextRetryTime - now) * 1000 : 0);
+    }
 }
 
 static void ProcessMessage(ADUC_D2C_Message_Processing_Context* message_processing_context)
 {
     bool shouldSend = false;
     time_t now = GetTimeSinceEpochInSeconds();
-    pthread_mutex_lock(&s_pendingMessageStoreMutex);
+    ADUC_D2C_Pending_Message_Queue* queue = &s_pendingMessageStore[message_processing_context->type];
     pthread_mutex_lock(&message_processing_context->mutex);
 
-    if (s_pendingMessageStore[message_processing_context->type].content != NULL)
+    AcceptIncomingMessages(message_processing_context);
+
+    if (queue->count > 0)
     {
         if (message_processing_context->message.content != NULL)
         {
@@ -345,23 +763,33 @@ static void ProcessMessage(ADUC_D2C_Message_Processing_Context* message_processi
                 goto done;
             }
 
-            // Discard old message.
+            // The current message is waiting to be retried. Fold it into the next message when possible,
+            // so that its changes are not lost; otherwise, the next message supersedes it.
+            if (message_processing_context->coalescingEnabled)
+            {
+                char* coalesced =
+                    CoalesceMessageContent(message_processing_context->message.content, queue->messages[0].content);
+                if (coalesced != NULL)
+                {
+                    free(queue->messages[0].content);
+                    queue->messages[0].content = coalesced;
+                }
+            }
+
             Log_Info(
                 "New D2C message content (t:%d, content:0x%x).",
                 message_processing_context->type,
-                s_pendingMessageStore[message_processing_context->type].content);
+                queue->messages[0].content);
             OnMessageProcessingCompleted(&message_processing_context->message, ADUC_D2C_Message_Status_Replaced);
         }
 
-        // Use new message
+        // Use next message
         memset(&message_processing_context->message, 0, sizeof(message_processing_context->message));
-        message_processing_context->message = s_pendingMessageStore[message_processing_context->type];
+        DequeuePendingMessage(queue, &message_processing_context->message);
         message_processing_context->message.attempts = 0;
         message_processing_context->retries = 0;
         message_processing_context->nextRetryTimeStampEpoch = now;
 
-        // Empty pending message store.
-        memset(&s_pendingMessageStore[message_processing_context->type], 0, sizeof(ADUC_D2C_Message));
         shouldSend = message_processing_context->message.content != NULL;
 
         SetMessageStatus(&message_processing_context->message, ADUC_D2C_Message_Status_In_Progress);
@@ -408,7 +836,6 @@ static void ProcessMessage(ADUC_D2C_Message_Processing_Context* message_processi
 
 done:
     pthread_mutex_unlock(&message_processing_context->mutex);
-    pthread_mutex_unlock(&s_pendingMessageStoreMutex);
 }
 
 /**
@@ -420,16 +847,22 @@ bool ADUC_D2C_Messaging_Init()
 {
     bool success = false;
     int i = 0;
-    pthread_mutex_lock(&s_pendingMessageStoreMutex);
+    pthread_mutex_lock(&s_lifecycleMutex);
     if (!s_core_initialized)
     {
         memset(&s_messageProcessingContext, 0, sizeof(s_messageProcessingContext));
         memset(&s_pendingMessageStore, 0, sizeof(s_pendingMessageStore));
         for (i = 0; i < ADUC_D2C_Message_Type_Max; i++)
         {
+            if (!IncomingMessageRing_Init(&s_incomingMessages[i]))
+            {
+                Log_Error("Can't init overflow mutex for type %d.", i);
+                goto done;
+            }
             s_messageProcessingContext[i].type = i;
             s_messageProcessingContext[i].transportFunc = ADUC_D2C_Default_Message_Transport_Function;
             s_messageProcessingContext[i].retryStrategy = &g_defaultRetryStrategy;
+            s_messageProcessingContext[i].coalescingEnabled = false;
             int res = pthread_mutex_init(&s_messageProcessingContext[i].mutex, NULL);
             if (res != 0)
             {
@@ -446,39 +879,53 @@ done:
         ADUC_D2C_Messaging_Uninit();
     }
 
-    pthread_mutex_unlock(&s_pendingMessageStoreMutex);
+    pthread_mutex_unlock(&s_lifecycleMutex);
     return success;
 }
 
 void ADUC_D2C_Messaging_Uninit()
 {
-    pthread_mutex_lock(&s_pendingMessageStoreMutex);
+    pthread_mutex_lock(&s_lifecycleMutex);
     if (s_core_initialized)
     {
         // Cancel pending messages
         for (int i = 0; i < ADUC_D2C_Message_Type_Max; i++)
         {
+            ADUC_D2C_Message incoming;
             pthread_mutex_lock(&s_messageProcessingContext[i].mutex);
-            if (s_pendingMessageStore[i].content != NULL)
+            while (IncomingMessageRing_Pop(&s_incomingMessages[i], &incoming)
+                   || IncomingMessageRing_PopOverflow(&s_incomingMessages[i], &incoming))
             {
-                OnMessageProcessingCompleted(&s_pendingMessageStore[i], ADUC_D2C_Message_Status_Canceled);
+                OnMessageProcessingCompleted(&incoming, ADUC_D2C_Message_Status_Canceled);
             }
 
+            for (unsigned int j = 0; j < s_pendingMessageStore[i].count; j++)
+            {
+                OnMessageProcessingCompleted(&s_pendingMessageStore[i].messages[j], ADUC_D2C_Message_Status_Canceled);
+            }
+            s_pendingMessageStore[i].count = 0;
+
             if (s_messageProcessingContext[i].message.content != NULL)
             {
                 OnMessageProcessingCompleted(&s_messageProcessingContext[i].message, ADUC_D2C_Message_Status_Canceled);
             }
             pthread_mutex_unlock(&s_messageProcessingContext[i].mutex);
             pthread_mutex_destroy(&s_messageProcessingContext[i].mutex);
+            pthread_mutex_destroy(&s_incomingMessages[i].overflowMutex);
             s_messageProcessingContext[i].initialized = false;
         }
         s_core_initialized = false;
     }
-    pthread_mutex_unlock(&s_pendingMessageStoreMutex);
+    pthread_mutex_unlock(&s_lifecycleMutex);
 }
 
 /**
- * @brief Submits the message to pending messages store. If the message for specified @p type already exist, it will be replaced by the new message.
+ * @brief Submits the message to the pending messages queue of the specified @p type. Does not block.
+ *
+ * If coalescing is enabled for @p type and the most recently queued message has not been sent yet,
+ * the two reported property patches are merged into a single message, and the queued one completes with
+ * ADUC_D2C_Message_Status_Replaced. Otherwise, the message is appended to the queue. If the queue is full,
+ * the oldest queued message is replaced.
  *
  * @param type The message type.
  * @param cloudServiceHandle An opaque pointer to the underlying cloud service handle.
@@ -489,7 +936,8 @@ void ADUC_D2C_Messaging_Uninit()
  * @param statusChangedCallback A optional callback to be called when the messages status has changed.
  * @param userData An additional user data.
  *
- * @return Returns true if message successfully added to the pending-messages queue.
+ * @return Returns true if message successfully added to the pending-messages queue. If too many messages of @p type
+ *         were submitted since the last ADUC_D2C_Messaging_DoWork(), the newest one replaces the last unaccepted one.
  */
 bool ADUC_D2C_Message_SendAsync(
     ADUC_D2C_Message_Type type,
@@ -511,30 +959,64 @@ bool ADUC_D2C_Message_SendAsync(
     {
         return false;
     }
-    pthread_mutex_lock(&s_pendingMessageStoreMutex);
 
-    // Replace pending message if exist.
-    if (s_pendingMessageStore[type].content != NULL)
+    return ADUC_D2C_Message_SendOwnedAsync(
+        type, cloudServiceHandle, messageToSend, responseCallback, completedCallback, statusChangedCallback, userData);
+}
+
+/**
+ * @brief Same as ADUC_D2C_Message_SendAsync(), but the messaging utility takes ownership of @p message instead of
+ * copying it, so a caller that builds the content in a heap buffer doesn't pay for a second copy.
+ *
+ * @param type The message type.
+ * @param cloudServiceHandle An opaque pointer to the underlying cloud service handle.
+ * @param message The required, malloc'd message content. Ownership is transferred to the messaging utility, even
+ *                when this function fails.
+ * @param responseCallback A optional callback to be called when the device received a http response.
+ * @param completedCallback An optional callback to be called when the messages processor stopped processing the message.
+ * @param statusChangedCallback A optional callback to be called when the messages status has changed.
+ * @param userData An additional user data.
+ *
+ * @return Returns true if message successfully added to the pending-messages queue.
+ */
+bool ADUC_D2C_Message_SendOwnedAsync(
+    ADUC_D2C_Message_Type type,
+    void* cloudServiceHandle,
+    char* message,
+    ADUC_D2C_MESSAGE_HTTP_RESPONSE_CALLBACK responseCallback,
+    ADUC_D2C_MESSAGE_COMPLETED_CALLBACK completedCallback,
+    ADUC_D2C_MESSAGE_STATUS_CHANGED_CALLBACK statusChangedCallback,
+    void* userData)
+{
+    if (message == NULL)
     {
-        if (s_pendingMessageStore[type].completedCallback != NULL)
-        {
-            Log_Debug("Replacing existing pending message. (t:%d, s:%s)", type, s_pendingMessageStore[type].content);
-            OnMessageProcessingCompleted(&s_pendingMessageStore[type], ADUC_D2C_Message_Status_Replaced);
-        }
+        Log_Error("message is NULL");
+        return false;
     }
 
     Log_Debug("Queueing message (t:%d, c:0x%x, m:%s)", type, message, message);
-    memset(&s_pendingMessageStore[type], 0, sizeof(s_pendingMessageStore[0]));
-    s_pendingMessageStore[type].cloudServiceHandle = cloudServiceHandle;
-    s_pendingMessageStore[type].originalContent = message;
-    s_pendingMessageStore[type].content = messageToSend;
-    s_pendingMessageStore[type].responseCallback = responseCallback;
-    s_pendingMessageStore[type].completedCallback = completedCallback;
-    s_pendingMessageStore[type].statusChangedCallback = statusChangedCallback;
-    s_pendingMessageStore[type].contentSubmitTime = GetTimeSinceEpochInSeconds();
-    s_pendingMessageStore[type].userData = userData;
-    SetMessageStatus(&s_pendingMessageStore[type], ADUC_D2C_Message_Status_Pending);
-    pthread_mutex_unlock(&s_pendingMessageStoreMutex);
+    ADUC_D2C_Message newMessage;
+    memset(&newMessage, 0, sizeof(newMessage));
+    newMessage.cloudServiceHandle = cloudServiceHandle;
+    newMessage.originalContent = message;
+    newMessage.content = message;
+    newMessage.responseCallback = responseCallback;
+    newMessage.completedCallback = completedCallback;
+    newMessage.statusChangedCallback = statusChangedCallback;
+    newMessage.contentSubmitTime = GetTimeSinceEpochInSeconds();
+    newMessage.contentSubmitTimeMs = ADUC_Timing_GetMonotonicTimeMs();
+    newMessage.userData = userData;
+
+    // The Pending status is reported once the message is accepted into the pending queue.
+    // While an overflow message waits, newer messages replace it instead of overtaking it through the ring.
+    if (D2C_ATOMIC_LOAD(&s_incomingMessages[type].hasOverflowMessage)
+        || !IncomingMessageRing_Push(&s_incomingMessages[type], &newMessage))
+    {
+        IncomingMessageRing_PushOverflow(&s_incomingMessages[type], &newMessage);
+    }
+
+    // Messages are often queued by worker threads; have the main loop send it now.
+    ADUC_Wakeup_Signal();
     return true;
 }
 
@@ -612,3 +1094,18 @@ void ADUC_D2C_Messaging_Set_Retry_Strategy(ADUC_D2C_Message_Type type, ADUC_D2C_
     s_messageProcessingContext[type].retryStrategy = strategy;
     pthread_mutex_unlock(&s_messageProcessingContext[type].mutex);
 }
+
+/**
+ * @brief Enables or disables coalescing of pending messages for the specified @p type. Disabled by default.
+ * Only enable it for types whose messages are reported property patches (JSON merge patches).
+ *
+ * @param type The message type.
+ * @param enabled Whether consecutive pending messages are merged into a single reported property patch.
+ */
+void ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type type, bool enabled)
+{
+    pthread_mutex_lock(&s_messageProcessingContext[type].mutex);
+    s_messageProcessingContext[type].coalescingEnabled = enabled;
+    D2C_ATOMIC_STORE(&s_incomingMessages[type].coalescingEnabled, enabled ? 1 : 0);
+    pthread_mutex_unlock(&s_messageProcessingContext[type].mutex);
+}
@@ -4,9 +4,14 @@
 #include "aduc/d2c_messaging.h"
 #include "aduc/retry_utils.h"
 
+#include <atomic>
 #include <catch2/catch.hpp>
+#include <parson.h>
 #include <stdexcept> // runtime_error
 #include <string.h>
+#include <string>
+#include <thread>
+#include <vector>
 
 #include <aducpal/time.h> // nanosleep
 
@@ -620,9 +625,10 @@ TEST_CASE("Bad http status retry info", "[.][functional]")
 
 // Send message #1 message (service will took 5 seconds to process)
 // Wait for 2 seconds to ensure that message# 1 is in progress, then send message #2 and #3 back to back.
+// Message #2 and #3 are not JSON, so they cannot be coalesced and are sent in order.
 // Expected result:
 //     msg#1 success
-//     msg#2 replaced
+//     msg#2 success
 //     msg#3 success
 
 TEST_CASE("Message replacement test", "[.][functional]")
@@ -695,7 +701,7 @@ TEST_CASE("Message replacement test", "[.][functional]")
     g_cloudServiceMutex.unlock();
 
     CHECK(message1FinalStatus == ADUC_D2C_Message_Status_Success);
-    CHECK(message2FinalStatus == ADUC_D2C_Message_Status_Replaced);
+    CHECK(message2FinalStatus == ADUC_D2C_Message_Status_Success);
     CHECK(message3FinalStatus == ADUC_D2C_Message_Status_Success);
 
     // Done
@@ -765,3 +771,312 @@ TEST_CASE("30 retries - httpStatus 401", "[.][functional]")
     ADUC_D2C_Messaging_Uninit();
     g_testCaseSyncMutex.unlock();
 }
+
+static std::vector<std::string> g_sentContents;
+static ADUC_D2C_Message_Processing_Context* g_awaitingResponseContext = nullptr;
+static ADUC_C2D_RESPONSE_HANDLER_FUNCTION g_awaitingResponseHandler = nullptr;
+
+/**
+ * A mock transport function that records the message and leaves it waiting for RespondToSentMessage().
+ */
+static int CapturingMessageTransportFunc(
+    void* cloudServiceHandle, void* context, ADUC_C2D_RESPONSE_HANDLER_FUNCTION c2dResponseHandlerFunc)
+{
+    UNREFERENCED_PARAMETER(cloudServiceHandle);
+    auto message_processing_context = static_cast<ADUC_D2C_Message_Processing_Context*>(context);
+    g_sentContents.emplace_back(message_processing_context->message.content);
+    g_awaitingResponseContext = message_processing_context;
+    g_awaitingResponseHandler = c2dResponseHandlerFunc;
+    MockSetMessageStatus(&message_processing_context->message, ADUC_D2C_Message_Status_Waiting_For_Response);
+    return 0;
+}
+
+static void RespondToSentMessage(int httpStatus)
+{
+    REQUIRE(g_awaitingResponseHandler != nullptr);
+    auto handler = g_awaitingResponseHandler;
+    g_awaitingResponseHandler = nullptr;
+    handler(httpStatus, g_awaitingResponseContext);
+}
+
+static bool JsonEquals(const std::string& actual, const char* expected)
+{
+    JSON_Value* actualValue = json_parse_string(actual.c_str());
+    JSON_Value* expectedValue = json_parse_string(expected);
+    bool equals = actualValue != nullptr && expectedValue != nullptr && json_value_equals(actualValue, expectedValue);
+    json_value_free(actualValue);
+    json_value_free(expectedValue);
+    return equals;
+}
+
+static void SendStatusTrackedMessage(const char* message, ADUC_D2C_Message_Status* finalStatus)
+{
+    static auto handle = reinterpret_cast<ADUC_ClientHandle>(-1); // We don't need real handle.
+    REQUIRE(ADUC_D2C_Message_SendAsync(
+        ADUC_D2C_Message_Type_Device_Update_Result,
+        &handle,
+        message,
+        nullptr /* responseCallback */,
+        OnMessageProcessCompleted_SaveStatus,
+        nullptr /* statusChangedCallback */,
+        finalStatus));
+}
+
+TEST_CASE("Pending messages queue")
+{
+    g_testCaseSyncMutex.lock();
+    g_sentContents.clear();
+
+    ADUC_D2C_Message_Status status1 = ADUC_D2C_Message_Status_Pending;
+    ADUC_D2C_Message_Status status2 = ADUC_D2C_Message_Status_Pending;
+    ADUC_D2C_Message_Status status3 = ADUC_D2C_Message_Status_Pending;
+
+    REQUIRE(ADUC_D2C_Messaging_Init());
+    ADUC_D2C_Messaging_Set_Transport(ADUC_D2C_Message_Type_Device_Update_Result, CapturingMessageTransportFunc);
+    ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type_Device_Update_Result, true);
+
+    SECTION("Reported property patches are coalesced while a message is in flight")
+    {
+        SendStatusTrackedMessage(R"({"du":{"__t":"c","agent":{"state":1,"a":[1,2]}}})", &status1);
+        ADUC_D2C_Messaging_DoWork();
+        REQUIRE(g_sentContents.size() == 1);
+
+        SendStatusTrackedMessage(R"({"du":{"__t":"c","agent":{"state":2,"a":[3],"b":"x"}}})", &status2);
+        SendStatusTrackedMessage(R"({"du":{"__t":"c","agent":{"state":3,"c":null}},"other":true})", &status3);
+
+        // Nothing is sent until the in-flight message is acknowledged.
+        ADUC_D2C_Messaging_DoWork();
+        CHECK(g_sentContents.size() == 1);
+        CHECK(status2 == ADUC_D2C_Message_Status_Replaced);
+        CHECK(ADUC_D2C_Messaging_HasInFlightMessages());
+
+        RespondToSentMessage(200);
+        CHECK(status1 == ADUC_D2C_Message_Status_Success);
+
+        ADUC_D2C_Messaging_DoWork();
+        REQUIRE(g_sentContents.size() == 2);
+        CHECK(JsonEquals(
+            g_sentContents[1], R"({"du":{"__t":"c","agent":{"state":3,"a":[3],"b":"x","c":null}},"other":true})"));
+
+        RespondToSentMessage(200);
+        CHECK(status3 == ADUC_D2C_Message_Status_Success);
+        CHECK_FALSE(ADUC_D2C_Messaging_HasInFlightMessages());
+    }
+
+    SECTION("Patches that cannot be combined are sent in order")
+    {
+        SendStatusTrackedMessage(R"({"du":{"agent":1}})", &status1);
+        ADUC_D2C_Messaging_DoWork();
+
+        // Replacing a non-object with an object cannot be expressed as a single patch.
+        SendStatusTrackedMessage(R"({"du":{"agent":null}})", &status2);
+        SendStatusTrackedMessage(R"({"du":{"agent":{"state":1}}})", &status3);
+
+        RespondToSentMessage(200);
+        ADUC_D2C_Messaging_DoWork();
+        RespondToSentMessage(200);
+        ADUC_D2C_Messaging_DoWork();
+        RespondToSentMessage(200);
+
+        REQUIRE(g_sentContents.size() == 3);
+        CHECK(JsonEquals(g_sentContents[1], R"({"du":{"agent":null}})"));
+        CHECK(JsonEquals(g_sentContents[2], R"({"du":{"agent":{"state":1}}})"));
+        CHECK(status2 == ADUC_D2C_Message_Status_Success);
+        CHECK(status3 == ADUC_D2C_Message_Status_Success);
+    }
+
+    SECTION("Coalescing can be disabled")
+    {
+        ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type_Device_Update_Result, false);
+
+        SendStatusTrackedMessage(R"({"state":1})", &status1);
+        SendStatusTrackedMessage(R"({"state":2})", &status2);
+        SendStatusTrackedMessage(R"({"state":3})", &status3);
+
+        for (int i = 0; i < 3; ++i)
+        {
+            ADUC_D2C_Messaging_DoWork();
+            RespondToSentMessage(200);
+        }
+
+        REQUIRE(g_sentContents.size() == 3);
+        CHECK(JsonEquals(g_sentContents[0], R"({"state":1})"));
+        CHECK(JsonEquals(g_sentContents[1], R"({"state":2})"));
+        CHECK(JsonEquals(g_sentContents[2], R"({"state":3})"));
+        CHECK(status1 == ADUC_D2C_Message_Status_Success);
+        CHECK(status2 == ADUC_D2C_Message_Status_Success);
+        CHECK(status3 == ADUC_D2C_Message_Status_Success);
+    }
+
+    SECTION("Failed message waiting for retry is folded into the next one")
+    {
+        SendStatusTrackedMessage(R"({"a":1})", &status1);
+        ADUC_D2C_Messaging_DoWork();
+        RespondToSentMessage(500);
+
+        // Not completed, waiting for retry.
+        CHECK(status1 == ADUC_D2C_Message_Status_Pending);
+
+        SendStatusTrackedMessage(R"({"b":2})", &status2);
+        ADUC_D2C_Messaging_DoWork();
+
+        CHECK(status1 == ADUC_D2C_Message_Status_Replaced);
+        REQUIRE(g_sentContents.size() == 2);
+        CHECK(JsonEquals(g_sentContents[1], R"({"a":1,"b":2})"));
+
+        RespondToSentMessage(200);
+        CHECK(status2 == ADUC_D2C_Message_Status_Success);
+    }
+
+    ADUC_D2C_Messaging_Uninit();
+    g_testCaseSyncMutex.unlock();
+}
+
+TEST_CASE("Pending messages are not coalesced by default")
+{
+    g_testCaseSyncMutex.lock();
+    g_sentContents.clear();
+
+    ADUC_D2C_Message_Status status1 = ADUC_D2C_Message_Status_Pending;
+    ADUC_D2C_Message_Status status2 = ADUC_D2C_Message_Status_Pending;
+
+    REQUIRE(ADUC_D2C_Messaging_Init());
+    ADUC_D2C_Messaging_Set_Transport(ADUC_D2C_Message_Type_Device_Update_Result, CapturingMessageTransportFunc);
+
+    SendStatusTrackedMessage(R"({"a":1})", &status1);
+    SendStatusTrackedMessage(R"({"b":2})", &status2);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        ADUC_D2C_Messaging_DoWork();
+        RespondToSentMessage(200);
+    }
+
+    REQUIRE(g_sentContents.size() == 2);
+    CHECK(JsonEquals(g_sentContents[0], R"({"a":1})"));
+    CHECK(JsonEquals(g_sentContents[1], R"({"b":2})"));
+    CHECK(status1 == ADUC_D2C_Message_Status_Success);
+    CHECK(status2 == ADUC_D2C_Message_Status_Success);
+
+    ADUC_D2C_Messaging_Uninit();
+    g_testCaseSyncMutex.unlock();
+}
+
+TEST_CASE("Submissions beyond the incoming ring's capacity")
+{
+    g_testCaseSyncMutex.lock();
+    g_sentContents.clear();
+
+    // More than fit in the incoming ring, submitted without the main loop running.
+    const int messageCount = 40;
+    std::vector<ADUC_D2C_Message_Status> statuses(messageCount, ADUC_D2C_Message_Status_Pending);
+
+    REQUIRE(ADUC_D2C_Messaging_Init());
+    ADUC_D2C_Messaging_Set_Transport(ADUC_D2C_Message_Type_Device_Update_Result, CapturingMessageTransportFunc);
+
+    for (int i = 0; i < messageCount; ++i)
+    {
+        SendStatusTrackedMessage(("{\"state\":" + std::to_string(i) + "}").c_str(), &statuses[i]);
+    }
+
+    while (ADUC_D2C_Messaging_HasInFlightMessages())
+    {
+        ADUC_D2C_Messaging_DoWork();
+        RespondToSentMessage(200);
+    }
+
+    // The latest message replaces an earlier one instead of being dropped, and is sent last.
+    REQUIRE_FALSE(g_sentContents.empty());
+    CHECK(JsonEquals(g_sentContents.back(), R"({"state":39})"));
+    CHECK(statuses[messageCount - 1] == ADUC_D2C_Message_Status_Success);
+    CHECK(statuses[messageCount - 2] == ADUC_D2C_Message_Status_Replaced);
+
+    ADUC_D2C_Messaging_Uninit();
+    g_testCaseSyncMutex.unlock();
+}
+
+TEST_CASE("Concurrent submissions")
+{
+    g_testCaseSyncMutex.lock();
+    g_sentContents.clear();
+
+    const int producerCount = 4;
+    const int messagesPerProducer = 200;
+    static auto handle = reinterpret_cast<ADUC_ClientHandle>(-1); // We don't need real handle.
+
+    REQUIRE(ADUC_D2C_Messaging_Init());
+    ADUC_D2C_Messaging_Set_Transport(ADUC_D2C_Message_Type_Device_Update_Result, CapturingMessageTransportFunc);
+    ADUC_D2C_Messaging_Set_Coalescing(ADUC_D2C_Message_Type_Device_Update_Result, true);
+
+    std::atomic<int> runningProducers{ producerCount };
+    std::atomic<int> failedSubmissions{ 0 };
+    std::vector<std::thread> producers;
+    for (int p = 0; p < producerCount; ++p)
+    {
+        producers.emplace_back([p, &runningProducers, &failedSubmissions]() {
+            for (int i = 1; i <= messagesPerProducer; ++i)
+            {
+                std::string message = "{\"p" + std::to_string(p) + "\":" + std::to_string(i) + "}";
+                // While the ring is full, submissions are folded into its overflow message.
+                if (!ADUC_D2C_Message_SendAsync(
+                        ADUC_D2C_Message_Type_Device_Update_Result,
+                        &handle,
+                        message.c_str(),
+                        nullptr /* responseCallback */,
+                        nullptr /* completedCallback */,
+                        nullptr /* statusChangedCallback */,
+                        nullptr /* userData */))
+                {
+                    ++failedSubmissions;
+                }
+            }
+            --runningProducers;
+        });
+    }
+
+    // Act as the main loop: process and acknowledge until every submission has been sent.
+    while (runningProducers > 0 || ADUC_D2C_Messaging_HasInFlightMessages())
+    {
+        ADUC_D2C_Messaging_DoWork();
+        if (g_awaitingResponseHandler != nullptr)
+        {
+            RespondToSentMessage(200);
+        }
+    }
+
+    for (auto& producer : producers)
+    {
+        producer.join();
+    }
+
+    CHECK(failedSubmissions == 0);
+
+    // Applying the sent patches in order must yield each producer's last value.
+    JSON_Value* twin = json_value_init_object();
+    for (const auto& content : g_sentContents)
+    {
+        JSON_Value* patch = json_parse_string(content.c_str());
+        REQUIRE(patch != nullptr);
+        JSON_Object* patchObject = json_value_get_object(patch);
+        for (size_t i = 0; i < json_object_get_count(patchObject); ++i)
+        {
+            json_object_set_number(
+                json_value_get_object(twin),
+                json_object_get_name(patchObject, i),
+                json_value_get_number(json_object_get_value_at(patchObject, i)));
+        }
+        json_value_free(patch);
+    }
+
+    for (int p = 0; p < producerCount; ++p)
+    {
+        CHECK(
+            json_object_get_number(json_value_get_object(twin), ("p" + std::to_string(p)).c_str())
+            == messagesPerProducer);
+    }
+    CHECK(g_sentContents.size() < static_cast<size_t>(producerCount * messagesPerProducer));
+
+    json_value_free(twin);
+    ADUC_D2C_Messaging_Uninit();
+    g_testCaseSyncMutex.unlock();
+}
@@ -0,0 +1,153 @@
+/**
+ * @file hash_utils_benchmark.c
+ * @brief Micro-benchmark for file hashing in hash_utils.
+ *
+ * Usage: hash_utils_benchmark [sizeInMiB ...]
+ *
+ * Creates a synthetic file of each size (default 1, 64 and 512 MiB) in $TMPDIR (or /tmp),
+ * hashes it with each supported file digest algorithm and prints the best throughput of a few runs.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <aduc/c_utils.h> // for ARRAY_SIZE
+#include <aduc/hash_utils.h>
+#include <aduc/logging.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h> // for clock_gettime
+#include <unistd.h> // for close, unlink, write
+
+#define MIB (1024 * 1024)
+#define RUNS_PER_CASE 3
+
+static const unsigned int DefaultSizesInMiB[] = { 1, 64, 512 };
+
+static const struct
+{
+    SHAversion algorithm;
+    const char* name;
+} Algorithms[] = { { SHA256, "sha256" }, { SHA384, "sha384" }, { SHA512, "sha512" } };
+
+static double NowInSeconds(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (double)ts.tv_sec + ((double)ts.tv_nsec / 1e9);
+}
+
+/**
+ * @brief Creates a file of @p sizeInMiB MiB of pseudo-random content.
+ * @param path The path template for mkstemp. Receives the file path.
+ * @returns true on success.
+ */
+static bool CreateSyntheticFile(char* path, unsigned int sizeInMiB)
+{
+    bool success = false;
+    uint8_t* block = malloc(MIB);
+    int fd = mkstemp(path);
+
+    if (block == NULL || fd == -1)
+    {
+        goto done;
+    }
+
+    // xorshift32, so the content is not trivially compressible by the storage layer.
+    uint32_t state = 2463534242u;
+    for (size_t i = 0; i < MIB; ++i)
+    {
+        state ^= state << 13;
+        state ^= state >> 17;
+        state ^= state << 5;
+        block[i] = (uint8_t)state;
+    }
+
+    for (unsigned int i = 0; i < sizeInMiB; ++i)
+    {
+        block[0] = (uint8_t)i; // Vary every block.
+        if (write(fd, block, MIB) != MIB)
+        {
+            goto done;
+        }
+    }
+
+    success = true;
+
+done:
+    if (fd != -1)
+    {
+        close(fd);
+    }
+
+    free(block);
+    return success;
+}
+
+int main(int argc, char** argv)
+{
+    int ret = EXIT_FAILURE;
+    const char* tmpDir = getenv("TMPDIR");
+    size_t sizeCount = (argc > 1) ? (size_t)(argc - 1) : ARRAY_SIZE(DefaultSizesInMiB);
+
+    ADUC_Logging_Init(ADUC_LOG_ERROR, "hash-utils-benchmark");
+
+    printf("%-10s %-8s %12s %12s\n", "size(MiB)", "alg", "best(s)", "MiB/s");
+
+    for (size_t s = 0; s < sizeCount; ++s)
+    {
+        const unsigned int sizeInMiB =
+            (argc > 1) ? (unsigned int)strtoul(argv[s + 1], NULL, 10) : DefaultSizesInMiB[s];
+        char path[256];
+
+        snprintf(path, sizeof(path), "%s/hash_utils_benchmark_XXXXXX", (tmpDir != NULL) ? tmpDir : "/tmp");
+
+        if (sizeInMiB == 0 || !CreateSyntheticFile(path, sizeInMiB))
+        {
+            fprintf(stderr, "Cannot create a %u MiB test file.\n", sizeInMiB);
+            goto done;
+        }
+
+        for (size_t a = 0; a < ARRAY_SIZE(Algorithms); ++a)
+        {
+            double best = 0;
+
+            for (int run = 0; run < RUNS_PER_CASE; ++run)
+            {
+                char* hash = NULL;
+                const double start = NowInSeconds();
+                const bool hashed = ADUC_HashUtils_GetFileHash(path, Algorithms[a].algorithm, &hash);
+                const double elapsed = NowInSeconds() - start;
+                free(hash);
+
+                if (!hashed)
+                {
+                    fprintf(stderr, "Cannot hash %s.\n", path);
+                    unlink(path);
+                    goto done;
+                }
+
+                if (run == 0 || elapsed < best)
+                {
+                    best = elapsed;
+                }
+            }
+
+            printf(
+                "%-10u %-8s %12.4f %12.1f\n",
+                sizeInMiB,
+                Algorithms[a].name,
+                best,
+                (best > 0) ? ((double)sizeInMiB / best) : 0.0);
+        }
+
+        unlink(path);
+    }
+
+    ret = EXIT_SUCCESS;
+
+done:
+    ADUC_Logging_Uninit();
+    return ret;
+}
@@ -18,9 +18,30 @@
 
 EXTERN_C_BEGIN
 
+/**
+ * @brief The size of a buffer large enough to hold the base64 encoded digest of any supported
+ * algorithm, including the null-terminator (base64 of a SHA-512 digest is 88 chars).
+ */
+#define ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE 89
+
+/**
+ * @brief Environment variable with the path of the file in which verified file digests are persisted.
+ * Digests are kept in memory only unless it is set. The agent sets it at startup, so that every module's
+ * copy of hash_utils in the agent process shares the file.
+ */
+#define ADUC_DIGEST_CACHE_FILE_ENV "ADUC_DIGEST_CACHE_FILE"
+
+/**
+ * @brief Opaque handle to an incremental hash computation.
+ */
+typedef void* ADUC_HashStreamHandle;
+
 bool ADUC_HashUtils_IsValidFileHash(
     const char* path, const char* hashBase64, SHAversion algorithm, bool suppressErrorLog);
 
+bool ADUC_HashUtils_IsValidFileHashUncached(
+    const char* path, const char* hashBase64, SHAversion algorithm, bool suppressErrorLog);
+
 bool ADUC_HashUtils_IsValidBufferHash(
     const uint8_t* buffer, size_t bufferLen, const char* hashBase64, SHAversion algorithm);
 
@@ -28,6 +49,8 @@ bool ADUC_HashUtils_GetShaVersionForTypeString(const char* hashTypeStr, SHAversi
 
 bool ADUC_HashUtils_GetFileHash(const char* path, SHAversion algorithm, char** hash);
 
+bool ADUC_HashUtils_GetFileHashUncached(const char* path, SHAversion algorithm, char** hash);
+
 /**
  * @brief Get file hash type at specified index.
  * @param hashArray The ADUC_Hash array.
@@ -72,6 +95,7 @@ void ADUC_Hash_FreeArray(size_t hashCount, ADUC_Hash* hashArray);
 
 /**
  * @brief For the given array of ADUC_Hash, it will verify that the hash of the file contents matches the strongest hash in the array.
+ * The file is always read, without the digest cache.
  *
  * @param filePath The path to the file with contents to hash.
  * @param hashes The array of ADUC_Hash objects.
@@ -80,6 +104,44 @@ void ADUC_Hash_FreeArray(size_t hashCount, ADUC_Hash* hashArray);
  */
 bool ADUC_HashUtils_VerifyWithStrongestHash(const char* filePath, const ADUC_Hash* hashes, size_t hashCount);
 
+/**
+ * @brief Creates an incremental hash computation for @p algorithm.
+ * @details Lets a producer (e.g. a downloader) hash data from the same buffers it writes to disk,
+ * so the resulting file does not need to be read back to be verified.
+ *
+ * @param algorithm The hashing algorithm to use.
+ * @return ADUC_HashStreamHandle The handle, or NULL on failure. Caller must call ADUC_HashUtils_HashStream_Free().
+ */
+ADUC_HashStreamHandle ADUC_HashUtils_HashStream_Create(SHAversion algorithm);
+
+/**
+ * @brief Adds @p bufferLen bytes from @p buffer to the hash computation.
+ *
+ * @param handle The hash stream handle.
+ * @param buffer The data to hash.
+ * @param bufferLen The length of @p buffer.
+ * @return bool true on success.
+ */
+bool ADUC_HashUtils_HashStream_Update(ADUC_HashStreamHandle handle, const uint8_t* buffer, size_t bufferLen);
+
+/**
+ * @brief Finalizes the hash computation and writes the base64 encoded digest to @p hashBase64.
+ * @details No more data can be added to the stream after this call.
+ *
+ * @param handle The hash stream handle.
+ * @param hashBase64 The output buffer for the null-terminated, base64 encoded digest.
+ * @param hashBase64Size The size of @p hashBase64. ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE is always large enough.
+ * @return bool true on success.
+ */
+bool ADUC_HashUtils_HashStream_GetResult(ADUC_HashStreamHandle handle, char* hashBase64, size_t hashBase64Size);
+
+/**
+ * @brief Frees the hash stream.
+ *
+ * @param handle The hash stream handle. May be NULL.
+ */
+void ADUC_HashUtils_HashStream_Free(ADUC_HashStreamHandle handle);
+
 /**
  * @brief Whether the hash algorithm is valid.
  *
@@ -88,6 +150,14 @@ bool ADUC_HashUtils_VerifyWithStrongestHash(const char* filePath, const ADUC_Has
  */
 bool ADUC_HashUtils_IsValidHashAlgorithm(SHAversion sha);
 
+/**
+ * @brief Overrides the file in which verified file digests are persisted, ignoring ADUC_DIGEST_CACHE_FILE_ENV.
+ * Used by unit tests.
+ *
+ * @param filePath The cache file path, or NULL to keep the cache in memory only.
+ */
+void ADUC_HashUtils_SetDigestCacheFilePath(const char* filePath);
+
 EXTERN_C_END
 
 #endif // ADUC_HASH_UTILS_H
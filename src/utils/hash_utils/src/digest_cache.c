@@ -0,0 +1,535 @@
+/**
+ * @file digest_cache.c
+ * @brief Implements the cache of file digests that were already computed.
+ *
+ * The cache holds a small, bounded number of entries. If ADUC_DIGEST_CACHE_FILE_ENV is set, it is persisted to
+ * that file, so that digests survive agent restarts and are shared with extensions that link their own copy of
+ * hash_utils.
+ * The persisted file is only trusted if it is a regular file owned by the effective user and accessible by it only.
+ * New entries are appended to it; it is rewritten with the current entries only once it has grown too long.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "digest_cache.h"
+
+#include "aduc/hash_utils.h" // for ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE
+
+#include <inttypes.h> // for PRIu64, SCNu64
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h> // for free, getenv, mkstemp
+#include <string.h>
+#include <time.h> // for time
+
+#include <aducpal/sys_stat.h> // for stat
+
+#if !defined(WIN32)
+#    include <fcntl.h> // for open, fcntl
+#    include <unistd.h> // for close, geteuid
+#endif
+
+#include <azure_c_shared_utility/crt_abstractions.h> // for mallocAndStrcpy_s
+
+#include <aduc/logging.h>
+#include <aduc/string_c_utils.h> // for ADUC_StringFormat
+
+/**
+ * @brief The maximum number of cached digests. The oldest entry is evicted first.
+ */
+#define DIGEST_CACHE_MAX_ENTRIES 128
+
+/**
+ * @brief An entry is only trusted if it was stored at least this many seconds after the file's last change.
+ * File timestamps have coarse granularity, so a file modified right after its digest was stored may still
+ * carry the same mtime and ctime.
+ */
+#define DIGEST_CACHE_RACY_WINDOW_SECONDS 2
+
+/**
+ * @brief Once the persisted file has this many entry lines, it is rewritten with the current entries only.
+ */
+#define DIGEST_CACHE_MAX_FILE_LINES (2 * DIGEST_CACHE_MAX_ENTRIES)
+
+static const char* DigestCacheFileHeader = "# ADU digest cache v2";
+
+typedef struct tagADUC_DigestCacheEntry
+{
+    ADUC_DigestCacheKey key; //!< The file version.
+    int64_t storedAtSec; //!< The wall clock time at which the entry was stored.
+    char digestBase64[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE]; //!< The digest.
+} ADUC_DigestCacheEntry;
+
+static pthread_mutex_t s_cacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static ADUC_DigestCacheEntry s_entries[DIGEST_CACHE_MAX_ENTRIES];
+static size_t s_entryCount = 0;
+
+static bool s_filePathInitialized = false;
+static char* s_filePath = NULL;
+
+// Identity of the persisted file content that s_entries was last synchronized with.
+static ADUC_DigestCacheKey s_loadedFileKey;
+
+// Number of entry lines in the persisted file, as of s_loadedFileKey.
+static size_t s_fileLineCount = 0;
+
+static bool IsSameFileVersion(const ADUC_DigestCacheKey* a, const ADUC_DigestCacheKey* b)
+{
+    return a->dev == b->dev && a->ino == b->ino && a->size == b->size && a->mtimeSec == b->mtimeSec
+        && a->mtimeNsec == b->mtimeNsec && a->ctimeSec == b->ctimeSec && a->ctimeNsec == b->ctimeNsec;
+}
+
+static bool IsSameFile(const ADUC_DigestCacheKey* a, const ADUC_DigestCacheKey* b)
+{
+    return a->dev == b->dev && a->ino == b->ino;
+}
+
+/**
+ * @brief Gets the persisted file path, reading ADUC_DIGEST_CACHE_FILE_ENV on first use. Caller holds s_cacheMutex.
+ * @return const char* The path, or NULL if digests are kept in memory only.
+ */
+static const char* GetFilePath(void)
+{
+    if (!s_filePathInitialized)
+    {
+        const char* filePath = getenv(ADUC_DIGEST_CACHE_FILE_ENV);
+
+        s_filePathInitialized = true;
+        if (filePath != NULL && *filePath != '\0' && mallocAndStrcpy_s(&s_filePath, filePath) != 0)
+        {
+            s_filePath = NULL;
+        }
+    }
+
+    return s_filePath;
+}
+
+#if !defined(WIN32)
+/**
+ * @brief Fills @p key from the status @p st of a file.
+ */
+static void SetKeyFromStat(const struct stat* st, SHAversion algorithm, ADUC_DigestCacheKey* key)
+{
+    memset(key, 0, sizeof(*key));
+    key->dev = (uint64_t)st->st_dev;
+    key->ino = (uint64_t)st->st_ino;
+    key->size = (int64_t)st->st_size;
+    key->mtimeSec = (int64_t)st->st_mtim.tv_sec;
+    key->mtimeNsec = (int64_t)st->st_mtim.tv_nsec;
+    key->ctimeSec = (int64_t)st->st_ctim.tv_sec;
+    key->ctimeNsec = (int64_t)st->st_ctim.tv_nsec;
+    key->algorithm = (int)algorithm;
+}
+#endif
+
+bool ADUC_DigestCache_GetKey(const char* path, SHAversion algorithm, ADUC_DigestCacheKey* key)
+{
+#if defined(WIN32)
+    UNREFERENCED_PARAMETER(path);
+    UNREFERENCED_PARAMETER(algorithm);
+    UNREFERENCED_PARAMETER(key);
+
+    // No nanosecond ctime; don't cache.
+    return false;
+#else
+    struct stat st;
+
+    if (path == NULL || stat(path, &st) != 0 || !S_ISREG(st.st_mode))
+    {
+        return false;
+    }
+
+    SetKeyFromStat(&st, algorithm, key);
+    return true;
+#endif
+}
+
+#if !defined(WIN32)
+/**
+ * @brief Whether the persisted file can be trusted: only the effective user, or root, can have written it.
+ */
+static bool IsTrustedCacheFile(const struct stat* st)
+{
+    return S_ISREG(st->st_mode) && st->st_uid == geteuid() && (st->st_mode & 07777) == (S_IRUSR | S_IWUSR);
+}
+
+/**
+ * @brief Opens the persisted file at @p filePath, if it can be trusted. Does not follow symbolic links.
+ *
+ * @param flags The open flags.
+ * @param mode The fdopen mode matching @p flags.
+ * @param[out] fileKey Receives the version of the opened file, trusted or not. Untouched if it cannot be opened.
+ * @return FILE* The file, or NULL if it cannot be opened or is not trusted.
+ */
+static FILE* OpenTrustedCacheFile(const char* filePath, int flags, const char* mode, ADUC_DigestCacheKey* fileKey)
+{
+    struct stat st;
+    FILE* file = NULL;
+
+    const int fd = open(filePath, flags | O_NOFOLLOW | O_CLOEXEC);
+    if (fd == -1)
+    {
+        return NULL;
+    }
+
+    if (fstat(fd, &st) != 0)
+    {
+        close(fd);
+        return NULL;
+    }
+
+    SetKeyFromStat(&st, SHA1, fileKey);
+
+    if (!IsTrustedCacheFile(&st))
+    {
+        Log_Warn("Ignoring digest cache file %s, which is not private to this user.", filePath);
+        close(fd);
+        return NULL;
+    }
+
+    file = fdopen(fd, mode);
+    if (file == NULL)
+    {
+        close(fd);
+    }
+
+    return file;
+}
+#endif
+
+/**
+ * @brief Adds @p newEntry to s_entries, replacing entries for older versions of the same file
+ * and evicting the oldest entry if full. Caller holds s_cacheMutex.
+ */
+static void InsertEntry(const ADUC_DigestCacheEntry* newEntry)
+{
+    const ADUC_DigestCacheKey* key = &newEntry->key;
+
+    // Drop entries for older versions of the same file, and any existing entry for this key.
+    size_t kept = 0;
+    for (size_t i = 0; i < s_entryCount; ++i)
+    {
+        const ADUC_DigestCacheKey* existing = &s_entries[i].key;
+        const bool isStale = IsSameFile(existing, key)
+            && (!IsSameFileVersion(existing, key) || existing->algorithm == key->algorithm);
+        if (!isStale)
+        {
+            s_entries[kept++] = s_entries[i];
+        }
+    }
+    s_entryCount = kept;
+
+    if (s_entryCount == DIGEST_CACHE_MAX_ENTRIES)
+    {
+        memmove(&s_entries[0], &s_entries[1], sizeof(s_entries[0]) * (DIGEST_CACHE_MAX_ENTRIES - 1));
+        --s_entryCount;
+    }
+
+    s_entries[s_entryCount++] = *newEntry;
+}
+
+/**
+ * @brief Writes @p entry as one line of the persisted file.
+ * @return bool true on success.
+ */
+static bool WriteEntry(FILE* file, const ADUC_DigestCacheEntry* entry)
+{
+    return fprintf(
+               file,
+               "%" PRIu64 " %" PRIu64 " %" PRId64 " %" PRId64 " %" PRId64 " %" PRId64 " %" PRId64 " %d %" PRId64
+               " %s\n",
+               entry->key.dev,
+               entry->key.ino,
+               entry->key.size,
+               entry->key.mtimeSec,
+               entry->key.mtimeNsec,
+               entry->key.ctimeSec,
+               entry->key.ctimeNsec,
+               entry->key.algorithm,
+               entry->storedAtSec,
+               entry->digestBase64)
+        > 0;
+}
+
+/**
+ * @brief Reloads s_entries from the persisted file if it changed since last synchronized. Caller holds s_cacheMutex.
+ * Entries of an untrusted file are ignored, and the in-memory entries are kept.
+ */
+static void ReloadFromFileIfChanged(void)
+{
+#if defined(WIN32)
+    // Digests are not cached on Windows.
+#else
+    const char* filePath = GetFilePath();
+    ADUC_DigestCacheKey fileKey;
+    FILE* file = NULL;
+    char line[256];
+
+    if (filePath == NULL || !ADUC_DigestCache_GetKey(filePath, SHA1, &fileKey))
+    {
+        return;
+    }
+
+    if (IsSameFileVersion(&fileKey, &s_loadedFileKey))
+    {
+        return;
+    }
+
+    file = OpenTrustedCacheFile(filePath, O_RDONLY, "r", &fileKey);
+
+    // Don't check this version of the file again, whether or not it can be used.
+    s_loadedFileKey = fileKey;
+
+    if (file == NULL)
+    {
+        return;
+    }
+
+    s_entryCount = 0;
+    s_fileLineCount = 0;
+
+    // Later lines supersede earlier ones, as entries are appended.
+    while (fgets(line, sizeof(line), file) != NULL)
+    {
+        ADUC_DigestCacheEntry entry;
+
+        if (line[0] == '#')
+        {
+            continue;
+        }
+
+        const int fields = sscanf(
+            line,
+            "%" SCNu64 " %" SCNu64 " %" SCNd64 " %" SCNd64 " %" SCNd64 " %" SCNd64 " %" SCNd64 " %d %" SCNd64 " %88s",
+            &entry.key.dev,
+            &entry.key.ino,
+            &entry.key.size,
+            &entry.key.mtimeSec,
+            &entry.key.mtimeNsec,
+            &entry.key.ctimeSec,
+            &entry.key.ctimeNsec,
+            &entry.key.algorithm,
+            &entry.storedAtSec,
+            entry.digestBase64);
+
+        if (fields == 10)
+        {
+            InsertEntry(&entry);
+        }
+
+        ++s_fileLineCount;
+    }
+
+    fclose(file);
+#endif
+}
+
+/**
+ * @brief Writes s_entries to the persisted file, replacing it atomically. Caller holds s_cacheMutex.
+ */
+static void PersistToFile(void)
+{
+#if defined(WIN32)
+    // Digests are not cached on Windows.
+#else
+    const char* filePath = GetFilePath();
+    char* tempFilePath = NULL;
+    FILE* file = NULL;
+    bool written = false;
+    int fd = -1;
+
+    if (filePath == NULL)
+    {
+        return;
+    }
+
+    tempFilePath = ADUC_StringFormat("%s.XXXXXX", filePath);
+    if (tempFilePath == NULL)
+    {
+        goto done;
+    }
+
+    // A new file with a unique name, so that other processes rewriting the cache cannot write to it,
+    // and nothing can be written through an existing file or link.
+    fd = mkstemp(tempFilePath);
+    if (fd != -1)
+    {
+        // The umask must not make the file unreadable for IsTrustedCacheFile.
+        if (fchmod(fd, S_IRUSR | S_IWUSR) == 0 && fcntl(fd, F_SETFD, FD_CLOEXEC) == 0)
+        {
+            file = fdopen(fd, "w");
+        }
+
+        if (file == NULL)
+        {
+            close(fd);
+            (void)remove(tempFilePath);
+        }
+    }
+
+    if (file == NULL)
+    {
+        Log_Debug("Cannot write digest cache file %s", tempFilePath);
+        goto done;
+    }
+
+    written = (fprintf(file, "%s\n", DigestCacheFileHeader) > 0);
+
+    for (size_t i = 0; written && i < s_entryCount; ++i)
+    {
+        written = WriteEntry(file, &s_entries[i]);
+    }
+
+    if (fclose(file) != 0)
+    {
+        written = false;
+    }
+
+    if (!written || rename(tempFilePath, filePath) != 0)
+    {
+        Log_Debug("Cannot persist digest cache file %s", filePath);
+        (void)remove(tempFilePath);
+        goto done;
+    }
+
+    // Don't re-read what we just wrote.
+    (void)ADUC_DigestCache_GetKey(filePath, SHA1, &s_loadedFileKey);
+    s_fileLineCount = s_entryCount;
+
+done:
+    free(tempFilePath);
+#endif
+}
+
+/**
+ * @brief Appends @p entry to the persisted file, or rewrites the file if it is missing, untrusted or too long.
+ * Caller holds s_cacheMutex, and already added @p entry to s_entries.
+ */
+static void AppendToFile(const ADUC_DigestCacheEntry* entry)
+{
+#if defined(WIN32)
+    UNREFERENCED_PARAMETER(entry);
+#else
+    const char* filePath = GetFilePath();
+    ADUC_DigestCacheKey fileKey;
+    struct stat st;
+    FILE* file = NULL;
+    bool written = false;
+
+    if (filePath == NULL)
+    {
+        return;
+    }
+
+    if (s_fileLineCount < DIGEST_CACHE_MAX_FILE_LINES)
+    {
+        file = OpenTrustedCacheFile(filePath, O_WRONLY | O_APPEND, "a", &fileKey);
+    }
+
+    if (file == NULL)
+    {
+        PersistToFile();
+        return;
+    }
+
+    written = WriteEntry(file, entry) && fflush(file) == 0;
+
+    // Don't re-read what we just wrote.
+    if (written && fstat(fileno(file), &st) == 0)
+    {
+        SetKeyFromStat(&st, SHA1, &s_loadedFileKey);
+        ++s_fileLineCount;
+    }
+
+    if (fclose(file) != 0 || !written)
+    {
+        Log_Debug("Cannot append to digest cache file %s", filePath);
+    }
+#endif
+}
+
+static const ADUC_DigestCacheEntry* FindEntry(const ADUC_DigestCacheKey* key)
+{
+    for (size_t i = 0; i < s_entryCount; ++i)
+    {
+        const ADUC_DigestCacheEntry* entry = &s_entries[i];
+        if (IsSameFileVersion(&entry->key, key) && entry->key.algorithm == key->algorithm)
+        {
+            // Stored too soon after the last change to tell the stored version from a later one.
+            if (entry->storedAtSec < key->ctimeSec + DIGEST_CACHE_RACY_WINDOW_SECONDS)
+            {
+                return NULL;
+            }
+
+            return entry;
+        }
+    }
+
+    return NULL;
+}
+
+bool ADUC_DigestCache_Lookup(const ADUC_DigestCacheKey* key, char* digestBase64, size_t digestBase64Size)
+{
+    bool found = false;
+
+    pthread_mutex_lock(&s_cacheMutex);
+
+    const ADUC_DigestCacheEntry* entry = FindEntry(key);
+    if (entry == NULL)
+    {
+        // Another process, or another module's copy of this cache, may have stored it.
+        ReloadFromFileIfChanged();
+        entry = FindEntry(key);
+    }
+
+    if (entry != NULL && strlen(entry->digestBase64) < digestBase64Size)
+    {
+        memcpy(digestBase64, entry->digestBase64, strlen(entry->digestBase64) + 1);
+        found = true;
+    }
+
+    pthread_mutex_unlock(&s_cacheMutex);
+
+    return found;
+}
+
+void ADUC_DigestCache_Store(const ADUC_DigestCacheKey* key, const char* digestBase64)
+{
+    if (digestBase64 == NULL || strlen(digestBase64) >= ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE)
+    {
+        return;
+    }
+
+    ADUC_DigestCacheEntry entry;
+    entry.key = *key;
+    entry.storedAtSec = (int64_t)time(NULL);
+    memcpy(entry.digestBase64, digestBase64, strlen(digestBase64) + 1);
+
+    pthread_mutex_lock(&s_cacheMutex);
+
+    ReloadFromFileIfChanged();
+    InsertEntry(&entry);
+    AppendToFile(&entry);
+
+    pthread_mutex_unlock(&s_cacheMutex);
+}
+
+void ADUC_DigestCache_SetFilePath(const char* filePath)
+{
+    pthread_mutex_lock(&s_cacheMutex);
+
+    free(s_filePath);
+    s_filePath = NULL;
+    s_filePathInitialized = true;
+
+    if (filePath != NULL && mallocAndStrcpy_s(&s_filePath, filePath) != 0)
+    {
+        s_filePath = NULL;
+    }
+
+    s_entryCount = 0;
+    s_fileLineCount = 0;
+    memset(&s_loadedFileKey, 0, sizeof(s_loadedFileKey));
+
+    pthread_mutex_unlock(&s_cacheMutex);
+}
@@ -0,0 +1,60 @@
+/**
+ * @file digest_cache.h
+ * @brief Cache of file digests that were already computed, keyed by file identity and change times.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#ifndef DIGEST_CACHE_H
+#define DIGEST_CACHE_H
+
+#include <aduc/c_utils.h>
+#include <azure_c_shared_utility/sha.h> // for SHAversion
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief Identifies a specific version of a file's content.
+ * Any write to the file changes its ctime, so a matching key means the content was not modified.
+ */
+typedef struct tagADUC_DigestCacheKey
+{
+    uint64_t dev; //!< The device of the file.
+    uint64_t ino; //!< The inode of the file.
+    int64_t size; //!< The size of the file.
+    int64_t mtimeSec; //!< The modification time, seconds.
+    int64_t mtimeNsec; //!< The modification time, nanoseconds.
+    int64_t ctimeSec; //!< The status change time, seconds.
+    int64_t ctimeNsec; //!< The status change time, nanoseconds.
+    int algorithm; //!< The SHAversion of the digest.
+} ADUC_DigestCacheKey;
+
+/**
+ * @brief Gets the cache key of the file at @p path.
+ * @returns bool true on success. false if the file cannot be stat'ed or caching is not supported.
+ */
+bool ADUC_DigestCache_GetKey(const char* path, SHAversion algorithm, ADUC_DigestCacheKey* key);
+
+/**
+ * @brief Looks up the base64 encoded digest for @p key.
+ * @returns bool true if found and copied to @p digestBase64.
+ */
+bool ADUC_DigestCache_Lookup(const ADUC_DigestCacheKey* key, char* digestBase64, size_t digestBase64Size);
+
+/**
+ * @brief Stores the base64 encoded digest for @p key, replacing entries for older versions of the same file.
+ */
+void ADUC_DigestCache_Store(const ADUC_DigestCacheKey* key, const char* digestBase64);
+
+/**
+ * @brief Sets the file in which the cache is persisted. NULL keeps the cache in memory only.
+ */
+void ADUC_DigestCache_SetFilePath(const char* filePath);
+
+EXTERN_C_END
+
+#endif // DIGEST_CACHE_H
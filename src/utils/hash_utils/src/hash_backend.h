@@ -0,0 +1,54 @@
+/**
+ * @file hash_backend.h
+ * @brief Digest backend used by hash_utils. Selected at build time with ADUC_HASH_UTILS_BACKEND.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+
+#ifndef HASH_BACKEND_H
+#define HASH_BACKEND_H
+
+#include <aduc/c_utils.h>
+#include <azure_c_shared_utility/sha.h> // for SHAversion, USHAMaxHashSize
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief Opaque digest computation state of the backend.
+ */
+typedef struct tagADUC_HashBackendContext ADUC_HashBackendContext;
+
+/**
+ * @brief Creates a digest computation for @p algorithm.
+ * @param algorithm The hashing algorithm.
+ * @returns The context, or NULL on failure. Caller must call ADUC_HashBackend_Free().
+ */
+ADUC_HashBackendContext* ADUC_HashBackend_Create(SHAversion algorithm);
+
+/**
+ * @brief Adds @p bufferLen bytes from @p buffer to the digest computation.
+ * @returns true on success.
+ */
+bool ADUC_HashBackend_Update(ADUC_HashBackendContext* context, const uint8_t* buffer, size_t bufferLen);
+
+/**
+ * @brief Finalizes the digest computation.
+ * @param context The context.
+ * @param digest The output buffer of at least USHAMaxHashSize bytes.
+ * @param[out] digestLen The number of bytes written to @p digest.
+ * @returns true on success.
+ */
+bool ADUC_HashBackend_Final(ADUC_HashBackendContext* context, uint8_t* digest, size_t* digestLen);
+
+/**
+ * @brief Frees the context. @p context may be NULL.
+ */
+void ADUC_HashBackend_Free(ADUC_HashBackendContext* context);
+
+EXTERN_C_END
+
+#endif // HASH_BACKEND_H
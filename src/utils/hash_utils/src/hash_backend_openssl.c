@@ -0,0 +1,104 @@
+/**
+ * @file hash_backend_openssl.c
+ * @brief hash_utils digest backend using OpenSSL EVP, which uses the CPU's SHA extensions when available.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "hash_backend.h"
+
+#include <stdlib.h> // for calloc
+
+#include <openssl/evp.h>
+
+#include <aduc/logging.h>
+
+struct tagADUC_HashBackendContext
+{
+    EVP_MD_CTX* mdctx; //!< The OpenSSL digest context.
+};
+
+/**
+ * @brief Maps @p algorithm to the OpenSSL message digest.
+ * @returns The message digest, or NULL if not supported.
+ */
+static const EVP_MD* GetMessageDigest(SHAversion algorithm)
+{
+    switch (algorithm)
+    {
+    case SHA1:
+        return EVP_sha1();
+    case SHA224:
+        return EVP_sha224();
+    case SHA256:
+        return EVP_sha256();
+    case SHA384:
+        return EVP_sha384();
+    case SHA512:
+        return EVP_sha512();
+    default:
+        return NULL;
+    }
+}
+
+ADUC_HashBackendContext* ADUC_HashBackend_Create(SHAversion algorithm)
+{
+    ADUC_HashBackendContext* context = NULL;
+    const EVP_MD* md = GetMessageDigest(algorithm);
+
+    if (md == NULL)
+    {
+        Log_Error("Unsupported SHAversion: %d", algorithm);
+        goto done;
+    }
+
+    context = calloc(1, sizeof(*context));
+    if (context == NULL)
+    {
+        goto done;
+    }
+
+    context->mdctx = EVP_MD_CTX_new();
+    if (context->mdctx == NULL || EVP_DigestInit_ex(context->mdctx, md, NULL) != 1)
+    {
+        Log_Error("EVP_DigestInit_ex failed, SHAversion: %d", algorithm);
+        ADUC_HashBackend_Free(context);
+        context = NULL;
+        goto done;
+    }
+
+done:
+    return context;
+}
+
+bool ADUC_HashBackend_Update(ADUC_HashBackendContext* context, const uint8_t* buffer, size_t bufferLen)
+{
+    if (bufferLen == 0)
+    {
+        return true;
+    }
+
+    return EVP_DigestUpdate(context->mdctx, buffer, bufferLen) == 1;
+}
+
+bool ADUC_HashBackend_Final(ADUC_HashBackendContext* context, uint8_t* digest, size_t* digestLen)
+{
+    unsigned int len = 0;
+
+    if (EVP_DigestFinal_ex(context->mdctx, digest, &len) != 1)
+    {
+        return false;
+    }
+
+    *digestLen = len;
+    return true;
+}
+
+void ADUC_HashBackend_Free(ADUC_HashBackendContext* context)
+{
+    if (context != NULL)
+    {
+        EVP_MD_CTX_free(context->mdctx);
+        free(context);
+    }
+}
@@ -0,0 +1,74 @@
+/**
+ * @file hash_backend_usha.c
+ * @brief hash_utils digest backend using the portable USHA implementation from azure-c-shared-utility.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "hash_backend.h"
+
+#include <limits.h> // for UINT_MAX
+#include <stdlib.h> // for calloc
+
+#include <aduc/logging.h>
+
+struct tagADUC_HashBackendContext
+{
+    USHAContext context; //!< The SHA context.
+    SHAversion algorithm; //!< The hashing algorithm.
+};
+
+ADUC_HashBackendContext* ADUC_HashBackend_Create(SHAversion algorithm)
+{
+    ADUC_HashBackendContext* context = calloc(1, sizeof(*context));
+    if (context == NULL)
+    {
+        return NULL;
+    }
+
+    if (USHAReset(&context->context, algorithm) != 0)
+    {
+        Log_Error("Error in SHA Reset, SHAversion: %d", algorithm);
+        free(context);
+        return NULL;
+    }
+
+    context->algorithm = algorithm;
+    return context;
+}
+
+bool ADUC_HashBackend_Update(ADUC_HashBackendContext* context, const uint8_t* buffer, size_t bufferLen)
+{
+    // USHAInput takes an unsigned int length, so feed very large buffers in slices.
+    while (bufferLen > 0)
+    {
+        const unsigned int sliceLen = (bufferLen > UINT_MAX) ? UINT_MAX : (unsigned int)bufferLen;
+        if (USHAInput(&context->context, buffer, sliceLen) != 0)
+        {
+            Log_Error("Error in SHA Input, SHAversion: %d", context->algorithm);
+            return false;
+        }
+
+        buffer += sliceLen;
+        bufferLen -= sliceLen;
+    }
+
+    return true;
+}
+
+bool ADUC_HashBackend_Final(ADUC_HashBackendContext* context, uint8_t* digest, size_t* digestLen)
+{
+    if (USHAResult(&context->context, digest) != 0)
+    {
+        Log_Error("Error in SHA Result, SHAversion: %d", context->algorithm);
+        return false;
+    }
+
+    *digestLen = (size_t)USHAHashSize(context->algorithm);
+    return true;
+}
+
+void ADUC_HashBackend_Free(ADUC_HashBackendContext* context)
+{
+    free(context);
+}
@@ -6,9 +6,18 @@
  * Licensed under the MIT License.
  */
 #include "aduc/hash_utils.h"
+#include "digest_cache.h"
+#include "hash_backend.h"
 
-#include <stdio.h> // for FILE
-#include <stdlib.h> // for calloc
+#include <stdio.h> // for FILE, setvbuf
+#include <stdlib.h> // for calloc, malloc
+#include <string.h> // for memcpy, strrchr
+
+#if !defined(WIN32)
+#    include <errno.h> // for errno, EINTR
+#    include <fcntl.h> // for open, posix_fadvise
+#    include <unistd.h> // for read, close
+#endif
 
 #include <aducpal/strings.h> // strcasecmp
 
@@ -18,6 +27,13 @@
 #include <azure_c_shared_utility/sha.h>
 
 #include <aduc/logging.h>
+#include <aduc/timing_utils.h>
+
+/**
+ * @brief The size of the blocks read from a file being hashed.
+ * A large block keeps the per-read overhead negligible next to the digest computation.
+ */
+#define HASH_UTILS_FILE_READ_BLOCK_SIZE (2 * 1024 * 1024)
 
 /**
  * @brief Helper function gets the calculated hash from the @p context, compares it to @p hashBase64, and returns the appropriate value
@@ -28,14 +44,19 @@
  * @returns bool True if the hash is valid and equals @p hashBase64
  */
 static bool GetResultAndCompareHashes(
-    USHAContext* context, const char* hashBase64, SHAversion algorithm, bool suppressErrorLog, char** outputHash)
+    ADUC_HashBackendContext* context,
+    const char* hashBase64,
+    SHAversion algorithm,
+    bool suppressErrorLog,
+    char** outputHash)
 {
     bool success = false;
     // "USHAHashSize(algorithm)" is more precise, but requires a variable length array, or heap allocation.
     uint8_t buffer_hash[USHAMaxHashSize];
+    size_t hashSize = 0;
     STRING_HANDLE encoded_file_hash = NULL;
 
-    if (USHAResult(context, (uint8_t*)buffer_hash) != 0)
+    if (!ADUC_HashBackend_Final(context, buffer_hash, &hashSize))
     {
         if (!suppressErrorLog)
         {
@@ -44,7 +65,7 @@ static bool GetResultAndCompareHashes(
         goto done;
     }
 
-    encoded_file_hash = Azure_Base64_Encode_Bytes((unsigned char*)buffer_hash, (size_t)USHAHashSize(algorithm));
+    encoded_file_hash = Azure_Base64_Encode_Bytes((unsigned char*)buffer_hash, hashSize);
     if (encoded_file_hash == NULL)
     {
         if (!suppressErrorLog)
@@ -141,6 +162,7 @@ static bool ADUC_HashUtils_GetIndexStrongestValidHash(
 
 /**
  * @brief For the given array of ADUC_Hash, it will verify that the hash of the file contents matches the strongest hash in the array.
+ * The file is always read, without the digest cache, as this checks download handler libraries before loading them.
  *
  * @param filePath The path to the file with contents to hash.
  * @param hashes The array of ADUC_Hash objects.
@@ -160,7 +182,7 @@ bool ADUC_HashUtils_VerifyWithStrongestHash(const char* filePath, const ADUC_Has
     Log_Debug("Best hash index %d", indexStrongestAlgorithm);
 
     char* hashValue = ADUC_HashUtils_GetHashValue(hashes, hashCount, indexStrongestAlgorithm);
-    if (!ADUC_HashUtils_IsValidFileHash(filePath, hashValue, bestShaVersion, false))
+    if (!ADUC_HashUtils_IsValidFileHashUncached(filePath, hashValue, bestShaVersion, false))
     {
         return false;
     }
@@ -169,79 +191,321 @@ bool ADUC_HashUtils_VerifyWithStrongestHash(const char* filePath, const ADUC_Has
 }
 
 /**
- * @brief Checks if the hash of the file at @p path matches @p hashBase64
+ * @brief Sequential, block-wise reader of a file being hashed.
+ */
+typedef struct tagHashFileReader
+{
+#if defined(WIN32)
+    FILE* file; //!< The file.
+#else
+    int fd; //!< The file descriptor.
+    off_t lastBlockOffset; //!< The offset of the block returned by the previous read.
+    size_t lastBlockSize; //!< The size of the block returned by the previous read.
+#endif
+} HashFileReader;
+
+/**
+ * @brief Opens @p path for a single sequential pass.
+ * @returns bool true on success.
+ */
+static bool HashFileReader_Open(HashFileReader* reader, const char* path)
+{
+#if defined(WIN32)
+    reader->file = fopen(path, "rb");
+    if (reader->file == NULL)
+    {
+        return false;
+    }
+
+    // Reads go straight into our block-sized buffer, so stdio's own buffer would only add a copy.
+    if (setvbuf(reader->file, NULL, _IONBF, 0) != 0)
+    {
+        Log_Warn("Cannot disable stdio buffering for %s", path);
+    }
+#else
+    reader->fd = open(path, O_RDONLY | O_CLOEXEC);
+    if (reader->fd == -1)
+    {
+        return false;
+    }
+
+    reader->lastBlockOffset = 0;
+    reader->lastBlockSize = 0;
+
+    // Let the kernel read ahead aggressively. Failure only costs performance.
+    (void)posix_fadvise(reader->fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+
+    return true;
+}
+
+/**
+ * @brief Reads the next block of up to @p bufferSize bytes.
+ * The previously returned block must have been consumed, as its pages may be dropped from the page cache.
  *
- * @param path The path to the file to check
- * @param algorithm The hashing algorithm to use to calculate the hash.
- * @param hash [out] The pointer to output buffer. Caller must call free() when done with the returned buffer.
- * @return bool True if the hash data is successfully generated.
+ * @param reader The reader.
+ * @param buffer The output buffer.
+ * @param bufferSize The size of @p buffer.
+ * @param[out] readSize The number of bytes read. Zero at the end of the file.
+ * @returns bool true on success.
  */
-bool ADUC_HashUtils_GetFileHash(const char* path, SHAversion algorithm, char** hash)
+static bool HashFileReader_Read(HashFileReader* reader, uint8_t* buffer, size_t bufferSize, size_t* readSize)
 {
-    bool success = false;
-    FILE* file = NULL;
+#if defined(WIN32)
+    *readSize = fread(buffer, 1, bufferSize, reader->file);
+    return (*readSize != 0 || !ferror(reader->file));
+#else
+    // Verifying a large payload should not evict the working set of the rest of the system,
+    // so drop the pages that were already hashed.
+    if (reader->lastBlockSize > 0)
+    {
+        (void)posix_fadvise(reader->fd, reader->lastBlockOffset, (off_t)reader->lastBlockSize, POSIX_FADV_DONTNEED);
+        reader->lastBlockOffset += (off_t)reader->lastBlockSize;
+        reader->lastBlockSize = 0;
+    }
 
-    if (hash == NULL)
+    size_t total = 0;
+    while (total < bufferSize)
     {
-        Log_Error("Invalid input. 'hash' is NULL.");
-        goto done;
+        const ssize_t n = read(reader->fd, buffer + total, bufferSize - total);
+        if (n == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+            return false;
+        }
+
+        if (n == 0)
+        {
+            break;
+        }
+
+        total += (size_t)n;
     }
 
-    *hash = NULL;
+    reader->lastBlockSize = total;
+    *readSize = total;
+    return true;
+#endif
+}
+
+/**
+ * @brief Closes the reader.
+ */
+static void HashFileReader_Close(HashFileReader* reader)
+{
+#if defined(WIN32)
+    fclose(reader->file);
+#else
+    if (reader->lastBlockSize > 0)
+    {
+        (void)posix_fadvise(reader->fd, reader->lastBlockOffset, (off_t)reader->lastBlockSize, POSIX_FADV_DONTNEED);
+    }
+
+    close(reader->fd);
+#endif
+}
+
+/**
+ * @brief Reads the file at @p path in large blocks and feeds it to a new digest computation.
+ *
+ * @param path The path to the file to hash.
+ * @param algorithm The hashing algorithm to use to calculate the hash.
+ * @param suppressErrorLog A boolean indicates whether to log error message inside this function.
+ * @return ADUC_HashBackendContext* The context holding the digest of the file content, or NULL on failure.
+ * Caller must call ADUC_HashBackend_Free().
+ */
+static ADUC_HashBackendContext* HashFileContent(const char* path, SHAversion algorithm, bool suppressErrorLog)
+{
+    bool success = false;
+    bool isOpen = false;
+    HashFileReader reader;
+    uint8_t* buffer = NULL;
+    ADUC_HashBackendContext* context = NULL;
 
-    file = fopen(path, "rb");
-    if (file == NULL)
+    isOpen = HashFileReader_Open(&reader, path);
+    if (!isOpen)
     {
         // Sometime we call this function to check whether the file is already exist.
         // So, log info here instead of error.
-        Log_Info("No such file or directory: %s", path);
+        if (!suppressErrorLog)
+        {
+            Log_Info("No such file or directory: %s", path);
+        }
         goto done;
     }
 
-    USHAContext context;
+    buffer = malloc(HASH_UTILS_FILE_READ_BLOCK_SIZE);
+    if (buffer == NULL)
+    {
+        goto done;
+    }
 
-    if (USHAReset(&context, algorithm) != 0)
+    context = ADUC_HashBackend_Create(algorithm);
+    if (context == NULL)
     {
-        Log_Error("Error in SHA Reset, SHAversion: %d", algorithm);
         goto done;
-    };
+    }
 
     // Repeatedly read and hash chunks of the file
-    while (!feof(file))
+    for (;;)
     {
-        uint8_t buffer[USHA_Max_Message_Block_Size];
-        const size_t readSize = fread(buffer, sizeof(buffer[0]), ARRAY_SIZE(buffer), file);
-        if (readSize == 0)
+        size_t readSize = 0;
+        if (!HashFileReader_Read(&reader, buffer, HASH_UTILS_FILE_READ_BLOCK_SIZE, &readSize))
         {
-            if (ferror(file))
+            if (!suppressErrorLog)
             {
                 Log_Error("Error reading file content.");
-                goto done;
             }
+            goto done;
+        }
 
+        if (readSize == 0)
+        {
             // At the end of file. We're done here.
             break;
         }
 
-        if (USHAInput(&context, buffer, (unsigned int)readSize) != 0)
+        if (!ADUC_HashBackend_Update(context, buffer, readSize))
         {
-            Log_Error("Error in SHA Input, SHAversion: %d", algorithm);
+            if (!suppressErrorLog)
+            {
+                Log_Error("Error in SHA Input, SHAversion: %d", algorithm);
+            }
             goto done;
-        };
+        }
     }
 
-    success = GetResultAndCompareHashes(&context, NULL, algorithm, true, hash);
+    success = true;
 
 done:
+    if (!success)
+    {
+        ADUC_HashBackend_Free(context);
+        context = NULL;
+    }
+
+    free(buffer);
+
+    if (isOpen)
+    {
+        HashFileReader_Close(&reader);
+    }
+
+    return context;
+}
+
+/**
+ * @brief Gets the base64 encoded digest of the file at @p path, from the digest cache if the file is unchanged
+ * since its digest was last computed, otherwise by reading the file.
+ *
+ * @param path The path to the file.
+ * @param algorithm The hashing algorithm to use to calculate the hash.
+ * @param suppressErrorLog A boolean indicates whether to log error message inside this function.
+ * @param useCache Whether to use the digest cache. If false, the file is always read and the cache is not updated.
+ * @param hash [out] The digest. Caller must call free() when done with the returned buffer.
+ * @return bool True on success.
+ */
+static bool GetFileDigest(const char* path, SHAversion algorithm, bool suppressErrorLog, bool useCache, char** hash)
+{
+    bool success = false;
+    ADUC_HashBackendContext* context = NULL;
+    ADUC_DigestCacheKey keyBefore;
+    ADUC_DigestCacheKey keyAfter;
+    char cachedHash[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE];
+    ADUC_TimingSpan span;
+    bool isTimed = false;
+
+    const bool isCacheable = useCache && ADUC_DigestCache_GetKey(path, algorithm, &keyBefore);
+
+    if (isCacheable && ADUC_DigestCache_Lookup(&keyBefore, cachedHash, sizeof(cachedHash)))
+    {
+        Log_Debug("Using cached digest for %s", path);
+        success = (mallocAndStrcpy_s(hash, cachedHash) == 0);
+        goto done;
+    }
+
+    const char* fileName = strrchr(path, '/');
+    ADUC_Timing_BeginSpan(
+        &span,
+        ADUC_TIMING_PHASE_HASH,
+        fileName != NULL ? fileName + 1 : path,
+        ADUC_TIMING_NO_LEVEL,
+        ADUC_TIMING_NO_LEVEL);
+    isTimed = true;
 
-    if (file != NULL)
+    context = HashFileContent(path, algorithm, suppressErrorLog);
+    if (context == NULL)
     {
-        fclose(file);
+        goto done;
+    }
+
+    success = GetResultAndCompareHashes(context, NULL /* hashBase64 */, algorithm, suppressErrorLog, hash);
+
+    // Only remember the digest if the file was not modified while it was being read.
+    if (success && isCacheable && ADUC_DigestCache_GetKey(path, algorithm, &keyAfter)
+        && memcmp(&keyBefore, &keyAfter, sizeof(keyBefore)) == 0)
+    {
+        ADUC_DigestCache_Store(&keyBefore, *hash);
+    }
+
+done:
+    if (isTimed)
+    {
+        // Also ends the span when the file cannot be read, so the report shows the time spent on the failure.
+        ADUC_Timing_EndSpanInCurrentReport(&span);
     }
 
+    ADUC_HashBackend_Free(context);
     return success;
 }
 
+/**
+ * @brief Checks if the hash of the file at @p path matches @p hashBase64
+ *
+ * @param path The path to the file to check
+ * @param algorithm The hashing algorithm to use to calculate the hash.
+ * @param hash [out] The pointer to output buffer. Caller must call free() when done with the returned buffer.
+ * @return bool True if the hash data is successfully generated.
+ */
+bool ADUC_HashUtils_GetFileHash(const char* path, SHAversion algorithm, char** hash)
+{
+    if (hash == NULL)
+    {
+        Log_Error("Invalid input. 'hash' is NULL.");
+        return false;
+    }
+
+    *hash = NULL;
+
+    return GetFileDigest(path, algorithm, false /* suppressErrorLog */, true /* useCache */, hash);
+}
+
+/**
+ * @brief Gets the hash of the file at @p path, always reading the whole file.
+ * @details Neither consults nor updates the digest cache. Use it when the digest must reflect the file's bytes,
+ * e.g. to tell whether a re-downloaded file is unchanged.
+ *
+ * @param path The path to the file to hash.
+ * @param algorithm The hashing algorithm to use to calculate the hash.
+ * @param hash [out] The pointer to output buffer. Caller must call free() when done with the returned buffer.
+ * @return bool True if the hash data is successfully generated.
+ */
+bool ADUC_HashUtils_GetFileHashUncached(const char* path, SHAversion algorithm, char** hash)
+{
+    if (hash == NULL)
+    {
+        Log_Error("Invalid input. 'hash' is NULL.");
+        return false;
+    }
+
+    *hash = NULL;
+
+    return GetFileDigest(path, algorithm, false /* suppressErrorLog */, false /* useCache */, hash);
+}
+
 /**
  * @brief Get file hash type at specified index.
  * @param hashArray The ADUC_Hash array.
@@ -281,111 +545,229 @@ char* ADUC_HashUtils_GetHashValue(const ADUC_Hash* hashArray, size_t arraySize,
 }
 
 /**
- * @brief Checks if the hash of the file at @p path matches @p hashBase64
+ * @brief Checks if the digest of the file at @p path matches @p hashBase64.
  *
  * @param path The path to the file to check
  * @param hashBase64 The expected hash of the file at @p path
  * @param algorithm The hashing algorithm to use to calculate the hash.
  * @param suppressErrorLog A boolean indicates whether to log error message inside this function.
+ * @param useCache Whether to use the digest cache.
  * @return bool True if the hash is valid and matches @p hashBase64
  */
-bool ADUC_HashUtils_IsValidFileHash(
-    const char* path, const char* hashBase64, SHAversion algorithm, bool suppressErrorLog)
+static bool IsValidFileDigest(
+    const char* path, const char* hashBase64, SHAversion algorithm, bool suppressErrorLog, bool useCache)
 {
     bool success = false;
+    char* computedHash = NULL;
 
-    FILE* file = fopen(path, "rb");
-    if (file == NULL)
+    if (!GetFileDigest(path, algorithm, suppressErrorLog, useCache, &computedHash))
     {
-        if (!suppressErrorLog)
-        {
-            Log_Error("Cannot open file: %s", path);
-        }
         goto done;
     }
 
-    USHAContext context;
-
-    if (USHAReset(&context, algorithm) != 0)
+    if (hashBase64 != NULL && strcmp(hashBase64, computedHash) != 0)
     {
         if (!suppressErrorLog)
         {
-            Log_Error("Error in SHA Reset, SHAversion: %d", algorithm);
+            Log_Error("Invalid Hash, Expect: %s, Result: %s, SHAversion: %d", hashBase64, computedHash, algorithm);
         }
         goto done;
-    };
+    }
 
-    // Repeatedly read and hash chunks of the file
-    while (!feof(file))
-    {
-        uint8_t buffer[USHA_Max_Message_Block_Size];
-        const size_t readSize = fread(buffer, sizeof(buffer[0]), ARRAY_SIZE(buffer), file);
-        if (readSize == 0)
-        {
-            if (ferror(file))
-            {
-                if (!suppressErrorLog)
-                {
-                    Log_Error("Error reading file content.");
-                }
-                goto done;
-            }
+    success = true;
 
-            // At the end of file. We're done here.
-            break;
-        }
+done:
+    free(computedHash);
+    return success;
+}
 
-        if (USHAInput(&context, buffer, (unsigned int)readSize) != 0)
-        {
-            if (!suppressErrorLog)
-            {
-                Log_Error("Error in SHA Input, SHAversion: %d", algorithm);
-            }
-            goto done;
-        };
+/**
+ * @brief Checks if the hash of the file at @p path matches @p hashBase64
+ * @details A file that is unchanged since its digest was last computed is not read again.
+ *
+ * @param path The path to the file to check
+ * @param hashBase64 The expected hash of the file at @p path
+ * @param algorithm The hashing algorithm to use to calculate the hash.
+ * @param suppressErrorLog A boolean indicates whether to log error message inside this function.
+ * @return bool True if the hash is valid and matches @p hashBase64
+ */
+bool ADUC_HashUtils_IsValidFileHash(
+    const char* path, const char* hashBase64, SHAversion algorithm, bool suppressErrorLog)
+{
+    return IsValidFileDigest(path, hashBase64, algorithm, suppressErrorLog, true /* useCache */);
+}
+
+/**
+ * @brief Checks if the hash of the file at @p path matches @p hashBase64, always reading the whole file.
+ * @details Neither consults nor updates the digest cache. Use it to check the integrity of code before loading it.
+ *
+ * @param path The path to the file to check
+ * @param hashBase64 The expected hash of the file at @p path
+ * @param algorithm The hashing algorithm to use to calculate the hash.
+ * @param suppressErrorLog A boolean indicates whether to log error message inside this function.
+ * @return bool True if the hash is valid and matches @p hashBase64
+ */
+bool ADUC_HashUtils_IsValidFileHashUncached(
+    const char* path, const char* hashBase64, SHAversion algorithm, bool suppressErrorLog)
+{
+    return IsValidFileDigest(path, hashBase64, algorithm, suppressErrorLog, false /* useCache */);
+}
+
+void ADUC_HashUtils_SetDigestCacheFilePath(const char* filePath)
+{
+    ADUC_DigestCache_SetFilePath(filePath);
+}
+
+/**
+ * @brief Checks if the hash of the @p buffer matches @p hashBase64
+ *
+ * @param buffer The buffer to check
+ * @param bufferLen The length of the @p buffer
+ * @param hashBase64 The expected hash of the buffer @p buffer
+ * @return bool True if the hash is valid and matches @p hashBase64
+ */
+bool ADUC_HashUtils_IsValidBufferHash(
+    const uint8_t* buffer, size_t bufferLen, const char* hashBase64, SHAversion algorithm)
+{
+    bool success = false;
+
+    ADUC_HashBackendContext* context = ADUC_HashBackend_Create(algorithm);
+    if (context == NULL)
+    {
+        goto done;
     }
 
-    success = GetResultAndCompareHashes(&context, hashBase64, algorithm, suppressErrorLog, NULL /* outputHash */);
-    if (!success)
+    if (!ADUC_HashBackend_Update(context, buffer, bufferLen))
     {
+        Log_Error("Error in SHA Input, SHAversion: %d", algorithm);
         goto done;
     }
 
+    success = GetResultAndCompareHashes(context, hashBase64, algorithm, true, NULL);
+
 done:
-    if (file != NULL)
+    ADUC_HashBackend_Free(context);
+    return success;
+}
+
+/**
+ * @brief The state of an incremental hash computation.
+ */
+typedef struct tagADUC_HashStream
+{
+    ADUC_HashBackendContext* context; //!< The digest computation.
+    SHAversion algorithm; //!< The hashing algorithm.
+    bool finalized; //!< Whether the result was already computed.
+} ADUC_HashStream;
+
+/**
+ * @brief Creates an incremental hash computation for @p algorithm.
+ *
+ * @param algorithm The hashing algorithm to use.
+ * @return ADUC_HashStreamHandle The handle, or NULL on failure. Caller must call ADUC_HashUtils_HashStream_Free().
+ */
+ADUC_HashStreamHandle ADUC_HashUtils_HashStream_Create(SHAversion algorithm)
+{
+    ADUC_HashStream* stream = calloc(1, sizeof(*stream));
+    if (stream == NULL)
     {
-        fclose(file);
+        return NULL;
     }
 
-    return success;
+    stream->context = ADUC_HashBackend_Create(algorithm);
+    if (stream->context == NULL)
+    {
+        free(stream);
+        return NULL;
+    }
+
+    stream->algorithm = algorithm;
+    return stream;
 }
 
 /**
- * @brief Checks if the hash of the @p buffer matches @p hashBase64
+ * @brief Adds @p bufferLen bytes from @p buffer to the hash computation.
  *
- * @param buffer The buffer to check
- * @param bufferLen The length of the @p buffer
- * @param hashBase64 The expected hash of the buffer @p buffer
- * @return bool True if the hash is valid and matches @p hashBase64
+ * @param handle The hash stream handle.
+ * @param buffer The data to hash.
+ * @param bufferLen The length of @p buffer.
+ * @return bool true on success.
  */
-bool ADUC_HashUtils_IsValidBufferHash(
-    const uint8_t* buffer, size_t bufferLen, const char* hashBase64, SHAversion algorithm)
+bool ADUC_HashUtils_HashStream_Update(ADUC_HashStreamHandle handle, const uint8_t* buffer, size_t bufferLen)
 {
-    USHAContext context;
+    ADUC_HashStream* stream = (ADUC_HashStream*)handle;
 
-    if (USHAReset(&context, algorithm) != 0)
+    if (stream == NULL || stream->finalized || (buffer == NULL && bufferLen != 0))
     {
-        Log_Error("Error in SHA Reset, SHAversion: %d", algorithm);
         return false;
     }
 
-    if (USHAInput(&context, buffer, (unsigned int)bufferLen) != 0)
+    if (!ADUC_HashBackend_Update(stream->context, buffer, bufferLen))
     {
-        Log_Error("Error in SHA Input, SHAversion: %d", algorithm);
+        Log_Error("Error in SHA Input, SHAversion: %d", stream->algorithm);
         return false;
     }
 
-    return GetResultAndCompareHashes(&context, hashBase64, algorithm, true, NULL);
+    return true;
+}
+
+/**
+ * @brief Finalizes the hash computation and writes the base64 encoded digest to @p hashBase64.
+ *
+ * @param handle The hash stream handle.
+ * @param hashBase64 The output buffer for the null-terminated, base64 encoded digest.
+ * @param hashBase64Size The size of @p hashBase64.
+ * @return bool true on success.
+ */
+bool ADUC_HashUtils_HashStream_GetResult(ADUC_HashStreamHandle handle, char* hashBase64, size_t hashBase64Size)
+{
+    bool success = false;
+    char* computedHash = NULL;
+    ADUC_HashStream* stream = (ADUC_HashStream*)handle;
+
+    if (stream == NULL || stream->finalized || hashBase64 == NULL || hashBase64Size == 0)
+    {
+        goto done;
+    }
+
+    stream->finalized = true;
+
+    if (!GetResultAndCompareHashes(
+            stream->context, NULL /* hashBase64 */, stream->algorithm, false /* suppressErrorLog */, &computedHash))
+    {
+        goto done;
+    }
+
+    const size_t computedHashSize = strlen(computedHash) + 1;
+    if (computedHashSize > hashBase64Size)
+    {
+        Log_Error("Hash output buffer too small. Need %u bytes.", (unsigned int)computedHashSize);
+        goto done;
+    }
+
+    memcpy(hashBase64, computedHash, computedHashSize);
+
+    success = true;
+
+done:
+    free(computedHash);
+    return success;
+}
+
+/**
+ * @brief Frees the hash stream.
+ *
+ * @param handle The hash stream handle. May be NULL.
+ */
+void ADUC_HashUtils_HashStream_Free(ADUC_HashStreamHandle handle)
+{
+    ADUC_HashStream* stream = (ADUC_HashStream*)handle;
+
+    if (stream != NULL)
+    {
+        ADUC_HashBackend_Free(stream->context);
+        free(stream);
+    }
 }
 
 /**
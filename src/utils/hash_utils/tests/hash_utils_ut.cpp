@@ -8,13 +8,19 @@
 #include <aduc/hash_utils.h>
 
 #include "aduc/system_utils.h" // ADUC_SystemUtils_MkTemp
+#include <aducpal/sys_stat.h> // ADUCPAL_chmod, stat
 
 #include <catch2/catch.hpp>
 using Catch::Matchers::Equals;
 
 #include <aduc/calloc_wrapper.hpp>
+#include <algorithm> // std::min
 #include <array>
+#include <chrono>
+#include <cstring>
 #include <fstream>
+#include <sstream>
+#include <thread>
 #include <unordered_map>
 
 // To generate file hashes:
@@ -30,6 +36,9 @@ public:
 
     TestFile()
     {
+        // Keep digests of test files out of the agent's data folder.
+        ADUC_HashUtils_SetDigestCacheFilePath(nullptr);
+
         // Generate a unique filename.
 
         ADUC_SystemUtils_MkTemp(_filePath);
@@ -257,6 +266,51 @@ private:
     // clang-format on
 };
 
+class MultiBlockFile : public TestFile
+{
+public:
+    MultiBlockFile()
+    {
+        _data.resize(TestBufferSize);
+
+        uint8_t n = 0;
+        std::generate(_data.begin(), _data.end(), [&n]() mutable { return n++; });
+
+        CreateFile();
+    }
+
+    const uint8_t* GetData() const override
+    {
+        return _data.data();
+    }
+
+    const size_t GetDataByteLen() const override
+    {
+        return _data.size() * sizeof(uint8_t);
+    }
+
+    const char* GetDataHashBase64(SHAversion shaVersion) const override
+    {
+        return _hashBase64Map.at(shaVersion).c_str();
+    }
+
+private:
+    // Spans more than one file read block, and ends with a partial block.
+    static constexpr size_t TestBufferSize = 2 * 1024 * 1024 + 4;
+    std::vector<uint8_t> _data;
+
+    // clang-format off
+    const std::unordered_map<SHAversion, std::string> _hashBase64Map
+    {
+        { SHAversion::SHA1,   "PJdmg/WDI04PFYsEn02Riv+qqdA=" },
+        { SHAversion::SHA224, "lkmz3LHuYN3XS2vn3pE1v1P0bDCvVWma+InRkw==" },
+        { SHAversion::SHA256, "mS+HiTiGRfM3bJacuv12lABG//ycpbJq0BQPtT51Yac=" },
+        { SHAversion::SHA384, "29WlhEtbuw0lftcT5jJoLK2ubYkXhE0hk/NVg5LCBjMI+da133vKhri0eSLcQoL/" },
+        { SHAversion::SHA512, "CJuU5tCaN93WDsMpCCsdQzSvvidbsGLpbPDtTvVYn8hlP+JZ0UaKV9ZfciXZ3y4u41lY5A3r4cAmfVhoKKXqLw==" }
+    };
+    // clang-format on
+};
+
 TEST_CASE("ADUC_HashUtils_IsValidFileHash - LargeFile")
 {
     LargeFile testFile;
@@ -306,3 +360,190 @@ TEST_CASE("ADUC_HashUtils_GetFileHash - LargeFile")
         CHECK_THAT(hash.get(), Equals(testFile.GetDataHashBase64(version)));
     }
 }
+
+TEST_CASE("ADUC_HashUtils_HashStream - LargeFile")
+{
+    LargeFile testFile;
+
+    // clang-format off
+    auto version = GENERATE( // NOLINT(google-build-using-namespace)
+        SHAversion::SHA1,
+        SHAversion::SHA224,
+        SHAversion::SHA256,
+        SHAversion::SHA384,
+        SHAversion::SHA512);
+    // clang-format on
+
+    SECTION("Hash of data fed in uneven chunks matches file hash")
+    {
+        INFO("SHAversion: " << version);
+        ADUC_HashStreamHandle stream = ADUC_HashUtils_HashStream_Create(version);
+        REQUIRE(stream != nullptr);
+
+        const uint8_t* data = testFile.GetData();
+        size_t remaining = testFile.GetDataByteLen();
+        const size_t chunkSize = 4093;
+        while (remaining > 0)
+        {
+            const size_t len = std::min(remaining, chunkSize);
+            REQUIRE(ADUC_HashUtils_HashStream_Update(stream, data, len));
+            data += len;
+            remaining -= len;
+        }
+
+        char hash[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE] = {};
+        REQUIRE(ADUC_HashUtils_HashStream_GetResult(stream, hash, sizeof(hash)));
+        CHECK_THAT(hash, Equals(testFile.GetDataHashBase64(version)));
+
+        // The stream cannot be used after the result was computed.
+        CHECK_FALSE(ADUC_HashUtils_HashStream_Update(stream, testFile.GetData(), 1));
+        CHECK_FALSE(ADUC_HashUtils_HashStream_GetResult(stream, hash, sizeof(hash)));
+
+        ADUC_HashUtils_HashStream_Free(stream);
+    }
+
+    SECTION("Output buffer too small")
+    {
+        ADUC_HashStreamHandle stream = ADUC_HashUtils_HashStream_Create(version);
+        REQUIRE(stream != nullptr);
+        REQUIRE(ADUC_HashUtils_HashStream_Update(stream, testFile.GetData(), testFile.GetDataByteLen()));
+
+        char hash[8] = {};
+        CHECK_FALSE(ADUC_HashUtils_HashStream_GetResult(stream, hash, sizeof(hash)));
+
+        ADUC_HashUtils_HashStream_Free(stream);
+    }
+}
+
+TEST_CASE("ADUC_HashUtils_IsValidFileHash - MultiBlockFile")
+{
+    MultiBlockFile testFile;
+
+    // clang-format off
+    auto version = GENERATE( // NOLINT(google-build-using-namespace)
+        SHAversion::SHA1,
+        SHAversion::SHA224,
+        SHAversion::SHA256,
+        SHAversion::SHA384,
+        SHAversion::SHA512);
+    // clang-format on
+
+    SECTION("Verify file hash")
+    {
+        INFO("SHAversion: " << version);
+        CHECK(ADUC_HashUtils_IsValidFileHash(testFile.Filename(), testFile.GetDataHashBase64(version), version, false));
+    }
+
+    SECTION("Get file hash")
+    {
+        INFO("SHAversion: " << version);
+        ADUC::StringUtils::cstr_wrapper hash;
+        REQUIRE(ADUC_HashUtils_GetFileHash(testFile.Filename(), version, hash.address_of()));
+        CHECK_THAT(hash.get(), Equals(testFile.GetDataHashBase64(version)));
+    }
+}
+
+TEST_CASE("ADUC_HashUtils_IsValidFileHash - digest cache")
+{
+    SmallFile testFile;
+    const char* sha256 = testFile.GetDataHashBase64(SHAversion::SHA256);
+    const char* otherDigest = testFile.GetDataHashBase64(SHAversion::SHA512);
+
+    char cacheFilePath[ARRAY_SIZE("/tmp/digestcacheXXXXXX")] = "/tmp/digestcacheXXXXXX";
+    ADUC_SystemUtils_MkTemp(cacheFilePath);
+    ADUC_HashUtils_SetDigestCacheFilePath(cacheFilePath);
+
+    // Digests of files changed within the last couple of seconds are not trusted.
+    std::this_thread::sleep_for(std::chrono::milliseconds(2100));
+
+    REQUIRE(ADUC_HashUtils_IsValidFileHash(testFile.Filename(), sha256, SHAversion::SHA256, false));
+
+    // Forge the persisted digest, so that a cache hit is observable.
+    std::string cacheContent;
+    {
+        std::ifstream cacheFile{ cacheFilePath };
+        std::stringstream buffer;
+        buffer << cacheFile.rdbuf();
+        cacheContent = buffer.str();
+    }
+
+    const size_t pos = cacheContent.find(sha256);
+    REQUIRE(pos != std::string::npos);
+    cacheContent.replace(pos, strlen(sha256), otherDigest);
+    {
+        std::ofstream cacheFile{ cacheFilePath, std::ios::trunc };
+        cacheFile << cacheContent;
+    }
+
+    SECTION("Unchanged file uses persisted digest")
+    {
+        // Drops the in-memory entries, so the digest comes from the file.
+        ADUC_HashUtils_SetDigestCacheFilePath(cacheFilePath);
+
+        CHECK(ADUC_HashUtils_IsValidFileHash(testFile.Filename(), otherDigest, SHAversion::SHA256, true));
+
+        // Other algorithms are cached separately.
+        CHECK(ADUC_HashUtils_IsValidFileHash(
+            testFile.Filename(), testFile.GetDataHashBase64(SHAversion::SHA512), SHAversion::SHA512, true));
+    }
+
+    SECTION("Persisted digests are ignored unless the file is private")
+    {
+        REQUIRE(ADUCPAL_chmod(cacheFilePath, S_IRUSR | S_IWUSR | S_IRGRP | S_IROTH) == 0);
+        ADUC_HashUtils_SetDigestCacheFilePath(cacheFilePath);
+
+        CHECK_FALSE(ADUC_HashUtils_IsValidFileHash(testFile.Filename(), otherDigest, SHAversion::SHA256, true));
+        CHECK(ADUC_HashUtils_IsValidFileHash(testFile.Filename(), sha256, SHAversion::SHA256, false));
+    }
+
+    SECTION("New digests are appended to the persisted file")
+    {
+        struct stat before = {};
+        struct stat after = {};
+
+        REQUIRE(stat(cacheFilePath, &before) == 0);
+        CHECK(ADUC_HashUtils_IsValidFileHash(
+            testFile.Filename(), testFile.GetDataHashBase64(SHAversion::SHA512), SHAversion::SHA512, false));
+        REQUIRE(stat(cacheFilePath, &after) == 0);
+
+        CHECK(after.st_ino == before.st_ino);
+        CHECK(after.st_size > before.st_size);
+    }
+
+    SECTION("Uncached check always reads the file")
+    {
+        CHECK_FALSE(
+            ADUC_HashUtils_IsValidFileHashUncached(testFile.Filename(), otherDigest, SHAversion::SHA256, true));
+        CHECK(ADUC_HashUtils_IsValidFileHashUncached(testFile.Filename(), sha256, SHAversion::SHA256, false));
+    }
+
+    SECTION("Uncached file hash always reads the file")
+    {
+        ADUC_HashUtils_SetDigestCacheFilePath(cacheFilePath);
+
+        ADUC::StringUtils::cstr_wrapper cachedHash;
+        REQUIRE(ADUC_HashUtils_GetFileHash(testFile.Filename(), SHAversion::SHA256, cachedHash.address_of()));
+        CHECK_THAT(cachedHash.get(), Equals(otherDigest));
+
+        ADUC::StringUtils::cstr_wrapper hash;
+        REQUIRE(ADUC_HashUtils_GetFileHashUncached(testFile.Filename(), SHAversion::SHA256, hash.address_of()));
+        CHECK_THAT(hash.get(), Equals(sha256));
+    }
+
+    SECTION("Changed file is hashed again")
+    {
+        ADUC_HashUtils_SetDigestCacheFilePath(cacheFilePath);
+
+        {
+            std::ofstream file{ testFile.Filename(), std::ios::binary | std::ios::trunc };
+            // NOLINTNEXTLINE(cppcoreguidelines-pro-type-reinterpret-cast)
+            file.write(reinterpret_cast<const char*>(testFile.GetData()), testFile.GetDataByteLen());
+        }
+
+        CHECK(ADUC_HashUtils_IsValidFileHash(testFile.Filename(), sha256, SHAversion::SHA256, false));
+        CHECK_FALSE(ADUC_HashUtils_IsValidFileHash(testFile.Filename(), otherDigest, SHAversion::SHA256, true));
+    }
+
+    ADUC_HashUtils_SetDigestCacheFilePath(nullptr);
+    CHECK(std::remove(cacheFilePath) == 0);
+}
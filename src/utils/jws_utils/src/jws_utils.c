@@ -28,8 +28,73 @@
 //
 // Internal Functions
 //
+// JWS sections are handled as spans into the JWS itself, and are decoded into buffers on the stack. A heap buffer is
+// only allocated when the decoded data does not fit, e.g. for unusually large keys.
+//
+
+/**
+ * @brief Size of the stack buffers for decoded JWS headers and payloads. Large enough for a header holding an SJWK with
+ * an RSA-4096 signing key.
+ */
+#define JWS_DECODE_BUFFER_SIZE 2048
+
+/**
+ * @brief Size of the stack buffers for decoded signatures. Large enough for an RSA-8192 signature.
+ */
+#define JWS_SIGNATURE_BUFFER_SIZE 1024
+
+/**
+ * @brief Size of the stack buffers for null-terminated copies of header and JWK field values.
+ */
+#define JWS_FIELD_BUFFER_SIZE 1024
+
+/**
+ * @brief The number of members of a JSON object that the field scanner checks for repeated keys. Objects with more
+ * members are left to the JSON parser.
+ */
+#define JWS_SCAN_MAX_KEYS 16
 
-// Find the position of the period and return the next character
+/**
+ * @brief A run of characters within a larger buffer. Not null-terminated.
+ */
+typedef struct tagJWSSpan
+{
+    const char* data; /**< The first character. */
+    size_t length; /**< The number of characters. */
+} JWSSpan;
+
+/**
+ * @brief The sections of a JWS, as spans into the JWS.
+ */
+typedef struct tagJWSSections
+{
+    JWSSpan header; /**< The Base64URL encoded header. */
+    JWSSpan payload; /**< The Base64URL encoded payload. */
+    JWSSpan signature; /**< The Base64URL encoded signature. */
+    JWSSpan signingInput; /**< The header, '.', and the payload, which is what the signature is computed over. */
+} JWSSections;
+
+/**
+ * @brief Result of scanning a JSON object for a field.
+ */
+typedef enum tagJSONScanResult
+{
+    JSONScanResult_NotFound = 0, /**< The field is missing, is not a string, or the JSON is malformed. */
+    JSONScanResult_Found = 1, /**< The field was found; its value needs no unescaping. */
+    JSONScanResult_NeedsFullParse = 2, /**< The JSON has content the scanner does not judge; use the JSON parser. */
+} JSONScanResult;
+
+static JWSSpan SpanFromString(const char* string)
+{
+    JWSSpan span = { .data = string, .length = string == NULL ? 0 : strlen(string) };
+    return span;
+}
+
+static bool SpanEquals(JWSSpan span, const char* string)
+{
+    const size_t length = strlen(string);
+    return span.length == length && memcmp(span.data, string, length) == 0;
+}
 
 /**
  * @brief Returns the string value of the fieldName iwthin the jsonString
@@ -70,273 +135,844 @@ done:
 }
 
 /**
- * @brief Finds the character in the string, assigns a pointer to that lcoation, and returns the size of the substring from the beginning of @p string to @p foundCharPos
- * @param string string to be searched
- * @param charToFind the character to find within @p string
- * @param foundCharPos pointer will be set to the pointer to the first instance of @p charToFind within @p string
- * @returns the size of the substring from the beginning of string to the first instance of foundCharPos
+ * @brief Skips whitespace. Like the JSON parser, which uses isspace(), this includes vertical tabs and form feeds.
  */
-static size_t FindCharInString(const char* string, const char charToFind, char** foundCharPos)
+static const char* SkipJSONWhitespace(const char* p, const char* end)
 {
-    if (foundCharPos == NULL)
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\n' || *p == '\r' || *p == '\v' || *p == '\f'))
     {
-        return 0;
+        ++p;
     }
 
-    char* found = strchr(string, charToFind);
+    return p;
+}
 
-    if (found == NULL)
+/**
+ * @brief Scans the JSON string starting at @p *p, which must point at the opening quote.
+ * @param p the scan position; on success, set to the character after the closing quote
+ * @param end the end of the JSON text
+ * @param content set to the characters between the quotes, still escaped
+ * @param hasEscapes set to whether @p content contains escape sequences or control characters, which only the JSON
+ * parser judges
+ * @returns true on success; false if the string is malformed
+ */
+static bool ScanJSONString(const char** p, const char* end, JWSSpan* content, bool* hasEscapes)
+{
+    const char* cur = *p + 1;
+
+    *hasEscapes = false;
+
+    while (cur < end && *cur != '"')
     {
-        *foundCharPos = NULL;
-        return 0;
+        if ((unsigned char)*cur < 0x20)
+        {
+            *hasEscapes = true;
+        }
+
+        if (*cur == '\\')
+        {
+            *hasEscapes = true;
+            ++cur;
+        }
+
+        ++cur;
+    }
+
+    if (cur >= end)
+    {
+        return false;
     }
 
-    *foundCharPos = found;
-    return (size_t)(found - string);
+    content->data = *p + 1;
+    content->length = (size_t)(cur - content->data);
+    *p = cur + 1;
+    return true;
 }
 
 /**
- * @brief Extracts the header, payload, and signature from the Base64Url encoded JSON Web Signature within @p jws
- * @param jws a Base64URL encoded JSON Web Signature containing a header, payload, and signature delimited by '.'
- * @param header buffer to store the Base64URL encoded header in, allocated by function to be freed by Caller using free()
- * @param payload buffer to store the Base64URL encoded payload in,  allocated by function to be freed by Caller using free()
- * @param signature buffer to store the Base64URL encoded signature in,  allocated by function to be freed by Caller using free()
- * @returns on successful extraction of all sections True is returned otherwise False
+ * @brief Skips the literal @p literal if the JSON text at @p *p starts with it.
+ */
+static bool SkipJSONLiteral(const char** p, const char* end, const char* literal)
+{
+    const size_t length = strlen(literal);
+
+    if ((size_t)(end - *p) < length || memcmp(*p, literal, length) != 0)
+    {
+        return false;
+    }
+
+    *p += length;
+    return true;
+}
+
+/**
+ * @brief Skips the JSON value starting at @p *p.
+ * @details Only values that the JSON parser is known to judge the same way are skipped: strings without escape
+ * sequences, true, false, null, empty objects and arrays, and numbers without an exponent and with at most 15 integer
+ * digits. For other objects, arrays, strings and numbers, @p needsFullParse is set.
+ * @param p the scan position; on success, set to the character after the value
+ * @param end the end of the JSON text
+ * @param needsFullParse set to true if the value must be judged by the JSON parser
+ * @returns true on success; false if the value is malformed or @p needsFullParse is set
  */
-static bool ExtractJWSSections(const char* jws, char** header, char** payload, char** signature)
+static bool SkipJSONValue(const char** p, const char* end, bool* needsFullParse)
 {
-    bool success = false;
+    const char* cur = *p;
+    JWSSpan content;
+    bool hasEscapes = false;
+    size_t integerDigits = 0;
 
-    *header = NULL;
-    *payload = NULL;
-    *signature = NULL;
+    *needsFullParse = false;
 
-    if (jws == NULL)
+    if (cur >= end)
     {
-        goto done;
+        return false;
     }
 
-    const size_t jwsLen = strlen(jws);
-    if (jwsLen == 0)
+    if (*cur == '"')
     {
-        goto done;
+        if (!ScanJSONString(&cur, end, &content, &hasEscapes))
+        {
+            return false;
+        }
+
+        if (hasEscapes)
+        {
+            *needsFullParse = true;
+            return false;
+        }
+
+        *p = cur;
+        return true;
     }
 
-    char* headerEnd = NULL;
-    size_t headerLen = FindCharInString(jws, '.', &headerEnd);
+    if (*cur == '{' || *cur == '[')
+    {
+        const char close = *cur == '{' ? '}' : ']';
+
+        cur = SkipJSONWhitespace(cur + 1, end);
+        if (cur >= end || *cur != close)
+        {
+            *needsFullParse = true;
+            return false;
+        }
 
-    if (headerLen == 0 || headerLen + 1 >= jwsLen)
+        *p = cur + 1;
+        return true;
+    }
+
+    if (SkipJSONLiteral(p, end, "true") || SkipJSONLiteral(p, end, "false") || SkipJSONLiteral(p, end, "null"))
     {
-        goto done;
+        return true;
     }
 
-    char* payloadEnd = NULL;
-    size_t payloadLen = FindCharInString((headerEnd + 1), '.', &payloadEnd);
+    if (*cur != '-' && (*cur < '0' || *cur > '9'))
+    {
+        // Not a JSON value.
+        return false;
+    }
 
-    if (payloadLen == 0 || (headerLen + payloadLen + 2 >= jwsLen))
+    // A number: -?(0|[1-9][0-9]*)(\.[0-9]+)?
+    if (*cur == '-')
     {
-        goto done;
+        ++cur;
     }
 
-    // From payloadEnd to the end of jws is the signature
+    if (cur < end && *cur == '0')
+    {
+        ++cur;
+        integerDigits = 1;
+    }
+    else
+    {
+        while (cur < end && *cur >= '0' && *cur <= '9')
+        {
+            ++cur;
+            ++integerDigits;
+        }
+    }
 
-    size_t sigLen = jwsLen - payloadLen - headerLen - 2; // 2 is for the periods
+    if (cur < end && *cur == '.' && cur + 1 < end && cur[1] >= '0' && cur[1] <= '9')
+    {
+        cur += 2;
+        while (cur < end && *cur >= '0' && *cur <= '9')
+        {
+            ++cur;
+        }
+    }
+
+    // Exponents, large integers that may overflow, and anything else the JSON parser's strtod() might accept are left
+    // to the JSON parser.
+    if (integerDigits == 0 || integerDigits > 15
+        || (cur < end
+            && ((*cur >= '0' && *cur <= '9') || (*cur >= 'a' && *cur <= 'z') || (*cur >= 'A' && *cur <= 'Z')
+                || *cur == '.' || *cur == '+' || *cur == '-')))
+    {
+        *needsFullParse = true;
+        return false;
+    }
 
-    *header = (char*)malloc(headerLen + 1);
-    *payload = (char*)malloc(payloadLen + 1);
-    *signature = (char*)malloc(sigLen + 1);
+    *p = cur;
+    return true;
+}
 
-    if (*header == NULL || *payload == NULL || *signature == NULL)
+/**
+ * @brief Finds the string value of the top-level field @p fieldName in the JSON object @p json, without building a DOM
+ * @details The scanner must agree with the JSON parser. It only returns JSONScanResult_Found or
+ * JSONScanResult_NotFound for objects it fully understands: flat members, no escape sequences, and no repeated keys.
+ * Anything else, including content after the object, which the JSON parser ignores, is left to the JSON parser.
+ * @param json the JSON object text
+ * @param fieldName the name of the field
+ * @param value set to the value, as a span into @p json, when the field is found
+ * @returns a value of JSONScanResult
+ */
+static JSONScanResult ScanJSONForStringField(JWSSpan json, const char* fieldName, JWSSpan* value)
+{
+    const char* p = json.data;
+    const char* end = json.data + json.length;
+    JWSSpan keys[JWS_SCAN_MAX_KEYS];
+    size_t keyCount = 0;
+    bool isFound = false;
+    bool needsFullParse = false;
+
+    if (json.length >= 3 && memcmp(p, "\xEF\xBB\xBF", 3) == 0)
     {
-        goto done;
+        // The JSON parser skips a UTF-8 byte order mark.
+        return JSONScanResult_NeedsFullParse;
     }
 
-    ADUC_Safe_StrCopyN(*header, jws, headerLen + 1, headerLen);
-    ADUC_Safe_StrCopyN(*payload, (headerEnd + 1), payloadLen + 1, payloadLen);
-    ADUC_Safe_StrCopyN(*signature, (payloadEnd + 1), sigLen + 1, sigLen);
+    p = SkipJSONWhitespace(p, end);
 
-    success = true;
-done:
-    if (!success)
+    if (p >= end || *p != '{')
+    {
+        return JSONScanResult_NotFound;
+    }
+
+    p = SkipJSONWhitespace(p + 1, end);
+
+    if (p < end && *p == '}')
     {
-        if (*header != NULL)
+        ++p;
+    }
+    else
+    {
+        for (;;)
         {
-            free(*header);
-            *header = NULL;
+            JWSSpan key;
+            bool keyHasEscapes = false;
+
+            if (p >= end || *p != '"' || !ScanJSONString(&p, end, &key, &keyHasEscapes))
+            {
+                return JSONScanResult_NotFound;
+            }
+
+            if (keyHasEscapes || keyCount == JWS_SCAN_MAX_KEYS)
+            {
+                // The key might be an escaped form of fieldName or of another key.
+                return JSONScanResult_NeedsFullParse;
+            }
+
+            for (size_t i = 0; i < keyCount; ++i)
+            {
+                if (keys[i].length == key.length && memcmp(keys[i].data, key.data, key.length) == 0)
+                {
+                    // The JSON parser rejects repeated keys.
+                    return JSONScanResult_NeedsFullParse;
+                }
+            }
+
+            keys[keyCount++] = key;
+
+            p = SkipJSONWhitespace(p, end);
+
+            if (p >= end || *p != ':')
+            {
+                return JSONScanResult_NotFound;
+            }
+
+            p = SkipJSONWhitespace(p + 1, end);
+
+            if (SpanEquals(key, fieldName) && p < end && *p == '"')
+            {
+                bool valueHasEscapes = false;
+
+                if (!ScanJSONString(&p, end, value, &valueHasEscapes))
+                {
+                    return JSONScanResult_NotFound;
+                }
+
+                if (valueHasEscapes)
+                {
+                    return JSONScanResult_NeedsFullParse;
+                }
+
+                isFound = true;
+            }
+            else if (!SkipJSONValue(&p, end, &needsFullParse))
+            {
+                return needsFullParse ? JSONScanResult_NeedsFullParse : JSONScanResult_NotFound;
+            }
+
+            p = SkipJSONWhitespace(p, end);
+
+            if (p < end && *p == ',')
+            {
+                p = SkipJSONWhitespace(p + 1, end);
+                continue;
+            }
+
+            if (p < end && *p == '}')
+            {
+                ++p;
+                break;
+            }
+
+            return JSONScanResult_NotFound;
         }
+    }
 
-        if (*payload != NULL)
+    if (SkipJSONWhitespace(p, end) != end)
+    {
+        return JSONScanResult_NeedsFullParse;
+    }
+
+    return isFound ? JSONScanResult_Found : JSONScanResult_NotFound;
+}
+
+/**
+ * @brief Gets the string value of the top-level field @p fieldName in the JSON object @p json
+ * @details Values without escape sequences, which is every field this library reads in practice, are returned as a
+ * span into @p json. Otherwise the JSON is parsed, and the value is unescaped into @p heapValue.
+ * @param json the JSON object text, which must be followed by a null terminator
+ * @param fieldName the name of the field
+ * @param value set to the value
+ * @param heapValue set to the allocated, unescaped value if one was needed; NULL otherwise. Caller must free() it.
+ * @returns true if the field exists and is a string; false otherwise
+ */
+static bool GetJSONStringField(JWSSpan json, const char* fieldName, JWSSpan* value, char** heapValue)
+{
+    *heapValue = NULL;
+
+    switch (ScanJSONForStringField(json, fieldName, value))
+    {
+    case JSONScanResult_Found:
+        return true;
+
+    case JSONScanResult_NeedsFullParse:
+        *heapValue = GetStringValueFromJSON(json.data, fieldName);
+        if (*heapValue == NULL)
         {
-            free(*payload);
-            *payload = NULL;
+            return false;
         }
 
-        if (*signature != NULL)
+        *value = SpanFromString(*heapValue);
+        return true;
+
+    case JSONScanResult_NotFound:
+    default:
+        return false;
+    }
+}
+
+/**
+ * @brief Copies @p span into a null-terminated string
+ * @param span the characters to copy
+ * @param buffer the caller-provided buffer to copy into if it is large enough
+ * @param bufferSize the size of @p buffer
+ * @param heapString set to an allocated string if @p buffer is too small; NULL otherwise. Caller must free() it.
+ * @returns the string, or NULL on failure
+ */
+static const char* SpanToString(JWSSpan span, char* buffer, size_t bufferSize, char** heapString)
+{
+    char* dest = buffer;
+
+    *heapString = NULL;
+
+    if (span.length + 1 > bufferSize)
+    {
+        *heapString = (char*)malloc(span.length + 1);
+
+        if (*heapString == NULL)
         {
-            free(*signature);
-            *signature = NULL;
+            return NULL;
         }
+
+        dest = *heapString;
     }
 
-    return success;
+    memcpy(dest, span.data, span.length);
+    dest[span.length] = '\0';
+    return dest;
+}
+
+static int Base64URLCharValue(char c)
+{
+    if (c >= 'A' && c <= 'Z')
+    {
+        return c - 'A';
+    }
+
+    if (c >= 'a' && c <= 'z')
+    {
+        return c - 'a' + 26;
+    }
+
+    if (c >= '0' && c <= '9')
+    {
+        return c - '0' + 52;
+    }
+
+    // Base64URL characters, and for compatibility with Base64URLDecode(), their Base64 equivalents.
+    if (c == '-' || c == '+')
+    {
+        return 62;
+    }
+
+    if (c == '_' || c == '/')
+    {
+        return 63;
+    }
+
+    return -1;
 }
 
 /**
- * @brief Extracts the header from the Base64URL encoded JSON Web Signature within @p jws
- * @details Copies the header from @p jws to @p header the header will be allocated by this method and should be freed by the caller using free
+ * @brief Decodes the Base64URL encoded @p encoded into @p dest
+ * @details Padding is optional, as with Base64URLDecode().
+ * @param encoded the Base64URL encoded data
+ * @param dest the destination buffer
+ * @param destSize the size of @p dest
+ * @returns the number of decoded bytes; 0 if @p encoded is empty or malformed, or @p dest is too small
+ */
+static size_t Base64URLDecodeSpan(JWSSpan encoded, uint8_t* dest, size_t destSize)
+{
+    size_t length = encoded.length;
+    size_t decodedLength = 0;
+    uint32_t bitBuffer = 0;
+    int bitCount = 0;
+
+    for (int i = 0; i < 2 && length > 0 && encoded.data[length - 1] == '='; ++i)
+    {
+        --length;
+    }
+
+    if (length % 4 == 1)
+    {
+        return 0;
+    }
+
+    for (size_t i = 0; i < length; ++i)
+    {
+        const int value = Base64URLCharValue(encoded.data[i]);
+
+        if (value < 0)
+        {
+            return 0;
+        }
+
+        bitBuffer = ((bitBuffer << 6) | (uint32_t)value) & 0xFFFFFF;
+        bitCount += 6;
+
+        if (bitCount >= 8)
+        {
+            bitCount -= 8;
+
+            if (decodedLength >= destSize)
+            {
+                return 0;
+            }
+
+            dest[decodedLength++] = (uint8_t)(bitBuffer >> bitCount);
+        }
+    }
+
+    return decodedLength;
+}
+
+/**
+ * @brief Decodes the Base64URL encoded @p encoded, and null-terminates the result so it can be used as a string
+ * @param encoded the Base64URL encoded data
+ * @param buffer the caller-provided buffer to decode into if it is large enough; may be NULL
+ * @param bufferSize the size of @p buffer
+ * @param heapBuffer set to an allocated buffer if @p buffer is too small; NULL otherwise. Caller must free() it.
+ * @param decoded set to the decoded data, excluding the null terminator
+ * @returns true on success; false if @p encoded is empty or malformed, or on allocation failure
+ */
+static bool DecodeJWSSpan(JWSSpan encoded, uint8_t* buffer, size_t bufferSize, uint8_t** heapBuffer, JWSSpan* decoded)
+{
+    // Every 4 characters decode to at most 3 bytes, plus the null terminator.
+    const size_t maxDecodedSize = (encoded.length / 4 + 1) * 3 + 1;
+    uint8_t* dest = buffer;
+
+    *heapBuffer = NULL;
+
+    if (maxDecodedSize > bufferSize)
+    {
+        *heapBuffer = (uint8_t*)malloc(maxDecodedSize);
+
+        if (*heapBuffer == NULL)
+        {
+            return false;
+        }
+
+        dest = *heapBuffer;
+    }
+
+    const size_t decodedLength = Base64URLDecodeSpan(encoded, dest, maxDecodedSize - 1);
+
+    if (decodedLength == 0)
+    {
+        free(*heapBuffer);
+        *heapBuffer = NULL;
+        return false;
+    }
+
+    dest[decodedLength] = '\0';
+    decoded->data = (const char*)dest;
+    decoded->length = decodedLength;
+    return true;
+}
+
+/**
+ * @brief Splits the Base64Url encoded JSON Web Signature @p jws into its header, payload, and signature, in place
+ * @param jws a Base64URL encoded JSON Web Signature containing a header, payload, and signature delimited by '.'
+ * @param sections set to the sections of @p jws
+ * @returns on successful extraction of all sections True is returned otherwise False
+ */
+static bool SplitJWSSections(JWSSpan jws, JWSSections* sections)
+{
+    if (jws.data == NULL || jws.length == 0)
+    {
+        return false;
+    }
+
+    const char* end = jws.data + jws.length;
+    const char* headerEnd = (const char*)memchr(jws.data, '.', jws.length);
+
+    if (headerEnd == NULL || headerEnd == jws.data || headerEnd + 1 >= end)
+    {
+        return false;
+    }
+
+    const char* payloadStart = headerEnd + 1;
+    const char* payloadEnd = (const char*)memchr(payloadStart, '.', (size_t)(end - payloadStart));
+
+    if (payloadEnd == NULL || payloadEnd == payloadStart || payloadEnd + 1 >= end)
+    {
+        return false;
+    }
+
+    // From payloadEnd to the end of jws is the signature
+    sections->header.data = jws.data;
+    sections->header.length = (size_t)(headerEnd - jws.data);
+    sections->payload.data = payloadStart;
+    sections->payload.length = (size_t)(payloadEnd - payloadStart);
+    sections->signature.data = payloadEnd + 1;
+    sections->signature.length = (size_t)(end - sections->signature.data);
+    sections->signingInput.data = jws.data;
+    sections->signingInput.length = (size_t)(payloadEnd - jws.data);
+
+    return true;
+}
+
+/**
+ * @brief Finds the header of the Base64URL encoded JSON Web Signature @p jws
  * @param jws a Base4Url encoded JSON Web Signature contianing at least a header delimited by '.'
- * @param header destination buffer to store the Base64Url encoded header in
+ * @param header set to the Base64Url encoded header, as a span into @p jws
  * @returns on successful extraction of the header True, false otherwise
+ */
+static bool SplitJWSHeader(JWSSpan jws, JWSSpan* header)
+{
+    if (jws.data == NULL || jws.length == 0)
+    {
+        return false;
+    }
+
+    const char* headerEnd = (const char*)memchr(jws.data, '.', jws.length);
+
+    if (headerEnd == NULL || headerEnd == jws.data || headerEnd + 1 >= jws.data + jws.length)
+    {
+        return false;
+    }
+
+    header->data = jws.data;
+    header->length = (size_t)(headerEnd - jws.data);
+    return true;
+}
+
+/**
+ * @brief Computes the SHA256 hash of the public key of the signing key in @p sjwkJson, which is how disabled
+ * signing keys are listed in the root key package.
  *
+ * @param sjwkJson The SJWK json string that is base64 URL decoded header section of the JWS. Must be followed by a null
+ * terminator.
+ * @param outSha256HashPubKey Set to the hash on success. Caller must free it with CONSTBUFFER_DecRef().
+ * @return JWSResult Returns JWSResult_Success on success, or a failure JWSResult.
  */
-static bool ExtractJWSHeader(const char* jws, char** header)
+static JWSResult GetSigningKeyHash(JWSSpan sjwkJson, CONSTBUFFER_HANDLE* outSha256HashPubKey)
 {
-    bool success = false;
-    char* tempHeader = NULL;
+    JWSResult result = JWSResult_Failed;
+    CONSTBUFFER_HANDLE pubkey = NULL;
+    CONSTBUFFER_HANDLE sha256HashPubKey = NULL;
 
-    *header = NULL;
+    JWSSpan nSpan = { NULL, 0 };
+    JWSSpan eSpan = { NULL, 0 };
+    char* heapNValue = NULL;
+    char* heapEValue = NULL;
+    char nBuffer[JWS_FIELD_BUFFER_SIZE];
+    char* heapN = NULL;
+    const char* N = NULL;
 
-    if (jws == NULL)
+    if (!GetJSONStringField(sjwkJson, "n", &nSpan, &heapNValue)
+        || !GetJSONStringField(sjwkJson, "e", &eSpan, &heapEValue) || nSpan.length == 0
+        || !SpanEquals(eSpan, "AQAB")) // AQAB is 65337 or 0x010001, the ubiquitous RSA exponent.
     {
+        result = JWSResult_InvalidSJWKPayload;
         goto done;
     }
 
-    const size_t jwsLen = strlen(jws);
-    if (jwsLen == 0)
+    N = SpanToString(nSpan, nBuffer, sizeof(nBuffer), &heapN);
+    if (N == NULL)
     {
         goto done;
     }
 
-    char* headerEnd = NULL;
-
-    size_t headerLen = FindCharInString(jws, '.', &headerEnd);
-
-    if (headerLen == 0 || headerLen + 1 >= jwsLen)
+    pubkey = CryptoUtils_GenerateRsaPublicKey(N, "AQAB");
+    if (pubkey == NULL)
     {
+        result = JWSResult_FailGenPubKey;
         goto done;
     }
 
-    tempHeader = (char*)malloc(headerLen + 1);
-
-    if (tempHeader == NULL)
+    sha256HashPubKey = CryptoUtils_CreateSha256Hash(pubkey);
+    if (sha256HashPubKey == NULL)
     {
+        result = JWSResult_HashPubKeyFailed;
         goto done;
     }
 
-    ADUC_Safe_StrCopyN(tempHeader, jws, headerLen + 1, headerLen);
+#ifdef TRACE_DISABLED_SIGNING_KEY
+    char* base64urlSha256HashPubKey = Base64URLEncode(
+        CONSTBUFFER_GetContent(sha256HashPubKey)->buffer, CONSTBUFFER_GetContent(sha256HashPubKey)->size);
+    printf("base64url encoding of sha256 hash of public key: %s\n", base64urlSha256HashPubKey);
+#endif
 
-    success = true;
+    *outSha256HashPubKey = sha256HashPubKey;
+    sha256HashPubKey = NULL;
+    result = JWSResult_Success;
 
 done:
-    if (!success)
+
+    if (pubkey != NULL)
     {
-        free(tempHeader);
-        tempHeader = NULL;
+        CONSTBUFFER_DecRef(pubkey);
     }
 
-    *header = tempHeader;
-    return success;
-}
+    if (sha256HashPubKey != NULL)
+    {
+        CONSTBUFFER_DecRef(sha256HashPubKey);
+    }
 
-//
-// Public Functions
-//
+    free(heapNValue);
+    free(heapEValue);
+    free(heapN);
+
+    return result;
+}
 
 /**
- * @brief converts JWSResult to const C string.
- *
- * @param r The jws result to convert.
- * @return const char* The mapped-to string.
- * @details NOTE: Needs to be kept in sync with JWSResult enum in jws_utils.h
+ * @brief Verifies the Base64URL encoded JSON Web Signature @p jws using @p key
+ * @param jws a Base64URL encoded JSON Web Token in JSON Web Signature format
+ * @param key the public key that corresponds to the one used to sign @p jws
+ * @param isLongLivedKey whether @p key is kept for a long time, e.g. a root key, so its verification set up is cached
+ * @returns a value of JWSResult
  */
-const char* jws_result_to_str(JWSResult r)
+static JWSResult VerifyJWSSpanWithKey(JWSSpan jws, CryptoKeyHandle key, bool isLongLivedKey)
 {
-    switch (r)
+    JWSResult result = JWSResult_Failed;
+    JWSSections sections;
+
+    uint8_t headerBuffer[JWS_DECODE_BUFFER_SIZE];
+    uint8_t* heapHeader = NULL;
+    JWSSpan headerJson;
+
+    JWSSpan algSpan;
+    char* heapAlgValue = NULL;
+    char algBuffer[JWS_FIELD_BUFFER_SIZE];
+    char* heapAlg = NULL;
+    const char* alg = NULL;
+
+    uint8_t signatureBuffer[JWS_SIGNATURE_BUFFER_SIZE];
+    uint8_t* heapSignature = NULL;
+    JWSSpan decodedSignature = { NULL, 0 };
+
+    if (!SplitJWSSections(jws, &sections))
     {
-    case JWSResult_Failed:
-        return "Failed";
+        result = JWSResult_BadStructure;
+        goto done;
+    }
 
-    case JWSResult_Success:
-        return "Success";
+    if (!DecodeJWSSpan(sections.header, headerBuffer, sizeof(headerBuffer), &heapHeader, &headerJson))
+    {
+        result = JWSResult_Failed;
+        goto done;
+    }
 
-    case JWSResult_BadStructure:
-        return "BadStructure";
+    if (!GetJSONStringField(headerJson, "alg", &algSpan, &heapAlgValue))
+    {
+        result = JWSResult_BadStructure;
+        goto done;
+    }
 
-    case JWSResult_InvalidSignature:
-        return "InvalidSignature";
+    alg = SpanToString(algSpan, algBuffer, sizeof(algBuffer), &heapAlg);
+    if (alg == NULL)
+    {
+        result = JWSResult_Failed;
+        goto done;
+    }
 
-    case JWSResult_DisallowedRootKid:
-        return "DisallowedRootKid";
+    // A signature that cannot be decoded fails verification below.
+    (void)DecodeJWSSpan(
+        sections.signature, signatureBuffer, sizeof(signatureBuffer), &heapSignature, &decodedSignature);
 
-    case JWSResult_MissingRootKid:
-        return "MissingRootKid";
+    // The signing input is the header, '.', and the payload, which is a prefix of the JWS itself.
+    if (!(isLongLivedKey ? CryptoUtils_IsValidSignatureWithLongLivedKey : CryptoUtils_IsValidSignature)(
+            alg,
+            (const uint8_t*)decodedSignature.data,
+            decodedSignature.length,
+            (const uint8_t*)sections.signingInput.data,
+            sections.signingInput.length,
+            key))
+    {
+        result = JWSResult_InvalidSignature;
+    }
+    else
+    {
+        result = JWSResult_Success;
+    }
 
-    case JWSResult_InvalidRootKid:
-        return "InvalidRootKid";
+done:
 
-    case JWSResult_InvalidEncodingJWSHeader:
-        return "JWSResult_InvalidEncodingJWSHeader";
+    free(heapHeader);
+    free(heapAlgValue);
+    free(heapAlg);
+    free(heapSignature);
 
-    case JWSResult_InvalidSJWKPayload:
-        return "JWSResult_InvalidSJWKPayload";
+    return result;
+}
 
-    case JWSResult_DisallowedSigningKey:
-        return "DisallowedSigningKey";
+/**
+ * @brief Parses the key from the Base64URL encoded Signed JSON Web Key @p sjwk into a usable CryptoLib key
+ * @param sjwk a Base64URL encoded Signed JSON Web Key
+ * @returns the key on success, NULL on failure. Caller must free it with CryptoUtils_FreeCryptoKeyHandle().
+ */
+static CryptoKeyHandle GetKeyFromJWKSpan(JWSSpan sjwk)
+{
+    CryptoKeyHandle key = NULL;
+    JWSSections sections;
 
-    case JWSResult_FailedGetDisabledSigningKeys:
-        return "JWSResult_FailedGetDisabledSigningKeys";
+    uint8_t payloadBuffer[JWS_DECODE_BUFFER_SIZE];
+    uint8_t* heapPayload = NULL;
+    JWSSpan payloadJson;
 
-    case JWSResult_FailGenPubKey:
-        return "JWSResult_FailGenPubKey";
+    JWSSpan nSpan;
+    JWSSpan eSpan;
+    char* heapNValue = NULL;
+    char* heapEValue = NULL;
+    char nBuffer[JWS_FIELD_BUFFER_SIZE];
+    char eBuffer[JWS_FIELD_BUFFER_SIZE];
+    char* heapN = NULL;
+    char* heapE = NULL;
+    const char* strN = NULL;
+    const char* stre = NULL;
+
+    if (!SplitJWSSections(sjwk, &sections))
+    {
+        goto done;
+    }
+
+    if (!DecodeJWSSpan(sections.payload, payloadBuffer, sizeof(payloadBuffer), &heapPayload, &payloadJson))
+    {
+        goto done;
+    }
+
+    if (!GetJSONStringField(payloadJson, "n", &nSpan, &heapNValue)
+        || !GetJSONStringField(payloadJson, "e", &eSpan, &heapEValue))
+    {
+        goto done;
+    }
+
+    strN = SpanToString(nSpan, nBuffer, sizeof(nBuffer), &heapN);
+    stre = SpanToString(eSpan, eBuffer, sizeof(eBuffer), &heapE);
+
+    if (strN == NULL || stre == NULL)
+    {
+        goto done;
+    }
+
+    key = RSAKey_ObjFromB64Strings(strN, stre);
+
+done:
 
-    case JWSResult_HashPubKeyFailed:
-        return "JWSResult_HashPubKeyFailed";
+    free(heapPayload);
+    free(heapNValue);
+    free(heapEValue);
+    free(heapN);
+    free(heapE);
 
-    default:
-        return "???";
-    }
+    return key;
 }
 
 /**
- * @brief Verifies the Base64URL encoded @p sjwk in Signed JSON Web Key (SJWK) format using the KiD found within the encoded JWKs Header
- * @details A Signed JSON Web Key (SJWK) is JWK in JSON Web Signature (JWS) format. The function parses the header for the kid, builds the associated key, and then verifies the signature of the JWK
- * @param sjwk a base64URL encoded string that contains the Signed JSON Web Key
+ * @brief Verifies the Base64URL encoded Signed JSON Web Key @p sjwk using the KiD found within its header
+ * @param sjwk a base64URL encoded Signed JSON Web Key
  * @returns a value of JWSResult
  */
-JWSResult VerifySJWK(const char* sjwk)
+static JWSResult VerifySJWKSpan(JWSSpan sjwk)
 {
     JWSResult retval = JWSResult_Failed;
     JWSResult jwsResultIsSigningKeyDisallowed = JWSResult_Failed;
     JWSResult jwsResultVerifyJwtSignature = JWSResult_Failed;
     ADUC_Result result = { ADUC_GeneralResult_Failure, 0 };
-    ADUC_Result resultGetDisabledSigningKeys = { ADUC_GeneralResult_Failure, 0 };
-    VECTOR_HANDLE signingKeyDisallowed = NULL;
-
-    char* header = NULL;
-    char* payload = NULL;
-    char* signature = NULL;
-
-    char* jsonHeader = NULL;
-    char* jsonPayload = NULL;
-    char* kid = NULL;
+    ADUC_Result resultIsSigningKeyHashDisabled = { ADUC_GeneralResult_Failure, 0 };
+    CONSTBUFFER_HANDLE sha256HashPubKey = NULL;
+    bool isSigningKeyDisabled = false;
+    JWSSections sections;
+
+    uint8_t headerBuffer[JWS_DECODE_BUFFER_SIZE];
+    uint8_t* heapHeader = NULL;
+    JWSSpan jsonHeader;
+
+    uint8_t payloadBuffer[JWS_DECODE_BUFFER_SIZE];
+    uint8_t* heapPayload = NULL;
+    JWSSpan jsonPayload;
+
+    JWSSpan kidSpan;
+    char* heapKidValue = NULL;
+    char kidBuffer[JWS_FIELD_BUFFER_SIZE];
+    char* heapKid = NULL;
+    const char* kid = NULL;
     void* rootKey = NULL;
 
-    if (!ExtractJWSSections(sjwk, &header, &payload, &signature))
+    if (!SplitJWSSections(sjwk, &sections))
     {
         retval = JWSResult_BadStructure;
         goto done;
     }
 
-    jsonHeader = Base64URLDecodeToString(header);
-
-    if (jsonHeader == NULL)
+    if (!DecodeJWSSpan(sections.header, headerBuffer, sizeof(headerBuffer), &heapHeader, &jsonHeader))
     {
         retval = JWSResult_Failed;
         goto done;
     }
 
-    kid = GetStringValueFromJSON(jsonHeader, "kid");
+    if (!GetJSONStringField(jsonHeader, "kid", &kidSpan, &heapKidValue))
+    {
+        retval = JWSResult_Failed;
+        goto done;
+    }
 
+    kid = SpanToString(kidSpan, kidBuffer, sizeof(kidBuffer), &heapKid);
     if (kid == NULL)
     {
         retval = JWSResult_Failed;
@@ -363,80 +999,129 @@ JWSResult VerifySJWK(const char* sjwk)
     }
 
     // First verify JWT structure and signature
-    jwsResultVerifyJwtSignature = VerifyJWSWithKey(sjwk, rootKey);
+    jwsResultVerifyJwtSignature = VerifyJWSSpanWithKey(sjwk, rootKey, true /* isLongLivedKey */);
     if (jwsResultVerifyJwtSignature != JWSResult_Success)
     {
         retval = jwsResultVerifyJwtSignature;
         goto done;
     }
 
-    // Now, verify that signing key is not on the rootkey packages's Disallowed
-    resultGetDisabledSigningKeys = RootKeyUtility_GetDisabledSigningKeys(&signingKeyDisallowed);
-    if (IsAducResultCodeFailure(resultGetDisabledSigningKeys.ResultCode))
+    if (!DecodeJWSSpan(sections.payload, payloadBuffer, sizeof(payloadBuffer), &heapPayload, &jsonPayload))
     {
-        retval = JWSResult_FailedGetDisabledSigningKeys;
+        retval = JWSResult_Failed;
         goto done;
     }
 
-    jsonPayload = Base64URLDecodeToString(payload);
+    // Now, verify that signing key is not on the rootkey packages's Disallowed
+    jwsResultIsSigningKeyDisallowed = GetSigningKeyHash(jsonPayload, &sha256HashPubKey);
+    if (jwsResultIsSigningKeyDisallowed != JWSResult_Success)
+    {
+        retval = jwsResultIsSigningKeyDisallowed;
+        goto done;
+    }
 
-    if (jsonPayload == NULL)
+    resultIsSigningKeyHashDisabled = RootKeyUtility_IsSigningKeyHashDisabled(sha256HashPubKey, &isSigningKeyDisabled);
+    if (IsAducResultCodeFailure(resultIsSigningKeyHashDisabled.ResultCode))
     {
-        retval = JWSResult_Failed;
+        retval = JWSResult_FailedGetDisabledSigningKeys;
         goto done;
     }
 
-    jwsResultIsSigningKeyDisallowed = IsSigningKeyDisallowed(jsonPayload, signingKeyDisallowed);
-    if (jwsResultIsSigningKeyDisallowed != JWSResult_Success)
+    if (isSigningKeyDisabled)
     {
-        retval = jwsResultIsSigningKeyDisallowed;
+        retval = JWSResult_DisallowedSigningKey;
         goto done;
     }
 
     retval = JWSResult_Success;
 
 done:
-    if (signingKeyDisallowed != NULL)
+    if (sha256HashPubKey != NULL)
     {
-        VECTOR_destroy(signingKeyDisallowed);
+        CONSTBUFFER_DecRef(sha256HashPubKey);
     }
 
-    if (header != NULL)
-    {
-        free(header);
-    }
+    free(heapHeader);
+    free(heapPayload);
+    free(heapKidValue);
+    free(heapKid);
 
-    if (payload != NULL)
+    if (rootKey != NULL)
     {
-        free(payload);
+        CryptoUtils_FreeCryptoKeyHandle(rootKey);
     }
 
-    if (signature != NULL)
-    {
-        free(signature);
-    }
+    return retval;
+}
 
-    if (kid != NULL)
-    {
-        free(kid);
-    }
+//
+// Public Functions
+//
 
-    if (jsonHeader != NULL)
+/**
+ * @brief converts JWSResult to const C string.
+ *
+ * @param r The jws result to convert.
+ * @return const char* The mapped-to string.
+ * @details NOTE: Needs to be kept in sync with JWSResult enum in jws_utils.h
+ */
+const char* jws_result_to_str(JWSResult r)
+{
+    switch (r)
     {
-        free(jsonHeader);
-    }
+    case JWSResult_Failed:
+        return "Failed";
 
-    if (jsonPayload != NULL)
-    {
-        free(jsonPayload);
-    }
+    case JWSResult_Success:
+        return "Success";
 
-    if (rootKey != NULL)
-    {
-        CryptoUtils_FreeCryptoKeyHandle(rootKey);
+    case JWSResult_BadStructure:
+        return "BadStructure";
+
+    case JWSResult_InvalidSignature:
+        return "InvalidSignature";
+
+    case JWSResult_DisallowedRootKid:
+        return "DisallowedRootKid";
+
+    case JWSResult_MissingRootKid:
+        return "MissingRootKid";
+
+    case JWSResult_InvalidRootKid:
+        return "InvalidRootKid";
+
+    case JWSResult_InvalidEncodingJWSHeader:
+        return "JWSResult_InvalidEncodingJWSHeader";
+
+    case JWSResult_InvalidSJWKPayload:
+        return "JWSResult_InvalidSJWKPayload";
+
+    case JWSResult_DisallowedSigningKey:
+        return "DisallowedSigningKey";
+
+    case JWSResult_FailedGetDisabledSigningKeys:
+        return "JWSResult_FailedGetDisabledSigningKeys";
+
+    case JWSResult_FailGenPubKey:
+        return "JWSResult_FailGenPubKey";
+
+    case JWSResult_HashPubKeyFailed:
+        return "JWSResult_HashPubKeyFailed";
+
+    default:
+        return "???";
     }
+}
 
-    return retval;
+/**
+ * @brief Verifies the Base64URL encoded @p sjwk in Signed JSON Web Key (SJWK) format using the KiD found within the encoded JWKs Header
+ * @details A Signed JSON Web Key (SJWK) is JWK in JSON Web Signature (JWS) format. The function parses the header for the kid, builds the associated key, and then verifies the signature of the JWK
+ * @param sjwk a base64URL encoded string that contains the Signed JSON Web Key
+ * @returns a value of JWSResult
+ */
+JWSResult VerifySJWK(const char* sjwk)
+{
+    return VerifySJWKSpan(SpanFromString(sjwk));
 }
 
 /**
@@ -448,48 +1133,50 @@ done:
 JWSResult VerifyJWSWithSJWK(const char* jws)
 {
     JWSResult result = JWSResult_Failed;
+    const JWSSpan jwsSpan = SpanFromString(jws);
 
-    char* header = NULL;
-    char* jsonHeader = NULL;
-    char* sjwk = NULL;
+    JWSSpan header;
+    uint8_t headerBuffer[JWS_DECODE_BUFFER_SIZE];
+    uint8_t* heapHeader = NULL;
+    JWSSpan jsonHeader;
+
+    // The SJWK is a span into the decoded header.
+    JWSSpan sjwk;
+    char* heapSjwkValue = NULL;
     CryptoKeyHandle key = NULL;
 
-    if (!ExtractJWSHeader(jws, &header))
+    if (!SplitJWSHeader(jwsSpan, &header))
     {
         result = JWSResult_BadStructure;
         goto done;
     }
 
-    jsonHeader = Base64URLDecodeToString(header);
-
-    if (jsonHeader == NULL)
+    if (!DecodeJWSSpan(header, headerBuffer, sizeof(headerBuffer), &heapHeader, &jsonHeader))
     {
         result = JWSResult_InvalidEncodingJWSHeader;
         goto done;
     }
 
-    sjwk = GetStringValueFromJSON(jsonHeader, "sjwk");
-
-    if (sjwk == NULL || *sjwk == '\0')
+    if (!GetJSONStringField(jsonHeader, "sjwk", &sjwk, &heapSjwkValue) || sjwk.length == 0)
     {
         result = JWSResult_BadStructure;
         goto done;
     }
 
-    result = VerifySJWK(sjwk);
+    result = VerifySJWKSpan(sjwk);
     if (result != JWSResult_Success)
     {
         goto done;
     }
 
-    key = GetKeyFromBase64EncodedJWK(sjwk);
+    key = GetKeyFromJWKSpan(sjwk);
     if (key == NULL)
     {
         result = JWSResult_BadStructure;
         goto done;
     }
 
-    result = VerifyJWSWithKey(jws, key);
+    result = VerifyJWSSpanWithKey(jwsSpan, key, false /* isLongLivedKey */);
 
     if (result != JWSResult_Success)
     {
@@ -497,20 +1184,8 @@ JWSResult VerifyJWSWithSJWK(const char* jws)
     }
 
 done:
-    if (header != NULL)
-    {
-        free(header);
-    }
-
-    if (jsonHeader != NULL)
-    {
-        free(jsonHeader);
-    }
-
-    if (sjwk != NULL)
-    {
-        free(sjwk);
-    }
+    free(heapHeader);
+    free(heapSjwkValue);
 
     if (key != NULL)
     {
@@ -528,38 +1203,15 @@ done:
  */
 JWSResult IsSigningKeyDisallowed(const char* sjwkJsonStr, VECTOR_HANDLE disabledHashOfPubKeysList)
 {
-    JWSResult result = JWSResult_Failed;
-    CONSTBUFFER_HANDLE pubkey = NULL;
     CONSTBUFFER_HANDLE sha256HashPubKey = NULL;
 
-    char* N = GetStringValueFromJSON(sjwkJsonStr, "n");
-    char* e = GetStringValueFromJSON(sjwkJsonStr, "e");
-    if (IsNullOrEmpty(N) || IsNullOrEmpty(e)
-        || strcmp(e, "AQAB") != 0) // AQAB is 65337 or 0x010001, the ubiquitous RSA exponent.
-    {
-        result = JWSResult_InvalidSJWKPayload;
-        goto done;
-    }
-
-    pubkey = CryptoUtils_GenerateRsaPublicKey(N, e);
-    if (pubkey == NULL)
-    {
-        result = JWSResult_FailGenPubKey;
-        goto done;
-    }
-
-    sha256HashPubKey = CryptoUtils_CreateSha256Hash(pubkey);
-    if (pubkey == NULL)
+    JWSResult result = GetSigningKeyHash(SpanFromString(sjwkJsonStr), &sha256HashPubKey);
+    if (result != JWSResult_Success)
     {
-        result = JWSResult_HashPubKeyFailed;
         goto done;
     }
 
-#ifdef TRACE_DISABLED_SIGNING_KEY
-    char* base64urlSha256HashPubKey = Base64URLEncode(
-        CONSTBUFFER_GetContent(sha256HashPubKey)->buffer, CONSTBUFFER_GetContent(sha256HashPubKey)->size);
-    printf("base64url encoding of sha256 hash of public key: %s\n", base64urlSha256HashPubKey);
-#endif
+    result = JWSResult_Failed;
 
     // See if the hash of public key is on the Disallowed List.
     for (size_t i = 0; i < VECTOR_size(disabledHashOfPubKeysList); ++i)
@@ -579,11 +1231,6 @@ JWSResult IsSigningKeyDisallowed(const char* sjwkJsonStr, VECTOR_HANDLE disabled
 
 done:
 
-    if (pubkey != NULL)
-    {
-        CONSTBUFFER_DecRef(pubkey);
-    }
-
     if (sha256HashPubKey != NULL)
     {
         CONSTBUFFER_DecRef(sha256HashPubKey);
@@ -601,107 +1248,7 @@ done:
  */
 JWSResult VerifyJWSWithKey(const char* blob, CryptoKeyHandle key)
 {
-    JWSResult result = JWSResult_Failed;
-
-    // Check for structure
-    char* header = NULL;
-    char* payload = NULL;
-    char* signature = NULL;
-
-    char* headerJson = NULL;
-    char* alg = NULL;
-    char* headerPlusPayload = NULL;
-    uint8_t* decodedSignature = NULL;
-
-    if (!ExtractJWSSections(blob, &header, &payload, &signature))
-    {
-        result = JWSResult_BadStructure;
-        goto done;
-    }
-
-    headerJson = Base64URLDecodeToString(header);
-
-    if (headerJson == NULL)
-    {
-        result = JWSResult_Failed;
-        goto done;
-    }
-
-    alg = GetStringValueFromJSON(headerJson, "alg");
-
-    if (alg == NULL)
-    {
-        result = JWSResult_BadStructure;
-        goto done;
-    }
-
-    // Note: The +2 is for the "." between the header and the payload
-    // and the null terminator at the end of the string.
-    size_t headerLen = strlen(header);
-    size_t payloadLen = strlen(payload);
-    size_t hppSize = headerLen + payloadLen + 2;
-    headerPlusPayload = (char*)calloc(1, hppSize);
-
-    if (headerPlusPayload == NULL)
-    {
-        result = JWSResult_Failed;
-        goto done;
-    }
-
-    memcpy(headerPlusPayload, header, headerLen);
-    headerPlusPayload[headerLen] = '.';
-    memcpy(headerPlusPayload + headerLen + 1, payload, payloadLen);
-    headerPlusPayload[headerLen + payloadLen + 1] = '\0';
-
-    size_t decodedSignatureLen = Base64URLDecode(signature, &decodedSignature);
-
-    if (!CryptoUtils_IsValidSignature(
-            alg, decodedSignature, decodedSignatureLen, (uint8_t*)headerPlusPayload, strlen(headerPlusPayload), key))
-    {
-        result = JWSResult_InvalidSignature;
-    }
-    else
-    {
-        result = JWSResult_Success;
-    }
-
-done:
-
-    if (header != NULL)
-    {
-        free(header);
-    }
-
-    if (payload != NULL)
-    {
-        free(payload);
-    }
-
-    if (signature != NULL)
-    {
-        free(signature);
-    }
-
-    if (headerJson != NULL)
-    {
-        free(headerJson);
-    }
-
-    if (alg != NULL)
-    {
-        free(alg);
-    }
-
-    if (headerPlusPayload != NULL)
-    {
-        free(headerPlusPayload);
-    }
-
-    if (decodedSignature != NULL)
-    {
-        free(decodedSignature);
-    }
-    return result;
+    return VerifyJWSSpanWithKey(SpanFromString(blob), key, false /* isLongLivedKey */);
 }
 
 /**
@@ -713,22 +1260,19 @@ done:
 bool GetPayloadFromJWT(const char* blob, char** destBuff)
 {
     bool result = false;
+    JWSSections sections;
+    uint8_t* payload = NULL;
+    JWSSpan decodedPayload;
 
     *destBuff = NULL;
 
-    char* header = NULL;
-    char* payload = NULL;
-    char* signature = NULL;
-    char* tempStr = NULL;
-
-    if (!ExtractJWSSections(blob, &header, &payload, &signature))
+    if (!SplitJWSSections(SpanFromString(blob), &sections))
     {
         goto done;
     }
 
-    tempStr = Base64URLDecodeToString(payload);
-
-    if (tempStr == NULL)
+    // No caller-provided buffer; the payload is decoded straight into the string returned to the caller.
+    if (!DecodeJWSSpan(sections.payload, NULL, 0, &payload, &decodedPayload))
     {
         goto done;
     }
@@ -737,11 +1281,7 @@ bool GetPayloadFromJWT(const char* blob, char** destBuff)
 
 done:
 
-    free(header);
-    free(payload);
-    free(signature);
-
-    *destBuff = tempStr;
+    *destBuff = (char*)payload;
     return result;
 }
 
@@ -753,69 +1293,5 @@ done:
  */
 void* GetKeyFromBase64EncodedJWK(const char* blob)
 {
-    CryptoKeyHandle key = NULL;
-
-    char* header = NULL;
-    char* payload = NULL;
-    char* signature = NULL;
-
-    char* strN = NULL;
-    char* stre = NULL;
-    char* payloadJson = NULL;
-
-    if (!ExtractJWSSections(blob, &header, &payload, &signature))
-    {
-        goto done;
-    }
-
-    payloadJson = Base64URLDecodeToString(payload);
-
-    if (payloadJson == NULL)
-    {
-        goto done;
-    }
-
-    strN = GetStringValueFromJSON(payloadJson, "n");
-    stre = GetStringValueFromJSON(payloadJson, "e");
-
-    if (strN == NULL || stre == NULL)
-    {
-        goto done;
-    }
-
-    key = RSAKey_ObjFromB64Strings(strN, stre);
-
-done:
-
-    if (header != NULL)
-    {
-        free(header);
-    }
-
-    if (payload != NULL)
-    {
-        free(payload);
-    }
-
-    if (signature != NULL)
-    {
-        free(signature);
-    }
-
-    if (payloadJson != NULL)
-    {
-        free(payloadJson);
-    }
-
-    if (strN != NULL)
-    {
-        free(strN);
-    }
-
-    if (stre != NULL)
-    {
-        free(stre);
-    }
-
-    return key;
+    return GetKeyFromJWKSpan(SpanFromString(blob));
 }
@@ -19,6 +19,7 @@
 #include <iostream>
 #include <openssl/evp.h>
 #include <openssl/rsa.h>
+#include <parson.h>
 #include <regex>
 #include <root_key_util.h>
 #include <stdio.h>
@@ -588,6 +589,128 @@ TEST_CASE_METHOD(TestCaseFixture, "VerifyJWSWithKey")
     }
 }
 
+static std::string GetJWSWithHeader(const std::string& header)
+{
+    char* encodedHeader = Base64URLEncode(reinterpret_cast<const uint8_t*>(header.c_str()), header.length());
+    REQUIRE(encodedHeader != nullptr);
+
+    // The payload and signature of a JWS signed by another key.
+    std::string jws{ encodedHeader };
+    jws += ".eyJzaGEyNTYiOiI3Mk9BRTJmME5iVDArVEw5MzdvNzB4bzhvTzk2Z21WTFlESnB4WEh6ZVhFPSJ9"
+           ".Sagxe9ylLitBHD14QsqSCO1lhrsrqqMdJo73at50-C3B2OVu6n5uiQ-6AOnuwEY07cRtxLcUl";
+    free(encodedHeader);
+    return jws;
+}
+
+TEST_CASE("VerifyJWSWithKey - header parsing")
+{
+    std::string N{ "rHVBEFKR1vshg+AhIg/SDQO3x4kj3CUT7fGnJhAmuDhvHfj3gHzi0T2IAqC"
+                   "1x2BCWdOo5v8tumqRj/nYpg97jjPCKucdO6m37dcOma46h7O0kHpwL3nUHG"
+                   "ErJ5DA/apYnwEesexTjT8Sp/+bTqWEmzgD37pfdKaqjtHLGViYwVHPztBab"
+                   "wwjhAvzyRY/y9OfmzDfXmrY1ro/+2hEqEykujwQEYkhjJa+B476+0muGyWI"
+                   "5eIv/olt2ReXxMb9MllXNyoP3aNKIJibZMs7uKciwkyiUIaYcMjs9i/REy+"
+                   "lM9vIZqrfpCUXu3tn1Kgc2Qs/Td8tNTCGV6wtVaqiIpTdT4RrCdMoO5SNef"
+                   "fDyc2lC7u85+omTkcjPjm6fapdIyF2qemvSBDfB7caj5DII25Ww5EJcavfy"
+                   "P54mqNQQ3GcMQb2dghiclpjYo+43ZgYCdGtaZd2EfLZwH3Qg2rDlfk/ia0/"
+                   "1yqik/XZ1nsZTi0Bc5CpOMEqfNJFQk3BWoA05rCZ" };
+
+    CryptoKeyHandle key = RSAKey_ObjFromB64Strings(N.c_str(), "AQAB");
+    REQUIRE(key != nullptr);
+
+    SECTION("Missing alg")
+    {
+        CHECK(VerifyJWSWithKey(GetJWSWithHeader(R"({"typ":"JWT"})").c_str(), key) == JWSResult_BadStructure);
+    }
+
+    SECTION("Duplicate alg")
+    {
+        CHECK(
+            VerifyJWSWithKey(GetJWSWithHeader(R"({"alg":"RS256","alg":"RS256"})").c_str(), key)
+            == JWSResult_BadStructure);
+    }
+
+    SECTION("Malformed header")
+    {
+        CHECK(VerifyJWSWithKey(GetJWSWithHeader(R"({"alg":"RS256")").c_str(), key) == JWSResult_BadStructure);
+    }
+
+    SECTION("Invalid members")
+    {
+        CHECK(
+            VerifyJWSWithKey(GetJWSWithHeader(R"({"alg":"RS256","x":bogus})").c_str(), key)
+            == JWSResult_BadStructure);
+        CHECK(
+            VerifyJWSWithKey(GetJWSWithHeader(R"({"alg":"RS256","x":truex})").c_str(), key)
+            == JWSResult_BadStructure);
+        CHECK(
+            VerifyJWSWithKey(GetJWSWithHeader(R"({"alg":"RS256","x":{"y":bogus}})").c_str(), key)
+            == JWSResult_BadStructure);
+        CHECK(
+            VerifyJWSWithKey(GetJWSWithHeader(R"({"alg":"RS256","x":1,"x":2})").c_str(), key)
+            == JWSResult_BadStructure);
+    }
+
+    SECTION("Agrees with the JSON parser")
+    {
+        const char* headers[] = {
+            R"({"alg":"RS256"})",
+            R"({"alg":"RS256","x":true,"y":false,"z":null})",
+            R"({"alg":"RS256","x":nul})",
+            R"({"alg":"RS256","x":-0.25})",
+            R"({"alg":"RS256","x":1e5})",
+            R"({"alg":"RS256","x":1.})",
+            R"({"alg":"RS256","x":01})",
+            R"({"alg":"RS256","x":0x10})",
+            R"({"alg":"RS256","x":-})",
+            R"({"alg":"RS256","x":123456789012345678901234567890})",
+            R"({"alg":"RS256","x":{},"y":[ ]})",
+            R"({"alg":"RS256","x":{"a":[1,{"b":"}"}]}})",
+            R"({"alg":"RS256","x":[1,2,]})",
+            R"({"alg":"RS256","x":"a\qb"})",
+            R"({"alg":"RS256","x":"a\u0041b"})",
+            R"({"alg":"RS256","alg":"RS256"})",
+            R"({"alg":"RS256","x":1,"x":1})",
+            R"({"alg":"RS256",})",
+            R"({"alg":1})",
+            R"({"alg":"RS256"} x)",
+            "\xEF\xBB\xBF{\"alg\":\"RS256\"}",
+            "{\v\"alg\":\"RS256\"\f}",
+            "{\"alg\":\"RS\t256\"}",
+        };
+
+        for (const char* header : headers)
+        {
+            JSON_Value* root = json_parse_string(header);
+            const bool parserFindsAlg = json_object_get_string(json_value_get_object(root), "alg") != nullptr;
+            json_value_free(root);
+
+            INFO("header: " << header);
+            CHECK(
+                VerifyJWSWithKey(GetJWSWithHeader(header).c_str(), key)
+                == (parserFindsAlg ? JWSResult_InvalidSignature : JWSResult_BadStructure));
+        }
+    }
+
+    SECTION("Nested and escaped members")
+    {
+        CHECK(
+            VerifyJWSWithKey(GetJWSWithHeader(R"({"x":{"alg":"}"},"alg":"RS256"})").c_str(), key)
+            == JWSResult_InvalidSignature);
+        CHECK(
+            VerifyJWSWithKey(GetJWSWithHeader(R"({ "\u0061lg" : "RS256" })").c_str(), key)
+            == JWSResult_InvalidSignature);
+    }
+
+    SECTION("Missing sections")
+    {
+        CHECK(VerifyJWSWithKey("eyJhbGciOiJSUzI1NiJ9", key) == JWSResult_BadStructure);
+        CHECK(VerifyJWSWithKey("eyJhbGciOiJSUzI1NiJ9.eyJ9.", key) == JWSResult_BadStructure);
+        CHECK(VerifyJWSWithKey("eyJhbGciOiJSUzI1NiJ9..c2ln", key) == JWSResult_BadStructure);
+    }
+
+    CryptoUtils_FreeCryptoKeyHandle(key);
+}
+
 const char* AllowedSigningKey =
     "ucKAJMkskVVKjtVLFdraMSd0cTa2Vcndkle540smg3a2v4hYXoHWBaA0tkZj5VM1fWR-XcjHJ9NRh74TzsHqPJODXn085tWGMwOzUEPhOSAzRaY-FCr23SIqM6AHCYPxziKbz9kEcD6e043UyCRMyLf8fQJ3SOvBXCNoVSkiQ8rwcDeHjFiSzk_BLy0JGRjfzJZF8l-q1N-Vqpq3VtOmQJphblSL6bC9AR1GNrvaJbHiSciaFvuiucneVBu3B6bY0wEin20x_CrjTNmiWEtuY_zoUxJGLGQVHkzJRRAQweHxw_FDSMd3UhiINRuN7Qb3r_S9HPoFNkZvaOUVOVe7WUY0jAFIzVUEcq2CTx43p0XvaLeYEz-DsG-RlPkkT2i-1ykEhwtJfsKGDTIP5mPDslZkTUScgZFRMToJdwOtGKkAzGXQPlvtf3IL49fUTM4r8dpIc7E1N2Djt94__kcdY1e8JxfgRH7RoiQCATHep6-mQW5UKq_onJW2bNo7i9Gb";
 const char* DisallowedSigningKey =
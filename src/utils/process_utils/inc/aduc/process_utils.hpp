@@ -13,6 +13,8 @@
 #include <aducpal/unistd.h> // getegid, geteuid
 
 #include <azure_c_shared_utility/vector.h>
+#include <cstddef> // size_t
+#include <cstdint> // uint8_t
 #include <functional>
 
 #include <string>
@@ -45,6 +47,24 @@ int ADUC_LaunchChildProcess(const std::string& command, std::vector<std::string>
 int ADUC_LaunchChildProcess(
     const std::string& command, std::vector<std::string> args, std::vector<std::string>& output);
 
+/**
+ * @brief Runs specified command in a new process and streams its raw standard output to @p onOutput.
+ * @details Unlike ADUC_LaunchChildProcess, the output is neither buffered nor split into lines, so this is
+ * suitable for commands that produce large binary output (e.g. a payload written to stdout).
+ * Standard error of the child process is discarded.
+ *
+ * @param command Name of a command to run. If command doesn't contain '/', this function will
+ *               search for the specified command in PATH.
+ * @param args List of arguments for the command.
+ * @param onOutput Called for each chunk of output read. Returning false stops reading and terminates the child process.
+ *
+ * @return An exit code from the command.
+ */
+int ADUC_LaunchChildProcessStreamOutput(
+    const std::string& command,
+    std::vector<std::string> args,
+    const std::function<bool(const uint8_t* data, size_t size)>& onOutput);
+
 /**
  * @brief Ensure that the effective group of the process is the given group (or is root).
  * @remark This function is not thread-safe if called with the defaults for the optional args.
@@ -28,7 +28,9 @@
 #include <chrono>
 #include <functional> // for std::function
 #include <string>
+#include <utility> // for std::move
 #ifndef WIN32 // Note: Only included when not in windows since a different wait signal is used.
+#    include <signal.h> // kill
 #    include <sys/wait.h>
 #    include <unistd.h>
 #endif
@@ -239,6 +241,186 @@ int ADUC_LaunchChildProcess(
         output.push_back(str.substr(0, str.size() - 1));
     });
 }
+#ifdef WIN32
+static int ADUC_LaunchChildProcessStreamOutputHelper(
+    const std::string& command,
+    std::vector<std::string> args,
+    const std::function<bool(const uint8_t* data, size_t size)>& onOutput)
+{
+    int ret = 0;
+
+    std::string redirected_command{ command };
+    redirected_command += " ";
+
+    for (const std::string& arg : args)
+    {
+        redirected_command += arg;
+        redirected_command += " ";
+    }
+
+    FILE* fp = ADUCPAL_popen(redirected_command.c_str(), "rb");
+    if (fp == NULL)
+    {
+        return errno;
+    }
+
+    uint8_t buffer[64 * 1024];
+
+    for (;;)
+    {
+        const size_t count = fread(buffer, 1, sizeof(buffer), fp);
+        if (count == 0)
+        {
+            break;
+        }
+
+        if (!onOutput(buffer, count))
+        {
+            break;
+        }
+    }
+
+    // Returns 0 if no error occurred.
+    ret = ferror(fp);
+    if (ret != 0)
+    {
+        ADUCPAL_pclose(fp);
+        return ret;
+    }
+
+    return ADUCPAL_pclose(fp);
+}
+#else
+static int ADUC_LaunchChildProcessStreamOutputHelper(
+    const std::string& command,
+    std::vector<std::string> args,
+    const std::function<bool(const uint8_t* data, size_t size)>& onOutput)
+{
+    int filedes[2];
+    const int ret = pipe(filedes);
+    if (ret != 0)
+    {
+        Log_Error("Cannot create output pipe. %s (errno %d).", strerror(errno), errno);
+        return ret;
+    }
+
+    const int pid = fork();
+
+    if (pid == 0)
+    {
+        // Running inside child process.
+
+        // Redirect stdout to WRITE_END, and discard stderr so it cannot interleave with the data.
+        dup2(filedes[WRITE_END], STDOUT_FILENO);
+
+        const int devNull = open("/dev/null", O_WRONLY);
+        if (devNull != -1)
+        {
+            dup2(devNull, STDERR_FILENO);
+            close(devNull);
+        }
+
+        close(filedes[READ_END]);
+        close(filedes[WRITE_END]);
+
+        std::vector<char*> argv;
+        argv.reserve(args.size() + 2);
+        argv.emplace_back(const_cast<char*>(command.c_str())); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        for (const std::string& arg : args)
+        {
+            argv.emplace_back(const_cast<char*>(arg.c_str())); // NOLINT(cppcoreguidelines-pro-type-const-cast)
+        }
+        argv.emplace_back(nullptr);
+
+        execvp(command.c_str(), &argv[0]);
+
+        _exit(EXIT_FAILURE);
+    }
+
+    close(filedes[WRITE_END]);
+
+    if (pid == -1)
+    {
+        Log_Error("fork failed, error %d", errno);
+        close(filedes[READ_END]);
+        return EXIT_FAILURE;
+    }
+
+    bool aborted = false;
+    uint8_t buffer[64 * 1024];
+
+    for (;;)
+    {
+        const ssize_t count = read(filedes[READ_END], buffer, sizeof(buffer));
+
+        if (count == -1)
+        {
+            if (errno == EINTR)
+            {
+                continue;
+            }
+
+            Log_Error("Read failed, error %d", errno);
+            break;
+        }
+
+        if (count == 0)
+        {
+            break;
+        }
+
+        if (!onOutput(buffer, static_cast<size_t>(count)))
+        {
+            aborted = true;
+            kill(pid, SIGTERM);
+            break;
+        }
+    }
+
+    close(filedes[READ_END]);
+
+    int wstatus = 0;
+    waitpid(pid, &wstatus, 0);
+
+    if (aborted)
+    {
+        return EXIT_FAILURE;
+    }
+
+    if (WIFEXITED(wstatus))
+    {
+        return WEXITSTATUS(wstatus);
+    }
+
+    if (WIFSIGNALED(wstatus))
+    {
+        Log_Info("Child process terminated, signal %d", WTERMSIG(wstatus));
+        return WTERMSIG(wstatus);
+    }
+
+    Log_Error("Child process terminated abnormally.");
+    return EXIT_FAILURE;
+}
+#endif
+
+/**
+ * @brief Runs specified command in a new process and streams its raw standard output to @p onOutput.
+ *
+ * @param command Name of a command to run. If command doesn't contain '/', this function will
+ *               search for the specified command in PATH.
+ * @param args List of arguments for the command.
+ * @param onOutput Called for each chunk of output read. Returning false stops reading and terminates the child process.
+ *
+ * @return An exit code from the command.
+ */
+int ADUC_LaunchChildProcessStreamOutput(
+    const std::string& command,
+    std::vector<std::string> args,
+    const std::function<bool(const uint8_t* data, size_t size)>& onOutput)
+{
+    return ADUC_LaunchChildProcessStreamOutputHelper(command, std::move(args), onOutput);
+}
+
 /**
  * @brief Ensure that the effective group of the process is the given group (or is root).
  * @remark This function is not thread-safe if called with the defaults for the optional args.
@@ -0,0 +1,71 @@
+/**
+ * @file json_writer.h
+ * @brief A streaming JSON writer that appends a document to a growable buffer, without building a DOM.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#ifndef ADUC_JSON_WRITER_H
+#define ADUC_JSON_WRITER_H
+
+#include <aduc/c_utils.h>
+
+#include <stdbool.h> // for bool
+#include <stddef.h> // for size_t
+#include <stdint.h> // for int64_t
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief Default initial capacity of the writer buffer.
+ */
+#define ADUC_JSON_WRITER_DEFAULT_CAPACITY 1024
+
+/**
+ * @brief A JSON writer. The caller is responsible for emitting keys and values in a valid order;
+ * the writer only inserts the separators.
+ */
+typedef struct tagADUC_JsonWriter
+{
+    char* Buffer; /**< The nul-terminated document written so far. */
+    size_t Length; /**< The length of the document, excluding the nul terminator. */
+    size_t Capacity; /**< The allocated size of Buffer. */
+    bool NeedsSeparator; /**< Whether a ',' must precede the next key or value. */
+    bool Failed; /**< Set when an allocation fails; all further writes are ignored. */
+} ADUC_JsonWriter;
+
+bool ADUC_JsonWriter_Init(ADUC_JsonWriter* writer, size_t initialCapacity);
+
+void ADUC_JsonWriter_Uninit(ADUC_JsonWriter* writer);
+
+void ADUC_JsonWriter_Reset(ADUC_JsonWriter* writer);
+
+char* ADUC_JsonWriter_Detach(ADUC_JsonWriter* writer);
+
+void ADUC_JsonWriter_BeginObject(ADUC_JsonWriter* writer);
+
+void ADUC_JsonWriter_EndObject(ADUC_JsonWriter* writer);
+
+void ADUC_JsonWriter_BeginArray(ADUC_JsonWriter* writer);
+
+void ADUC_JsonWriter_EndArray(ADUC_JsonWriter* writer);
+
+void ADUC_JsonWriter_WriteKey(ADUC_JsonWriter* writer, const char* key);
+
+void ADUC_JsonWriter_WriteString(ADUC_JsonWriter* writer, const char* value);
+
+void ADUC_JsonWriter_BeginString(ADUC_JsonWriter* writer);
+
+void ADUC_JsonWriter_AppendStringContent(ADUC_JsonWriter* writer, const char* value);
+
+void ADUC_JsonWriter_EndString(ADUC_JsonWriter* writer);
+
+void ADUC_JsonWriter_WriteInt64(ADUC_JsonWriter* writer, int64_t value);
+
+void ADUC_JsonWriter_WriteNull(ADUC_JsonWriter* writer);
+
+bool ADUC_JsonWriter_HasFailed(const ADUC_JsonWriter* writer);
+
+EXTERN_C_END
+
+#endif // ADUC_JSON_WRITER_H
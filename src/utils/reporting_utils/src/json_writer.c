@@ -0,0 +1,332 @@
+/**
+ * @file json_writer.c
+ * @brief Implements a streaming JSON writer that appends a document to a growable buffer, without building a DOM.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "aduc/json_writer.h"
+
+#include <inttypes.h> // for PRId64
+#include <stdio.h> // for snprintf
+#include <stdlib.h> // for malloc, realloc, free
+#include <string.h> // for memcpy, strlen
+
+// keep this last to avoid interfering with system headers
+#include "aduc/aduc_banned.h"
+
+/**
+ * @brief Ensures there is room for @p count more characters plus the nul terminator.
+ *
+ * @param writer The writer.
+ * @param count The number of characters about to be appended.
+ * @return true if there is room; false if the writer is (now) in the failed state.
+ */
+static bool EnsureCapacity(ADUC_JsonWriter* writer, size_t count)
+{
+    if (writer->Failed)
+    {
+        return false;
+    }
+
+    size_t required = writer->Length + count + 1;
+    if (required <= writer->Capacity)
+    {
+        return true;
+    }
+
+    size_t newCapacity = writer->Capacity > 0 ? writer->Capacity : ADUC_JSON_WRITER_DEFAULT_CAPACITY;
+    while (newCapacity < required)
+    {
+        newCapacity *= 2;
+    }
+
+    char* newBuffer = realloc(writer->Buffer, newCapacity);
+    if (newBuffer == NULL)
+    {
+        writer->Failed = true;
+        return false;
+    }
+
+    writer->Buffer = newBuffer;
+    writer->Capacity = newCapacity;
+    return true;
+}
+
+static void AppendChars(ADUC_JsonWriter* writer, const char* chars, size_t count)
+{
+    if (!EnsureCapacity(writer, count))
+    {
+        return;
+    }
+
+    memcpy(writer->Buffer + writer->Length, chars, count);
+    writer->Length += count;
+    writer->Buffer[writer->Length] = '\0';
+}
+
+static void AppendChar(ADUC_JsonWriter* writer, char c)
+{
+    AppendChars(writer, &c, 1);
+}
+
+/**
+ * @brief Emits the ',' that separates this key or value from the previous one, if any.
+ */
+static void WriteSeparator(ADUC_JsonWriter* writer)
+{
+    if (writer->NeedsSeparator)
+    {
+        AppendChar(writer, ',');
+        writer->NeedsSeparator = false;
+    }
+}
+
+/**
+ * @brief Appends @p value with JSON string escaping. The escaping matches parson's serializer, so
+ * documents produced here are byte-for-byte what json_serialize_to_string() would produce.
+ */
+static void AppendEscaped(ADUC_JsonWriter* writer, const char* value)
+{
+    const char* runStart = value;
+    const char* p = value;
+
+    for (; *p != '\0'; ++p)
+    {
+        const unsigned char c = (unsigned char)*p;
+        const char* escape = NULL;
+        char unicodeEscape[7];
+
+        switch (c)
+        {
+        case '\"':
+            escape = "\\\"";
+            break;
+        case '\\':
+            escape = "\\\\";
+            break;
+        case '/':
+            escape = "\\/";
+            break;
+        case '\b':
+            escape = "\\b";
+            break;
+        case '\f':
+            escape = "\\f";
+            break;
+        case '\n':
+            escape = "\\n";
+            break;
+        case '\r':
+            escape = "\\r";
+            break;
+        case '\t':
+            escape = "\\t";
+            break;
+        default:
+            if (c < 0x20)
+            {
+                (void)snprintf(unicodeEscape, sizeof(unicodeEscape), "\\u%04x", c);
+                escape = unicodeEscape;
+            }
+            break;
+        }
+
+        if (escape != NULL)
+        {
+            // Flush the unescaped run before the escape sequence.
+            AppendChars(writer, runStart, (size_t)(p - runStart));
+            AppendChars(writer, escape, strlen(escape));
+            runStart = p + 1;
+        }
+    }
+
+    AppendChars(writer, runStart, (size_t)(p - runStart));
+}
+
+/**
+ * @brief Initializes a writer.
+ *
+ * @param writer The writer to initialize.
+ * @param initialCapacity The initial buffer size. Pass the size of a previous document of the same kind to avoid
+ * growing the buffer while writing. 0 means ADUC_JSON_WRITER_DEFAULT_CAPACITY.
+ * @return true on success; false if the buffer could not be allocated.
+ */
+bool ADUC_JsonWriter_Init(ADUC_JsonWriter* writer, size_t initialCapacity)
+{
+    memset(writer, 0, sizeof(*writer));
+
+    size_t capacity = initialCapacity > 0 ? initialCapacity : ADUC_JSON_WRITER_DEFAULT_CAPACITY;
+    writer->Buffer = malloc(capacity);
+    if (writer->Buffer == NULL)
+    {
+        writer->Failed = true;
+        return false;
+    }
+
+    writer->Buffer[0] = '\0';
+    writer->Capacity = capacity;
+    return true;
+}
+
+/**
+ * @brief Frees the writer buffer, if the writer still owns it.
+ *
+ * @param writer The writer.
+ */
+void ADUC_JsonWriter_Uninit(ADUC_JsonWriter* writer)
+{
+    if (writer == NULL)
+    {
+        return;
+    }
+
+    free(writer->Buffer);
+    memset(writer, 0, sizeof(*writer));
+}
+
+/**
+ * @brief Discards the document written so far but keeps the buffer, so the writer can be reused.
+ *
+ * @param writer The writer.
+ */
+void ADUC_JsonWriter_Reset(ADUC_JsonWriter* writer)
+{
+    writer->Length = 0;
+    writer->NeedsSeparator = false;
+    writer->Failed = writer->Buffer == NULL;
+    if (writer->Buffer != NULL)
+    {
+        writer->Buffer[0] = '\0';
+    }
+}
+
+/**
+ * @brief Transfers ownership of the document to the caller. The writer must be re-initialized before reuse.
+ *
+ * @param writer The writer.
+ * @return char* The nul-terminated document, or NULL if any write failed. Caller must free().
+ */
+char* ADUC_JsonWriter_Detach(ADUC_JsonWriter* writer)
+{
+    char* document = NULL;
+
+    if (!writer->Failed)
+    {
+        document = writer->Buffer;
+        writer->Buffer = NULL;
+    }
+
+    ADUC_JsonWriter_Uninit(writer);
+    return document;
+}
+
+void ADUC_JsonWriter_BeginObject(ADUC_JsonWriter* writer)
+{
+    WriteSeparator(writer);
+    AppendChar(writer, '{');
+}
+
+void ADUC_JsonWriter_EndObject(ADUC_JsonWriter* writer)
+{
+    AppendChar(writer, '}');
+    writer->NeedsSeparator = true;
+}
+
+void ADUC_JsonWriter_BeginArray(ADUC_JsonWriter* writer)
+{
+    WriteSeparator(writer);
+    AppendChar(writer, '[');
+}
+
+void ADUC_JsonWriter_EndArray(ADUC_JsonWriter* writer)
+{
+    AppendChar(writer, ']');
+    writer->NeedsSeparator = true;
+}
+
+/**
+ * @brief Writes an object member name and the ':' that follows it.
+ *
+ * @param writer The writer.
+ * @param key The member name.
+ */
+void ADUC_JsonWriter_WriteKey(ADUC_JsonWriter* writer, const char* key)
+{
+    WriteSeparator(writer);
+    AppendChar(writer, '\"');
+    AppendEscaped(writer, key);
+    AppendChars(writer, "\":", 2);
+}
+
+/**
+ * @brief Writes a string value.
+ *
+ * @param writer The writer.
+ * @param value The value. A NULL value is written as 'null'.
+ */
+void ADUC_JsonWriter_WriteString(ADUC_JsonWriter* writer, const char* value)
+{
+    if (value == NULL)
+    {
+        ADUC_JsonWriter_WriteNull(writer);
+        return;
+    }
+
+    ADUC_JsonWriter_BeginString(writer);
+    AppendEscaped(writer, value);
+    ADUC_JsonWriter_EndString(writer);
+}
+
+/**
+ * @brief Starts a string value whose content is appended in parts with ADUC_JsonWriter_AppendStringContent().
+ *
+ * @param writer The writer.
+ */
+void ADUC_JsonWriter_BeginString(ADUC_JsonWriter* writer)
+{
+    WriteSeparator(writer);
+    AppendChar(writer, '\"');
+}
+
+void ADUC_JsonWriter_AppendStringContent(ADUC_JsonWriter* writer, const char* value)
+{
+    if (value != NULL)
+    {
+        AppendEscaped(writer, value);
+    }
+}
+
+void ADUC_JsonWriter_EndString(ADUC_JsonWriter* writer)
+{
+    AppendChar(writer, '\"');
+    writer->NeedsSeparator = true;
+}
+
+void ADUC_JsonWriter_WriteInt64(ADUC_JsonWriter* writer, int64_t value)
+{
+    char number[24];
+    int length = snprintf(number, sizeof(number), "%" PRId64, value);
+
+    WriteSeparator(writer);
+    AppendChars(writer, number, (size_t)length);
+    writer->NeedsSeparator = true;
+}
+
+void ADUC_JsonWriter_WriteNull(ADUC_JsonWriter* writer)
+{
+    WriteSeparator(writer);
+    AppendChars(writer, "null", 4);
+    writer->NeedsSeparator = true;
+}
+
+/**
+ * @brief Gets whether any write failed. A failed writer's document is incomplete and must not be used.
+ *
+ * @param writer The writer.
+ * @return true if an allocation failed.
+ */
+bool ADUC_JsonWriter_HasFailed(const ADUC_JsonWriter* writer)
+{
+    return writer->Failed;
+}
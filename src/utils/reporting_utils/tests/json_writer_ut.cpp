@@ -0,0 +1,135 @@
+/**
+ * @file json_writer_ut.cpp
+ * @brief Unit Tests for the streaming JSON writer
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <catch2/catch.hpp>
+using Catch::Matchers::Equals;
+#include <aduc/json_writer.h>
+#include <stdlib.h>
+
+TEST_CASE("ADUC_JsonWriter nested objects")
+{
+    ADUC_JsonWriter writer;
+    REQUIRE(ADUC_JsonWriter_Init(&writer, 0));
+
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, "state");
+    ADUC_JsonWriter_WriteInt64(&writer, 6);
+    ADUC_JsonWriter_WriteKey(&writer, "lastInstallResult");
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, "resultCode");
+    ADUC_JsonWriter_WriteInt64(&writer, -1);
+    ADUC_JsonWriter_WriteKey(&writer, "resultDetails");
+    ADUC_JsonWriter_WriteString(&writer, nullptr);
+    ADUC_JsonWriter_WriteKey(&writer, "stepResults");
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_EndObject(&writer);
+    ADUC_JsonWriter_EndObject(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, "installedUpdateId");
+    ADUC_JsonWriter_WriteString(&writer, "id");
+    ADUC_JsonWriter_EndObject(&writer);
+
+    CHECK_FALSE(ADUC_JsonWriter_HasFailed(&writer));
+    CHECK_THAT(
+        writer.Buffer,
+        Equals(
+            R"({"state":6,"lastInstallResult":{"resultCode":-1,"resultDetails":null,"stepResults":{}},"installedUpdateId":"id"})"));
+
+    ADUC_JsonWriter_Uninit(&writer);
+}
+
+TEST_CASE("ADUC_JsonWriter escapes strings like parson")
+{
+    ADUC_JsonWriter writer;
+    REQUIRE(ADUC_JsonWriter_Init(&writer, 0));
+
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, "k\"ey");
+    ADUC_JsonWriter_WriteString(&writer, "a\\b/c\n\t\x01");
+    ADUC_JsonWriter_EndObject(&writer);
+
+    CHECK_THAT(writer.Buffer, Equals(R"({"k\"ey":"a\\b\/c\n\t\u0001"})"));
+
+    ADUC_JsonWriter_Uninit(&writer);
+}
+
+TEST_CASE("ADUC_JsonWriter arrays")
+{
+    ADUC_JsonWriter writer;
+    REQUIRE(ADUC_JsonWriter_Init(&writer, 0));
+
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, "spans");
+    ADUC_JsonWriter_BeginArray(&writer);
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, "n");
+    ADUC_JsonWriter_WriteInt64(&writer, 1);
+    ADUC_JsonWriter_EndObject(&writer);
+    ADUC_JsonWriter_BeginObject(&writer);
+    ADUC_JsonWriter_EndObject(&writer);
+    ADUC_JsonWriter_WriteInt64(&writer, 2);
+    ADUC_JsonWriter_EndArray(&writer);
+    ADUC_JsonWriter_WriteKey(&writer, "empty");
+    ADUC_JsonWriter_BeginArray(&writer);
+    ADUC_JsonWriter_EndArray(&writer);
+    ADUC_JsonWriter_EndObject(&writer);
+
+    CHECK_THAT(writer.Buffer, Equals(R"({"spans":[{"n":1},{},2],"empty":[]})"));
+
+    ADUC_JsonWriter_Uninit(&writer);
+}
+
+TEST_CASE("ADUC_JsonWriter string in parts")
+{
+    ADUC_JsonWriter writer;
+    REQUIRE(ADUC_JsonWriter_Init(&writer, 0));
+
+    ADUC_JsonWriter_BeginString(&writer);
+    ADUC_JsonWriter_AppendStringContent(&writer, "00000000");
+    ADUC_JsonWriter_AppendStringContent(&writer, nullptr);
+    ADUC_JsonWriter_AppendStringContent(&writer, ",30000001");
+    ADUC_JsonWriter_EndString(&writer);
+
+    CHECK_THAT(writer.Buffer, Equals(R"("00000000,30000001")"));
+
+    ADUC_JsonWriter_Uninit(&writer);
+}
+
+TEST_CASE("ADUC_JsonWriter grows, resets and detaches")
+{
+    ADUC_JsonWriter writer;
+    REQUIRE(ADUC_JsonWriter_Init(&writer, 4));
+
+    ADUC_JsonWriter_BeginObject(&writer);
+    for (int i = 0; i < 100; ++i)
+    {
+        ADUC_JsonWriter_WriteKey(&writer, "key");
+        ADUC_JsonWriter_WriteInt64(&writer, i);
+    }
+    ADUC_JsonWriter_EndObject(&writer);
+
+    CHECK_FALSE(ADUC_JsonWriter_HasFailed(&writer));
+    CHECK(writer.Capacity > writer.Length);
+
+    SECTION("reset keeps the buffer")
+    {
+        size_t capacity = writer.Capacity;
+        ADUC_JsonWriter_Reset(&writer);
+        ADUC_JsonWriter_WriteNull(&writer);
+        CHECK_THAT(writer.Buffer, Equals("null"));
+        CHECK(writer.Capacity == capacity);
+        ADUC_JsonWriter_Uninit(&writer);
+    }
+
+    SECTION("detach transfers ownership")
+    {
+        char* document = ADUC_JsonWriter_Detach(&writer);
+        REQUIRE(document != nullptr);
+        CHECK(document[0] == '{');
+        CHECK(writer.Buffer == nullptr);
+        free(document);
+    }
+}
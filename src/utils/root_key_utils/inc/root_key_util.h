@@ -11,6 +11,7 @@
 #include "aduc/rootkeypackage_types.h"
 #include "crypto_key.h"
 #include <stdbool.h>
+#include <stdint.h>
 #ifndef ROOT_KEY_UTIL_H
 #    define ROOT_KEY_UTIL_H
 
@@ -28,7 +29,9 @@ void RootKeyUtility_ClearReportingErc();
 ADUC_Result_t RootKeyUtility_GetReportingErc();
 bool ADUC_RootKeyUtility_IsUpdateStoreNeeded(const STRING_HANDLE storePath, const ADUC_RootKeyPackage* packageToTest);
 ADUC_Result RootKeyUtility_GetDisabledSigningKeys(VECTOR_HANDLE* outDisabledSigningKeyList);
+ADUC_Result RootKeyUtility_IsSigningKeyHashDisabled(const CONSTBUFFER_HANDLE sha256Hash, bool* outIsDisabled);
 bool RootKeyUtility_RootKeyIsDisabled(const ADUC_RootKeyPackage* rootKeyPackage, const char* keyId);
+uint64_t RootKeyUtility_GetLocalStoreGeneration(void);
 
 ADUC_Result RootKeyUtility_GetKeyForKidFromHardcodedKeys(CryptoKeyHandle* key, const char* kid);
 ADUC_Result RootKeyUtility_GetKeyForKid(CryptoKeyHandle* key, const char* kid);
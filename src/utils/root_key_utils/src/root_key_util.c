@@ -30,6 +30,8 @@
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdlib.h> // for bsearch, qsort
+#include <string.h> // for memcmp, strcmp
 
 //
 // Root Key Validation Helper Functions
@@ -262,24 +264,20 @@ done:
 }
 
 /**
- * @brief Validates the @p rootKeyPackage using a RSARootKEy
- * @details Helper function for RootKeyUtility_ValidateRootKeyPackageWithHardcodedKeys(). It explicitly does not check for disabled root keys.
+ * @brief Validates the @p rootKeyPackage signature made by the root key @p kid using @p rootKeyCryptoKey
  * @param rootKeyPackage package to be validated
- * @param rootKey the RSARootKey to be used for validation
+ * @param kid the key identifier of the root key
+ * @param rootKeyCryptoKey the root key
+ * @param isLongLivedKey whether @p rootKeyCryptoKey is kept for a long time, so its verification set up is cached
  * @return a value of ADUC_Result
  */
-ADUC_Result RootKeyUtility_ValidatePackageWithKey(const ADUC_RootKeyPackage* rootKeyPackage, const RSARootKey rootKey)
+static ADUC_Result ValidatePackageWithCryptoKey(
+    const ADUC_RootKeyPackage* rootKeyPackage, const char* kid, CryptoKeyHandle rootKeyCryptoKey, bool isLongLivedKey)
 {
     ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
-    CryptoKeyHandle rootKeyCryptoKey = NULL;
-
-    if (rootKeyPackage == NULL)
-    {
-        goto done;
-    }
 
     size_t signatureIndex = 0;
-    if (!RootKeyUtility_GetSignatureForKey(&signatureIndex, rootKeyPackage, rootKey.kid))
+    if (!RootKeyUtility_GetSignatureForKey(&signatureIndex, rootKeyPackage, kid))
     {
         result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYUTIL_SIGNATURE_FOR_KEY_NOT_FOUND;
         goto done;
@@ -295,20 +293,12 @@ ADUC_Result RootKeyUtility_ValidatePackageWithKey(const ADUC_RootKeyPackage* roo
         goto done;
     }
 
-    rootKeyCryptoKey = MakeCryptoKeyHandleFromRSARootkey(rootKey);
-
-    if (rootKeyCryptoKey == NULL)
-    {
-        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYUTIL_UNEXPECTED;
-        goto done;
-    }
-
     const char* protectedProperties = STRING_c_str(rootKeyPackage->protectedPropertiesJsonString);
     const size_t protectedPropertiesLength = STRING_length(rootKeyPackage->protectedPropertiesJsonString);
 
     const CONSTBUFFER* signatureHash = CONSTBUFFER_GetContent(signature->hash);
 
-    if (!CryptoUtils_IsValidSignature(
+    if (!(isLongLivedKey ? CryptoUtils_IsValidSignatureWithLongLivedKey : CryptoUtils_IsValidSignature)(
             CRYPTO_UTILS_SIGNATURE_VALIDATION_ALG_RS256,
             signatureHash->buffer,
             signatureHash->size,
@@ -322,6 +312,38 @@ ADUC_Result RootKeyUtility_ValidatePackageWithKey(const ADUC_RootKeyPackage* roo
 
     result.ResultCode = ADUC_GeneralResult_Success;
 
+done:
+
+    return result;
+}
+
+/**
+ * @brief Validates the @p rootKeyPackage using a RSARootKEy
+ * @details Helper function for RootKeyUtility_ValidateRootKeyPackageWithHardcodedKeys(). It explicitly does not check for disabled root keys.
+ * @param rootKeyPackage package to be validated
+ * @param rootKey the RSARootKey to be used for validation
+ * @return a value of ADUC_Result
+ */
+ADUC_Result RootKeyUtility_ValidatePackageWithKey(const ADUC_RootKeyPackage* rootKeyPackage, const RSARootKey rootKey)
+{
+    ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
+    CryptoKeyHandle rootKeyCryptoKey = NULL;
+
+    if (rootKeyPackage == NULL)
+    {
+        goto done;
+    }
+
+    rootKeyCryptoKey = MakeCryptoKeyHandleFromRSARootkey(rootKey);
+
+    if (rootKeyCryptoKey == NULL)
+    {
+        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYUTIL_UNEXPECTED;
+        goto done;
+    }
+
+    result = ValidatePackageWithCryptoKey(rootKeyPackage, rootKey.kid, rootKeyCryptoKey, false /* isLongLivedKey */);
+
 done:
 
     if (rootKeyCryptoKey != NULL)
@@ -355,8 +377,24 @@ ADUC_Result RootKeyUtility_ValidateRootKeyPackageWithHardcodedKeys(const ADUC_Ro
     for (size_t i = 0; i < numHardcodedKeys; ++i)
     {
         const RSARootKey rootKey = hardcodedRsaKeys[i];
+        ADUC_Result validationResult = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
+        CryptoKeyHandle rootKeyCryptoKey = NULL;
 
-        ADUC_Result validationResult = RootKeyUtility_ValidatePackageWithKey(rootKeyPackage, rootKey);
+        // Prefer the key already built for the hardcoded key index, which lives as long as the agent, so that
+        // signature verification can reuse the set up cached for it by crypto_lib.
+        const ADUC_Result getKeyResult = RootKeyUtility_GetKeyForKidFromHardcodedKeys(&rootKeyCryptoKey, rootKey.kid);
+
+        if (rootKeyPackage != NULL && IsAducResultCodeSuccess(getKeyResult.ResultCode))
+        {
+            validationResult =
+                ValidatePackageWithCryptoKey(rootKeyPackage, rootKey.kid, rootKeyCryptoKey, true /* isLongLivedKey */);
+        }
+        else
+        {
+            validationResult = RootKeyUtility_ValidatePackageWithKey(rootKeyPackage, rootKey);
+        }
+
+        CryptoUtils_FreeCryptoKeyHandle(rootKeyCryptoKey);
 
         if (IsAducResultCodeFailure(validationResult.ResultCode))
         {
@@ -472,24 +510,375 @@ done:
     return result;
 }
 
+//
+// Root Key Indexes
+//
+// Every JWS verification looks up a root key by kid and checks the disabled lists, so the keys are built once, when
+// the hardcoded list or the local store is first seen, and found by binary search afterwards.
+//
+
 /**
- * @brief Reloads the package from disk into the local store
+ * @brief An entry of a kid-indexed key table
+ */
+typedef struct tagRootKeyIndexEntry
+{
+    const char* kid; /**< The key identifier, borrowed from the source of the key. */
+    CryptoKeyHandle key; /**< The key, owned by the index. */
+} RootKeyIndexEntry;
+
+/**
+ * @brief A table of ready-to-use keys sorted by kid
+ */
+typedef struct tagRootKeyIndex
+{
+    RootKeyIndexEntry* entries; /**< The entries, sorted by kid. */
+    size_t count; /**< The number of entries. */
+} RootKeyIndex;
+
+// The index of the hardcoded keys, and the hardcoded list it was built from.
+static RootKeyIndex s_hardcodedKeyIndex = { .entries = NULL, .count = 0 };
+static const RSARootKey* s_hardcodedKeyIndexSource = NULL;
+static size_t s_hardcodedKeyIndexSourceCount = 0;
+
+// The indexes of s_localStore. Kids and hashes are borrowed from it, so these are rebuilt whenever it changes.
+static RootKeyIndex s_localStoreKeyIndex = { .entries = NULL, .count = 0 };
+static const char** s_disabledRootKids = NULL;
+static size_t s_disabledRootKidsCount = 0;
+static const CONSTBUFFER** s_disabledSigningKeyHashes = NULL;
+static size_t s_disabledSigningKeyHashesCount = 0;
+
+// Incremented whenever a package is loaded into s_localStore.
+static uint64_t s_localStoreGeneration = 0;
+
+static int CompareRootKeyIndexEntries(const void* lhs, const void* rhs)
+{
+    return strcmp(((const RootKeyIndexEntry*)lhs)->kid, ((const RootKeyIndexEntry*)rhs)->kid);
+}
+
+static int CompareKids(const void* lhs, const void* rhs)
+{
+    return strcmp(*(const char* const*)lhs, *(const char* const*)rhs);
+}
+
+static int CompareHashes(const void* lhs, const void* rhs)
+{
+    const CONSTBUFFER* lhsHash = *(const CONSTBUFFER* const*)lhs;
+    const CONSTBUFFER* rhsHash = *(const CONSTBUFFER* const*)rhs;
+
+    if (lhsHash->size != rhsHash->size)
+    {
+        return lhsHash->size < rhsHash->size ? -1 : 1;
+    }
+
+    return lhsHash->size == 0 ? 0 : memcmp(lhsHash->buffer, rhsHash->buffer, lhsHash->size);
+}
+
+static void RootKeyIndex_Clear(RootKeyIndex* index)
+{
+    for (size_t i = 0; i < index->count; ++i)
+    {
+        CryptoUtils_FreeCryptoKeyHandle(index->entries[i].key);
+    }
+
+    free(index->entries);
+    index->entries = NULL;
+    index->count = 0;
+}
+
+/**
+ * @brief Finds the key for @p kid in @p index
  *
- * @param filepath The path to the package on disk, or use the default with NULL.
- * @param validateSignatures Whether to validate root key pkg signatures.
- * @return a value of ADUC_Result
+ * @param index the index to search
+ * @param kid the key identifier
+ * @return the key, still owned by the index; NULL if there is none
  */
-ADUC_Result RootKeyUtility_ReloadPackageFromDisk(const char* filepath, bool validateSignatures)
+static CryptoKeyHandle RootKeyIndex_Find(const RootKeyIndex* index, const char* kid)
+{
+    if (index->count == 0 || kid == NULL)
+    {
+        return NULL;
+    }
+
+    const RootKeyIndexEntry seek = { .kid = kid, .key = NULL };
+    const RootKeyIndexEntry* found =
+        bsearch(&seek, index->entries, index->count, sizeof(RootKeyIndexEntry), CompareRootKeyIndexEntries);
+
+    return found == NULL ? NULL : found->key;
+}
+
+/**
+ * @brief Builds the index of the hardcoded keys, unless it was already built from the current hardcoded list
+ * @details A key that cannot be built is left out, and the index is then rebuilt on the next call.
+ * @return true on success; false on failure
+ */
+static bool EnsureHardcodedKeyIndex(void)
+{
+    bool success = false;
+    const RSARootKey* hardcodedRsaRootKeys = RootKeyList_GetHardcodedRsaRootKeys();
+    const size_t numberKeys = RootKeyList_numHardcodedKeys();
+
+    if (s_hardcodedKeyIndexSource != NULL && s_hardcodedKeyIndexSource == hardcodedRsaRootKeys
+        && s_hardcodedKeyIndexSourceCount == numberKeys)
+    {
+        return true;
+    }
+
+    RootKeyIndex_Clear(&s_hardcodedKeyIndex);
+    s_hardcodedKeyIndexSource = NULL;
+    s_hardcodedKeyIndexSourceCount = 0;
+
+    if (hardcodedRsaRootKeys == NULL || numberKeys == 0)
+    {
+        success = true;
+        goto done;
+    }
+
+    s_hardcodedKeyIndex.entries = (RootKeyIndexEntry*)calloc(numberKeys, sizeof(RootKeyIndexEntry));
+
+    if (s_hardcodedKeyIndex.entries == NULL)
+    {
+        goto done;
+    }
+
+    bool isComplete = true;
+
+    for (size_t i = 0; i < numberKeys; ++i)
+    {
+        CryptoKeyHandle key = IsNullOrEmpty(hardcodedRsaRootKeys[i].kid)
+            ? NULL
+            : MakeCryptoKeyHandleFromRSARootkey(hardcodedRsaRootKeys[i]);
+
+        if (key == NULL)
+        {
+            isComplete = false;
+            continue;
+        }
+
+        s_hardcodedKeyIndex.entries[s_hardcodedKeyIndex.count].kid = hardcodedRsaRootKeys[i].kid;
+        s_hardcodedKeyIndex.entries[s_hardcodedKeyIndex.count].key = key;
+        ++s_hardcodedKeyIndex.count;
+    }
+
+    qsort(
+        s_hardcodedKeyIndex.entries, s_hardcodedKeyIndex.count, sizeof(RootKeyIndexEntry), CompareRootKeyIndexEntries);
+
+    if (isComplete)
+    {
+        s_hardcodedKeyIndexSource = hardcodedRsaRootKeys;
+        s_hardcodedKeyIndexSourceCount = numberKeys;
+    }
+
+    success = true;
+
+done:
+
+    return success;
+}
+
+static void ClearLocalStoreIndexes(void)
+{
+    RootKeyIndex_Clear(&s_localStoreKeyIndex);
+
+    free((void*)s_disabledRootKids);
+    s_disabledRootKids = NULL;
+    s_disabledRootKidsCount = 0;
+
+    free((void*)s_disabledSigningKeyHashes);
+    s_disabledSigningKeyHashes = NULL;
+    s_disabledSigningKeyHashesCount = 0;
+}
+
+/**
+ * @brief Builds the kid-indexed root keys, the disabled root kids and the disabled SHA256 signing key hashes of
+ * s_localStore
+ * @details A root key that cannot be built is left out, the same as when it was built on each lookup.
+ * @return true on success; false on failure
+ */
+static bool BuildLocalStoreIndexes(void)
+{
+    bool success = false;
+
+    ClearLocalStoreIndexes();
+
+    if (s_localStore == NULL)
+    {
+        success = true;
+        goto done;
+    }
+
+    const size_t numStoreRootKeys = VECTOR_size(s_localStore->protectedProperties.rootKeys);
+
+    if (numStoreRootKeys > 0)
+    {
+        s_localStoreKeyIndex.entries = (RootKeyIndexEntry*)calloc(numStoreRootKeys, sizeof(RootKeyIndexEntry));
+
+        if (s_localStoreKeyIndex.entries == NULL)
+        {
+            goto done;
+        }
+    }
+
+    for (size_t i = 0; i < numStoreRootKeys; ++i)
+    {
+        const ADUC_RootKey* rootKey = VECTOR_element(s_localStore->protectedProperties.rootKeys, i);
+        const char* kid = rootKey == NULL ? NULL : STRING_c_str(rootKey->kid);
+
+        if (kid == NULL)
+        {
+            continue;
+        }
+
+        CryptoKeyHandle key = MakeCryptoKeyHandleFromADUC_RootKey(rootKey);
+
+        if (key == NULL)
+        {
+            Log_Warn("Cannot make key for root key '%s'", kid);
+            continue;
+        }
+
+        s_localStoreKeyIndex.entries[s_localStoreKeyIndex.count].kid = kid;
+        s_localStoreKeyIndex.entries[s_localStoreKeyIndex.count].key = key;
+        ++s_localStoreKeyIndex.count;
+    }
+
+    qsort(
+        s_localStoreKeyIndex.entries,
+        s_localStoreKeyIndex.count,
+        sizeof(RootKeyIndexEntry),
+        CompareRootKeyIndexEntries);
+
+    const size_t numDisabledKeys = VECTOR_size(s_localStore->protectedProperties.disabledRootKeys);
+
+    if (numDisabledKeys > 0)
+    {
+        s_disabledRootKids = (const char**)calloc(numDisabledKeys, sizeof(const char*));
+
+        if (s_disabledRootKids == NULL)
+        {
+            goto done;
+        }
+    }
+
+    for (size_t i = 0; i < numDisabledKeys; ++i)
+    {
+        const STRING_HANDLE* disabledKey = VECTOR_element(s_localStore->protectedProperties.disabledRootKeys, i);
+
+        if (disabledKey != NULL && STRING_c_str(*disabledKey) != NULL)
+        {
+            s_disabledRootKids[s_disabledRootKidsCount++] = STRING_c_str(*disabledKey);
+        }
+    }
+
+    qsort((void*)s_disabledRootKids, s_disabledRootKidsCount, sizeof(const char*), CompareKids);
+
+    const size_t numDisabledSigningKeys = VECTOR_size(s_localStore->protectedProperties.disabledSigningKeys);
+
+    if (numDisabledSigningKeys > 0)
+    {
+        s_disabledSigningKeyHashes = (const CONSTBUFFER**)calloc(numDisabledSigningKeys, sizeof(const CONSTBUFFER*));
+
+        if (s_disabledSigningKeyHashes == NULL)
+        {
+            goto done;
+        }
+    }
+
+    for (size_t i = 0; i < numDisabledSigningKeys; ++i)
+    {
+        const ADUC_RootKeyPackage_Hash* disabledSigningKey =
+            VECTOR_element(s_localStore->protectedProperties.disabledSigningKeys, i);
+
+        if (disabledSigningKey != NULL && disabledSigningKey->alg == SHA256 && disabledSigningKey->hash != NULL)
+        {
+            s_disabledSigningKeyHashes[s_disabledSigningKeyHashesCount++] =
+                CONSTBUFFER_GetContent(disabledSigningKey->hash);
+        }
+    }
+
+    qsort(
+        (void*)s_disabledSigningKeyHashes,
+        s_disabledSigningKeyHashesCount,
+        sizeof(const CONSTBUFFER*),
+        CompareHashes);
+
+    success = true;
+
+done:
+
+    if (!success)
+    {
+        ClearLocalStoreIndexes();
+    }
+
+    return success;
+}
+
+/**
+ * @brief Makes @p rootKeyPackage the local store, destroying the previous one, and rebuilds the local store indexes
+ * @details If the indexes cannot be built, @p rootKeyPackage is destroyed and the local store is left unloaded.
+ * @param rootKeyPackage the loaded root key package, or NULL. Ownership is transferred.
+ * @return true on success; false on failure
+ */
+static bool SetLocalStore(ADUC_RootKeyPackage* rootKeyPackage)
 {
+    ClearLocalStoreIndexes();
+
     if (s_localStore != NULL)
+    {
+        ADUC_RootKeyPackageUtils_Destroy(s_localStore);
+        free(s_localStore);
+    }
+
+    s_localStore = rootKeyPackage;
+
+    if (!BuildLocalStoreIndexes())
     {
         ADUC_RootKeyPackageUtils_Destroy(s_localStore);
         free(s_localStore);
         s_localStore = NULL;
+        return false;
+    }
+
+    if (s_localStore != NULL)
+    {
+        ++s_localStoreGeneration;
     }
 
-    return RootKeyUtility_LoadPackageFromDisk(
-        &s_localStore, filepath == NULL ? ADUC_ROOTKEY_STORE_PACKAGE_PATH : filepath, validateSignatures);
+    return true;
+}
+
+/**
+ * @brief Loads the package at @p filepath into the local store, and builds its indexes
+ *
+ * @param filepath the path to the package on disk
+ * @param validateSignatures whether to validate the package with hard-coded keys
+ * @return a value of ADUC_Result
+ */
+static ADUC_Result LoadLocalStore(const char* filepath, bool validateSignatures)
+{
+    ADUC_RootKeyPackage* rootKeyPackage = NULL;
+
+    ADUC_Result result = RootKeyUtility_LoadPackageFromDisk(&rootKeyPackage, filepath, validateSignatures);
+
+    if (!SetLocalStore(rootKeyPackage))
+    {
+        result.ResultCode = ADUC_GeneralResult_Failure;
+        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYUTIL_ERRNOMEM;
+    }
+
+    return result;
+}
+
+/**
+ * @brief Reloads the package from disk into the local store
+ *
+ * @param filepath The path to the package on disk, or use the default with NULL.
+ * @param validateSignatures Whether to validate root key pkg signatures.
+ * @return a value of ADUC_Result
+ */
+ADUC_Result RootKeyUtility_ReloadPackageFromDisk(const char* filepath, bool validateSignatures)
+{
+    return LoadLocalStore(filepath == NULL ? ADUC_ROOTKEY_STORE_PACKAGE_PATH : filepath, validateSignatures);
 }
 
 /**
@@ -588,6 +977,12 @@ bool RootKeyUtility_RootKeyIsDisabled(const ADUC_RootKeyPackage* rootKeyPackage,
         return true;
     }
 
+    if (rootKeyPackage == s_localStore)
+    {
+        return keyId != NULL && s_disabledRootKidsCount > 0
+            && bsearch(&keyId, s_disabledRootKids, s_disabledRootKidsCount, sizeof(const char*), CompareKids) != NULL;
+    }
+
     const size_t numDisabledKeys = VECTOR_size(rootKeyPackage->protectedProperties.disabledRootKeys);
 
     for (size_t i = 0; i < numDisabledKeys; ++i)
@@ -611,26 +1006,14 @@ bool RootKeyUtility_RootKeyIsDisabled(const ADUC_RootKeyPackage* rootKeyPackage,
  */
 CryptoKeyHandle RootKeyUtility_SearchLocalStoreForKey(const char* keyId)
 {
-    CryptoKeyHandle key = NULL;
-
-    if (s_localStore == NULL)
+    if (s_localStore == NULL || RootKeyUtility_RootKeyIsDisabled(s_localStore, keyId))
     {
-        return key;
+        return NULL;
     }
 
-    const size_t numStoreRootKeys = VECTOR_size(s_localStore->protectedProperties.rootKeys);
+    CryptoKeyHandle key = RootKeyIndex_Find(&s_localStoreKeyIndex, keyId);
 
-    for (size_t i = 0; i < numStoreRootKeys; ++i)
-    {
-        ADUC_RootKey* rootKey = VECTOR_element(s_localStore->protectedProperties.rootKeys, i);
-
-        if (strcmp(STRING_c_str(rootKey->kid), keyId) == 0 && !RootKeyUtility_RootKeyIsDisabled(s_localStore, keyId))
-        {
-            key = MakeCryptoKeyHandleFromADUC_RootKey(rootKey);
-        }
-    }
-
-    return key;
+    return key == NULL ? NULL : CryptoUtils_DuplicateCryptoKeyHandle(key);
 }
 
 /**
@@ -673,16 +1056,17 @@ ADUC_Result RootKeyUtility_GetKeyForKidFromHardcodedKeys(CryptoKeyHandle* key, c
     ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
     CryptoKeyHandle tempKey = NULL;
 
-    const RSARootKey* hardcodedRsaRootKeys = RootKeyList_GetHardcodedRsaRootKeys();
+    if (!EnsureHardcodedKeyIndex())
+    {
+        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYUTIL_ERRNOMEM;
+        goto done;
+    }
 
-    const size_t numberKeys = RootKeyList_numHardcodedKeys();
-    for (size_t i = 0; i < numberKeys; ++i)
+    tempKey = RootKeyIndex_Find(&s_hardcodedKeyIndex, kid);
+
+    if (tempKey != NULL)
     {
-        if (strcmp(hardcodedRsaRootKeys[i].kid, kid) == 0)
-        {
-            tempKey = MakeCryptoKeyHandleFromRSARootkey(hardcodedRsaRootKeys[i]);
-            break;
-        }
+        tempKey = CryptoUtils_DuplicateCryptoKeyHandle(tempKey);
     }
 
     if (tempKey == NULL)
@@ -719,8 +1103,7 @@ ADUC_Result RootKeyUtility_GetKeyForKid(CryptoKeyHandle* key, const char* kid)
     if (s_localStore == NULL)
     {
         const char* rootKeyStorePath = RootKeyStore_GetRootKeyStorePath();
-        ADUC_Result loadResult =
-            RootKeyUtility_LoadPackageFromDisk(&s_localStore, rootKeyStorePath, true /* validateSignatures */);
+        ADUC_Result loadResult = LoadLocalStore(rootKeyStorePath, true /* validateSignatures */);
 
         if (IsAducResultCodeFailure(loadResult.ResultCode))
         {
@@ -852,8 +1235,7 @@ ADUC_Result RootKeyUtility_GetDisabledSigningKeys(VECTOR_HANDLE* outDisabledSign
 
     if (s_localStore == NULL)
     {
-        ADUC_Result loadResult = RootKeyUtility_LoadPackageFromDisk(
-            &s_localStore, ADUC_ROOTKEY_STORE_PACKAGE_PATH, true /* validateSignatures */);
+        ADUC_Result loadResult = LoadLocalStore(ADUC_ROOTKEY_STORE_PACKAGE_PATH, true /* validateSignatures */);
 
         if (IsAducResultCodeFailure(loadResult.ResultCode))
         {
@@ -894,3 +1276,73 @@ done:
 
     return result;
 }
+
+/**
+ * @brief Checks whether @p sha256Hash, the SHA256 hash of a signing key's public key, is in the disabledSigningKeys of
+ * the local store
+ * @details Loads the local store if it is not already loaded. Unlike RootKeyUtility_GetDisabledSigningKeys(), this
+ * does not copy the list.
+ * @param sha256Hash the SHA256 hash of the public key of the signing key
+ * @param outIsDisabled set to true if the signing key is disabled; false if it isn't
+ * @return a value of ADUC_Result
+ */
+ADUC_Result RootKeyUtility_IsSigningKeyHashDisabled(const CONSTBUFFER_HANDLE sha256Hash, bool* outIsDisabled)
+{
+    ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
+
+    if (sha256Hash == NULL || outIsDisabled == NULL)
+    {
+        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYUTIL_BAD_ARGS;
+        goto done;
+    }
+
+    if (s_localStore == NULL)
+    {
+        ADUC_Result loadResult = LoadLocalStore(ADUC_ROOTKEY_STORE_PACKAGE_PATH, true /* validateSignatures */);
+
+        if (IsAducResultCodeFailure(loadResult.ResultCode))
+        {
+            Log_Error("Fail load pkg from disk: 0x%08x", loadResult.ExtendedResultCode);
+            result = loadResult;
+            goto done;
+        }
+    }
+
+    const CONSTBUFFER* seekHash = CONSTBUFFER_GetContent(sha256Hash);
+
+    *outIsDisabled = s_disabledSigningKeyHashesCount > 0
+        && bsearch(
+               &seekHash,
+               s_disabledSigningKeyHashes,
+               s_disabledSigningKeyHashesCount,
+               sizeof(const CONSTBUFFER*),
+               CompareHashes)
+            != NULL;
+
+    result.ResultCode = ADUC_GeneralResult_Success;
+
+done:
+
+    return result;
+}
+
+/**
+ * @brief Gets the generation of the local store, which changes whenever a package is loaded into it
+ * @details Loads the local store if it is not already loaded. Results that depend on the root keys, e.g. verified
+ * signatures, are only valid for as long as the generation they were computed under is current.
+ * @return the generation of the local store; 0 if it is not loaded
+ */
+uint64_t RootKeyUtility_GetLocalStoreGeneration(void)
+{
+    if (s_localStore == NULL)
+    {
+        ADUC_Result loadResult = LoadLocalStore(RootKeyStore_GetRootKeyStorePath(), true /* validateSignatures */);
+
+        if (IsAducResultCodeFailure(loadResult.ResultCode))
+        {
+            return 0;
+        }
+    }
+
+    return s_localStore == NULL ? 0 : s_localStoreGeneration;
+}
@@ -312,6 +312,60 @@ TEST_CASE("RootKeyUtility_GetDisabledSigningKeys")
     }
 }
 
+TEST_CASE("RootKeyUtility_IsSigningKeyHashDisabled")
+{
+    uint8_t* disabledHashBytes = nullptr;
+    const size_t disabledHashSize = Base64URLDecode("q5xF2ARjhdtH-kaLNTwZAMoXdy0iJQjziQ_AyZWDPRA", &disabledHashBytes);
+    REQUIRE(disabledHashSize > 0);
+    uint8_t_wrapper disabledHashBytesWrapper{ disabledHashBytes };
+
+    std::vector<uint8_t> otherHashBytes{ disabledHashBytes, disabledHashBytes + disabledHashSize };
+    otherHashBytes[0] ^= 0xff;
+
+    CONSTBUFFER_HANDLE disabledHash = CONSTBUFFER_Create(disabledHashBytes, disabledHashSize);
+    REQUIRE(disabledHash != nullptr);
+    CONSTBUFFER_HANDLE otherHash = CONSTBUFFER_Create(otherHashBytes.data(), otherHashBytes.size());
+    REQUIRE(otherHash != nullptr);
+
+    SECTION("bad args")
+    {
+        bool isDisabled = false;
+        CHECK(IsAducResultCodeFailure(RootKeyUtility_IsSigningKeyHashDisabled(nullptr, &isDisabled).ResultCode));
+        CHECK(IsAducResultCodeFailure(RootKeyUtility_IsSigningKeyHashDisabled(disabledHash, nullptr).ResultCode));
+    }
+
+    SECTION("prod - no disabled signing keys")
+    {
+        std::string filePath = get_prod_disabled_rootkey_package_json_path();
+        ADUC_Result lResult = RootKeyUtility_ReloadPackageFromDisk(filePath.c_str(), false /* validateSignatures */);
+        REQUIRE(IsAducResultCodeSuccess(lResult.ResultCode));
+
+        bool isDisabled = true;
+        ADUC_Result result = RootKeyUtility_IsSigningKeyHashDisabled(disabledHash, &isDisabled);
+        REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+        CHECK_FALSE(isDisabled);
+    }
+
+    SECTION("prod - one disabled signing key")
+    {
+        std::string filePath = get_prod_disabled_signingkey_package_json_path();
+        ADUC_Result lResult = RootKeyUtility_ReloadPackageFromDisk(filePath.c_str(), false /* validateSignatures */);
+        REQUIRE(IsAducResultCodeSuccess(lResult.ResultCode));
+
+        bool isDisabled = false;
+        ADUC_Result result = RootKeyUtility_IsSigningKeyHashDisabled(disabledHash, &isDisabled);
+        REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+        CHECK(isDisabled);
+
+        result = RootKeyUtility_IsSigningKeyHashDisabled(otherHash, &isDisabled);
+        REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+        CHECK_FALSE(isDisabled);
+    }
+
+    CONSTBUFFER_DecRef(disabledHash);
+    CONSTBUFFER_DecRef(otherHash);
+}
+
 TEST_CASE_METHOD(GetRootKeyValidationMockHook, "RootKeyUtility_GetKeyForKid")
 {
     SECTION("Get hardcoded key")
@@ -369,6 +423,28 @@ TEST_CASE_METHOD(GetRootKeyValidationMockHook, "RootKeyUtility_GetKeyForKid")
 
         CryptoUtils_FreeCryptoKeyHandle(key);
     }
+    SECTION("Get key from store, keys are independently freed")
+    {
+        g_mockedRootKeyStorePath = get_valid_example_rootkey_package_json_path();
+
+        RootKeyUtility_ReloadPackageFromDisk(g_mockedRootKeyStorePath.c_str(), true /* validateSignatures */);
+        CryptoKeyHandle key1 = nullptr;
+        CryptoKeyHandle key2 = nullptr;
+
+        CHECK(IsAducResultCodeSuccess(RootKeyUtility_GetKeyForKid(&key1, "testrootkey1").ResultCode));
+        CHECK(key1 != nullptr);
+        CryptoUtils_FreeCryptoKeyHandle(key1);
+
+        CHECK(IsAducResultCodeSuccess(RootKeyUtility_GetKeyForKid(&key2, "testrootkey1").ResultCode));
+        CHECK(key2 != nullptr);
+        CryptoUtils_FreeCryptoKeyHandle(key2);
+
+        // Reloading rebuilds the keys of the store.
+        RootKeyUtility_ReloadPackageFromDisk(g_mockedRootKeyStorePath.c_str(), true /* validateSignatures */);
+        CHECK(IsAducResultCodeSuccess(RootKeyUtility_GetKeyForKid(&key1, "testrootkey2").ResultCode));
+        CHECK(key1 != nullptr);
+        CryptoUtils_FreeCryptoKeyHandle(key1);
+    }
     SECTION("Get non-existent key")
     {
         // set the store path to the valid package tht we know contains the hardcoded key
@@ -386,3 +462,28 @@ TEST_CASE_METHOD(GetRootKeyValidationMockHook, "RootKeyUtility_GetKeyForKid")
         CHECK(key == nullptr);
     }
 }
+
+TEST_CASE_METHOD(GetRootKeyValidationMockHook, "RootKeyUtility_GetLocalStoreGeneration")
+{
+    g_mockedRootKeyStorePath = get_valid_example_rootkey_package_json_path();
+
+    ADUC_Result result =
+        RootKeyUtility_ReloadPackageFromDisk(g_mockedRootKeyStorePath.c_str(), true /* validateSignatures */);
+    REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+
+    const uint64_t generation = RootKeyUtility_GetLocalStoreGeneration();
+    CHECK(generation != 0);
+    CHECK(RootKeyUtility_GetLocalStoreGeneration() == generation);
+
+    // Reloading the store changes the generation.
+    result = RootKeyUtility_ReloadPackageFromDisk(g_mockedRootKeyStorePath.c_str(), true /* validateSignatures */);
+    REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+    CHECK(RootKeyUtility_GetLocalStoreGeneration() != generation);
+    CHECK(RootKeyUtility_GetLocalStoreGeneration() != 0);
+
+    // No store is loaded.
+    g_mockedRootKeyStorePath = get_nonexistent_example_rootkey_package_json_path();
+    result = RootKeyUtility_ReloadPackageFromDisk(g_mockedRootKeyStorePath.c_str(), true /* validateSignatures */);
+    CHECK(IsAducResultCodeFailure(result.ResultCode));
+    CHECK(RootKeyUtility_GetLocalStoreGeneration() == 0);
+}
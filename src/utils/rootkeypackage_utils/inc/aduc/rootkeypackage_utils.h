@@ -25,6 +25,8 @@ ADUC_Result ADUC_RootKeyPackageUtils_DownloadPackage(
 
 ADUC_Result ADUC_RootKeyPackageUtils_Parse(const char* jsonString, ADUC_RootKeyPackage* outRootKeyPackage);
 
+ADUC_Result ADUC_RootKeyPackageUtils_ParseFile(const char* filePath, ADUC_RootKeyPackage* outRootKeyPackage);
+
 char* ADUC_RootKeyPackageUtils_SerializePackageToJsonString(const ADUC_RootKeyPackage* rootKeyPackage);
 
 void ADUC_RootKeyPackageUtils_DisabledRootKeys_Destroy(ADUC_RootKeyPackage* rootKeyPackage);
@@ -20,38 +20,21 @@
 EXTERN_C_BEGIN
 
 /**
- * @brief Parses JSON string into an ADUC_RootKeyPackage struct.
+ * @brief Parses the root JSON value of a root key package into an ADUC_RootKeyPackage struct.
  *
- * @param jsonString The root key package JSON string to parse.
+ * @param rootValue The parsed root key package JSON. May be NULL if parsing failed.
  * @param outRootKeyPackage parameter for the resultant ADUC_RootKeyPackage.
  *
  * @return ADUC_Result The result of parsing.
- * @details Caller must call ADUC_RootKeyPackageUtils_Cleanup() on the resultant ADUC_RootKeyPackage.
  */
-ADUC_Result ADUC_RootKeyPackageUtils_Parse(const char* jsonString, ADUC_RootKeyPackage* outRootKeyPackage)
+static ADUC_Result ParseRootKeyPackageJsonValue(const JSON_Value* rootValue, ADUC_RootKeyPackage* outRootKeyPackage)
 {
     ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
 
     ADUC_RootKeyPackage pkg;
     memset(&pkg, 0, sizeof(pkg));
 
-    JSON_Value* rootValue = NULL;
-    JSON_Object* rootObj = NULL;
-
-    if (IsNullOrEmpty(jsonString) || outRootKeyPackage == NULL)
-    {
-        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYPKG_UTIL_ERROR_BAD_ARG;
-        return result;
-    }
-
-    rootValue = json_parse_string(jsonString);
-    if (rootValue == NULL)
-    {
-        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYPKG_UTIL_ERROR_BAD_JSON;
-        goto done;
-    }
-
-    rootObj = json_object(rootValue);
+    JSON_Object* rootObj = json_value_get_object(rootValue);
     if (rootObj == NULL)
     {
         result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYPKG_UTIL_ERROR_BAD_JSON;
@@ -82,7 +65,6 @@ ADUC_Result ADUC_RootKeyPackageUtils_Parse(const char* jsonString, ADUC_RootKeyP
     result.ResultCode = ADUC_GeneralResult_Success;
 
 done:
-    json_value_free(rootValue);
 
     if (IsAducResultCodeFailure(result.ResultCode))
     {
@@ -92,6 +74,59 @@ done:
     return result;
 }
 
+/**
+ * @brief Parses JSON string into an ADUC_RootKeyPackage struct.
+ *
+ * @param jsonString The root key package JSON string to parse.
+ * @param outRootKeyPackage parameter for the resultant ADUC_RootKeyPackage.
+ *
+ * @return ADUC_Result The result of parsing.
+ * @details Caller must call ADUC_RootKeyPackageUtils_Cleanup() on the resultant ADUC_RootKeyPackage.
+ */
+ADUC_Result ADUC_RootKeyPackageUtils_Parse(const char* jsonString, ADUC_RootKeyPackage* outRootKeyPackage)
+{
+    ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
+
+    if (IsNullOrEmpty(jsonString) || outRootKeyPackage == NULL)
+    {
+        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYPKG_UTIL_ERROR_BAD_ARG;
+        return result;
+    }
+
+    JSON_Value* rootValue = json_parse_string(jsonString);
+    result = ParseRootKeyPackageJsonValue(rootValue, outRootKeyPackage);
+    json_value_free(rootValue);
+
+    return result;
+}
+
+/**
+ * @brief Parses a root key package file into an ADUC_RootKeyPackage struct.
+ *
+ * @param filePath The path to the root key package JSON file.
+ * @param outRootKeyPackage parameter for the resultant ADUC_RootKeyPackage.
+ *
+ * @return ADUC_Result The result of parsing.
+ * @details Equivalent to ADUC_RootKeyPackageUtils_Parse() on the file content, without reading the file into a
+ * string first. Caller must call ADUC_RootKeyPackageUtils_Cleanup() on the resultant ADUC_RootKeyPackage.
+ */
+ADUC_Result ADUC_RootKeyPackageUtils_ParseFile(const char* filePath, ADUC_RootKeyPackage* outRootKeyPackage)
+{
+    ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
+
+    if (IsNullOrEmpty(filePath) || outRootKeyPackage == NULL)
+    {
+        result.ExtendedResultCode = ADUC_ERC_UTILITIES_ROOTKEYPKG_UTIL_ERROR_BAD_ARG;
+        return result;
+    }
+
+    JSON_Value* rootValue = json_parse_file(filePath);
+    result = ParseRootKeyPackageJsonValue(rootValue, outRootKeyPackage);
+    json_value_free(rootValue);
+
+    return result;
+}
+
 /**
  * @brief Helper function for comparing two ADUC_RootKeys
  *
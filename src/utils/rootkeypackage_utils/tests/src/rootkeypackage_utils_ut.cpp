@@ -9,6 +9,7 @@
 #include "rootkeypkgtestutils.hpp"
 #include <aduc/file_test_utils.hpp>
 #include <aduc/hash_utils.h>
+#include <aduc/rootkeypackage_parse.h> // ADUC_RootKeyPackageUtils_AreEqual
 #include <aduc/rootkeypackage_types.h>
 #include <aduc/rootkeypackage_utils.h>
 #include <algorithm>
@@ -388,3 +389,37 @@ TEST_CASE("RootKeyPackageUtils_Parse")
         CHECK_FALSE(pkg.protectedProperties.isTest);
     }
 }
+
+TEST_CASE("RootKeyPackageUtils_ParseFile")
+{
+    SECTION("bad args")
+    {
+        ADUC_RootKeyPackage pkg{};
+
+        ADUC_Result result = ADUC_RootKeyPackageUtils_ParseFile(nullptr, &pkg);
+        REQUIRE(IsAducResultCodeFailure(result.ResultCode));
+        CHECK(result.ExtendedResultCode == ADUC_ERC_UTILITIES_ROOTKEYPKG_UTIL_ERROR_BAD_ARG);
+
+        result = ADUC_RootKeyPackageUtils_ParseFile("/nonexistent/rootkeypackage.json", &pkg);
+        REQUIRE(IsAducResultCodeFailure(result.ResultCode));
+        CHECK(result.ExtendedResultCode == ADUC_ERC_UTILITIES_ROOTKEYPKG_UTIL_ERROR_BAD_JSON);
+    }
+
+    SECTION("same as parsing the file content")
+    {
+        std::string rootkey_pkg_json = aduc::FileTestUtils_slurpFile(get_example_rootkey_package_json_path());
+
+        ADUC_RootKeyPackage pkgFromString{};
+        ADUC_Result result = ADUC_RootKeyPackageUtils_Parse(rootkey_pkg_json.c_str(), &pkgFromString);
+        REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+
+        ADUC_RootKeyPackage pkgFromFile{};
+        result = ADUC_RootKeyPackageUtils_ParseFile(get_example_rootkey_package_json_path().c_str(), &pkgFromFile);
+        REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+
+        CHECK(ADUC_RootKeyPackageUtils_AreEqual(&pkgFromString, &pkgFromFile));
+
+        ADUC_RootKeyPackageUtils_Destroy(&pkgFromString);
+        ADUC_RootKeyPackageUtils_Destroy(&pkgFromFile);
+    }
+}
@@ -0,0 +1,107 @@
+/**
+ * @file timing_utils.h
+ * @brief Lightweight, monotonic-clock spans that record where a deployment spends its time.
+ *
+ * Spans are recorded into a deployment timing report, which is owned by the root workflow of the deployment
+ * (see workflow_get_timing_report()). Code that has no workflow at hand, e.g. hashing or D2C reporting, records
+ * into the report last set with ADUC_Timing_SetCurrentReport() in the same module, if any.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#ifndef ADUC_TIMING_UTILS_H
+#define ADUC_TIMING_UTILS_H
+
+#include <aduc/c_utils.h>
+#include <aduc/json_writer.h>
+
+#include <stdbool.h> // for bool
+#include <stdint.h> // for uint64_t
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief Maximum number of individual spans kept in a report. Later spans still count toward the phase totals.
+ */
+#define ADUC_TIMING_MAX_SPANS 512
+
+/**
+ * @brief Maximum number of distinct phases in a report.
+ */
+#define ADUC_TIMING_MAX_PHASES 16
+
+/**
+ * @brief Size of the buffer for a span's detail, e.g. a file or handler name. Longer details are truncated.
+ */
+#define ADUC_TIMING_MAX_DETAIL_SIZE 64
+
+/**
+ * @brief Level or step index of a span that is not associated with a workflow step, e.g. hashing or reporting.
+ */
+#define ADUC_TIMING_NO_LEVEL -1
+
+//
+// Phase names. Phases are compared by value, but must have static storage duration.
+//
+#define ADUC_TIMING_PHASE_MANIFEST_VALIDATION "manifestValidation"
+#define ADUC_TIMING_PHASE_WORKFLOW_STEP "workflowStep"
+#define ADUC_TIMING_PHASE_HANDLER_LOAD "handlerLoad"
+#define ADUC_TIMING_PHASE_DOWNLOAD "download"
+#define ADUC_TIMING_PHASE_HASH "hash"
+#define ADUC_TIMING_PHASE_INSTALL "install"
+#define ADUC_TIMING_PHASE_APPLY "apply"
+#define ADUC_TIMING_PHASE_REPORTING "reporting"
+
+/**
+ * @brief A deployment timing report. Reference counted, and safe to record into from multiple threads.
+ */
+typedef struct tagADUC_TimingReport ADUC_TimingReport;
+
+/**
+ * @brief A span that has been started but not yet recorded.
+ */
+typedef struct tagADUC_TimingSpan
+{
+    const char* Phase; /**< The phase, one of the ADUC_TIMING_PHASE_* names. */
+    char Detail[ADUC_TIMING_MAX_DETAIL_SIZE]; /**< What was timed within the phase, e.g. a file name. */
+    int Level; /**< The workflow level, or ADUC_TIMING_NO_LEVEL. */
+    int StepIndex; /**< The step index within the workflow level, or ADUC_TIMING_NO_LEVEL. */
+    uint64_t StartMs; /**< The monotonic start time, in milliseconds. */
+} ADUC_TimingSpan;
+
+uint64_t ADUC_Timing_GetMonotonicTimeMs(void);
+
+ADUC_TimingReport* ADUC_TimingReport_Create(void);
+
+void ADUC_TimingReport_AddRef(ADUC_TimingReport* report);
+
+void ADUC_TimingReport_Release(ADUC_TimingReport* report);
+
+void ADUC_TimingReport_RecordSpan(
+    ADUC_TimingReport* report,
+    const char* phase,
+    const char* detail,
+    int level,
+    int stepIndex,
+    uint64_t startMs,
+    uint64_t durationMs);
+
+void ADUC_TimingReport_WriteJson(ADUC_TimingReport* report, const char* workflowId, ADUC_JsonWriter* writer);
+
+void ADUC_TimingReport_WritePhaseTotals(ADUC_TimingReport* report, ADUC_JsonWriter* writer);
+
+char* ADUC_TimingReport_CreateJson(ADUC_TimingReport* report, const char* workflowId);
+
+void ADUC_Timing_BeginSpan(ADUC_TimingSpan* span, const char* phase, const char* detail, int level, int stepIndex);
+
+void ADUC_Timing_EndSpan(ADUC_TimingReport* report, const ADUC_TimingSpan* span);
+
+void ADUC_Timing_EndSpanInCurrentReport(const ADUC_TimingSpan* span);
+
+void ADUC_Timing_SetCurrentReport(ADUC_TimingReport* report);
+
+ADUC_TimingReport* ADUC_Timing_AcquireCurrentReport(void);
+
+EXTERN_C_END
+
+#endif // ADUC_TIMING_UTILS_H
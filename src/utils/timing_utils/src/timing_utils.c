@@ -0,0 +1,435 @@
+/**
+ * @file timing_utils.c
+ * @brief Implements lightweight, monotonic-clock spans that record where a deployment spends its time.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "aduc/timing_utils.h"
+#include "aduc/string_c_utils.h" // ADUC_Safe_StrCopyN
+
+#include <aducpal/time.h> // ADUCPAL_clock_gettime, CLOCK_MONOTONIC
+#include <pthread.h>
+#include <stdlib.h> // for calloc, free
+#include <string.h> // for strcmp, strlen
+
+// keep this last to avoid interfering with system headers
+#include "aduc/aduc_banned.h"
+
+/**
+ * @brief A recorded span.
+ */
+typedef struct tagADUC_TimingRecord
+{
+    const char* Phase; /**< The phase. */
+    char Detail[ADUC_TIMING_MAX_DETAIL_SIZE]; /**< What was timed within the phase. */
+    int Level; /**< The workflow level. */
+    int StepIndex; /**< The step index. */
+    uint64_t StartMs; /**< The start time, relative to the creation of the report. */
+    uint64_t DurationMs; /**< The duration. */
+} ADUC_TimingRecord;
+
+/**
+ * @brief The accumulated time of all spans of a phase.
+ */
+typedef struct tagADUC_TimingPhaseTotal
+{
+    const char* Phase; /**< The phase. */
+    unsigned int Count; /**< The number of spans. */
+    uint64_t TotalMs; /**< The sum of the span durations. */
+} ADUC_TimingPhaseTotal;
+
+struct tagADUC_TimingReport
+{
+    pthread_mutex_t Mutex; /**< Guards all other members. */
+    unsigned int RefCount; /**< The number of owners. */
+    uint64_t StartMs; /**< The monotonic time the report was created. */
+    ADUC_TimingRecord Records[ADUC_TIMING_MAX_SPANS]; /**< The spans, in the order they ended. */
+    size_t RecordCount; /**< The number of spans in Records. */
+    size_t DroppedCount; /**< The number of spans that did not fit in Records. */
+    ADUC_TimingPhaseTotal Phases[ADUC_TIMING_MAX_PHASES]; /**< The phase totals, in order of first use. */
+    size_t PhaseCount; /**< The number of phases in Phases. */
+};
+
+// The report recorded into by code of this module that has no workflow at hand.
+static pthread_mutex_t s_currentReportMutex = PTHREAD_MUTEX_INITIALIZER;
+static ADUC_TimingReport* s_currentReport = NULL;
+
+/**
+ * @brief Gets a monotonic time suitable for measuring durations.
+ *
+ * @return uint64_t The time, in milliseconds, from an unspecified starting point.
+ */
+uint64_t ADUC_Timing_GetMonotonicTimeMs(void)
+{
+    struct timespec now;
+    if (ADUCPAL_clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+    {
+        return 0;
+    }
+
+    return (uint64_t)now.tv_sec * 1000 + (uint64_t)now.tv_nsec / 1000000;
+}
+
+/**
+ * @brief Copies @p src into @p dest, truncating it if needed. NULL is copied as an empty string.
+ */
+static void CopyDetail(char* dest, const char* src)
+{
+    dest[0] = '\0';
+    if (src != NULL)
+    {
+        size_t length = strlen(src);
+        (void)ADUC_Safe_StrCopyN(
+            dest,
+            src,
+            ADUC_TIMING_MAX_DETAIL_SIZE,
+            length < ADUC_TIMING_MAX_DETAIL_SIZE ? length : ADUC_TIMING_MAX_DETAIL_SIZE - 1);
+    }
+}
+
+/**
+ * @brief Creates an empty report.
+ *
+ * @return ADUC_TimingReport* The report, with a reference count of 1, or NULL on allocation failure.
+ * Caller must call ADUC_TimingReport_Release().
+ */
+ADUC_TimingReport* ADUC_TimingReport_Create(void)
+{
+    ADUC_TimingReport* report = calloc(1, sizeof(*report));
+    if (report == NULL)
+    {
+        return NULL;
+    }
+
+    if (pthread_mutex_init(&report->Mutex, NULL) != 0)
+    {
+        free(report);
+        return NULL;
+    }
+
+    report->RefCount = 1;
+    report->StartMs = ADUC_Timing_GetMonotonicTimeMs();
+    return report;
+}
+
+void ADUC_TimingReport_AddRef(ADUC_TimingReport* report)
+{
+    if (report == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&report->Mutex);
+    ++report->RefCount;
+    pthread_mutex_unlock(&report->Mutex);
+}
+
+/**
+ * @brief Releases a reference to @p report, and frees it when it was the last one.
+ *
+ * @param report The report. May be NULL.
+ */
+void ADUC_TimingReport_Release(ADUC_TimingReport* report)
+{
+    if (report == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&report->Mutex);
+    unsigned int refCount = --report->RefCount;
+    pthread_mutex_unlock(&report->Mutex);
+
+    if (refCount == 0)
+    {
+        pthread_mutex_destroy(&report->Mutex);
+        free(report);
+    }
+}
+
+/**
+ * @brief Records a span that was timed by the caller.
+ *
+ * @param report The report. If NULL, nothing is recorded.
+ * @param phase The phase, one of the ADUC_TIMING_PHASE_* names.
+ * @param detail optional. What was timed within the phase.
+ * @param level The workflow level, or ADUC_TIMING_NO_LEVEL.
+ * @param stepIndex The step index, or ADUC_TIMING_NO_LEVEL.
+ * @param startMs The monotonic start time, see ADUC_Timing_GetMonotonicTimeMs().
+ * @param durationMs The duration.
+ */
+void ADUC_TimingReport_RecordSpan(
+    ADUC_TimingReport* report,
+    const char* phase,
+    const char* detail,
+    int level,
+    int stepIndex,
+    uint64_t startMs,
+    uint64_t durationMs)
+{
+    if (report == NULL || phase == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&report->Mutex);
+
+    size_t i = 0;
+    for (; i < report->PhaseCount; ++i)
+    {
+        if (strcmp(report->Phases[i].Phase, phase) == 0)
+        {
+            break;
+        }
+    }
+
+    if (i == report->PhaseCount && report->PhaseCount < ADUC_TIMING_MAX_PHASES)
+    {
+        report->Phases[i].Phase = phase;
+        ++report->PhaseCount;
+    }
+
+    if (i < report->PhaseCount)
+    {
+        ++report->Phases[i].Count;
+        report->Phases[i].TotalMs += durationMs;
+    }
+
+    if (report->RecordCount < ADUC_TIMING_MAX_SPANS)
+    {
+        ADUC_TimingRecord* record = &report->Records[report->RecordCount++];
+        record->Phase = phase;
+        CopyDetail(record->Detail, detail);
+        record->Level = level;
+        record->StepIndex = stepIndex;
+        record->StartMs = startMs > report->StartMs ? startMs - report->StartMs : 0;
+        record->DurationMs = durationMs;
+    }
+    else
+    {
+        ++report->DroppedCount;
+    }
+
+    pthread_mutex_unlock(&report->Mutex);
+}
+
+/**
+ * @brief Writes the phase totals as an object of phase name to total milliseconds.
+ * Must be called with the report mutex held.
+ */
+static void WritePhaseTotalsLocked(const ADUC_TimingReport* report, ADUC_JsonWriter* writer)
+{
+    ADUC_JsonWriter_BeginObject(writer);
+    for (size_t i = 0; i < report->PhaseCount; ++i)
+    {
+        ADUC_JsonWriter_WriteKey(writer, report->Phases[i].Phase);
+        ADUC_JsonWriter_WriteInt64(writer, (int64_t)report->Phases[i].TotalMs);
+    }
+    ADUC_JsonWriter_EndObject(writer);
+}
+
+/**
+ * @brief Writes the compact form of the report, an object of phase name to total milliseconds,
+ * e.g. {"manifestValidation":40,"download":61234,"install":9021}.
+ *
+ * @param report The report. If NULL, an empty object is written.
+ * @param writer The writer.
+ */
+void ADUC_TimingReport_WritePhaseTotals(ADUC_TimingReport* report, ADUC_JsonWriter* writer)
+{
+    if (report == NULL)
+    {
+        ADUC_JsonWriter_BeginObject(writer);
+        ADUC_JsonWriter_EndObject(writer);
+        return;
+    }
+
+    pthread_mutex_lock(&report->Mutex);
+    WritePhaseTotalsLocked(report, writer);
+    pthread_mutex_unlock(&report->Mutex);
+}
+
+/**
+ * @brief Writes the full report, with the phase totals and every recorded span.
+ *
+ * Example:
+ * {
+ *     "workflowId": "...",
+ *     "elapsedMs": 72310,
+ *     "phases": { "manifestValidation": 40, "download": 61234, ... },
+ *     "spans": [
+ *         { "phase": "download", "detail": "payload.swu", "level": 1, "step": 0, "startMs": 512, "durationMs": 61002 },
+ *         ...
+ *     ],
+ *     "droppedSpans": 0
+ * }
+ *
+ * @param report The report.
+ * @param workflowId optional. The workflow id of the deployment.
+ * @param writer The writer.
+ */
+void ADUC_TimingReport_WriteJson(ADUC_TimingReport* report, const char* workflowId, ADUC_JsonWriter* writer)
+{
+    if (report == NULL)
+    {
+        ADUC_JsonWriter_WriteNull(writer);
+        return;
+    }
+
+    pthread_mutex_lock(&report->Mutex);
+
+    uint64_t now = ADUC_Timing_GetMonotonicTimeMs();
+    uint64_t elapsedMs = now > report->StartMs ? now - report->StartMs : 0;
+
+    ADUC_JsonWriter_BeginObject(writer);
+
+    ADUC_JsonWriter_WriteKey(writer, "workflowId");
+    ADUC_JsonWriter_WriteString(writer, workflowId);
+
+    ADUC_JsonWriter_WriteKey(writer, "elapsedMs");
+    ADUC_JsonWriter_WriteInt64(writer, (int64_t)elapsedMs);
+
+    ADUC_JsonWriter_WriteKey(writer, "phases");
+    WritePhaseTotalsLocked(report, writer);
+
+    ADUC_JsonWriter_WriteKey(writer, "spans");
+    ADUC_JsonWriter_BeginArray(writer);
+    for (size_t i = 0; i < report->RecordCount; ++i)
+    {
+        const ADUC_TimingRecord* record = &report->Records[i];
+
+        ADUC_JsonWriter_BeginObject(writer);
+        ADUC_JsonWriter_WriteKey(writer, "phase");
+        ADUC_JsonWriter_WriteString(writer, record->Phase);
+        if (record->Detail[0] != '\0')
+        {
+            ADUC_JsonWriter_WriteKey(writer, "detail");
+            ADUC_JsonWriter_WriteString(writer, record->Detail);
+        }
+        if (record->Level != ADUC_TIMING_NO_LEVEL)
+        {
+            ADUC_JsonWriter_WriteKey(writer, "level");
+            ADUC_JsonWriter_WriteInt64(writer, record->Level);
+        }
+        if (record->StepIndex != ADUC_TIMING_NO_LEVEL)
+        {
+            ADUC_JsonWriter_WriteKey(writer, "step");
+            ADUC_JsonWriter_WriteInt64(writer, record->StepIndex);
+        }
+        ADUC_JsonWriter_WriteKey(writer, "startMs");
+        ADUC_JsonWriter_WriteInt64(writer, (int64_t)record->StartMs);
+        ADUC_JsonWriter_WriteKey(writer, "durationMs");
+        ADUC_JsonWriter_WriteInt64(writer, (int64_t)record->DurationMs);
+        ADUC_JsonWriter_EndObject(writer);
+    }
+    ADUC_JsonWriter_EndArray(writer);
+
+    ADUC_JsonWriter_WriteKey(writer, "droppedSpans");
+    ADUC_JsonWriter_WriteInt64(writer, (int64_t)report->DroppedCount);
+
+    ADUC_JsonWriter_EndObject(writer);
+
+    pthread_mutex_unlock(&report->Mutex);
+}
+
+/**
+ * @brief Creates the full report JSON, see ADUC_TimingReport_WriteJson().
+ *
+ * @param report The report.
+ * @param workflowId optional. The workflow id of the deployment.
+ * @return char* The report JSON, or NULL on failure. Caller must free().
+ */
+char* ADUC_TimingReport_CreateJson(ADUC_TimingReport* report, const char* workflowId)
+{
+    ADUC_JsonWriter writer;
+    if (report == NULL || !ADUC_JsonWriter_Init(&writer, 0))
+    {
+        return NULL;
+    }
+
+    ADUC_TimingReport_WriteJson(report, workflowId, &writer);
+    return ADUC_JsonWriter_Detach(&writer);
+}
+
+/**
+ * @brief Starts a span. Nothing is recorded until ADUC_Timing_EndSpan().
+ *
+ * @param[out] span The span to start.
+ * @param phase The phase, one of the ADUC_TIMING_PHASE_* names.
+ * @param detail optional. What is timed within the phase, e.g. a file name. Copied.
+ * @param level The workflow level, or ADUC_TIMING_NO_LEVEL.
+ * @param stepIndex The step index, or ADUC_TIMING_NO_LEVEL.
+ */
+void ADUC_Timing_BeginSpan(ADUC_TimingSpan* span, const char* phase, const char* detail, int level, int stepIndex)
+{
+    span->Phase = phase;
+    CopyDetail(span->Detail, detail);
+    span->Level = level;
+    span->StepIndex = stepIndex;
+    span->StartMs = ADUC_Timing_GetMonotonicTimeMs();
+}
+
+/**
+ * @brief Records a span started by ADUC_Timing_BeginSpan() into @p report.
+ *
+ * @param report The report. If NULL, nothing is recorded.
+ * @param span The span.
+ */
+void ADUC_Timing_EndSpan(ADUC_TimingReport* report, const ADUC_TimingSpan* span)
+{
+    if (report == NULL)
+    {
+        return;
+    }
+
+    uint64_t now = ADUC_Timing_GetMonotonicTimeMs();
+    uint64_t durationMs = now > span->StartMs ? now - span->StartMs : 0;
+
+    ADUC_TimingReport_RecordSpan(
+        report, span->Phase, span->Detail, span->Level, span->StepIndex, span->StartMs, durationMs);
+}
+
+/**
+ * @brief Records a span started by ADUC_Timing_BeginSpan() into the current report of this module, if any.
+ *
+ * @param span The span.
+ */
+void ADUC_Timing_EndSpanInCurrentReport(const ADUC_TimingSpan* span)
+{
+    ADUC_TimingReport* report = ADUC_Timing_AcquireCurrentReport();
+    ADUC_Timing_EndSpan(report, span);
+    ADUC_TimingReport_Release(report);
+}
+
+/**
+ * @brief Sets the report recorded into by code of this module that has no workflow at hand.
+ *
+ * @param report The report, or NULL to stop recording. A reference is taken.
+ */
+void ADUC_Timing_SetCurrentReport(ADUC_TimingReport* report)
+{
+    ADUC_TimingReport_AddRef(report);
+
+    pthread_mutex_lock(&s_currentReportMutex);
+    ADUC_TimingReport* previous = s_currentReport;
+    s_currentReport = report;
+    pthread_mutex_unlock(&s_currentReportMutex);
+
+    ADUC_TimingReport_Release(previous);
+}
+
+/**
+ * @brief Gets the report set with ADUC_Timing_SetCurrentReport().
+ *
+ * @return ADUC_TimingReport* The report, or NULL. Caller must call ADUC_TimingReport_Release().
+ */
+ADUC_TimingReport* ADUC_Timing_AcquireCurrentReport(void)
+{
+    pthread_mutex_lock(&s_currentReportMutex);
+    ADUC_TimingReport* report = s_currentReport;
+    ADUC_TimingReport_AddRef(report);
+    pthread_mutex_unlock(&s_currentReportMutex);
+
+    return report;
+}
@@ -0,0 +1,123 @@
+/**
+ * @file timing_utils_ut.cpp
+ * @brief Unit Tests for timing_utils library
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include <catch2/catch.hpp>
+using Catch::Matchers::Contains;
+using Catch::Matchers::Equals;
+#include <aduc/timing_utils.h>
+#include <stdlib.h>
+#include <string>
+
+static std::string GetPhaseTotals(ADUC_TimingReport* report)
+{
+    ADUC_JsonWriter writer;
+    REQUIRE(ADUC_JsonWriter_Init(&writer, 0));
+    ADUC_TimingReport_WritePhaseTotals(report, &writer);
+    std::string totals{ writer.Buffer };
+    ADUC_JsonWriter_Uninit(&writer);
+    return totals;
+}
+
+static std::string GetReport(ADUC_TimingReport* report)
+{
+    char* json = ADUC_TimingReport_CreateJson(report, "workflow-1");
+    REQUIRE(json != nullptr);
+    std::string reportJson{ json };
+    free(json);
+    return reportJson;
+}
+
+TEST_CASE("ADUC_Timing_GetMonotonicTimeMs")
+{
+    uint64_t first = ADUC_Timing_GetMonotonicTimeMs();
+    uint64_t second = ADUC_Timing_GetMonotonicTimeMs();
+    CHECK(first > 0);
+    CHECK(second >= first);
+}
+
+TEST_CASE("ADUC_TimingReport phase totals")
+{
+    ADUC_TimingReport* report = ADUC_TimingReport_Create();
+    REQUIRE(report != nullptr);
+
+    CHECK_THAT(GetPhaseTotals(report), Equals("{}"));
+
+    uint64_t now = ADUC_Timing_GetMonotonicTimeMs();
+    ADUC_TimingReport_RecordSpan(report, ADUC_TIMING_PHASE_DOWNLOAD, "a.swu", 1, 0, now, 100);
+    ADUC_TimingReport_RecordSpan(
+        report, ADUC_TIMING_PHASE_HASH, "a.swu", ADUC_TIMING_NO_LEVEL, ADUC_TIMING_NO_LEVEL, now, 5);
+    ADUC_TimingReport_RecordSpan(report, ADUC_TIMING_PHASE_DOWNLOAD, "b.swu", 1, 1, now, 200);
+
+    CHECK_THAT(GetPhaseTotals(report), Equals(R"({"download":300,"hash":5})"));
+
+    ADUC_TimingReport_Release(report);
+}
+
+TEST_CASE("ADUC_TimingReport report")
+{
+    ADUC_TimingReport* report = ADUC_TimingReport_Create();
+    REQUIRE(report != nullptr);
+
+    ADUC_TimingSpan span;
+    ADUC_Timing_BeginSpan(&span, ADUC_TIMING_PHASE_APPLY, "component \"x\"", 2, 3);
+    ADUC_Timing_EndSpan(report, &span);
+    ADUC_TimingReport_RecordSpan(
+        report, ADUC_TIMING_PHASE_REPORTING, nullptr, ADUC_TIMING_NO_LEVEL, ADUC_TIMING_NO_LEVEL, span.StartMs, 1);
+
+    std::string reportJson = GetReport(report);
+    CHECK_THAT(reportJson, Contains(R"("workflowId":"workflow-1")"));
+    CHECK_THAT(reportJson, Contains(R"({"phase":"apply","detail":"component \"x\"","level":2,"step":3,"startMs":)"));
+    CHECK_THAT(reportJson, Contains(R"({"phase":"reporting","startMs":)"));
+    CHECK_THAT(reportJson, Contains(R"("droppedSpans":0})"));
+
+    ADUC_TimingReport_Release(report);
+}
+
+TEST_CASE("ADUC_TimingReport drops spans beyond the maximum but keeps the totals")
+{
+    ADUC_TimingReport* report = ADUC_TimingReport_Create();
+    REQUIRE(report != nullptr);
+
+    uint64_t now = ADUC_Timing_GetMonotonicTimeMs();
+    for (int i = 0; i < ADUC_TIMING_MAX_SPANS + 2; ++i)
+    {
+        ADUC_TimingReport_RecordSpan(
+            report, ADUC_TIMING_PHASE_HASH, nullptr, ADUC_TIMING_NO_LEVEL, ADUC_TIMING_NO_LEVEL, now, 1);
+    }
+
+    CHECK_THAT(GetReport(report), Contains(R"("droppedSpans":2})"));
+    CHECK_THAT(GetPhaseTotals(report), Equals(R"({"hash":514})"));
+
+    ADUC_TimingReport_Release(report);
+}
+
+TEST_CASE("ADUC_Timing current report")
+{
+    ADUC_TimingSpan span;
+    ADUC_Timing_BeginSpan(&span, ADUC_TIMING_PHASE_HASH, "a.swu", ADUC_TIMING_NO_LEVEL, ADUC_TIMING_NO_LEVEL);
+
+    // No current report; nothing is recorded.
+    ADUC_Timing_EndSpanInCurrentReport(&span);
+    CHECK(ADUC_Timing_AcquireCurrentReport() == nullptr);
+
+    ADUC_TimingReport* report = ADUC_TimingReport_Create();
+    REQUIRE(report != nullptr);
+
+    ADUC_Timing_SetCurrentReport(report);
+    ADUC_Timing_EndSpanInCurrentReport(&span);
+
+    ADUC_TimingReport* current = ADUC_Timing_AcquireCurrentReport();
+    CHECK(current == report);
+    ADUC_TimingReport_Release(current);
+
+    // The current report keeps its own reference.
+    ADUC_TimingReport_Release(report);
+    CHECK_THAT(GetReport(report), Contains(R"({"phase":"hash","detail":"a.swu","startMs":)"));
+
+    ADUC_Timing_SetCurrentReport(nullptr);
+    CHECK(ADUC_Timing_AcquireCurrentReport() == nullptr);
+}
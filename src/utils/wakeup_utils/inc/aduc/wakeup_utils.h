@@ -0,0 +1,53 @@
+/**
+ * @file wakeup_utils.h
+ * @brief Utilities for waking the agent main loop only when there is work to do.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#ifndef ADUC_WAKEUP_UTILS_H
+#define ADUC_WAKEUP_UTILS_H
+
+#include "aduc/c_utils.h"
+#include <stdbool.h>
+
+EXTERN_C_BEGIN
+
+/**
+ * @brief Initializes the wakeup sources (an eventfd for signals and a timerfd for scheduled wakeups).
+ *
+ * @return Returns true if success.
+ */
+bool ADUC_Wakeup_Init();
+
+/**
+ * @brief Releases the wakeup sources. Subsequent signals and schedules are ignored.
+ */
+void ADUC_Wakeup_Uninit();
+
+/**
+ * @brief Wakes the thread blocked in ADUC_Wakeup_Wait(), or makes its next call return immediately.
+ *
+ * @remark Safe to call from any thread and from a signal handler. No-op if not initialized.
+ */
+void ADUC_Wakeup_Signal();
+
+/**
+ * @brief Requests that ADUC_Wakeup_Wait() returns no later than @p delayMs milliseconds from now.
+ *
+ * @param delayMs The delay, in milliseconds. An earlier pending schedule is kept.
+ *
+ * @remark Safe to call from any thread. No-op if not initialized.
+ */
+void ADUC_Wakeup_ScheduleAfter(unsigned int delayMs);
+
+/**
+ * @brief Blocks until ADUC_Wakeup_Signal() is called, a scheduled wakeup is due, or @p timeoutMs elapsed.
+ *
+ * @param timeoutMs The maximum wait time, in milliseconds.
+ */
+void ADUC_Wakeup_Wait(unsigned int timeoutMs);
+
+EXTERN_C_END
+
+#endif // ADUC_WAKEUP_UTILS_H
@@ -0,0 +1,239 @@
+/**
+ * @file wakeup_utils.c
+ * @brief Implements utilities for waking the agent main loop only when there is work to do.
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "aduc/wakeup_utils.h"
+#include "aduc/logging.h"
+
+#if defined(WIN32)
+#    include <azure_c_shared_utility/threadapi.h> // ThreadAPI_Sleep
+#else
+#    include <errno.h>
+#    include <pthread.h>
+#    include <stdint.h> // uint64_t
+#    include <string.h> // memset
+#    include <sys/epoll.h>
+#    include <sys/eventfd.h>
+#    include <sys/timerfd.h>
+#    include <time.h>
+#    include <unistd.h>
+#endif
+
+#if defined(WIN32)
+
+// Without eventfd and timerfd, waits are capped so that signaled work is still picked up promptly.
+#    define WAKEUP_FALLBACK_MAX_WAIT_MS 100
+
+bool ADUC_Wakeup_Init()
+{
+    return true;
+}
+
+void ADUC_Wakeup_Uninit()
+{
+}
+
+void ADUC_Wakeup_Signal()
+{
+}
+
+void ADUC_Wakeup_ScheduleAfter(unsigned int delayMs)
+{
+    UNREFERENCED_PARAMETER(delayMs);
+}
+
+void ADUC_Wakeup_Wait(unsigned int timeoutMs)
+{
+    ThreadAPI_Sleep(timeoutMs < WAKEUP_FALLBACK_MAX_WAIT_MS ? timeoutMs : WAKEUP_FALLBACK_MAX_WAIT_MS);
+}
+
+#else
+
+static int s_epollFd = -1;
+static int s_eventFd = -1;
+static int s_timerFd = -1;
+
+// Guards s_scheduledDeadline and re-arming of s_timerFd.
+static pthread_mutex_t s_scheduleMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// The absolute CLOCK_MONOTONIC time the timer is armed for. Zero when disarmed.
+static struct timespec s_scheduledDeadline;
+
+static bool IsEarlier(const struct timespec* a, const struct timespec* b)
+{
+    return a->tv_sec < b->tv_sec || (a->tv_sec == b->tv_sec && a->tv_nsec < b->tv_nsec);
+}
+
+/**
+ * @brief Whether no wakeup is pending, i.e. the timer is disarmed or its deadline has passed.
+ * Must be called with s_scheduleMutex held.
+ */
+static bool IsScheduleIdle(const struct timespec* now)
+{
+    return (s_scheduledDeadline.tv_sec == 0 && s_scheduledDeadline.tv_nsec == 0)
+        || !IsEarlier(now, &s_scheduledDeadline);
+}
+
+static bool AddToEpoll(int fd)
+{
+    struct epoll_event event;
+    memset(&event, 0, sizeof(event));
+    event.events = EPOLLIN;
+    event.data.fd = fd;
+
+    return epoll_ctl(s_epollFd, EPOLL_CTL_ADD, fd, &event) == 0;
+}
+
+bool ADUC_Wakeup_Init()
+{
+    bool succeeded = false;
+
+    if (s_epollFd != -1)
+    {
+        return true;
+    }
+
+    s_epollFd = epoll_create1(EPOLL_CLOEXEC);
+    if (s_epollFd == -1)
+    {
+        Log_Error("epoll_create1 failed, errno: %d", errno);
+        goto done;
+    }
+
+    s_eventFd = eventfd(0, EFD_CLOEXEC | EFD_NONBLOCK);
+    if (s_eventFd == -1)
+    {
+        Log_Error("eventfd failed, errno: %d", errno);
+        goto done;
+    }
+
+    s_timerFd = timerfd_create(CLOCK_MONOTONIC, TFD_CLOEXEC | TFD_NONBLOCK);
+    if (s_timerFd == -1)
+    {
+        Log_Error("timerfd_create failed, errno: %d", errno);
+        goto done;
+    }
+
+    if (!AddToEpoll(s_eventFd) || !AddToEpoll(s_timerFd))
+    {
+        Log_Error("epoll_ctl failed, errno: %d", errno);
+        goto done;
+    }
+
+    memset(&s_scheduledDeadline, 0, sizeof(s_scheduledDeadline));
+
+    succeeded = true;
+
+done:
+    if (!succeeded)
+    {
+        ADUC_Wakeup_Uninit();
+    }
+
+    return succeeded;
+}
+
+void ADUC_Wakeup_Uninit()
+{
+    int fds[] = { s_eventFd, s_timerFd, s_epollFd };
+
+    pthread_mutex_lock(&s_scheduleMutex);
+    s_eventFd = -1;
+    s_timerFd = -1;
+    s_epollFd = -1;
+    memset(&s_scheduledDeadline, 0, sizeof(s_scheduledDeadline));
+    pthread_mutex_unlock(&s_scheduleMutex);
+
+    for (unsigned int i = 0; i < ARRAY_SIZE(fds); ++i)
+    {
+        if (fds[i] != -1)
+        {
+            close(fds[i]);
+        }
+    }
+}
+
+void ADUC_Wakeup_Signal()
+{
+    // Only async-signal-safe calls here; this is invoked from the shutdown signal handler.
+    const int fd = s_eventFd;
+    const uint64_t one = 1;
+
+    if (fd != -1)
+    {
+        // A failed write means the counter is already non-zero, so the wait will return anyway.
+        ssize_t unused = write(fd, &one, sizeof(one));
+        (void)unused;
+    }
+}
+
+void ADUC_Wakeup_ScheduleAfter(unsigned int delayMs)
+{
+    struct timespec now;
+    struct timespec deadline;
+
+    if (clock_gettime(CLOCK_MONOTONIC, &now) != 0)
+    {
+        return;
+    }
+
+    deadline = now;
+    deadline.tv_sec += delayMs / 1000;
+    deadline.tv_nsec += (long)(delayMs % 1000) * 1000000L;
+    if (deadline.tv_nsec >= 1000000000L)
+    {
+        deadline.tv_sec += 1;
+        deadline.tv_nsec -= 1000000000L;
+    }
+
+    pthread_mutex_lock(&s_scheduleMutex);
+
+    if (s_timerFd != -1 && (IsScheduleIdle(&now) || IsEarlier(&deadline, &s_scheduledDeadline)))
+    {
+        struct itimerspec timerValue;
+        memset(&timerValue, 0, sizeof(timerValue));
+        timerValue.it_value = deadline;
+
+        if (timerfd_settime(s_timerFd, TFD_TIMER_ABSTIME, &timerValue, NULL) == 0)
+        {
+            s_scheduledDeadline = deadline;
+        }
+        else
+        {
+            Log_Error("timerfd_settime failed, errno: %d", errno);
+        }
+    }
+
+    pthread_mutex_unlock(&s_scheduleMutex);
+}
+
+void ADUC_Wakeup_Wait(unsigned int timeoutMs)
+{
+    struct epoll_event events[2];
+    uint64_t counter = 0;
+
+    if (s_epollFd == -1)
+    {
+        usleep((useconds_t)timeoutMs * 1000);
+        return;
+    }
+
+    int count = epoll_wait(s_epollFd, events, (int)ARRAY_SIZE(events), (int)timeoutMs);
+    if (count == -1 && errno != EINTR)
+    {
+        Log_Error("epoll_wait failed, errno: %d", errno);
+        return;
+    }
+
+    for (int i = 0; i < count; ++i)
+    {
+        // Reading resets both the eventfd counter and the timerfd expiration count.
+        ssize_t unused = read(events[i].data.fd, &counter, sizeof(counter));
+        (void)unused;
+    }
+}
+
+#endif // defined(WIN32)
@@ -0,0 +1,104 @@
+/**
+ * @file wakeup_utils_ut.cpp
+ * @brief Unit tests for wakeup_utils library
+ *
+ * @copyright Copyright (c) Microsoft Corporation.
+ * Licensed under the MIT License.
+ */
+#include "aduc/wakeup_utils.h"
+
+#include <catch2/catch.hpp>
+#include <chrono>
+#include <thread>
+
+using Clock = std::chrono::steady_clock;
+
+static long long WaitAndMeasureMs(unsigned int timeoutMs)
+{
+    const auto start = Clock::now();
+    ADUC_Wakeup_Wait(timeoutMs);
+    return std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - start).count();
+}
+
+class WakeupFixture
+{
+public:
+    WakeupFixture()
+    {
+        REQUIRE(ADUC_Wakeup_Init());
+    }
+
+    ~WakeupFixture()
+    {
+        ADUC_Wakeup_Uninit();
+    }
+
+    WakeupFixture(const WakeupFixture&) = delete;
+    WakeupFixture& operator=(const WakeupFixture&) = delete;
+    WakeupFixture(WakeupFixture&&) = delete;
+    WakeupFixture& operator=(WakeupFixture&&) = delete;
+};
+
+TEST_CASE_METHOD(WakeupFixture, "ADUC_Wakeup_Wait times out without work")
+{
+    CHECK(WaitAndMeasureMs(200) >= 150);
+}
+
+TEST_CASE_METHOD(WakeupFixture, "ADUC_Wakeup_Signal")
+{
+    SECTION("Signal before wait is not lost")
+    {
+        ADUC_Wakeup_Signal();
+        ADUC_Wakeup_Signal();
+        CHECK(WaitAndMeasureMs(5000) < 1000);
+
+        // Both signals were consumed by the previous wait.
+        CHECK(WaitAndMeasureMs(200) >= 150);
+    }
+
+    SECTION("Signal from another thread wakes the waiter")
+    {
+        std::thread signaler{ []() {
+            std::this_thread::sleep_for(std::chrono::milliseconds(50));
+            ADUC_Wakeup_Signal();
+        } };
+
+        CHECK(WaitAndMeasureMs(5000) < 1000);
+        signaler.join();
+    }
+}
+
+TEST_CASE_METHOD(WakeupFixture, "ADUC_Wakeup_ScheduleAfter")
+{
+    SECTION("Scheduled wakeup ends the wait early")
+    {
+        ADUC_Wakeup_ScheduleAfter(100);
+        const long long elapsedMs = WaitAndMeasureMs(5000);
+        CHECK(elapsedMs >= 50);
+        CHECK(elapsedMs < 1000);
+    }
+
+    SECTION("Earliest schedule wins")
+    {
+        ADUC_Wakeup_ScheduleAfter(4000);
+        ADUC_Wakeup_ScheduleAfter(100);
+        ADUC_Wakeup_ScheduleAfter(3000);
+        CHECK(WaitAndMeasureMs(5000) < 1000);
+    }
+
+    SECTION("Expired schedule can be re-armed")
+    {
+        ADUC_Wakeup_ScheduleAfter(50);
+        CHECK(WaitAndMeasureMs(5000) < 1000);
+
+        ADUC_Wakeup_ScheduleAfter(50);
+        CHECK(WaitAndMeasureMs(5000) < 1000);
+    }
+}
+
+TEST_CASE("ADUC_Wakeup_Wait without Init sleeps for the timeout")
+{
+    ADUC_Wakeup_Signal();
+    ADUC_Wakeup_ScheduleAfter(10);
+    CHECK(WaitAndMeasureMs(100) >= 80);
+}
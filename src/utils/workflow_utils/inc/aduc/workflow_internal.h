@@ -15,6 +15,18 @@
 #include <azure_c_shared_utility/strings.h>
 #include <azure_c_shared_utility/vector.h>
 #include <parson.h>
+#include <stdint.h> // int64_t
+
+/**
+ * @brief Refcounted owner of a parsed Update Action and Update Manifest that are shared between a workflow
+ * and the inline step workflows created from it.
+ */
+typedef struct tagADUC_Workflow_Shared_Json
+{
+    JSON_Value* UpdateActionValue; /**< The shared update action JSON value. */
+    JSON_Value* UpdateManifestValue; /**< The shared update manifest JSON value. */
+    int64_t RefCount; /**< The count of workflows referencing the values. Only changed atomically. */
+} ADUC_Workflow_Shared_Json;
 
 /**
  * @brief A struct containing data needed for an update workflow.
@@ -51,12 +63,33 @@ typedef struct tagADUC_Workflow
     int Level; /**< The level of the workflow in the tree. */
     size_t StepIndex; /**< The step index for this workflow. */
 
+    //
+    // Inline step view. An inline step workflow shares the parsed json of the workflow it was created from,
+    // and only records which parts of the shared Update Manifest belong to its step.
+    //
+    ADUC_Workflow_Shared_Json*
+        SharedJson; /**< Owner of UpdateActionObject and UpdateManifestObject when shared. NULL if owned by this workflow. */
+    const JSON_Object* StepObject; /**< The step entry in the shared manifest. NULL if not an inline step workflow. */
+    size_t* StepFileIndexes; /**< Indexes of the step's files in the shared manifest 'files' map, in manifest order. */
+    size_t StepFileCount; /**< The count of StepFileIndexes. */
+
+    //
+    // Resolved update files, built on first use and invalidated when the manifest, 'fileUrls' or parent change.
+    // The entities, everything they reference and the name index are carved from FileEntityArena.
+    //
+    struct tagADUC_Arena* FileEntityArena; /**< Arena backing the members below. NULL until first use. */
+    ADUC_FileEntity* FileEntities; /**< Resolved file entities by file index. Unresolved entries have a NULL FileId. */
+    size_t FileEntityCount; /**< The count of FileEntities. */
+    size_t* FileNameIndex; /**< Case-insensitive file name hash table of file index + 1. Zero marks an empty slot. */
+    size_t FileNameIndexSize; /**< The slot count of FileNameIndex, a power of two. */
+
     //
     // Operation worker state including state for handling cancellation and completion.
     //
     bool OperationInProgress; /**< Is an upper-level method currently in progress? */
     bool OperationCancelled; /**< Was the operation in progress requested to cancel? */
     ADUC_WorkflowCancellationType CancellationType; /**< What type of cancellation is it? */
+    int64_t DownloadCancelRequested; /**< Non-zero to stop downloads for this workflow. Only accessed atomically. */
     struct tagADUC_Workflow*
         DeferredReplacementWorkflow; /**< A replacement workflow that came in while another deployment was in progress. */
 
@@ -66,6 +99,9 @@ typedef struct tagADUC_Workflow
     ino_t* UpdateFileInodes;
 
     bool ForceUpdate; /**< Always process this workflow, even when the previous update was successful. */
+
+    struct tagADUC_TimingReport*
+        TimingReport; /**< Where the deployment spends its time. Only used on the root; see workflow_get_timing_report. */
 } ADUC_Workflow;
 
 #endif // WORKFLOW_INTERNAL_H
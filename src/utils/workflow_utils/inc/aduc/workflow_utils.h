@@ -10,6 +10,7 @@
 
 #include "aduc/adu_types.h"
 #include "aduc/result.h"
+#include "aduc/timing_utils.h"
 #include "aduc/types/update_content.h"
 #include "aduc/types/workflow.h"
 #include <azure_c_shared_utility/strings.h>
@@ -256,6 +257,32 @@ bool workflow_get_update_file(ADUC_WorkflowHandle handle, size_t index, ADUC_Fil
  */
 bool workflow_get_update_file_by_name(ADUC_WorkflowHandle handle, const char* fileName, ADUC_FileEntity* entity);
 
+/**
+ * @brief Gets a read-only view of the update file entity at the specified index.
+ * The entity is resolved once and cached on the workflow.
+ *
+ * Threading: the file getters and peeks may be called from several threads at once, as the cache is filled
+ * under a lock. Changing the workflow's update data or parent invalidates the cache and must not overlap
+ * with any other use of the workflow, including holding a peeked entity.
+ *
+ * @param handle A workflow data object handle.
+ * @param index An index of the file to get.
+ * @return const ADUC_FileEntity* The file entity, or NULL on failure. Owned by the workflow and valid until
+ * the workflow's update data, parent, or lifetime changes. Caller must not modify or free it.
+ */
+const ADUC_FileEntity* workflow_peek_update_file(ADUC_WorkflowHandle handle, size_t index);
+
+/**
+ * @brief Gets a read-only view of the first update file entity with the specified name (case-insensitive).
+ * The entity is resolved once and cached on the workflow.
+ *
+ * @param handle A workflow data object handle.
+ * @param fileName File name.
+ * @return const ADUC_FileEntity* The file entity, or NULL if not found or it has no download URL. Owned by
+ * the workflow with the same lifetime as for workflow_peek_update_file().
+ */
+const ADUC_FileEntity* workflow_peek_update_file_by_name(ADUC_WorkflowHandle handle, const char* fileName);
+
 /**
  * @brief Gets the inode associated with the update file entity at the specified index.
  *
@@ -401,6 +428,15 @@ void workflow_clear_inprogress_and_cancelrequested(ADUC_WorkflowHandle handle);
  */
 ADUC_WorkflowHandle workflow_get_root(ADUC_WorkflowHandle handle);
 
+/**
+ * @brief Get the deployment timing report, which is shared by every workflow in the tree of @p handle.
+ *
+ * @param handle A workflow data object handle.
+ * @return ADUC_TimingReport* The report of the root workflow, created on first use, or NULL on allocation failure.
+ * The report is owned by the root workflow; callers that keep it past the root's lifetime must add a reference.
+ */
+ADUC_TimingReport* workflow_get_timing_report(ADUC_WorkflowHandle handle);
+
 /**
  * @brief Get parent workflow object handle of @p handle.
  *
@@ -409,6 +445,14 @@ ADUC_WorkflowHandle workflow_get_root(ADUC_WorkflowHandle handle);
  */
 ADUC_WorkflowHandle workflow_get_parent(ADUC_WorkflowHandle handle);
 
+/**
+ * @brief Set parent workflow object handle of @p handle, without adding @p handle to the parent's children.
+ *
+ * @param handle A child workflow object handle.
+ * @param parent A parent workflow object handle.
+ */
+void workflow_set_parent(ADUC_WorkflowHandle handle, ADUC_WorkflowHandle parent);
+
 /**
  * @brief Get child workflow count. For example, for Bundle Update, this is a count of
  * Leaf (Components) Updates. For Leaf (Components) Update, this is a count of 'InstallItems'.
@@ -500,6 +544,23 @@ bool workflow_request_cancel(ADUC_WorkflowHandle handle);
  */
 bool workflow_is_cancel_requested(ADUC_WorkflowHandle handle);
 
+/**
+ * @brief Sets whether downloads for the workflow, and for its descendants, should stop.
+ * Unlike workflow_request_cancel, this can be cleared, and can be set from another thread while the workflow downloads.
+ *
+ * @param handle A workflow data object handle.
+ * @param cancel Whether to stop downloads.
+ */
+void workflow_set_download_cancel_requested(ADUC_WorkflowHandle handle, bool cancel);
+
+/**
+ * @brief Check whether downloads were requested to stop for the workflow or any of its parents.
+ *
+ * @param handle A workflow data object handle.
+ * @return A boolean indicates whether downloads should stop.
+ */
+bool workflow_is_download_cancel_requested(ADUC_WorkflowHandle handle);
+
 /**
  * @brief Request the agent to restart after the top level workflow is finished.
  *
@@ -7,6 +7,7 @@
  */
 #include "aduc/workflow_utils.h"
 #include "aduc/adu_types.h"
+#include "aduc/arena.h"
 #include "aduc/aduc_inode.h" // ADUC_INODE_SENTINEL_VALUE
 #include "aduc/c_utils.h"
 #include "aduc/config_utils.h"
@@ -28,6 +29,8 @@
 #include "root_key_util.h"
 
 #include <parson.h>
+#include <ctype.h> // for tolower
+#include <pthread.h>
 #include <stdarg.h> // for va_*
 #include <stdlib.h> // for malloc, atoi
 #include <string.h>
@@ -35,6 +38,19 @@
 #include <aducpal/limits.h> // for PATH_MAX
 #include <aducpal/strings.h> // strcasecmp
 
+#if defined(WIN32)
+#    include <windows.h> // Interlocked*
+#    define WORKFLOW_ATOMIC_INCREMENT(ptr) InterlockedIncrement64((volatile LONG64*)(ptr))
+#    define WORKFLOW_ATOMIC_DECREMENT(ptr) InterlockedDecrement64((volatile LONG64*)(ptr))
+#    define WORKFLOW_ATOMIC_STORE(ptr, value) InterlockedExchange64((volatile LONG64*)(ptr), (value))
+#    define WORKFLOW_ATOMIC_LOAD(ptr) InterlockedCompareExchange64((volatile LONG64*)(ptr), 0, 0)
+#else
+#    define WORKFLOW_ATOMIC_INCREMENT(ptr) __atomic_add_fetch((ptr), 1, __ATOMIC_RELAXED)
+#    define WORKFLOW_ATOMIC_DECREMENT(ptr) __atomic_sub_fetch((ptr), 1, __ATOMIC_ACQ_REL)
+#    define WORKFLOW_ATOMIC_STORE(ptr, value) __atomic_store_n((ptr), (value), __ATOMIC_RELEASE)
+#    define WORKFLOW_ATOMIC_LOAD(ptr) __atomic_load_n((ptr), __ATOMIC_ACQUIRE)
+#endif
+
 #define WORKFLOW_PROPERTY_FIELD_ID "_id"
 #define WORKFLOW_PROPERTY_FIELD_RETRYTIMESTAMP "_retryTimestamp"
 #define WORKFLOW_PROPERTY_FIELD_WORKFLOW_DOT_ID "workflow.id"
@@ -77,6 +93,14 @@ const JSON_Object* _workflow_get_fileurls_map(ADUC_WorkflowHandle handle);
 // Private functions - this is an adapter for the underlying ADUC_Workflow object.
 //
 
+/**
+ * @brief qsort and bsearch comparator for an array of C strings.
+ */
+static int CompareStringPointers(const void* a, const void* b)
+{
+    return strcmp(*(const char* const*)a, *(const char* const*)b);
+}
+
 /**
  * @brief Frees an ADUC_Property object.
  * @param property The property to be freed.
@@ -156,66 +180,6 @@ static void ADUC_Properties_FreeArray(size_t propertiesCount, ADUC_Property* pro
     free(propertiesArray);
 }
 
-/**
- * @brief Allocates memory and populate with ADUC_Property object from a Parson JSON_Object.
- *
- * Caller MUST assume that this method allocates the memory for the returned ADUC_Property pointer.
- *
- * @param propertiesObj JSON Object that contains the properties to be returned.
- * @param propertiesCount A size_t* where the count of output properties will be stored.
- * @returns If success, a pointer to an array of ADUC_Property object. Otherwise, returns NULL.
- *  Caller must call ADUC_FileEntityArray_Free() to free the array.
- */
-ADUC_Property* ADUC_PropertiesArray_AllocAndInit(const JSON_Object* propertiesObj, size_t* propertiesCount)
-{
-    ADUC_Property* tempPropertyArray = NULL;
-
-    if (propertiesCount == NULL || propertiesObj == NULL)
-    {
-        return NULL;
-    }
-    *propertiesCount = 0;
-
-    size_t tempPropertyCount = json_object_get_count(propertiesObj);
-
-    if (tempPropertyCount == 0)
-    {
-        Log_Error("No properties");
-        goto done;
-    }
-
-    tempPropertyArray = calloc(tempPropertyCount, sizeof(*tempPropertyArray));
-
-    if (tempPropertyArray == NULL)
-    {
-        goto done;
-    }
-
-    for (size_t properties_index = 0; properties_index < tempPropertyCount; ++properties_index)
-    {
-        ADUC_Property* currProperty = tempPropertyArray + properties_index;
-
-        const char* propertiesName = json_object_get_name(propertiesObj, properties_index);
-        const char* propertiesValue = json_value_get_string(json_object_get_value_at(propertiesObj, properties_index));
-        if (!ADUC_Property_Init(currProperty, propertiesName, propertiesValue))
-        {
-            goto done;
-        }
-    }
-
-    *propertiesCount = tempPropertyCount;
-
-done:
-
-    if (*propertiesCount == 0 && tempPropertyCount > 0)
-    {
-        ADUC_Properties_FreeArray(tempPropertyCount, tempPropertyArray);
-        tempPropertyArray = NULL;
-    }
-
-    return tempPropertyArray;
-}
-
 /**
  * @brief Free the ADUC_RelatedFile struct members
  * @param hash a pointer to an ADUC_RelatedFile
@@ -394,240 +358,393 @@ void ADUC_RelatedFile_FreeArray(size_t relatedFileCount, ADUC_RelatedFile* relat
 }
 
 /**
- * @brief Allocates memory and populate with ADUC_RelatedFile object from a Parson JSON_Object.
- *
- * Caller MUST assume that this method allocates the memory for the returned ADUC_RelatedFile pointer.
+ * @brief Finds the download URL of @p fileId in the 'fileUrls' map of the workflow, and its enclosing workflow(s).
  *
  * @param handle The workflow handle.
- * @param relatedFileObj JSON Object that contains the relatedFiles to be returned.
- * @param relatedFileCount A size_t* where the count of output relatedFiles will be stored.
- * @returns If success, a pointer to an array of ADUC_RelatedFile object. Otherwise, returns NULL.
- * @details Caller must call ADUC_RelatedFileArray_Free() to free the array. On error, this function
- * will set extendedResultCode
+ * @param fileId The file id.
+ * @return const char* The URL, or NULL if no 'fileUrls' map has the file.
  */
-ADUC_RelatedFile* ADUC_RelatedFileArray_AllocAndInit(
-    ADUC_WorkflowHandle handle, const JSON_Object* relatedFileObj, size_t* relatedFileCount)
+static const char* workflow_find_file_url(ADUC_WorkflowHandle handle, const char* fileId)
 {
-    bool success = false;
-
-    ADUC_RelatedFile* tempRelatedFileArray = NULL;
     const JSON_Object* fileUrls = NULL;
+    const char* uri = NULL;
 
-    if (relatedFileObj == NULL || relatedFileCount == NULL)
+    ADUC_WorkflowHandle h = handle;
+    do
     {
-        return false;
+        if ((fileUrls = _workflow_get_fileurls_map(h)) != NULL)
+        {
+            uri = json_object_get_string(fileUrls, fileId);
+        }
+        h = workflow_get_parent(h);
+    } while (uri == NULL && h != NULL);
+
+    return uri;
+}
+
+//
+// Arena-backed file entity parsing.
+//
+// The parse functions below carve everything they return from the given arena, and may leave partial
+// allocations behind on failure. Callers take a mark beforehand and rewind to it on failure.
+//
+
+/**
+ * @brief Parses a 'hashes' JSON object into an ADUC_Hash array carved from @p arena.
+ *
+ * @param arena The arena.
+ * @param hashObj JSON Object that contains the hashes.
+ * @param[out] hashCount The count of hashes.
+ * @returns The hashes, or NULL on failure.
+ */
+static ADUC_Hash* workflow_arena_parse_hashes(ADUC_Arena* arena, const JSON_Object* hashObj, size_t* hashCount)
+{
+    *hashCount = 0;
+
+    size_t count = json_object_get_count(hashObj);
+    if (count == 0)
+    {
+        Log_Error("No hashes.");
+        return NULL;
     }
-    *relatedFileCount = 0;
 
-    size_t tempRelatedFileCount = json_object_get_count(relatedFileObj);
+    ADUC_Hash* hashes = ADUC_Arena_AllocArray(arena, count, sizeof(*hashes));
+    if (hashes == NULL)
+    {
+        return NULL;
+    }
 
-    if (tempRelatedFileCount == 0)
+    for (size_t i = 0; i < count; ++i)
     {
-        Log_Error("No relatedFiles.");
-        goto done;
+        const char* hashType = json_object_get_name(hashObj, i);
+        const char* hashValue = json_value_get_string(json_object_get_value_at(hashObj, i));
+        if (hashType == NULL || hashValue == NULL)
+        {
+            Log_Error("Invalid hash at %zu", i);
+            return NULL;
+        }
+
+        if ((hashes[i].type = ADUC_Arena_StrDup(arena, hashType)) == NULL
+            || (hashes[i].value = ADUC_Arena_StrDup(arena, hashValue)) == NULL)
+        {
+            return NULL;
+        }
+    }
+
+    *hashCount = count;
+    return hashes;
+}
+
+/**
+ * @brief Parses a 'properties' JSON object into an ADUC_Property array carved from @p arena.
+ *
+ * @param arena The arena.
+ * @param propertiesObj JSON Object that contains the properties.
+ * @param[out] propertiesCount The count of properties.
+ * @returns The properties, or NULL on failure.
+ */
+static ADUC_Property*
+workflow_arena_parse_properties(ADUC_Arena* arena, const JSON_Object* propertiesObj, size_t* propertiesCount)
+{
+    *propertiesCount = 0;
+
+    size_t count = json_object_get_count(propertiesObj);
+    if (count == 0)
+    {
+        Log_Error("No properties");
+        return NULL;
     }
 
-    tempRelatedFileArray = calloc(tempRelatedFileCount, sizeof(*tempRelatedFileArray));
+    ADUC_Property* properties = ADUC_Arena_AllocArray(arena, count, sizeof(*properties));
+    if (properties == NULL)
+    {
+        return NULL;
+    }
 
-    if (tempRelatedFileArray == NULL)
+    for (size_t i = 0; i < count; ++i)
     {
-        goto done;
+        const char* name = json_object_get_name(propertiesObj, i);
+        const char* value = json_value_get_string(json_object_get_value_at(propertiesObj, i));
+        if (name == NULL || value == NULL)
+        {
+            return NULL;
+        }
+
+        if ((properties[i].Name = ADUC_Arena_StrDup(arena, name)) == NULL
+            || (properties[i].Value = ADUC_Arena_StrDup(arena, value)) == NULL)
+        {
+            return NULL;
+        }
     }
 
-    for (size_t relatedFile_index = 0; relatedFile_index < tempRelatedFileCount; ++relatedFile_index)
+    *propertiesCount = count;
+    return properties;
+}
+
+/**
+ * @brief Parses a 'relatedFiles' JSON object into an ADUC_RelatedFile array carved from @p arena.
+ *
+ * @param handle The workflow handle, to resolve the download URLs against.
+ * @param arena The arena.
+ * @param relatedFileObj JSON Object that contains the related files.
+ * @param[out] relatedFileCount The count of related files.
+ * @returns The related files, or NULL on failure.
+ */
+static ADUC_RelatedFile* workflow_arena_parse_related_files(
+    ADUC_WorkflowHandle handle, ADUC_Arena* arena, const JSON_Object* relatedFileObj, size_t* relatedFileCount)
+{
+    *relatedFileCount = 0;
+
+    size_t count = json_object_get_count(relatedFileObj);
+    if (count == 0)
     {
-        const char* fileName = NULL;
-        const char* uri = NULL;
-        size_t hashCount = 0;
-        ADUC_Hash* tempHashes = NULL;
-        size_t propertiesCount = 0;
-        ADUC_Property* tempProperties = NULL;
+        Log_Error("No relatedFiles.");
+        return NULL;
+    }
+
+    ADUC_RelatedFile* relatedFiles = ADUC_Arena_AllocArray(arena, count, sizeof(*relatedFiles));
+    if (relatedFiles == NULL)
+    {
+        return NULL;
+    }
 
-        ADUC_RelatedFile* currentRelatedFile = tempRelatedFileArray + relatedFile_index;
+    for (size_t i = 0; i < count; ++i)
+    {
+        ADUC_RelatedFile* relatedFile = &relatedFiles[i];
 
-        JSON_Object* relatedFileValueObj =
-            json_value_get_object(json_object_get_value_at(relatedFileObj, relatedFile_index));
+        const JSON_Object* relatedFileValueObj = json_value_get_object(json_object_get_value_at(relatedFileObj, i));
         if (relatedFileValueObj == NULL)
         {
             Log_Error("no relatedFile");
-            goto done;
+            return NULL;
         }
 
-        // fileId
-        const char* fileId = json_object_get_name(relatedFileObj, relatedFile_index);
+        const char* fileId = json_object_get_name(relatedFileObj, i);
         if (IsNullOrEmpty(fileId))
         {
-            Log_Error("empty file id at %d", relatedFile_index);
-            goto done;
+            Log_Error("empty file id at %zu", i);
+            return NULL;
         }
 
-        // downloadUri
-        ADUC_WorkflowHandle h = handle;
-        do
-        {
-            if ((fileUrls = _workflow_get_fileurls_map(h)) != NULL)
-            {
-                uri = json_object_get_string(fileUrls, fileId);
-            }
-            h = workflow_get_parent(h);
-        } while (uri == NULL && h != NULL);
-
+        const char* uri = workflow_find_file_url(handle, fileId);
         if (uri == NULL)
         {
             Log_Error("Cannot find URL for fileId '%s'", fileId);
-            goto done;
+            return NULL;
         }
 
-        // fileName
-        fileName = json_object_get_string(relatedFileValueObj, "fileName");
-
-        // hashes
+        const char* fileName = json_object_get_string(relatedFileValueObj, "fileName");
+        if (fileName == NULL)
         {
-            JSON_Object* hashesObj = json_object_get_object(relatedFileValueObj, "hashes");
-            if (hashesObj == NULL)
-            {
-                Log_Error("'hashes' missing at %d", relatedFile_index);
-                goto done;
-            }
-
-            tempHashes = ADUC_HashArray_AllocAndInit(hashesObj, &hashCount);
-            if (tempHashes == NULL)
-            {
-                goto done;
-            }
+            Log_Error("'fileName' missing at %zu", i);
+            return NULL;
         }
 
-        // properties
+        const JSON_Object* hashesObj = json_object_get_object(relatedFileValueObj, "hashes");
+        if (hashesObj == NULL)
         {
-            JSON_Object* propertiesObj = json_object_get_object(relatedFileValueObj, "properties");
-            if (propertiesObj == NULL)
-            {
-                Log_Error("'properties' missing at %d", relatedFile_index);
-                goto done;
-            }
-
-            tempProperties = ADUC_PropertiesArray_AllocAndInit(propertiesObj, &propertiesCount);
-            if (tempProperties == NULL)
-            {
-                goto done;
-            }
+            Log_Error("'hashes' missing at %zu", i);
+            return NULL;
         }
 
-        if (!ADUC_RelatedFile_Init(
-                currentRelatedFile, fileId, uri, fileName, hashCount, tempHashes, propertiesCount, tempProperties))
+        const JSON_Object* propertiesObj = json_object_get_object(relatedFileValueObj, "properties");
+        if (propertiesObj == NULL)
         {
-            goto done;
+            Log_Error("'properties' missing at %zu", i);
+            return NULL;
         }
-    }
-
-    *relatedFileCount = tempRelatedFileCount;
-
-    success = true;
-
-done:
 
-    if (!success)
-    {
-        ADUC_RelatedFile_FreeArray(tempRelatedFileCount, tempRelatedFileArray);
-        tempRelatedFileArray = NULL;
+        if ((relatedFile->FileId = ADUC_Arena_StrDup(arena, fileId)) == NULL
+            || (relatedFile->DownloadUri = ADUC_Arena_StrDup(arena, uri)) == NULL
+            || (relatedFile->FileName = ADUC_Arena_StrDup(arena, fileName)) == NULL
+            || (relatedFile->Hash = workflow_arena_parse_hashes(arena, hashesObj, &relatedFile->HashCount)) == NULL
+            || (relatedFile->Properties =
+                    workflow_arena_parse_properties(arena, propertiesObj, &relatedFile->PropertiesCount))
+                == NULL)
+        {
+            return NULL;
+        }
     }
 
-    return tempRelatedFileArray;
+    *relatedFileCount = count;
+    return relatedFiles;
 }
 
 /**
- * @brief Parses the related files and assigns the relevant fields on the given ADUC_FileEntity.
+ * @brief Parses the downloadHandlerId and related files for a file entry in the update metadata json.
  *
  * @param handle The workflow handle.
+ * @param arena The arena.
  * @param file the json object parsed from a file entry in the update metadata.
  * @param entity the file entity.
  * @returns true for success.
  */
-static bool ParseFileEntityRelatedFiles(ADUC_WorkflowHandle handle, const JSON_Object* file, ADUC_FileEntity* entity)
+static bool workflow_arena_parse_download_handler(
+    ADUC_WorkflowHandle handle, ADUC_Arena* arena, const JSON_Object* file, ADUC_FileEntity* entity)
 {
-    bool success = false;
-
-    const JSON_Object* relatedFilesObj = json_object_get_object(file, ADUCITF_FIELDNAME_RELATEDFILES);
-    if (relatedFilesObj == NULL)
+    const JSON_Object* downloadHandlerObj = json_object_get_object(file, ADUCITF_FIELDNAME_DOWNLOADHANDLER);
+    if (downloadHandlerObj == NULL)
     {
-        // it's not necessarily an error if there are no related files for the file entity as one can
-        // have a download handler that does not use/process related files.
+        // it's ok not to have a download handler json object if there's none associated with the related file.
         return true;
     }
 
-    size_t tempRelatedFilesCount = 0;
-    ADUC_RelatedFile* tempRelatedFiles =
-        ADUC_RelatedFileArray_AllocAndInit(handle, relatedFilesObj, &tempRelatedFilesCount);
-    if (tempRelatedFiles == NULL)
+    const char* downloadHandlerId =
+        json_object_get_string(downloadHandlerObj, ADUCITF_FIELDNAME_DOWNLOADHANDLER_ID);
+    if (IsNullOrEmpty(downloadHandlerId))
     {
-        goto done;
+        Log_Error("missing '%s' under '%s'", ADUCITF_FIELDNAME_DOWNLOADHANDLER_ID, ADUCITF_FIELDNAME_DOWNLOADHANDLER);
+        return false;
     }
 
-    entity->RelatedFileCount = tempRelatedFilesCount;
-    entity->RelatedFiles = tempRelatedFiles;
-    tempRelatedFiles = NULL;
-    tempRelatedFilesCount = 0;
-
-    success = true;
-
-done:
+    if ((entity->DownloadHandlerId = ADUC_Arena_StrDup(arena, downloadHandlerId)) == NULL)
+    {
+        return false;
+    }
 
-    if (tempRelatedFilesCount > 0 && tempRelatedFiles != NULL)
+    const JSON_Object* relatedFilesObj = json_object_get_object(file, ADUCITF_FIELDNAME_RELATEDFILES);
+    if (relatedFilesObj == NULL)
     {
-        ADUC_RelatedFile_FreeArray(tempRelatedFilesCount, tempRelatedFiles);
+        // it's not necessarily an error if there are no related files for the file entity as one can
+        // have a download handler that does not use/process related files.
+        return true;
     }
 
-    return success;
+    entity->RelatedFiles =
+        workflow_arena_parse_related_files(handle, arena, relatedFilesObj, &entity->RelatedFileCount);
+
+    return entity->RelatedFiles != NULL;
 }
 
 /**
- * @brief Parses the downloadHandlerId and related files for a file entry in the update metadata json.
+ * @brief Builds the file entity for a file entry of the update manifest, resolving its download URL against
+ * the 'fileUrls' maps of the workflow and its enclosing workflow(s). Everything the entity references is
+ * carved from @p arena.
  *
  * @param handle The workflow handle.
- * @param file the json object parsed from a file entry in the update metadata.
- * @param entity the file entity.
- * @returns true for success.
+ * @param arena The arena.
+ * @param fileId The file id.
+ * @param file The file entry in the update manifest.
+ * @param[out] entity The output file entity. Its DownloadUri is NULL if no 'fileUrls' map has the file.
+ * @return true on success.
  */
-static bool
-ParseFileEntityDownloadHandler(ADUC_WorkflowHandle handle, const JSON_Object* file, ADUC_FileEntity* entity)
+static bool workflow_arena_resolve_file(
+    ADUC_WorkflowHandle handle,
+    ADUC_Arena* arena,
+    const char* fileId,
+    const JSON_Object* file,
+    ADUC_FileEntity* entity)
 {
-    bool success = false;
-    const char* downloadHandlerId = NULL;
-    const JSON_Object* downloadHandlerObj = NULL;
+    memset(entity, 0, sizeof(*entity));
 
-    if (entity == NULL)
+    if (fileId == NULL || file == NULL)
     {
         return false;
     }
 
-    downloadHandlerObj = json_object_get_object(file, ADUCITF_FIELDNAME_DOWNLOADHANDLER);
-    if (downloadHandlerObj == NULL)
+    const char* uri = workflow_find_file_url(handle, fileId);
+    if (uri == NULL)
     {
-        // it's ok not to have a download handler json object if there's none associated with the related file.
-        return true;
+        Log_Error("Cannot find URL for fileId '%s'", fileId);
     }
 
-    downloadHandlerId = json_object_get_string(downloadHandlerObj, ADUCITF_FIELDNAME_DOWNLOADHANDLER_ID);
-    if (IsNullOrEmpty(downloadHandlerId))
+    const char* name = json_object_get_string(file, ADUCITF_FIELDNAME_FILENAME);
+    if (name == NULL)
     {
-        Log_Error("missing '%s' under '%s'", ADUCITF_FIELDNAME_DOWNLOADHANDLER_ID, ADUCITF_FIELDNAME_DOWNLOADHANDLER);
-        goto done;
+        Log_Error("Invalid file entity arguments");
+        return false;
     }
 
-    if (mallocAndStrcpy_s(&(entity->DownloadHandlerId), downloadHandlerId) != 0)
+    const char* arguments = json_object_get_string(file, ADUCITF_FIELDNAME_ARGUMENTS);
+
+    entity->Hash = workflow_arena_parse_hashes(
+        arena, json_object_get_object(file, ADUCITF_FIELDNAME_HASHES), &entity->HashCount);
+    if (entity->Hash == NULL)
     {
-        goto done;
+        Log_Error("Unable to parse hashes for file '%s'", fileId);
+        return false;
     }
 
-    if (!ParseFileEntityRelatedFiles(handle, file, entity))
+    if (json_object_has_value(file, ADUCITF_FIELDNAME_SIZEINBYTES))
     {
-        goto done;
+        entity->SizeInBytes = (size_t)json_object_get_number(file, ADUCITF_FIELDNAME_SIZEINBYTES);
     }
 
-    success = true;
-done:
+    if ((entity->FileId = ADUC_Arena_StrDup(arena, fileId)) == NULL
+        || (entity->TargetFilename = ADUC_Arena_StrDup(arena, name)) == NULL
+        || (uri != NULL && (entity->DownloadUri = ADUC_Arena_StrDup(arena, uri)) == NULL)
+        || (arguments != NULL && (entity->Arguments = ADUC_Arena_StrDup(arena, arguments)) == NULL))
+    {
+        return false;
+    }
 
-    return success;
+    return workflow_arena_parse_download_handler(handle, arena, file, entity);
+}
+
+// Guards the lazily built file entity caches of all workflows, which readers on different threads
+// (e.g. concurrently processed components) may fill in at the same time.
+static pthread_mutex_t s_fileEntityCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+
+/**
+ * @brief Gets the arena backing the workflow's resolved file entities, creating it on first use.
+ * Caller must hold s_fileEntityCacheMutex.
+ *
+ * @param wf The workflow.
+ * @return ADUC_Arena* The arena, or NULL on allocation failure.
+ */
+static ADUC_Arena* workflow_get_file_entity_arena(ADUC_Workflow* wf)
+{
+    if (wf->FileEntityArena == NULL)
+    {
+        wf->FileEntityArena = ADUC_Arena_Create(0 /* blockSize */);
+    }
+
+    return wf->FileEntityArena;
+}
+
+/**
+ * @brief Uninitializes a heap-allocated file entity, including the download handler id and related files
+ * that ADUC_FileEntity_Uninit leaves to the caller.
+ *
+ * @param entity The file entity.
+ */
+static void workflow_uninit_file_entity(ADUC_FileEntity* entity)
+{
+    free(entity->DownloadHandlerId);
+    entity->DownloadHandlerId = NULL;
+
+    ADUC_RelatedFile_FreeArray(entity->RelatedFileCount, entity->RelatedFiles);
+    entity->RelatedFiles = NULL;
+    entity->RelatedFileCount = 0;
+
+    ADUC_FileEntity_Uninit(entity);
+}
+
+/**
+ * @brief Frees the cached file entities and file name index of the workflow, releasing their arena in one shot.
+ * Must be called whenever the files or the 'fileUrls' they resolve against may change.
+ *
+ * @param wf The workflow.
+ */
+static void workflow_invalidate_file_entity_cache(ADUC_Workflow* wf)
+{
+    if (wf == NULL)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s_fileEntityCacheMutex);
+
+    ADUC_Arena_Free(wf->FileEntityArena);
+    wf->FileEntityArena = NULL;
+
+    wf->FileEntities = NULL;
+    wf->FileEntityCount = 0;
+
+    wf->FileNameIndex = NULL;
+    wf->FileNameIndexSize = 0;
+
+    pthread_mutex_unlock(&s_fileEntityCacheMutex);
 }
 
 /**
@@ -808,85 +925,208 @@ done:
 }
 
 /**
- * @brief Helper function for checking the hash of the updatemanifest is equal to the
- * hash held within the signature
- * @param updateActionObject update action JSON object.
- * @returns true on success and false on failure
+ * @brief Helper function for getting the hash of the updatemanifest held within the signature.
+ * @param updateManifestb64Signature The update manifest signature JWS.
+ * @returns The base64 encoded SHA256 hash of the update manifest, or NULL on failure. Caller must free() it.
  */
-static bool Json_ValidateManifestHash(const JSON_Object* updateActionObject)
+static char* Json_GetSignedManifestHash(const char* updateManifestb64Signature)
 {
-    bool success = false;
+    char* hash = NULL;
 
     JSON_Value* signatureValue = NULL;
     char* jwtPayload = NULL;
 
-    if (updateActionObject == NULL)
+    if (!GetPayloadFromJWT(updateManifestb64Signature, &jwtPayload))
     {
-        Log_Error("NULL updateActionObject");
+        Log_Error("Retrieving the payload from the manifest failed.");
         goto done;
     }
 
-    const char* updateManifestStr = json_object_get_string(updateActionObject, ADUCITF_FIELDNAME_UPDATEMANIFEST);
-
-    if (updateManifestStr == NULL)
+    signatureValue = json_parse_string(jwtPayload);
+    if (signatureValue == NULL)
     {
-        Log_Error("No updateManifest field in updateActionJson ");
+        Log_Error("updateManifestSignature contains an invalid body");
         goto done;
     }
 
-    const char* updateManifestb64Signature =
-        json_object_get_string(updateActionObject, ADUCITF_FIELDNAME_UPDATEMANIFESTSIGNATURE);
-    if (updateManifestb64Signature == NULL)
+    const char* b64SignatureManifestHash =
+        json_object_get_string(json_object(signatureValue), ADUCITF_JWT_FIELDNAME_HASH);
+    if (b64SignatureManifestHash == NULL)
     {
-        Log_Error("No updateManifestSignature within the updateActionJson");
+        Log_Error("updateManifestSignature does not contain a hash value. Cannot validate the manifest!");
         goto done;
     }
 
-    if (!GetPayloadFromJWT(updateManifestb64Signature, &jwtPayload))
+    if (mallocAndStrcpy_s(&hash, b64SignatureManifestHash) != 0)
     {
-        Log_Error("Retrieving the payload from the manifest failed.");
-        goto done;
+        hash = NULL;
     }
 
-    signatureValue = json_parse_string(jwtPayload);
-    if (signatureValue == NULL)
+done:
+
+    json_value_free(signatureValue);
+
+    free(jwtPayload);
+    return hash;
+}
+
+//
+// Verified update manifest signatures
+//
+// Verifying an update manifest signature takes two RSA verifications, which are repeated whenever the same deployment
+// is parsed again, e.g. on retries and for child workflows. Signatures that verified successfully are remembered,
+// with the manifest hash they hold, for as long as the root key store they were verified against stays loaded.
+//
+
+/**
+ * @brief The maximum number of remembered signatures. The least recently used entry is evicted first.
+ */
+#define VERIFIED_SIGNATURE_CACHE_MAX_ENTRIES 8
+
+typedef struct tagADUC_VerifiedSignatureCacheEntry
+{
+    char signatureDigest[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE]; //!< The SHA256 digest of the signature.
+    uint64_t rootKeyStoreGeneration; //!< The root key store generation the signature was verified against.
+    char* signedManifestHash; //!< The update manifest hash held within the signature. NULL if the entry is unused.
+    uint64_t lastUsed; //!< The value of s_verifiedSignatureCacheUseCount when the entry was last used.
+} ADUC_VerifiedSignatureCacheEntry;
+
+static pthread_mutex_t s_verifiedSignatureCacheMutex = PTHREAD_MUTEX_INITIALIZER;
+static ADUC_VerifiedSignatureCacheEntry s_verifiedSignatureCache[VERIFIED_SIGNATURE_CACHE_MAX_ENTRIES];
+static uint64_t s_verifiedSignatureCacheUseCount = 0;
+
+/**
+ * @brief Computes the base64 encoded SHA256 digest of @p signature.
+ *
+ * @param signature The update manifest signature.
+ * @param[out] digest The buffer for the digest.
+ * @param digestSize The size of @p digest.
+ * @return true on success.
+ */
+static bool GetSignatureDigest(const char* signature, char* digest, size_t digestSize)
+{
+    bool success = false;
+    ADUC_HashStreamHandle stream = ADUC_HashUtils_HashStream_Create(SHA256);
+
+    if (stream != NULL && ADUC_HashUtils_HashStream_Update(stream, (const uint8_t*)signature, strlen(signature))
+        && ADUC_HashUtils_HashStream_GetResult(stream, digest, digestSize))
     {
-        Log_Error("updateManifestSignature contains an invalid body");
-        goto done;
+        success = true;
+    }
+
+    ADUC_HashUtils_HashStream_Free(stream);
+    return success;
+}
+
+/**
+ * @brief Looks up a signature that was already verified against the current root key store.
+ *
+ * @param signatureDigest The digest of the signature.
+ * @param rootKeyStoreGeneration The current root key store generation.
+ * @return char* The update manifest hash held within the signature, or NULL if the signature was not verified against
+ * @p rootKeyStoreGeneration. Caller must free() it.
+ */
+static char* VerifiedSignatureCache_Lookup(const char* signatureDigest, uint64_t rootKeyStoreGeneration)
+{
+    char* signedManifestHash = NULL;
+
+    if (rootKeyStoreGeneration == 0)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&s_verifiedSignatureCacheMutex);
+
+    for (size_t i = 0; i < VERIFIED_SIGNATURE_CACHE_MAX_ENTRIES; ++i)
+    {
+        ADUC_VerifiedSignatureCacheEntry* entry = &s_verifiedSignatureCache[i];
+
+        if (entry->signedManifestHash != NULL && entry->rootKeyStoreGeneration == rootKeyStoreGeneration
+            && strcmp(entry->signatureDigest, signatureDigest) == 0)
+        {
+            if (mallocAndStrcpy_s(&signedManifestHash, entry->signedManifestHash) != 0)
+            {
+                signedManifestHash = NULL;
+            }
+
+            entry->lastUsed = ++s_verifiedSignatureCacheUseCount;
+            break;
+        }
     }
 
-    const char* b64SignatureManifestHash =
-        json_object_get_string(json_object(signatureValue), ADUCITF_JWT_FIELDNAME_HASH);
-    if (b64SignatureManifestHash == NULL)
-    {
-        Log_Error("updateManifestSignature does not contain a hash value. Cannot validate the manifest!");
-        goto done;
+    pthread_mutex_unlock(&s_verifiedSignatureCacheMutex);
+
+    return signedManifestHash;
+}
+
+/**
+ * @brief Remembers a signature that verified successfully against the root key store.
+ *
+ * @param signatureDigest The digest of the signature.
+ * @param rootKeyStoreGeneration The root key store generation the signature was verified against.
+ * @param signedManifestHash The update manifest hash held within the signature.
+ */
+static void VerifiedSignatureCache_Store(
+    const char* signatureDigest, uint64_t rootKeyStoreGeneration, const char* signedManifestHash)
+{
+    char* signedManifestHashCopy = NULL;
+
+    if (rootKeyStoreGeneration == 0 || mallocAndStrcpy_s(&signedManifestHashCopy, signedManifestHash) != 0)
+    {
+        return;
+    }
+
+    pthread_mutex_lock(&s_verifiedSignatureCacheMutex);
+
+    ADUC_VerifiedSignatureCacheEntry* victim = &s_verifiedSignatureCache[0];
+
+    for (size_t i = 0; i < VERIFIED_SIGNATURE_CACHE_MAX_ENTRIES; ++i)
+    {
+        ADUC_VerifiedSignatureCacheEntry* entry = &s_verifiedSignatureCache[i];
+
+        if (entry->signedManifestHash == NULL || strcmp(entry->signatureDigest, signatureDigest) == 0)
+        {
+            victim = entry;
+            break;
+        }
+
+        if (entry->lastUsed < victim->lastUsed)
+        {
+            victim = entry;
+        }
     }
 
-    success = ADUC_HashUtils_IsValidBufferHash(
-        (const uint8_t*)updateManifestStr, strlen(updateManifestStr), b64SignatureManifestHash, SHA256);
+    free(victim->signedManifestHash);
 
-done:
-
-    json_value_free(signatureValue);
+    ADUC_Safe_StrCopyN(
+        victim->signatureDigest, signatureDigest, sizeof(victim->signatureDigest), strlen(signatureDigest));
+    victim->rootKeyStoreGeneration = rootKeyStoreGeneration;
+    victim->signedManifestHash = signedManifestHashCopy;
+    victim->lastUsed = ++s_verifiedSignatureCacheUseCount;
 
-    free(jwtPayload);
-    return success;
+    pthread_mutex_unlock(&s_verifiedSignatureCacheMutex);
 }
 
 /**
  * @brief Validates the update manifest signature.
+ * @details A signature that already verified against the current root key store is not verified again.
  * @param updateActionObject The update action JSON object.
+ * @param[out] outSignedManifestHash Receives the update manifest hash held within the signature, to be checked
+ * against the update manifest when it is parsed. Caller must free() it.
  *
  * @return ADUC_Result The result.
  */
-static ADUC_Result workflow_validate_update_manifest_signature(JSON_Object* updateActionObject)
+static ADUC_Result
+workflow_validate_update_manifest_signature(JSON_Object* updateActionObject, char** outSignedManifestHash)
 {
     ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
     const char* manifestSignature = NULL;
     JWSResult jwsResult = JWSResult_Failed;
+    char signatureDigest[ADUC_HASHUTILS_MAX_BASE64_HASH_SIZE];
+    bool isCacheable = false;
+    uint64_t rootKeyStoreGeneration = 0;
 
-    if (updateActionObject == NULL)
+    if (updateActionObject == NULL || outSignedManifestHash == NULL)
     {
         result.ExtendedResultCode = ADUC_ERC_UTILITIES_WORKFLOW_UTIL_ERROR_BAD_PARAM;
         return result;
@@ -900,6 +1140,20 @@ static ADUC_Result workflow_validate_update_manifest_signature(JSON_Object* upda
         goto done;
     }
 
+    isCacheable = GetSignatureDigest(manifestSignature, signatureDigest, sizeof(signatureDigest));
+    rootKeyStoreGeneration = RootKeyUtility_GetLocalStoreGeneration();
+
+    if (isCacheable)
+    {
+        *outSignedManifestHash = VerifiedSignatureCache_Lookup(signatureDigest, rootKeyStoreGeneration);
+        if (*outSignedManifestHash != NULL)
+        {
+            Log_Debug("Update manifest signature was already verified.");
+            result.ResultCode = ADUC_GeneralResult_Success;
+            goto done;
+        }
+    }
+
     jwsResult = VerifyJWSWithSJWK(manifestSignature);
     if (jwsResult != JWSResult_Success)
     {
@@ -917,14 +1171,19 @@ static ADUC_Result workflow_validate_update_manifest_signature(JSON_Object* upda
         goto done;
     }
 
-    if (!Json_ValidateManifestHash(updateActionObject))
+    *outSignedManifestHash = Json_GetSignedManifestHash(manifestSignature);
+    if (*outSignedManifestHash == NULL)
     {
-        // Handle failed hash case
-        Log_Error("Json_ValidateManifestHash failed");
         result.ExtendedResultCode = ADUC_ERC_UTILITIES_UPDATE_DATA_PARSER_MANIFEST_VALIDATION_FAILED;
         goto done;
     }
 
+    // Only remember the signature if the root key store did not change while it was verified.
+    if (isCacheable && RootKeyUtility_GetLocalStoreGeneration() == rootKeyStoreGeneration)
+    {
+        VerifiedSignatureCache_Store(signatureDigest, rootKeyStoreGeneration, *outSignedManifestHash);
+    }
+
     result.ResultCode = ADUC_GeneralResult_Success;
 done:
     if (IsAducResultCodeFailure(result.ResultCode))
@@ -940,12 +1199,15 @@ done:
 
 /**
  * @brief Updates the workflow object's UpdateManifest JSON object based on the workflow object's UpdateAction JSON object.
+ * The embedded update manifest string is hashed and parsed from the same buffer, and the object form is copied
+ * without a serialize and parse round trip.
  *
  * @param wf The workflow object.
+ * @param signedManifestHash The update manifest hash held within the signature, or NULL to skip the hash check.
  *
  * @return ADUC_Result The result
  */
-static ADUC_Result UpdateWorkflowUpdateManifestObjFromUpdateActionObj(ADUC_Workflow* wf)
+static ADUC_Result UpdateWorkflowUpdateManifestObjFromUpdateActionObj(ADUC_Workflow* wf, const char* signedManifestHash)
 {
     ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
 
@@ -963,17 +1225,33 @@ static ADUC_Result UpdateWorkflowUpdateManifestObjFromUpdateActionObj(ADUC_Workf
             goto done;
         }
 
+        // The signature covers the exact bytes of the embedded string, so check them before they are parsed.
+        if (signedManifestHash != NULL
+            && !ADUC_HashUtils_IsValidBufferHash(
+                (const uint8_t*)updateManifestString, strlen(updateManifestString), signedManifestHash, SHA256))
+        {
+            Log_Error("Update manifest hash does not match the hash in updateManifestSignature");
+            result.ExtendedResultCode = ADUC_ERC_UTILITIES_UPDATE_DATA_PARSER_MANIFEST_VALIDATION_FAILED;
+            goto done;
+        }
+
         wf->UpdateManifestObject = json_value_get_object(json_parse_string(updateManifestString));
     }
     // In case the Update Manifest is in a from of JSON object.
     else if (json_object_has_value_of_type(wf->UpdateActionObject, ADUCITF_FIELDNAME_UPDATEMANIFEST, JSONObject))
     {
+        if (signedManifestHash != NULL)
+        {
+            // Only the string form has the exact bytes that were signed.
+            Log_Error("No updateManifest string in updateActionJson to validate");
+            result.ExtendedResultCode = ADUC_ERC_UTILITIES_UPDATE_DATA_PARSER_MANIFEST_VALIDATION_FAILED;
+            goto done;
+        }
+
         JSON_Value* v = json_object_get_value(wf->UpdateActionObject, ADUCITF_FIELDNAME_UPDATEMANIFEST);
         if (v != NULL)
         {
-            char* serialized = json_serialize_to_string(v);
-            wf->UpdateManifestObject = json_value_get_object(json_parse_string(serialized));
-            json_free_serialized_string(serialized);
+            wf->UpdateManifestObject = json_value_get_object(json_value_deep_copy(v));
         }
     }
 
@@ -1081,6 +1359,7 @@ ADUC_Result ReplaceExistingUpdateManifestWithDetachedManifest(
     }
 
     // Replace old manifest object with detached one.
+    workflow_invalidate_file_entity_cache(wf);
     json_value_free(json_object_get_wrapping_value(wf->UpdateManifestObject));
     wf->UpdateManifestObject = detachedManifestJsonObj;
     detachedManifestJsonObj = NULL;
@@ -1227,20 +1506,21 @@ done:
 /**
  * @brief A helper function for parsing workflow data from file, or from string.
  *
- * @param updateActionJson The update action JSON value.
+ * @param updateActionJson The update action JSON value. On success, ownership moves to the workflow and
+ * the pointer is set to NULL.
  * @param validateManifest A boolean indicates whether to validate the manifest.
  * @param handle An output workflow object handle.
  * @return ADUC_Result The result.
  */
-ADUC_Result _workflow_parse(const JSON_Value* updateActionJson, bool validateManifest, ADUC_WorkflowHandle* handle)
+ADUC_Result _workflow_parse(JSON_Value** updateActionJson, bool validateManifest, ADUC_WorkflowHandle* handle)
 {
     ADUC_Result result = { .ResultCode = ADUC_GeneralResult_Failure, .ExtendedResultCode = 0 };
 
     ADUC_Workflow* wf = NULL;
-    JSON_Value* updateActionJsonClone = NULL;
     ADUCITF_UpdateAction updateAction = ADUCITF_UpdateAction_Undefined;
+    char* signedManifestHash = NULL;
 
-    if (handle == NULL)
+    if (updateActionJson == NULL || *updateActionJson == NULL || handle == NULL)
     {
         result.ExtendedResultCode = ADUC_ERC_UTILITIES_WORKFLOW_UTIL_ERROR_BAD_PARAM;
         return result;
@@ -1257,12 +1537,8 @@ ADUC_Result _workflow_parse(const JSON_Value* updateActionJson, bool validateMan
 
     memset(wf, 0, sizeof(*wf));
 
-    updateActionJsonClone = json_value_deep_copy(updateActionJson);
-    updateActionJson = NULL;
-
-    // commit ownership of cloned JSON_Value to the workflow's UpdateActionObject.
-    wf->UpdateActionObject = json_value_get_object(updateActionJsonClone);
-    updateActionJsonClone = NULL;
+    // Commit the parsed JSON_Value to the workflow's UpdateActionObject. It is handed back to the caller on failure.
+    wf->UpdateActionObject = json_value_get_object(*updateActionJson);
 
     // At this point, we have had a side-effect of committing to the
     // wf->UpdateActionObject.
@@ -1291,7 +1567,7 @@ ADUC_Result _workflow_parse(const JSON_Value* updateActionJson, bool validateMan
         // We will skip the validation for these cases.
         if (updateAction != ADUCITF_UpdateAction_Undefined && validateManifest)
         {
-            tmpResult = workflow_validate_update_manifest_signature(wf->UpdateActionObject);
+            tmpResult = workflow_validate_update_manifest_signature(wf->UpdateActionObject, &signedManifestHash);
             if (IsAducResultCodeFailure(tmpResult.ResultCode))
             {
                 result = tmpResult;
@@ -1299,7 +1575,7 @@ ADUC_Result _workflow_parse(const JSON_Value* updateActionJson, bool validateMan
             }
         }
 
-        tmpResult = UpdateWorkflowUpdateManifestObjFromUpdateActionObj(wf);
+        tmpResult = UpdateWorkflowUpdateManifestObjFromUpdateActionObj(wf, signedManifestHash);
         if (IsAducResultCodeFailure(tmpResult.ResultCode))
         {
             result = tmpResult;
@@ -1337,18 +1613,21 @@ ADUC_Result _workflow_parse(const JSON_Value* updateActionJson, bool validateMan
     }
 
     *handle = wf;
+    *updateActionJson = NULL;
     result.ResultCode = ADUC_GeneralResult_Success;
     result.ExtendedResultCode = 0;
 
 done:
 
-    if (updateActionJsonClone != NULL)
-    {
-        json_value_free(updateActionJsonClone);
-    }
+    free(signedManifestHash);
 
-    if (IsAducResultCodeFailure(result.ResultCode))
+    if (IsAducResultCodeFailure(result.ResultCode) && wf != NULL)
     {
+        if (wf->UpdateManifestObject != NULL)
+        {
+            json_value_free(json_object_get_wrapping_value(wf->UpdateManifestObject));
+        }
+
         free(wf);
         wf = NULL;
     }
@@ -1356,6 +1635,61 @@ done:
     return result;
 }
 
+/**
+ * @brief Gets the shared json owner of @p wf, moving the workflow's own Update Action and Manifest into
+ * a new one if needed, and adds a reference for the caller.
+ *
+ * @param wf The workflow whose parsed json is to be shared.
+ * @return ADUC_Workflow_Shared_Json* The shared json owner, or NULL on allocation failure.
+ */
+static ADUC_Workflow_Shared_Json* workflow_share_json(ADUC_Workflow* wf)
+{
+    if (wf->SharedJson == NULL)
+    {
+        ADUC_Workflow_Shared_Json* shared = calloc(1, sizeof(*shared));
+        if (shared == NULL)
+        {
+            return NULL;
+        }
+
+        shared->UpdateActionValue = json_object_get_wrapping_value(wf->UpdateActionObject);
+        shared->UpdateManifestValue = json_object_get_wrapping_value(wf->UpdateManifestObject);
+        shared->RefCount = 1;
+        wf->SharedJson = shared;
+    }
+
+    // Adding a reference needs one already held through wf, so it can never race the last release.
+    WORKFLOW_ATOMIC_INCREMENT(&wf->SharedJson->RefCount);
+    return wf->SharedJson;
+}
+
+/**
+ * @brief Drops the reference of @p wf to its shared json once it no longer uses any of it.
+ * The json is freed when the last referencing workflow drops its reference.
+ *
+ * @param wf The workflow.
+ */
+static void workflow_release_shared_json(ADUC_Workflow* wf)
+{
+    ADUC_Workflow_Shared_Json* shared = wf->SharedJson;
+
+    if (shared == NULL || wf->UpdateActionObject != NULL || wf->UpdateManifestObject != NULL)
+    {
+        return;
+    }
+
+    wf->SharedJson = NULL;
+    wf->StepObject = NULL;
+
+    // Workflows sharing the json may be freed on different threads, e.g. when components are processed concurrently.
+    if (WORKFLOW_ATOMIC_DECREMENT(&shared->RefCount) == 0)
+    {
+        json_value_free(shared->UpdateActionValue);
+        json_value_free(shared->UpdateManifestValue);
+        free(shared);
+    }
+}
+
 /**
  * @brief Free an UpdateActionObject.
  *
@@ -1366,8 +1700,12 @@ void _workflow_free_updateaction(ADUC_WorkflowHandle handle)
     ADUC_Workflow* wf = workflow_from_handle(handle);
     if (wf != NULL && wf->UpdateActionObject != NULL)
     {
-        json_value_free(json_object_get_wrapping_value(wf->UpdateActionObject));
+        if (wf->SharedJson == NULL)
+        {
+            json_value_free(json_object_get_wrapping_value(wf->UpdateActionObject));
+        }
         wf->UpdateActionObject = NULL;
+        workflow_release_shared_json(wf);
     }
 }
 
@@ -1381,9 +1719,22 @@ void _workflow_free_updatemanifest(ADUC_WorkflowHandle handle)
     ADUC_Workflow* wf = workflow_from_handle(handle);
     if (wf != NULL && wf->UpdateManifestObject != NULL)
     {
-        json_value_free(json_object_get_wrapping_value(wf->UpdateManifestObject));
+        if (wf->SharedJson == NULL)
+        {
+            json_value_free(json_object_get_wrapping_value(wf->UpdateManifestObject));
+        }
         wf->UpdateManifestObject = NULL;
+        workflow_release_shared_json(wf);
+    }
+
+    if (wf != NULL)
+    {
+        free(wf->StepFileIndexes);
+        wf->StepFileIndexes = NULL;
+        wf->StepFileCount = 0;
     }
+
+    workflow_invalidate_file_entity_cache(wf);
 }
 
 /**
@@ -1716,8 +2067,14 @@ char* workflow_get_string_property(ADUC_WorkflowHandle handle, const char* prope
     return NULL;
 }
 
+// Serializes boolean properties, since the reboot and restart requests of concurrently processed
+// components all land on the root workflow.
+static pthread_mutex_t s_booleanPropertyMutex = PTHREAD_MUTEX_INITIALIZER;
+
 bool workflow_set_boolean_property(ADUC_WorkflowHandle handle, const char* property, bool value)
 {
+    bool succeeded = false;
+
     if (handle == NULL)
     {
         return false;
@@ -1725,16 +2082,22 @@ bool workflow_set_boolean_property(ADUC_WorkflowHandle handle, const char* prope
 
     ADUC_Workflow* wf = workflow_from_handle(handle);
 
-    if (wf->PropertiesObject == NULL)
+    pthread_mutex_lock(&s_booleanPropertyMutex);
+
+    if (wf->PropertiesObject != NULL)
     {
-        return false;
+        succeeded = JSONSuccess == json_object_set_boolean(wf->PropertiesObject, property, value);
     }
 
-    return JSONSuccess == json_object_set_boolean(wf->PropertiesObject, property, value);
+    pthread_mutex_unlock(&s_booleanPropertyMutex);
+
+    return succeeded;
 }
 
 bool workflow_get_boolean_property(ADUC_WorkflowHandle handle, const char* property)
 {
+    bool value = false;
+
     if (handle == NULL)
     {
         return false;
@@ -1742,12 +2105,16 @@ bool workflow_get_boolean_property(ADUC_WorkflowHandle handle, const char* prope
 
     ADUC_Workflow* wf = workflow_from_handle(handle);
 
-    if (wf->PropertiesObject == NULL || !json_object_has_value(wf->PropertiesObject, property))
+    pthread_mutex_lock(&s_booleanPropertyMutex);
+
+    if (wf->PropertiesObject != NULL && json_object_has_value(wf->PropertiesObject, property))
     {
-        return false;
+        value = json_object_get_boolean(wf->PropertiesObject, property);
     }
 
-    return json_object_get_boolean(wf->PropertiesObject, property);
+    pthread_mutex_unlock(&s_booleanPropertyMutex);
+
+    return value;
 }
 
 bool workflow_set_workfolder(ADUC_WorkflowHandle handle, const char* format, ...)
@@ -2156,223 +2523,400 @@ ADUCITF_UpdateAction workflow_get_action(ADUC_WorkflowHandle handle)
     return action;
 }
 
+/**
+ * @brief Gets the file at @p index of the workflow's files, honoring the inline step view.
+ *
+ * @param handle A workflow object handle.
+ * @param index A file index.
+ * @param[out] fileId Receives the read-only file id.
+ * @return const JSON_Object* The read-only file object, or NULL if there is no such file.
+ */
+static const JSON_Object*
+workflow_peek_update_file_object(ADUC_WorkflowHandle handle, size_t index, const char** fileId)
+{
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    const JSON_Object* files = _workflow_get_update_manifest_files_map(handle);
+
+    if (wf != NULL && wf->StepObject != NULL)
+    {
+        if (index >= wf->StepFileCount)
+        {
+            return NULL;
+        }
+
+        index = wf->StepFileIndexes[index];
+    }
+
+    *fileId = json_object_get_name(files, index);
+    return json_value_get_object(json_object_get_value_at(files, index));
+}
+
 // Public functions - always return a copy of value.
 size_t workflow_get_update_files_count(ADUC_WorkflowHandle handle)
 {
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    if (wf != NULL && wf->StepObject != NULL)
+    {
+        return wf->StepFileCount;
+    }
+
     const JSON_Object* files = _workflow_get_update_manifest_files_map(handle);
     return files == NULL ? 0 : json_object_get_count(files);
 }
 
-bool workflow_get_update_file(ADUC_WorkflowHandle handle, size_t index, ADUC_FileEntity* entity)
+/**
+ * @brief Makes a deep copy of @p source into @p target.
+ *
+ * @param source The file entity to copy.
+ * @param[out] target The output file entity. Caller must uninitialize it via ADUC_FileEntity_Uninit when done.
+ * @return true on success.
+ */
+static bool workflow_copy_file_entity(const ADUC_FileEntity* source, ADUC_FileEntity* target)
 {
-    if (entity == NULL)
-    {
-        return false;
+    bool succeeded = false;
+
+    if (!ADUC_FileEntity_Init(
+            target,
+            source->FileId,
+            source->TargetFilename,
+            source->DownloadUri,
+            source->Arguments,
+            source->Hash,
+            source->HashCount,
+            source->SizeInBytes))
+    {
+        memset(target, 0, sizeof(*target));
+        goto done;
     }
 
-    size_t count = workflow_get_update_files_count(handle);
-    if (index >= count)
+    if (source->DownloadHandlerId != NULL
+        && mallocAndStrcpy_s(&(target->DownloadHandlerId), source->DownloadHandlerId) != 0)
     {
-        return false;
+        goto done;
     }
 
-    bool succeeded = false;
-    const JSON_Object* files = NULL;
-    const JSON_Object* file = NULL;
-    const JSON_Object* fileUrls = NULL;
-    const char* uri = NULL;
-    const char* fileId = NULL;
-    const char* name = NULL;
-    const char* arguments = NULL;
-    size_t tempHashCount = 0;
-    ADUC_Hash* tempHash = NULL;
-
-    if ((files = _workflow_get_update_manifest_files_map(handle)) == NULL)
+    if (source->RelatedFileCount > 0)
     {
-        goto done;
+        target->RelatedFiles = calloc(source->RelatedFileCount, sizeof(*target->RelatedFiles));
+        if (target->RelatedFiles == NULL)
+        {
+            goto done;
+        }
+
+        target->RelatedFileCount = source->RelatedFileCount;
+
+        for (size_t i = 0; i < source->RelatedFileCount; i++)
+        {
+            const ADUC_RelatedFile* relatedFile = &source->RelatedFiles[i];
+            if (!ADUC_RelatedFile_Init(
+                    &target->RelatedFiles[i],
+                    relatedFile->FileId,
+                    relatedFile->DownloadUri,
+                    relatedFile->FileName,
+                    relatedFile->HashCount,
+                    relatedFile->Hash,
+                    relatedFile->PropertiesCount,
+                    relatedFile->Properties))
+            {
+                goto done;
+            }
+        }
     }
 
-    fileId = json_object_get_name(files, index);
+    succeeded = true;
 
-    if ((file = json_value_get_object(json_object_get_value_at(files, index))) == NULL)
+done:
+    if (!succeeded)
     {
-        goto done;
+        workflow_uninit_file_entity(target);
     }
 
-    // Find fileurls map in this workflow, and its enclosing workflow(s).
-    ADUC_WorkflowHandle h = handle;
+    return succeeded;
+}
 
-    do
+/**
+ * @brief Makes a heap copy of the file entity of a file entry in the update manifest, resolving it in the
+ * workflow's arena and rewinding the arena afterwards.
+ *
+ * @param wf The workflow.
+ * @param fileId The file id.
+ * @param file The file entry in the update manifest.
+ * @param[out] entity The output file entity. Caller must uninitialize it via ADUC_FileEntity_Uninit when done.
+ * Its DownloadUri is NULL if no 'fileUrls' map has the file.
+ * @return true on success.
+ */
+static bool workflow_resolve_file_copy(
+    ADUC_Workflow* wf, const char* fileId, const JSON_Object* file, ADUC_FileEntity* entity)
+{
+    ADUC_FileEntity resolved;
+    bool succeeded = false;
+
+    memset(entity, 0, sizeof(*entity));
+
+    pthread_mutex_lock(&s_fileEntityCacheMutex);
+
+    // The scratch entity is carved from the shared arena, so the rewind must not interleave with cache fills.
+    ADUC_Arena* arena = workflow_get_file_entity_arena(wf);
+    if (arena != NULL)
     {
-        if ((fileUrls = _workflow_get_fileurls_map(h)) != NULL)
+        ADUC_ArenaMark mark = ADUC_Arena_GetMark(arena);
+
+        if (workflow_arena_resolve_file(handle_from_workflow(wf), arena, fileId, file, &resolved))
         {
-            uri = json_object_get_string(fileUrls, fileId);
+            succeeded = workflow_copy_file_entity(&resolved, entity);
         }
-        h = workflow_get_parent(h);
-    } while (uri == NULL && h != NULL);
 
-    if (uri == NULL)
-    {
-        Log_Error("Cannot find URL for fileId '%s'", fileId);
-        goto done;
+        ADUC_Arena_Rewind(arena, mark);
     }
 
-    name = json_object_get_string(file, ADUCITF_FIELDNAME_FILENAME);
-    arguments = json_object_get_string(file, ADUCITF_FIELDNAME_ARGUMENTS);
+    pthread_mutex_unlock(&s_fileEntityCacheMutex);
+
+    return succeeded;
+}
+
+/**
+ * @brief Gets the cached file entity for the file at @p index, resolving it on first use.
+ * Entities without a download URL are not cached, as the URL may come from a parent workflow set later.
+ *
+ * @param wf The workflow.
+ * @param index A file index. Must be less than the files count.
+ * @return ADUC_FileEntity* The cached entity, or NULL if it cannot be resolved or has no download URL.
+ */
+static const ADUC_FileEntity* workflow_get_cached_file_entity(ADUC_Workflow* wf, size_t index)
+{
+    ADUC_WorkflowHandle handle = handle_from_workflow(wf);
+    ADUC_FileEntity* entity = NULL;
 
-    const JSON_Object* hashObj = json_object_get_object(file, ADUCITF_FIELDNAME_HASHES);
+    pthread_mutex_lock(&s_fileEntityCacheMutex);
 
-    tempHash = ADUC_HashArray_AllocAndInit(hashObj, &tempHashCount);
-    if (tempHash == NULL)
+    ADUC_Arena* arena = workflow_get_file_entity_arena(wf);
+    if (arena == NULL)
     {
-        Log_Error("Unable to parse hashes for file @ %zu", index);
         goto done;
     }
 
-    size_t sizeInBytes = 0;
-    if (json_object_has_value(file, ADUCITF_FIELDNAME_SIZEINBYTES))
+    if (wf->FileEntities == NULL)
     {
-        sizeInBytes = (size_t)json_object_get_number(file, ADUCITF_FIELDNAME_SIZEINBYTES);
-    }
+        size_t count = workflow_get_update_files_count(handle);
+        if ((wf->FileEntities = ADUC_Arena_AllocArray(arena, count, sizeof(*wf->FileEntities))) == NULL)
+        {
+            goto done;
+        }
 
-    if (!ADUC_FileEntity_Init(entity, fileId, name, uri, arguments, tempHash, tempHashCount, sizeInBytes))
-    {
-        Log_Error("Invalid file entity arguments");
-        goto done;
+        wf->FileEntityCount = count;
     }
 
-    // ADUC_FileEntity_Init makes a deep copy of the hash so must free tempHash to avoid memory leak.
-    ADUC_Hash_FreeArray(tempHashCount, tempHash);
-    tempHash = NULL;
+    entity = &wf->FileEntities[index];
 
-    if (!ParseFileEntityDownloadHandler(handle, file, entity))
+    if (entity->FileId == NULL)
     {
-        goto done;
-    }
+        const char* fileId = NULL;
+        const JSON_Object* file = workflow_peek_update_file_object(handle, index, &fileId);
+        ADUC_ArenaMark mark = ADUC_Arena_GetMark(arena);
 
-    succeeded = true;
+        if (!workflow_arena_resolve_file(handle, arena, fileId, file, entity) || entity->DownloadUri == NULL)
+        {
+            ADUC_Arena_Rewind(arena, mark);
+            memset(entity, 0, sizeof(*entity));
+            entity = NULL;
+        }
+    }
 
 done:
-    if (!succeeded)
-    {
-        entity->Hash = NULL; // Manually free hash array below that is pointed to by tempHash...
-        ADUC_FileEntity_Uninit(entity);
-    }
+    pthread_mutex_unlock(&s_fileEntityCacheMutex);
+
+    return entity;
+}
 
-    if (tempHash != NULL)
+/**
+ * @brief Hashes a file name for the case-insensitive file name index.
+ */
+static size_t workflow_hash_file_name(const char* name)
+{
+    // FNV-1a over the lower-case characters.
+    size_t hash = (size_t)2166136261u;
+    for (const unsigned char* c = (const unsigned char*)name; *c != '\0'; c++)
     {
-        ADUC_Hash_FreeArray(tempHashCount, tempHash);
+        hash = (hash ^ (size_t)tolower(*c)) * (size_t)16777619u;
     }
 
-    return succeeded;
+    return hash;
 }
 
-bool workflow_get_update_file_by_name(ADUC_WorkflowHandle handle, const char* fileName, ADUC_FileEntity* entity)
+/**
+ * @brief Builds the case-insensitive file name index of the workflow's files, if not built yet.
+ * It is an open-addressing hash table of file index + 1, with 0 marking an empty slot.
+ * Caller must hold s_fileEntityCacheMutex.
+ *
+ * @param wf The workflow.
+ * @return true if the index is available.
+ */
+static bool workflow_build_file_name_index(ADUC_Workflow* wf)
 {
-    if (entity == NULL)
+    ADUC_WorkflowHandle handle = handle_from_workflow(wf);
+
+    if (wf->FileNameIndex != NULL)
     {
-        return false;
+        return true;
     }
 
     size_t count = workflow_get_update_files_count(handle);
-    if (count == 0)
+    size_t size = 8;
+    while (size < count * 2)
     {
-        return false;
+        size *= 2;
     }
 
-    bool succeeded = false;
-    const JSON_Object* files = NULL;
-    const JSON_Object* file = NULL;
-    const JSON_Object* fileUrls = NULL;
-    const char* uri = NULL;
-    const char* fileId = NULL;
-    const char* name = NULL;
-    const char* arguments = NULL;
-    size_t tempHashCount = 0;
-    ADUC_Hash* tempHash = NULL;
-
-    if ((files = _workflow_get_update_manifest_files_map(handle)) == NULL)
+    ADUC_Arena* arena = workflow_get_file_entity_arena(wf);
+    if (arena == NULL || (wf->FileNameIndex = ADUC_Arena_AllocArray(arena, size, sizeof(*wf->FileNameIndex))) == NULL)
     {
-        goto done;
+        return false;
     }
 
-    // Find file by name.
+    wf->FileNameIndexSize = size;
+
     for (size_t i = 0; i < count; i++)
     {
-        if ((file = json_value_get_object(json_object_get_value_at(files, i))) != NULL
-            && ADUCPAL_strcasecmp(json_object_get_string(file, "fileName"), fileName) == 0)
+        const char* fileId = NULL;
+        const char* name =
+            json_object_get_string(workflow_peek_update_file_object(handle, i, &fileId), ADUCITF_FIELDNAME_FILENAME);
+        if (name == NULL)
         {
-            fileId = json_object_get_name(files, i);
-            break;
+            continue;
+        }
+
+        size_t slot = workflow_hash_file_name(name) & (size - 1);
+        while (wf->FileNameIndex[slot] != 0)
+        {
+            const char* other = json_object_get_string(
+                workflow_peek_update_file_object(handle, wf->FileNameIndex[slot] - 1, &fileId),
+                ADUCITF_FIELDNAME_FILENAME);
+            if (ADUCPAL_strcasecmp(other, name) == 0)
+            {
+                // Keep the first file with this name.
+                break;
+            }
+
+            slot = (slot + 1) & (size - 1);
+        }
+
+        if (wf->FileNameIndex[slot] == 0)
+        {
+            wf->FileNameIndex[slot] = i + 1;
         }
     }
 
-    if (fileId == NULL)
+    return true;
+}
+
+/**
+ * @brief Finds the index of the first file named @p fileName, case-insensitively.
+ *
+ * @param wf The workflow.
+ * @param fileName The file name.
+ * @param[out] index Receives the file index.
+ * @return true if found.
+ */
+static bool workflow_find_file_by_name(ADUC_Workflow* wf, const char* fileName, size_t* index)
+{
+    ADUC_WorkflowHandle handle = handle_from_workflow(wf);
+    bool found = false;
+
+    if (fileName == NULL)
     {
-        goto done;
+        return false;
     }
 
-    // Find fileurls map in this workflow, and its enclosing workflow(s).
-    ADUC_WorkflowHandle h = handle;
+    pthread_mutex_lock(&s_fileEntityCacheMutex);
 
-    do
+    if (!workflow_build_file_name_index(wf))
     {
-        if ((fileUrls = _workflow_get_fileurls_map(h)) != NULL)
+        goto done;
+    }
+
+    size_t slot = workflow_hash_file_name(fileName) & (wf->FileNameIndexSize - 1);
+    while (wf->FileNameIndex[slot] != 0)
+    {
+        const char* fileId = NULL;
+        const char* name = json_object_get_string(
+            workflow_peek_update_file_object(handle, wf->FileNameIndex[slot] - 1, &fileId),
+            ADUCITF_FIELDNAME_FILENAME);
+        if (ADUCPAL_strcasecmp(name, fileName) == 0)
         {
-            uri = json_object_get_string(fileUrls, fileId);
+            *index = wf->FileNameIndex[slot] - 1;
+            found = true;
+            break;
         }
-        h = workflow_get_parent(h);
-    } while (uri == NULL && h != NULL);
 
-    if (uri == NULL)
+        slot = (slot + 1) & (wf->FileNameIndexSize - 1);
+    }
+
+done:
+    pthread_mutex_unlock(&s_fileEntityCacheMutex);
+
+    return found;
+}
+
+const ADUC_FileEntity* workflow_peek_update_file(ADUC_WorkflowHandle handle, size_t index)
+{
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    if (wf == NULL || index >= workflow_get_update_files_count(handle))
     {
-        Log_Error("Cannot find URL for fileId '%s'", fileId);
+        return NULL;
     }
 
-    name = json_object_get_string(file, ADUCITF_FIELDNAME_FILENAME);
-    arguments = json_object_get_string(file, ADUCITF_FIELDNAME_ARGUMENTS);
+    return workflow_get_cached_file_entity(wf, index);
+}
 
-    const JSON_Object* hashObj = json_object_get_object(file, ADUCITF_FIELDNAME_HASHES);
+const ADUC_FileEntity* workflow_peek_update_file_by_name(ADUC_WorkflowHandle handle, const char* fileName)
+{
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    size_t index = 0;
 
-    tempHash = ADUC_HashArray_AllocAndInit(hashObj, &tempHashCount);
-    if (tempHash == NULL)
+    if (wf == NULL || !workflow_find_file_by_name(wf, fileName, &index))
     {
-        Log_Error("Unable to parse hashes for fileId", fileId);
-        goto done;
+        return NULL;
     }
 
-    size_t sizeInBytes = 0;
-    if (json_object_has_value(file, ADUCITF_FIELDNAME_SIZEINBYTES))
-    {
-        sizeInBytes = (size_t)json_object_get_number(file, ADUCITF_FIELDNAME_SIZEINBYTES);
-    }
+    return workflow_get_cached_file_entity(wf, index);
+}
 
-    if (!ADUC_FileEntity_Init(entity, fileId, name, uri, arguments, tempHash, tempHashCount, sizeInBytes))
+bool workflow_get_update_file(ADUC_WorkflowHandle handle, size_t index, ADUC_FileEntity* entity)
+{
+    if (entity == NULL)
     {
-        Log_Error("Invalid file entity arguments");
-        goto done;
+        return false;
     }
 
-    if (!ParseFileEntityDownloadHandler(handle, file, entity))
+    const ADUC_FileEntity* cached = workflow_peek_update_file(handle, index);
+    if (cached == NULL)
     {
-        goto done;
+        return false;
     }
 
-    succeeded = true;
+    return workflow_copy_file_entity(cached, entity);
+}
 
-done:
-    if (!succeeded)
+bool workflow_get_update_file_by_name(ADUC_WorkflowHandle handle, const char* fileName, ADUC_FileEntity* entity)
+{
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    size_t index = 0;
+
+    if (entity == NULL || wf == NULL || !workflow_find_file_by_name(wf, fileName, &index))
     {
-        entity->Hash = NULL; // will be freed with tempHash below
-        ADUC_FileEntity_Uninit(entity);
+        return false;
+    }
 
-        if (tempHash != NULL)
-        {
-            ADUC_Hash_FreeArray(tempHashCount, tempHash);
-        }
+    const ADUC_FileEntity* cached = workflow_get_cached_file_entity(wf, index);
+    if (cached != NULL)
+    {
+        return workflow_copy_file_entity(cached, entity);
     }
 
-    return succeeded;
+    // Unlike lookup by index, a file without a download URL is still returned by name.
+    const char* fileId = NULL;
+    const JSON_Object* file = workflow_peek_update_file_object(handle, index, &fileId);
+    return workflow_resolve_file_copy(wf, fileId, file, entity);
 }
 
 /**
@@ -2446,6 +2990,21 @@ bool workflow_set_update_file_inode(ADUC_WorkflowHandle handle, size_t index, in
  */
 const char* workflow_peek_update_manifest_string(ADUC_WorkflowHandle handle, const char* propertyName)
 {
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    if (wf != NULL && wf->StepObject != NULL && propertyName != NULL)
+    {
+        // An inline step's update type is the step's handler, and it has no instructions of its own.
+        if (strcmp(propertyName, ADUCITF_FIELDNAME_UPDATETYPE) == 0)
+        {
+            return json_object_get_string(wf->StepObject, STEP_PROPERTY_FIELD_HANDLER);
+        }
+
+        if (strcmp(propertyName, "instructions") == 0)
+        {
+            return NULL;
+        }
+    }
+
     const JSON_Object* manifest = _workflow_get_update_manifest(handle);
     const char* value = json_object_get_string(manifest, propertyName);
     return value;
@@ -2584,7 +3143,7 @@ workflow_init_from_file(const char* updateManifestFile, bool validateManifest, A
         goto done;
     }
 
-    result = _workflow_parse(rootJsonValue, validateManifest, &workflowHandle);
+    result = _workflow_parse(&rootJsonValue, validateManifest, &workflowHandle);
     if (IsAducResultCodeFailure(result.ResultCode))
     {
         goto done;
@@ -2626,6 +3185,13 @@ done:
  */
 static JSON_Array* workflow_get_instructions_steps_array(ADUC_WorkflowHandle handle)
 {
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    if (wf != NULL && wf->StepObject != NULL)
+    {
+        // The steps in the shared manifest belong to the workflow this step was created from.
+        return NULL;
+    }
+
     const JSON_Object* o = _workflow_get_update_manifest(handle);
     return json_object_dotget_array(o, WORKFLOW_PROPERTY_FIELD_INSTRUCTIONS_DOT_STEPS);
 }
@@ -2654,14 +3220,12 @@ static JSON_Array* workflow_get_instructions_steps_array(ADUC_WorkflowHandle han
 ADUC_Result workflow_create_from_inline_step(ADUC_WorkflowHandle base, size_t stepIndex, ADUC_WorkflowHandle* handle)
 {
     ADUC_Result result = { ADUC_GeneralResult_Failure };
-    JSON_Status jsonStatus = JSONFailure;
-    JSON_Value* updateActionValue = NULL;
-    JSON_Value* updateManifestValue = NULL;
     ADUC_Workflow* wf = NULL;
+    const char** stepFileIds = NULL;
     JSON_Array* steps = workflow_get_instructions_steps_array(base);
-    JSON_Value* stepValue = json_array_get_value(steps, stepIndex);
+    JSON_Object* stepObject = json_array_get_object(steps, stepIndex);
 
-    if (stepValue == NULL)
+    if (stepObject == NULL)
     {
         result.ExtendedResultCode = ADUC_ERC_UTILITIES_WORKFLOW_UTIL_INVALID_STEP_INDEX;
         goto done;
@@ -2680,32 +3244,11 @@ ADUC_Result workflow_create_from_inline_step(ADUC_WorkflowHandle base, size_t st
 
     memset(wf, 0, sizeof(*wf));
 
-    updateActionValue = json_value_deep_copy(json_object_get_wrapping_value(wfBase->UpdateActionObject));
-    if (updateActionValue == NULL)
-    {
-        Log_Error("Cannot copy Update Action json from base");
-        result.ExtendedResultCode = ADUC_ERC_UTILITIES_WORKFLOW_UTIL_COPY_UPDATE_ACTION_FROM_BASE_FAILURE;
-        goto done;
-    }
-
-    JSON_Object* updateActionObject = json_object(updateActionValue);
-
-    updateManifestValue = json_value_deep_copy(json_object_get_wrapping_value(wfBase->UpdateManifestObject));
-    if (updateManifestValue == NULL)
-    {
-        Log_Error("Cannot copy Update Manifest json from base");
-        result.ExtendedResultCode = ADUC_ERC_UTILITIES_WORKFLOW_UTIL_COPY_UPDATE_ACTION_FROM_BASE_FAILURE;
-        goto done;
-    }
-
-    JSON_Object* updateManifestObject = json_object(updateManifestValue);
-    JSON_Object* stepObject = json_object(stepValue);
-
-    char* currentStepData = json_serialize_to_string_pretty(stepValue);
+    char* currentStepData = json_serialize_to_string_pretty(json_object_get_wrapping_value(stepObject));
     Log_Debug("Processing current step:\n%s", currentStepData);
     json_free_serialized_string(currentStepData);
 
-    // Replace 'updateType' with step's handler type.
+    // The step's handler is the child's 'updateType'.
     const char* updateType = json_object_get_string(stepObject, STEP_PROPERTY_FIELD_HANDLER);
     if (updateType == NULL || *updateType == 0)
     {
@@ -2713,73 +3256,62 @@ ADUC_Result workflow_create_from_inline_step(ADUC_WorkflowHandle base, size_t st
         result.ExtendedResultCode = ADUC_ERC_UTILITIES_WORKFLOW_UTIL_PARSE_STEP_ENTRY_NO_HANDLER_TYPE;
         goto done;
     }
-    jsonStatus = json_object_set_string(updateManifestObject, ADUCITF_FIELDNAME_UPDATETYPE, updateType);
-    if (jsonStatus == JSONFailure)
-    {
-        Log_Error("Cannot update step entry updateType.");
-        result.ExtendedResultCode = ADUC_ERC_UTILITIES_WORKFLOW_UTIL_COPY_UPDATE_ACTION_SET_UPDATE_TYPE_FAILURE;
-        goto done;
-    }
-
-    // Copy 'handlerProperties'.
-    JSON_Value* handlerProperties =
-        json_value_deep_copy(json_object_get_value(stepObject, STEP_PROPERTY_FIELD_HANDLER_PROPERTIES));
-    jsonStatus =
-        json_object_set_value(updateManifestObject, STEP_PROPERTY_FIELD_HANDLER_PROPERTIES, handlerProperties);
-    if (jsonStatus == JSONFailure)
-    {
-        json_value_free(handlerProperties);
-        handlerProperties = NULL;
-        Log_Error("Cannot copy 'handlerProperties'.");
-        result.ExtendedResultCode = ADUC_ERC_UTILITIES_WORKFLOW_UTIL_COPY_UPDATE_ACTION_COPY_HANDLER_PROPERTIES_FAILED;
-        goto done;
-    }
 
-    // Keep only file needed by this step entry. Remove the rest.
-    JSON_Array* stepFiles = json_object_get_array(stepObject, ADUCITF_FIELDNAME_FILES);
-    JSON_Object* baseFiles = json_object_get_object(updateManifestObject, ADUCITF_FIELDNAME_FILES);
+    // Keep only files needed by this step entry, in the order of the base 'files' map.
+    // Sorting the step's file ids keeps this O((files + stepFiles) * log(stepFiles)).
+    JSON_Array* stepFiles = json_object_get_array(stepObject, STEP_PROPERTY_FIELD_FILES);
+    const JSON_Object* baseFiles = _workflow_get_update_manifest_files_map(base);
+    size_t stepFilesCount = json_array_get_count(stepFiles);
+    size_t baseFilesCount = json_object_get_count(baseFiles);
 
-    size_t fileCount = json_object_get_count(baseFiles);
-    while (fileCount > 0)
+    if (stepFilesCount > 0 && baseFilesCount > 0)
     {
-        fileCount--;
-
-        const char* baseFileId = json_object_get_name(baseFiles, fileCount);
+        size_t stepFileIdCount = 0;
 
-        // If file is in the instruction, merge their properties.
-        bool fileRequired = false;
-
-        size_t stepFilesCount = json_array_get_count(stepFiles);
-        while (stepFilesCount > 0)
+        stepFileIds = malloc(stepFilesCount * sizeof(*stepFileIds));
+        wf->StepFileIndexes =
+            malloc((stepFilesCount < baseFilesCount ? stepFilesCount : baseFilesCount) * sizeof(*wf->StepFileIndexes));
+        if (stepFileIds == NULL || wf->StepFileIndexes == NULL)
         {
-            stepFilesCount--;
-
-            // Note: step's files is an array of file ids.
-            const char* stepFileId = json_array_get_string(stepFiles, stepFilesCount);
+            result.ExtendedResultCode = ADUC_ERC_NOMEM;
+            goto done;
+        }
 
-            if (baseFileId != NULL && stepFileId != NULL && strcmp(baseFileId, stepFileId) == 0)
+        // Note: step's files is an array of file ids.
+        for (size_t i = 0; i < stepFilesCount; i++)
+        {
+            const char* stepFileId = json_array_get_string(stepFiles, i);
+            if (stepFileId != NULL)
             {
-                // Found.
-                fileRequired = true;
-
-                // Done with this file, remove it (and free).
-                json_array_remove(stepFiles, stepFilesCount);
-                break;
+                stepFileIds[stepFileIdCount++] = stepFileId;
             }
         }
 
-        // Remove file from base files list, if no longer needed.
-        if (!fileRequired)
+        qsort(stepFileIds, stepFileIdCount, sizeof(*stepFileIds), CompareStringPointers);
+
+        for (size_t i = 0; i < baseFilesCount; i++)
         {
-            json_object_remove(baseFiles, json_object_get_name(baseFiles, fileCount));
+            const char* baseFileId = json_object_get_name(baseFiles, i);
+            if (baseFileId != NULL
+                && bsearch(&baseFileId, stepFileIds, stepFileIdCount, sizeof(*stepFileIds), CompareStringPointers)
+                    != NULL)
+            {
+                wf->StepFileIndexes[wf->StepFileCount++] = i;
+            }
         }
     }
 
-    // Remove 'instructions' list...
-    json_object_set_null(updateManifestObject, "instructions");
+    // Reference the base's parsed Update Action and Manifest rather than copying them.
+    if (workflow_share_json(wfBase) == NULL)
+    {
+        result.ExtendedResultCode = ADUC_ERC_NOMEM;
+        goto done;
+    }
 
-    wf->UpdateActionObject = updateActionObject;
-    wf->UpdateManifestObject = updateManifestObject;
+    wf->SharedJson = wfBase->SharedJson;
+    wf->UpdateActionObject = wfBase->UpdateActionObject;
+    wf->UpdateManifestObject = wfBase->UpdateManifestObject;
+    wf->StepObject = stepObject;
 
     {
         char* baseWorkfolder = workflow_get_workfolder(base);
@@ -2792,16 +3324,85 @@ ADUC_Result workflow_create_from_inline_step(ADUC_WorkflowHandle base, size_t st
     result.ExtendedResultCode = 0;
 
 done:
+    free(stepFileIds);
+
     if (IsAducResultCodeFailure(result.ResultCode))
     {
-        json_value_free(updateActionValue);
-        json_value_free(updateManifestValue);
         workflow_free(wf);
     }
 
     return result;
 }
 
+/**
+ * @brief Makes a standalone copy of the Update Manifest of an inline step workflow, as it would be
+ * if the step were a separate update: the step's handler as 'updateType', the step's 'handlerProperties',
+ * only the step's files, and no instructions.
+ *
+ * @param wf An inline step workflow.
+ * @return JSON_Value* The copy, or NULL on failure. Caller must free it with json_value_free().
+ */
+static JSON_Value* workflow_copy_step_update_manifest(const ADUC_Workflow* wf)
+{
+    bool succeeded = false;
+    JSON_Value* manifestValue = json_value_deep_copy(json_object_get_wrapping_value(wf->UpdateManifestObject));
+    JSON_Value* filesValue = json_value_init_object();
+    JSON_Object* manifest = json_object(manifestValue);
+    const JSON_Object* sharedFiles = json_object_get_object(wf->UpdateManifestObject, ADUCITF_FIELDNAME_FILES);
+
+    if (manifest == NULL || filesValue == NULL)
+    {
+        goto done;
+    }
+
+    for (size_t i = 0; i < wf->StepFileCount; i++)
+    {
+        size_t index = wf->StepFileIndexes[i];
+        JSON_Value* file = json_value_deep_copy(json_object_get_value_at(sharedFiles, index));
+        if (json_object_set_value(json_object(filesValue), json_object_get_name(sharedFiles, index), file)
+            != JSONSuccess)
+        {
+            json_value_free(file);
+            goto done;
+        }
+    }
+
+    if (json_object_set_value(manifest, ADUCITF_FIELDNAME_FILES, filesValue) != JSONSuccess)
+    {
+        goto done;
+    }
+    filesValue = NULL;
+
+    JSON_Value* handlerProperties =
+        json_value_deep_copy(json_object_get_value(wf->StepObject, STEP_PROPERTY_FIELD_HANDLER_PROPERTIES));
+    if (json_object_set_value(manifest, STEP_PROPERTY_FIELD_HANDLER_PROPERTIES, handlerProperties) != JSONSuccess)
+    {
+        json_value_free(handlerProperties);
+        goto done;
+    }
+
+    if (json_object_set_string(
+            manifest, ADUCITF_FIELDNAME_UPDATETYPE, json_object_get_string(wf->StepObject, STEP_PROPERTY_FIELD_HANDLER))
+            != JSONSuccess
+        || json_object_set_null(manifest, "instructions") != JSONSuccess)
+    {
+        goto done;
+    }
+
+    succeeded = true;
+
+done:
+    json_value_free(filesValue);
+
+    if (!succeeded)
+    {
+        json_value_free(manifestValue);
+        manifestValue = NULL;
+    }
+
+    return manifestValue;
+}
+
 /**
  * @brief Transfer data from @p sourceHandle to @p targetHandle.
  * The sourceHandle will no longer contains transferred action data.
@@ -2835,6 +3436,10 @@ bool workflow_transfer_data(ADUC_WorkflowHandle targetHandle, ADUC_WorkflowHandl
         return false;
     }
 
+    // Cached file entities were resolved against the old JSON objects.
+    workflow_invalidate_file_entity_cache(wfTarget);
+    workflow_invalidate_file_entity_cache(wfSource);
+
     // Transfer over the parsed JSON objects
     wfTarget->UpdateActionObject = wfSource->UpdateActionObject;
     wfSource->UpdateActionObject = NULL;
@@ -2842,9 +3447,26 @@ bool workflow_transfer_data(ADUC_WorkflowHandle targetHandle, ADUC_WorkflowHandl
     wfTarget->UpdateManifestObject = wfSource->UpdateManifestObject;
     wfSource->UpdateManifestObject = NULL;
 
+    wfTarget->SharedJson = wfSource->SharedJson;
+    wfSource->SharedJson = NULL;
+
+    wfTarget->StepObject = wfSource->StepObject;
+    wfSource->StepObject = NULL;
+
+    wfTarget->StepFileIndexes = wfSource->StepFileIndexes;
+    wfSource->StepFileIndexes = NULL;
+
+    wfTarget->StepFileCount = wfSource->StepFileCount;
+    wfSource->StepFileCount = 0;
+
     wfTarget->PropertiesObject = wfSource->PropertiesObject;
     wfSource->PropertiesObject = NULL;
 
+    // The timings of the replaced deployment do not apply to the replacement.
+    ADUC_TimingReport_Release(wfTarget->TimingReport);
+    wfTarget->TimingReport = wfSource->TimingReport;
+    wfSource->TimingReport = NULL;
+
     return true;
 }
 
@@ -2876,7 +3498,7 @@ ADUC_Result workflow_init(const char* updateManifestJsonStr, bool validateManife
         goto done;
     }
 
-    result = _workflow_parse(rootJsonValue, validateManifest, handle);
+    result = _workflow_parse(&rootJsonValue, validateManifest, handle);
     if (IsAducResultCodeFailure(result.ResultCode))
     {
         goto done;
@@ -3065,6 +3687,12 @@ void workflow_uninit(ADUC_WorkflowHandle handle)
 
     _workflow_free_update_file_inodes(wf);
 
+    if (wf != NULL)
+    {
+        ADUC_TimingReport_Release(wf->TimingReport);
+        wf->TimingReport = NULL;
+    }
+
     // This should have been transferred, but free it if it's still around.
     if (wf != NULL && wf->DeferredReplacementWorkflow != NULL)
     {
@@ -3113,6 +3741,9 @@ void workflow_set_parent(ADUC_WorkflowHandle handle, ADUC_WorkflowHandle parent)
     wf->Parent = workflow_from_handle(parent);
     wf->Level = workflow_get_level(parent) + 1;
 
+    // Download URLs may be resolved from the parent's 'fileUrls'.
+    workflow_invalidate_file_entity_cache(wf);
+
     if (parent != NULL && workflow_is_cancel_requested(parent))
     {
         if (!workflow_request_cancel(handle))
@@ -3143,6 +3774,29 @@ ADUC_WorkflowHandle workflow_get_root(ADUC_WorkflowHandle handle)
     return (ADUC_WorkflowHandle)wf;
 }
 
+// Serializes the creation of the root timing report by concurrently processed components.
+static pthread_mutex_t s_timingReportMutex = PTHREAD_MUTEX_INITIALIZER;
+
+ADUC_TimingReport* workflow_get_timing_report(ADUC_WorkflowHandle handle)
+{
+    ADUC_Workflow* root = workflow_from_handle(workflow_get_root(handle));
+    if (root == NULL)
+    {
+        return NULL;
+    }
+
+    pthread_mutex_lock(&s_timingReportMutex);
+
+    if (root->TimingReport == NULL)
+    {
+        root->TimingReport = ADUC_TimingReport_Create();
+    }
+
+    pthread_mutex_unlock(&s_timingReportMutex);
+
+    return root->TimingReport;
+}
+
 /**
  * @brief Get the parent workflow object linked by the @p handle.
  *
@@ -3595,6 +4249,31 @@ bool workflow_is_cancel_requested(ADUC_WorkflowHandle handle)
     return workflow_get_boolean_property(handle, WORKFLOW_PROPERTY_FIELD_CANCEL_REQUESTED);
 }
 
+void workflow_set_download_cancel_requested(ADUC_WorkflowHandle handle, bool cancel)
+{
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    if (wf == NULL)
+    {
+        return;
+    }
+
+    WORKFLOW_ATOMIC_STORE(&wf->DownloadCancelRequested, cancel ? 1 : 0);
+}
+
+bool workflow_is_download_cancel_requested(ADUC_WorkflowHandle handle)
+{
+    // Parent links do not change while the workflow downloads, so only the flags need atomic reads.
+    for (ADUC_Workflow* wf = workflow_from_handle(handle); wf != NULL; wf = wf->Parent)
+    {
+        if (WORKFLOW_ATOMIC_LOAD(&wf->DownloadCancelRequested) != 0)
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
 bool workflow_is_agent_restart_requested(ADUC_WorkflowHandle handle)
 {
     return workflow_get_boolean_property(workflow_get_root(handle), WORKFLOW_PROPERTY_FIELD_AGENT_RESTART_REQUESTED);
@@ -3916,7 +4595,9 @@ const char* workflow_peek_step_type(ADUC_WorkflowHandle handle, size_t stepIndex
 const char*
 workflow_peek_update_manifest_handler_properties_string(ADUC_WorkflowHandle handle, const char* propertyName)
 {
-    const JSON_Object* manifest = _workflow_get_update_manifest(handle);
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    const JSON_Object* manifest =
+        (wf != NULL && wf->StepObject != NULL) ? wf->StepObject : _workflow_get_update_manifest(handle);
     const JSON_Object* properties = json_object_get_object(manifest, STEP_PROPERTY_FIELD_HANDLER_PROPERTIES);
     return json_object_get_string(properties, propertyName);
 }
@@ -3977,84 +4658,34 @@ const char* workflow_peek_update_manifest_step_handler(ADUC_WorkflowHandle handl
  */
 bool workflow_get_step_detached_manifest_file(ADUC_WorkflowHandle handle, size_t stepIndex, ADUC_FileEntity* entity)
 {
+    ADUC_Workflow* wf = workflow_from_handle(handle);
     size_t count = workflow_get_instructions_steps_count(handle);
-    if (stepIndex >= count)
+    if (wf == NULL || entity == NULL || stepIndex >= count)
     {
         return false;
     }
 
-    bool succeeded = false;
-    bool fileEntityInited = false;
     JSON_Object* step = json_array_get_object(workflow_get_instructions_steps_array(handle), stepIndex);
     const char* fileId = json_object_get_string(step, STEP_PROPERTY_FIELD_DETACHED_MANIFEST_FILE_ID);
     const JSON_Object* files = _workflow_get_update_manifest_files_map(handle);
     const JSON_Object* file = json_object_get_object(files, fileId);
-    const JSON_Object* fileUrls = NULL;
-    const char* uri = NULL;
-    const char* name = NULL;
-    size_t tempHashCount = 0;
-    ADUC_Hash* tempHash = NULL;
-
-    // Find fileurls map in this workflow, and its enclosing workflow(s).
-    ADUC_WorkflowHandle h = handle;
-
-    do
-    {
-        if ((fileUrls = _workflow_get_fileurls_map(h)) == NULL)
-        {
-            Log_Warn("'fileUrls' property not found.");
-        }
-        else
-        {
-            uri = json_object_get_string(fileUrls, fileId);
-        }
-        h = workflow_get_parent(h);
-    } while (uri == NULL && h != NULL);
-
-    if (uri == NULL)
-    {
-        goto done;
-    }
-
-    name = json_object_get_string(file, ADUCITF_FIELDNAME_FILENAME);
-    const JSON_Object* hashObj = json_object_get_object(file, ADUCITF_FIELDNAME_HASHES);
-
-    tempHash = ADUC_HashArray_AllocAndInit(hashObj, &tempHashCount);
-    if (tempHash == NULL)
-    {
-        Log_Error("Unable to parse hashes for file @ %zu", stepIndex);
-        goto done;
-    }
-
-    size_t sizeInBytes = 0;
-    if (json_object_has_value(file, ADUCITF_FIELDNAME_SIZEINBYTES))
-    {
-        sizeInBytes = (size_t)json_object_get_number(file, ADUCITF_FIELDNAME_SIZEINBYTES);
-    }
 
-    if (!ADUC_FileEntity_Init(entity, fileId, name, uri, NULL /*arguments*/, tempHash, tempHashCount, sizeInBytes))
+    if (!workflow_resolve_file_copy(wf, fileId, file, entity))
     {
-        Log_Error("Invalid file entity arguments");
-        goto done;
+        return false;
     }
 
-    fileEntityInited = true;
-
-    if (!ParseFileEntityDownloadHandler(handle, file, entity))
+    if (entity->DownloadUri == NULL)
     {
-        goto done;
+        workflow_uninit_file_entity(entity);
+        return false;
     }
 
-    succeeded = true;
-
-done:
-
-    if (!succeeded && fileEntityInited)
-    {
-        ADUC_FileEntity_Uninit(entity);
-    }
+    // The detached manifest is not a payload, so it has no arguments for a down-level handler.
+    free(entity->Arguments);
+    entity->Arguments = NULL;
 
-    return succeeded;
+    return true;
 }
 
 /**
@@ -4066,13 +4697,32 @@ done:
  */
 char* workflow_get_serialized_update_manifest(ADUC_WorkflowHandle handle, bool pretty)
 {
+    ADUC_Workflow* wf = workflow_from_handle(handle);
+    JSON_Value* stepManifestValue = NULL;
     const JSON_Object* o = _workflow_get_update_manifest(handle);
+    char* serialized = NULL;
+
+    if (wf != NULL && wf->StepObject != NULL)
+    {
+        if ((stepManifestValue = workflow_copy_step_update_manifest(wf)) == NULL)
+        {
+            return NULL;
+        }
+
+        o = json_object(stepManifestValue);
+    }
+
     if (pretty)
     {
-        return json_serialize_to_string_pretty(json_object_get_wrapping_value(o));
+        serialized = json_serialize_to_string_pretty(json_object_get_wrapping_value(o));
+    }
+    else
+    {
+        serialized = json_serialize_to_string(json_object_get_wrapping_value(o));
     }
 
-    return json_serialize_to_string(json_object_get_wrapping_value(o));
+    json_value_free(stepManifestValue);
+    return serialized;
 }
 
 /**
@@ -4156,6 +4806,7 @@ bool workflow_set_update_action_object(ADUC_WorkflowHandle handle, JSON_Object*
     ADUC_Workflow* wf = workflow_from_handle(handle);
     if (wf != NULL)
     {
+        workflow_invalidate_file_entity_cache(wf);
         wf->UpdateActionObject = jsonObj;
         return true;
     }
@@ -166,3 +166,39 @@ TEST_CASE_METHOD(GetRootKeyValidationMockHook, "workflow_get_update_file - upd m
         ADUC_FileEntity_Uninit(&fileEntity);
     }
 }
+
+TEST_CASE_METHOD(GetRootKeyValidationMockHook, "workflow_init - verified manifest signature is not verified again")
+{
+    g_mockedRootKeyStorePath = get_prod_rootkey_store();
+
+    SECTION("Same deployment twice")
+    {
+        for (int i = 0; i < 2; ++i)
+        {
+            ADUC_WorkflowHandle handle = nullptr;
+            ADUC_Result result =
+                workflow_init(manifest_missing_related_file_file_url, true /* validateManifest */, &handle);
+            CHECK(IsAducResultCodeSuccess(result.ResultCode));
+            workflow_free(handle);
+        }
+    }
+
+    SECTION("Manifest is still checked against an already verified signature")
+    {
+        ADUC_WorkflowHandle handle = nullptr;
+        ADUC_Result result =
+            workflow_init(manifest_missing_related_file_file_url, true /* validateManifest */, &handle);
+        REQUIRE(IsAducResultCodeSuccess(result.ResultCode));
+        workflow_free(handle);
+
+        std::string tampered{ manifest_missing_related_file_file_url };
+        const size_t versionPos = tampered.find("0.2.0");
+        REQUIRE(versionPos != std::string::npos);
+        tampered.replace(versionPos, 5, "0.2.1");
+
+        handle = nullptr;
+        result = workflow_init(tampered.c_str(), true /* validateManifest */, &handle);
+        CHECK(IsAducResultCodeFailure(result.ResultCode));
+        workflow_free(handle);
+    }
+}
@@ -125,6 +125,37 @@ TEST_CASE("Undefined update action")
     workflow_free(handle);
 }
 
+TEST_CASE("Update manifest in object form")
+{
+    // clang-format off
+    const char* action_object_manifest =
+        R"( {                                                                                    )"
+        R"(     "workflow": { "action": 3, "id": "bbbbbbbb-bfc9-47b7-b7ed-617feba1e6c4" },       )"
+        R"(     "updateManifest": {                                                              )"
+        R"(         "manifestVersion": "5",                                                      )"
+        R"(         "updateId": { "provider": "Contoso", "name": "Virtual-Vacuum", "version": "20.0" }, )"
+        R"(         "files": { "f483750ebb885d32c": { "fileName": "apt-manifest-tree-1.0.json", "sizeInBytes": 136, "hashes": { "sha256": "Uk1vsEL/nT4btMngo0YSJjheOL2aqm6/EAFhzPb0rXs=" } } } )"
+        R"(     },                                                                               )"
+        R"(     "fileUrls": { "f483750ebb885d32c": "http://foo.bar/apt-manifest-tree-1.0.json" } )"
+        R"( }                                                                                    )";
+    // clang-format on
+
+    ADUC_WorkflowHandle handle = nullptr;
+    ADUC_Result result = workflow_init(action_object_manifest, false /* validateManifest */, &handle);
+
+    REQUIRE(result.ResultCode != 0);
+    CHECK(result.ExtendedResultCode == 0);
+
+    CHECK_THAT(workflow_peek_update_manifest_string(handle, "manifestVersion"), Equals("5"));
+    CHECK(workflow_get_update_files_count(handle) == 1);
+
+    const ADUC_FileEntity* file0 = workflow_peek_update_file(handle, 0);
+    REQUIRE(file0 != nullptr);
+    CHECK_THAT(file0->DownloadUri, Equals("http://foo.bar/apt-manifest-tree-1.0.json"));
+
+    workflow_free(handle);
+}
+
 TEST_CASE("Get Compatibility")
 {
     ADUC_WorkflowHandle handle = nullptr;
@@ -199,6 +230,62 @@ TEST_CASE("Child workflow uses fileUrls from parent")
     workflow_free(bundle);
 }
 
+TEST_CASE("Inline step workflow shares the parent's manifest")
+{
+    ADUC_WorkflowHandle bundle = nullptr;
+    ADUC_Result result = workflow_init(action_parent_update, false /* validateManifest */, &bundle);
+    REQUIRE(result.ResultCode != 0);
+
+    // Create the same step twice; creating a step must not change the parent's manifest.
+    for (int i = 0; i < 2; i++)
+    {
+        ADUC_WorkflowHandle step0 = nullptr;
+        result = workflow_create_from_inline_step(bundle, 0, &step0);
+        REQUIRE(result.ResultCode != 0);
+        REQUIRE(step0 != nullptr);
+
+        CHECK_THAT(workflow_peek_update_type(step0), Equals("microsoft/apt:1"));
+        CHECK(workflow_get_instructions_steps_count(step0) == 0);
+
+        char* installedCriteria = workflow_get_installed_criteria(step0);
+        CHECK_THAT(installedCriteria, Equals("apt-update-tree-1.0"));
+        workflow_free_string(installedCriteria);
+
+        REQUIRE(workflow_get_update_files_count(step0) == 1);
+
+        ADUC_FileEntity file0;
+        memset(&file0, 0, sizeof(file0));
+        REQUIRE(workflow_get_update_file(step0, 0, &file0));
+        CHECK_THAT(file0.FileId, Equals("f483750ebb885d32c"));
+        CHECK_THAT(file0.TargetFilename, Equals("apt-manifest-tree-1.0.json"));
+        ADUC_FileEntity_Uninit(&file0);
+
+        CHECK_FALSE(workflow_get_update_file(step0, 1, &file0));
+
+        workflow_insert_child(bundle, -1, step0);
+    }
+
+    CHECK(workflow_get_update_files_count(bundle) == 2);
+    CHECK(workflow_get_instructions_steps_count(bundle) == 2);
+    CHECK(workflow_get_children_count(bundle) == 2);
+
+    // The shared manifest outlives the parent for as long as a step workflow references it.
+    ADUC_WorkflowHandle step0 = workflow_remove_child(bundle, 0);
+    workflow_free(bundle);
+
+    char* serializedManifest = workflow_get_serialized_update_manifest(step0, false);
+    REQUIRE(serializedManifest != nullptr);
+    std::string manifest{ serializedManifest };
+    workflow_free_string(serializedManifest);
+
+    CHECK(manifest.find("\"updateType\":\"microsoft/apt:1\"") != std::string::npos);
+    CHECK(manifest.find("f483750ebb885d32c") != std::string::npos);
+    CHECK(manifest.find("f222b9ffefaaac577") == std::string::npos);
+    CHECK(manifest.find("\"instructions\":null") != std::string::npos);
+
+    workflow_free(step0);
+}
+
 TEST_CASE("Get update file by name")
 {
     ADUC_WorkflowHandle bundle = nullptr;
@@ -255,6 +342,44 @@ TEST_CASE("Get update file by name - mixed case")
     workflow_free(bundle);
 }
 
+TEST_CASE("Peek update files returns cached entities")
+{
+    ADUC_WorkflowHandle bundle = nullptr;
+    ADUC_Result result = workflow_init(action_parent_update, false /* validateManifest */, &bundle);
+
+    CHECK(result.ResultCode != 0);
+    CHECK(result.ExtendedResultCode == 0);
+
+    auto filecount = workflow_get_update_files_count(bundle);
+    REQUIRE(filecount == 2);
+
+    const ADUC_FileEntity* file0 = workflow_peek_update_file(bundle, 0);
+    REQUIRE(file0 != nullptr);
+    CHECK(workflow_peek_update_file(bundle, 0) == file0);
+    CHECK(workflow_peek_update_file(bundle, filecount) == nullptr);
+
+    const ADUC_FileEntity* byName = workflow_peek_update_file_by_name(bundle, file0->TargetFilename);
+    CHECK(byName == file0);
+
+    const ADUC_FileEntity* byMixedCaseName =
+        workflow_peek_update_file_by_name(bundle, "contoso.Contoso-virtual-motors.1.1.updatemanifest.json");
+    REQUIRE(byMixedCaseName != nullptr);
+    CHECK_THAT(byMixedCaseName->FileId, Equals("f222b9ffefaaac577"));
+    CHECK(workflow_peek_update_file_by_name(bundle, "no-such-file.json") == nullptr);
+
+    // Copies are independent of the cached entity.
+    ADUC_FileEntity copy;
+    memset(&copy, 0, sizeof(copy));
+    CHECK(workflow_get_update_file(bundle, 0, &copy));
+    CHECK(copy.FileId != file0->FileId);
+    CHECK_THAT(copy.FileId, Equals(file0->FileId));
+    CHECK_THAT(copy.DownloadUri, Equals(file0->DownloadUri));
+    CHECK(copy.HashCount == file0->HashCount);
+
+    ADUC_FileEntity_Uninit(&copy);
+    workflow_free(bundle);
+}
+
 TEST_CASE("Add and remove children")
 {
     ADUC_WorkflowHandle handle = nullptr;
@@ -728,3 +853,52 @@ TEST_CASE("Request workflow cancellation")
 
     workflow_free(handle);
 }
+
+TEST_CASE("Request download cancellation")
+{
+    ADUC_WorkflowHandle handle = nullptr;
+    ADUC_Result result = workflow_init(action_parent_update, false /* validateManifest */, &handle);
+
+    CHECK(result.ResultCode != 0);
+    CHECK(result.ExtendedResultCode == 0);
+
+    ADUC_WorkflowHandle childWorkflow[2];
+
+    for (int i = 0; i < ARRAY_SIZE(childWorkflow); i++)
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        result = workflow_init(action_child_update_0, false /* validateManifest */, &childWorkflow[i]);
+        CHECK(result.ResultCode != 0);
+        CHECK(result.ExtendedResultCode == 0);
+
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        CHECK(workflow_insert_child(handle, -1, childWorkflow[i]));
+    }
+
+    // Cancelling a child's downloads leaves its parent and siblings alone, and can be undone.
+    workflow_set_download_cancel_requested(childWorkflow[0], true);
+    CHECK(workflow_is_download_cancel_requested(childWorkflow[0]));
+    CHECK(!workflow_is_download_cancel_requested(childWorkflow[1]));
+    CHECK(!workflow_is_download_cancel_requested(handle));
+
+    workflow_set_download_cancel_requested(childWorkflow[0], false);
+    CHECK(!workflow_is_download_cancel_requested(childWorkflow[0]));
+
+    // Cancelling the parent's downloads cancels its children's, without a cancel request on them.
+    workflow_set_download_cancel_requested(handle, true);
+    for (int i = 0; i < ARRAY_SIZE(childWorkflow); i++)
+    {
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        CHECK(workflow_is_download_cancel_requested(childWorkflow[i]));
+        // NOLINTNEXTLINE(cppcoreguidelines-pro-bounds-constant-array-index)
+        CHECK(!workflow_is_cancel_requested(childWorkflow[i]));
+    }
+
+    for (int i = ARRAY_SIZE(childWorkflow) - 1; i >= 0; i--)
+    {
+        workflow_remove_child(handle, i);
+        workflow_free(childWorkflow[i]);
+    }
+
+    workflow_free(handle);
+}